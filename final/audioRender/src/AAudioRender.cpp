@@ -12,10 +12,23 @@ AAudioRender::AAudioRender() {
 }
 
 AAudioRender::~AAudioRender() {
-    AAudioStream_close(stream);
+    if (stream) {
+        AAudioStream_close(stream);
+    }
 }
 
-int AAudioRender::start() {
+aaudio_data_callback_result_t AAudioRender::dataCallback(AAudioStream *s, void *self, void *audioData, int32_t numFrames) {
+    auto *render = static_cast<AAudioRender *>(self);
+    if (!render->callback) {
+        return AAUDIO_CALLBACK_RESULT_STOP;
+    }
+    return render->callback(s, render->user_data, audioData, numFrames);
+}
+
+int AAudioRender::open() {
+    if (stream) {
+        return 0;
+    }
     AAudioStreamBuilder *builder;
     aaudio_result_t result = AAudio_createStreamBuilder(&builder);
     if (result != AAUDIO_OK) {
@@ -27,25 +40,33 @@ int AAudioRender::start() {
     AAudioStreamBuilder_setFormat(builder, this->format);
     AAudioStreamBuilder_setPerformanceMode(builder, AAUDIO_PERFORMANCE_MODE_LOW_LATENCY);
     AAudioStreamBuilder_setSharingMode(builder, AAUDIO_SHARING_MODE_SHARED);
-    if (!this->callback) {
-        LOGE(LOG_TAG, "callback is nullptr");
-        return -1;
-    }
-    AAudioStreamBuilder_setDataCallback(builder, callback, user_data);
+    AAudioStreamBuilder_setDataCallback(builder, &AAudioRender::dataCallback, this);
     result = AAudioStreamBuilder_openStream(builder, &stream);
+    AAudioStreamBuilder_delete(builder);
     if (result != AAUDIO_OK) {
         LOGE(LOG_TAG, "openStream failed: %s", AAudio_convertResultToText(result));
+        stream = nullptr;
         return -1;
     }
     this->format = AAudioStream_getFormat(stream);
     this->channel_count = AAudioStream_getChannelCount(stream);
     this->sample_rate = AAudioStream_getSampleRate(stream);
-    result = AAudioStream_requestStart(stream);
+    return 0;
+}
+
+int AAudioRender::start() {
+    if (!this->callback) {
+        LOGE(LOG_TAG, "callback is nullptr");
+        return -1;
+    }
+    if (open() != 0) {
+        return -1;
+    }
+    aaudio_result_t result = AAudioStream_requestStart(stream);
     if (result != AAUDIO_OK) {
         LOGE(LOG_TAG, "requestStart failed: %s", AAudio_convertResultToText(result));
         return -1;
     }
-    AAudioStreamBuilder_delete(builder);
     return 0;
 }
 
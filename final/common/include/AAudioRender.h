@@ -8,7 +8,7 @@
 using AAudioCallback = int (*)(AAudioStream*, void*, void*, int32_t);
 
 class AAudioRender {
-    AAudioStream* stream;
+    AAudioStream* stream = nullptr;
     int32_t channel_count;
     int32_t sample_rate;
     bool paused;
@@ -21,13 +21,22 @@ public:
 
     AAudioRender();
 
-    // 指定采样率，通道数和数据格式，否则使用默认
+    // 指定采样率，通道数和数据格式，否则使用默认。采样率传 AAUDIO_UNSPECIFIED 时由设备决定
     void configure(int32_t sampleRate, int32_t channelCnt, aaudio_format_t fmt);
 
+    // 打开AAudioStream但不开始播放，成功返回0，失败返回<0。
+    // 打开之后 getSampleRate / getChannelCount / getFormat 返回设备实际使用的参数，
+    // 回调可以在打开之后、start 之前再设置
+    int open();
+
+    int32_t getSampleRate() const { return sample_rate; }
+    int32_t getChannelCount() const { return channel_count; }
+    aaudio_format_t getFormat() const { return format; }
+
     // 设置AAudio的回调，指定user_data为你需要的数据指针，user_data会传递给callback的第二个参数
     void setCallback(AAudioCallback cb, void* data);
 
-    // AAudioStream开始工作，成功返回0，失败返回<0
+    // AAudioStream开始工作（还没有 open 时先 open），成功返回0，失败返回<0
     int start();
 
     // 刷新AAudio的内部缓冲区
@@ -35,4 +44,8 @@ public:
 
     // 参数p为true时表示暂停，为false时表示取消暂停
     int pause(bool p);
+
+private:
+    // 交给 AAudio 的回调，转发给 setCallback 设置的 callback
+    static aaudio_data_callback_result_t dataCallback(AAudioStream* s, void* self, void* audioData, int32_t numFrames);
 };
\ No newline at end of file
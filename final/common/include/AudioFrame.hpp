@@ -9,8 +9,9 @@ struct AudioFrame {
     double pts {};
     double duration {};
 
-    uint8_t* interleaved_pcm = nullptr;
+    uint8_t* interleaved_pcm = nullptr; // av_malloc 分配
     int interleaved_size = 0;
+    int interleaved_capacity = 0; // interleaved_pcm 实际分配的字节数，池里复用时用
     ~AudioFrame();
 };
 
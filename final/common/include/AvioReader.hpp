@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace player_utils {
+
+// MediaSource 自己装 AVIOContext 时，read_packet / seek 背后的数据来源：本地文件（LocalFileReader）、
+// 正在被追加的文件（GrowingFileReader）或者文件服务器上的文件（RemoteFileReader）。
+// read / seek 只在一个线程（解复用线程）里调用，各个实现内部的后台线程自己同步
+class AvioReader {
+public:
+    struct Stats {
+        uint64_t bytes_read = 0; // 交给调用方的字节数
+        uint64_t waits = 0; // 数据还没读好、调用方不得不等的次数
+        uint64_t refills = 0; // seek 到窗口之外，预读窗口整个重来的次数
+    };
+
+    virtual ~AvioReader() = default;
+
+    // 返回读到的字节数，0 表示文件结束，负数是 -errno
+    virtual int64_t read(uint8_t* dst, size_t len) = 0;
+    // 移到绝对位置 pos，返回新的位置或 -errno
+    virtual int64_t seek(int64_t pos) = 0;
+
+    [[nodiscard]] int64_t size() const { return size_; }
+    [[nodiscard]] int64_t position() const { return pos_; }
+    [[nodiscard]] virtual Stats stats() const = 0;
+
+protected:
+    int64_t size_ = 0;
+    int64_t pos_ = 0;
+};
+
+} // namespace player_utils
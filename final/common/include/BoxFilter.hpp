@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PLAYER_BOX_FILTER_NEON 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PLAYER_BOX_FILTER_SSE2 1
+#endif
+
+namespace player_utils {
+
+// 8 位平面的面积平均缩小（box filter），缩略图用。
+//
+// 每个输出像素是它覆盖的源矩形的平均值。分两步做：
+//   1. 把落在同一输出行里的源行逐像素累加到行缓冲——这一步要读全部源像素，用 NEON / SSE2 做；
+//   2. 按列区间把行缓冲求和，除以面积——只和输出像素数成正比。
+// 行缓冲跨调用复用，一个 BoxFilter 同一时间只能给一个线程用。
+class BoxFilter {
+public:
+    void scale(const uint8_t* src, int src_width, int src_height, int src_stride,
+        uint8_t* dst, int dst_width, int dst_height, int dst_stride)
+    {
+        if (src_width <= 0 || src_height <= 0 || dst_width <= 0 || dst_height <= 0) {
+            return;
+        }
+        acc_.resize(static_cast<size_t>(src_width));
+        acc16_.resize(static_cast<size_t>(src_width));
+
+        for (int y = 0; y < dst_height; ++y) {
+            const int y0 = span_begin(y, src_height, dst_height);
+            const int y1 = span_end(y, src_height, dst_height);
+
+            std::fill(acc_.begin(), acc_.end(), 0U);
+            // 每 kMaxRows16 行在 uint16 里累加（不会溢出，访存量是 uint32 的一半），再并进 uint32
+            for (int sy = y0; sy < y1; sy += kMaxRows16) {
+                const int end = std::min(y1, sy + kMaxRows16);
+                std::fill(acc16_.begin(), acc16_.end(), static_cast<uint16_t>(0));
+                for (int r = sy; r < end; ++r) {
+                    accumulate_row(src + static_cast<ptrdiff_t>(r) * src_stride, acc16_.data(), src_width);
+                }
+                for (int i = 0; i < src_width; ++i) {
+                    acc_[i] += acc16_[i];
+                }
+            }
+
+            uint8_t* out = dst + static_cast<ptrdiff_t>(y) * dst_stride;
+            const uint32_t rows = static_cast<uint32_t>(y1 - y0);
+            for (int x = 0; x < dst_width; ++x) {
+                const int x0 = span_begin(x, src_width, dst_width);
+                const int x1 = span_end(x, src_width, dst_width);
+                uint32_t sum = 0;
+                for (int sx = x0; sx < x1; ++sx) {
+                    sum += acc_[sx];
+                }
+                const uint32_t area = rows * static_cast<uint32_t>(x1 - x0);
+                out[x] = static_cast<uint8_t>((sum + area / 2) / area);
+            }
+        }
+    }
+
+    // acc[i] += row[i]，导出来给测试和 benchmark 对比用
+    static void accumulate_row(const uint8_t* row, uint16_t* acc, int width)
+    {
+        int i = 0;
+#if defined(PLAYER_BOX_FILTER_NEON)
+        for (; i + 16 <= width; i += 16) {
+            const uint8x16_t px = vld1q_u8(row + i);
+            vst1q_u16(acc + i, vaddw_u8(vld1q_u16(acc + i), vget_low_u8(px)));
+            vst1q_u16(acc + i + 8, vaddw_u8(vld1q_u16(acc + i + 8), vget_high_u8(px)));
+        }
+#elif defined(PLAYER_BOX_FILTER_SSE2)
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 16 <= width; i += 16) {
+            const __m128i px = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+            auto* a = reinterpret_cast<__m128i*>(acc + i);
+            _mm_storeu_si128(a + 0, _mm_add_epi16(_mm_loadu_si128(a + 0), _mm_unpacklo_epi8(px, zero)));
+            _mm_storeu_si128(a + 1, _mm_add_epi16(_mm_loadu_si128(a + 1), _mm_unpackhi_epi8(px, zero)));
+        }
+#endif
+        for (; i < width; ++i) {
+            acc[i] = static_cast<uint16_t>(acc[i] + row[i]);
+        }
+    }
+
+private:
+    // 第 i 个输出像素覆盖的源区间 [begin, end)，放大时至少一个像素
+    static int span_begin(int i, int src, int dst)
+    {
+        return static_cast<int>(static_cast<int64_t>(i) * src / dst);
+    }
+    static int span_end(int i, int src, int dst)
+    {
+        const int end = static_cast<int>(static_cast<int64_t>(i + 1) * src / dst);
+        return std::min(src, std::max(end, span_begin(i, src, dst) + 1));
+    }
+
+    // 255 * 257 == 65535
+    static constexpr int kMaxRows16 = 257;
+
+    std::vector<uint32_t> acc_;
+    std::vector<uint16_t> acc16_;
+};
+
+} // namespace player_utils
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <thread>
+
+namespace player_utils {
+
+// 解码线程策略，DecoderContext 在 avcodec_open2 之前把它换成 thread_type / thread_count / flags。
+//
+// 帧级多线程（frame threading）吞吐最高，但每多一个线程解码器就多压一帧，首帧和 seek 后的第一帧都要晚这么多帧出来；
+// 片级多线程（slice threading）不加延迟，但只有编码时切了多个 slice 的码流才并行得起来。
+struct DecodeThreading {
+    enum class Mode {
+        Auto, // 按编解码器和分辨率选
+        Frame,
+        Slice,
+        Single,
+    };
+
+    Mode mode = Mode::Auto;
+    // 0 表示按 CPU 核数和分辨率自动选
+    int thread_count = 0;
+    // 低延迟：不用帧级多线程，并打开 AV_CODEC_FLAG_LOW_DELAY
+    bool low_delay = false;
+};
+
+// resolve() 的结果，已经和具体的解码器能力对上了
+struct ResolvedDecodeThreading {
+    DecodeThreading::Mode mode = DecodeThreading::Mode::Single; // 不会是 Auto
+    int thread_count = 1;
+    bool low_delay = false;
+};
+
+// 解码器支持的多线程方式（AV_CODEC_CAP_FRAME_THREADS / AV_CODEC_CAP_SLICE_THREADS）
+struct DecoderThreadCaps {
+    bool frame = false;
+    bool slice = false;
+};
+
+// 纯计算，不碰 FFmpeg，方便单测。width / height 为 0 表示音频或未知分辨率
+inline ResolvedDecodeThreading resolve_decode_threading(const DecodeThreading& policy, DecoderThreadCaps caps,
+    int width, int height, unsigned cores = std::thread::hardware_concurrency())
+{
+    using Mode = DecodeThreading::Mode;
+    ResolvedDecodeThreading out;
+    out.low_delay = policy.low_delay;
+
+    // 音频帧很小，线程同步的开销比解码本身还大
+    const long long pixels = static_cast<long long>(width) * height;
+    if (pixels <= 0 || policy.mode == Mode::Single) {
+        return out;
+    }
+
+    Mode mode = policy.mode;
+    if (mode == Mode::Auto) {
+        mode = policy.low_delay ? Mode::Slice : Mode::Frame;
+    }
+    if (policy.low_delay && mode == Mode::Frame) {
+        mode = Mode::Slice;
+    }
+    // 解码器不支持的方式往下退
+    if (mode == Mode::Frame && !caps.frame) {
+        mode = Mode::Slice;
+    }
+    if (mode == Mode::Slice && !caps.slice) {
+        return out;
+    }
+
+    int count = policy.thread_count;
+    if (count <= 0) {
+        // 分辨率越高每帧的活越多，多线程越划算；480p 开太多线程只会多压几帧
+        int wanted = 2;
+        if (pixels >= 3840LL * 2160) {
+            wanted = 8;
+        } else if (pixels >= 1920LL * 1080) {
+            wanted = 6;
+        } else if (pixels >= 1280LL * 720) {
+            wanted = 4;
+        }
+        // 留一个核给解复用、渲染和音频
+        const int available = cores > 1 ? static_cast<int>(cores) - 1 : 1;
+        count = std::min(wanted, available);
+    }
+    // FFmpeg 的帧线程上限是 MAX_AUTO_THREADS（16）
+    count = std::clamp(count, 1, 16);
+    if (count == 1) {
+        return out;
+    }
+    out.mode = mode;
+    out.thread_count = count;
+    return out;
+}
+
+} // namespace player_utils
@@ -0,0 +1,289 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace player_utils {
+
+// 一个流在包队列里缓冲的时长上下限（微秒）
+struct BufferWatermarks {
+    int64_t low_us = 500000;
+    int64_t high_us = 2000000;
+};
+
+// 每个流在包队列里缓冲了多长时间。解复用侧收下一个包时 on_push，解码侧取走一个包时 on_pop，线程安全。
+// 带迟滞：涨到高水位之后这个流不再要数据，降到低水位以下才重新要，同时调用 on_refill 叫醒解复用器，
+// 这样解复用器一次补一批，而不是每解一个包就醒一次
+class StreamBufferLevels {
+public:
+    struct Level {
+        bool tracked = false;
+        int64_t buffered_us = 0;
+        BufferWatermarks watermarks;
+        bool filling = true; // 掉到低水位以下之后、涨到高水位之前
+    };
+
+    explicit StreamBufferLevels(size_t stream_count)
+        : levels_(stream_count)
+    {
+    }
+
+    // 在开始使用之前调用；没有 track 的流不参与调度
+    void track(int stream, BufferWatermarks watermarks)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (valid(stream)) {
+            levels_[stream] = Level { true, 0, watermarks, true };
+        }
+    }
+
+    // 回调在锁外调用，要很轻（一般就是 Demuxer::Wake()）
+    void set_on_refill(std::function<void()> on_refill)
+    {
+        on_refill_ = std::move(on_refill);
+    }
+
+    void on_push(int stream, int64_t duration_us)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!valid(stream) || !levels_[stream].tracked) {
+            return;
+        }
+        Level& level = levels_[stream];
+        level.buffered_us += duration_us;
+        if (level.buffered_us >= level.watermarks.high_us) {
+            level.filling = false;
+        }
+    }
+
+    void on_pop(int stream, int64_t duration_us)
+    {
+        bool crossed_low = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!valid(stream) || !levels_[stream].tracked) {
+                return;
+            }
+            Level& level = levels_[stream];
+            const bool was_above_low = level.buffered_us >= level.watermarks.low_us;
+            // seek 时 reset 和解码线程取包可能交错，不让它变成负数
+            level.buffered_us = level.buffered_us > duration_us ? level.buffered_us - duration_us : 0;
+            if (level.buffered_us < level.watermarks.low_us) {
+                level.filling = true;
+                crossed_low = was_above_low;
+            }
+        }
+        if (crossed_low && on_refill_) {
+            on_refill_();
+        }
+    }
+
+    // 播放中换了轨道（音轨）：to 接着 from 的缓冲时长和水位，from 不再参与调度。
+    // 旧轨道还在队列里的包出队时要按 to 记（on_pop 传当前的流）
+    void retarget(int from, int to)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (valid(from) && valid(to) && from != to) {
+            levels_[to] = levels_[from];
+            levels_[from] = Level {};
+        }
+    }
+
+    // 包队列清空（seek）之后调用
+    void reset()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (Level& level : levels_) {
+            level.buffered_us = 0;
+            level.filling = true;
+        }
+    }
+
+    [[nodiscard]] Level level(int stream) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return valid(stream) ? levels_[stream] : Level {};
+    }
+
+    [[nodiscard]] std::vector<Level> snapshot() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return levels_;
+    }
+
+    [[nodiscard]] size_t stream_count() const { return levels_.size(); }
+
+private:
+    bool valid(int stream) const { return stream >= 0 && static_cast<size_t>(stream) < levels_.size(); }
+
+    mutable std::mutex mutex_;
+    std::vector<Level> levels_;
+    std::function<void()> on_refill_;
+};
+
+enum class SinkResult {
+    kAccepted,
+    kFull,
+    kClosed,
+};
+
+// 解复用器按流调度读包。包按流进各自的队列，某个流的队列满了时：
+//   - 容器可以按流读（per_stream_reads，比如 Mp4SampleReader）：只读还在补数据、队列也放得下的流，
+//     缓冲最少的先读；
+//   - 只有一个读位置（av_read_frame）：满了的流的包先暂存在这里（有上限），只要还有别的流在补数据就接着读，
+//     视频队列满了不会饿着音频。
+// 暂存的包每一步先往队列里放，同一个流保持顺序。没有 StreamBufferLevels 时退化成原来的行为：有包放不进去就等。
+// 只在解复用线程上用，不加锁
+template <typename Packet>
+class DemuxScheduler {
+public:
+    using Sink = std::function<SinkResult(Packet&)>;
+
+    struct Decision {
+        enum Kind {
+            kRead, // 读一个包：stream >= 0 时读这个流的下一个，否则按容器的顺序读下一个
+            kWait, // 等 Wake()：队列腾出空位，或者某个流掉到低水位以下
+            kEnd, // 都读完了，暂存的包也都放进去了
+            kClosed, // sink 已经关闭
+        };
+        Kind kind = kWait;
+        int stream = -1;
+    };
+
+    // 暂存的上限，超过之后回到 "放不进去就等"，内存不会无限涨
+    static constexpr size_t kMaxParkedPackets = 512;
+    static constexpr size_t kMaxParkedBytes = 8 * 1024 * 1024;
+
+    void reset(std::shared_ptr<StreamBufferLevels> levels, bool per_stream_reads)
+    {
+        levels_ = std::move(levels);
+        per_stream_reads_ = per_stream_reads && levels_ != nullptr;
+        const size_t streams = levels_ ? levels_->stream_count() : 0;
+        parked_.clear();
+        parked_.resize(streams + 1); // 最后一格放不认识的流
+        ended_.assign(streams, false);
+        parked_packets_ = 0;
+        parked_bytes_ = 0;
+        input_ended_ = false;
+    }
+
+    // 换了读包方式（比如打开了字幕，样本表解复用不再按流读），暂存的包不动
+    void set_per_stream_reads(bool per_stream_reads)
+    {
+        per_stream_reads_ = per_stream_reads && levels_ != nullptr;
+    }
+
+    // 先把暂存的包往队列里放，再决定下一步
+    Decision next(const Sink& sink)
+    {
+        for (auto& parked : parked_) {
+            while (!parked.empty()) {
+                const SinkResult result = sink(parked.front().first);
+                if (result == SinkResult::kClosed) {
+                    return { Decision::kClosed };
+                }
+                if (result == SinkResult::kFull) {
+                    break;
+                }
+                --parked_packets_;
+                parked_bytes_ -= parked.front().second;
+                parked.pop_front();
+            }
+        }
+        if (input_ended_) {
+            return { parked_packets_ == 0 ? Decision::kEnd : Decision::kWait };
+        }
+        if (!levels_) {
+            return { parked_packets_ == 0 ? Decision::kRead : Decision::kWait };
+        }
+        const std::vector<StreamBufferLevels::Level> levels = levels_->snapshot();
+        return per_stream_reads_ ? next_stream(levels) : next_interleaved(levels);
+    }
+
+    // 把读出来的包交给 sink，放不进去就暂存。返回 false 表示 sink 已经关闭
+    bool deliver(Packet& packet, int stream, size_t bytes, const Sink& sink)
+    {
+        auto& parked = parked_[slot(stream)];
+        if (parked.empty()) {
+            const SinkResult result = sink(packet);
+            if (result != SinkResult::kFull) {
+                return result == SinkResult::kAccepted;
+            }
+        }
+        parked.emplace_back(std::move(packet), bytes);
+        ++parked_packets_;
+        parked_bytes_ += bytes;
+        return true;
+    }
+
+    // 按流读时这个流读完了
+    void stream_ended(int stream)
+    {
+        if (stream >= 0 && static_cast<size_t>(stream) < ended_.size()) {
+            ended_[stream] = true;
+        }
+    }
+
+    // 整个容器读完了（或者出错）
+    void input_ended() { input_ended_ = true; }
+
+    [[nodiscard]] size_t parked_packets() const { return parked_packets_; }
+
+private:
+    size_t slot(int stream) const
+    {
+        return stream >= 0 && static_cast<size_t>(stream) + 1 < parked_.size() ? static_cast<size_t>(stream) : parked_.size() - 1;
+    }
+
+    Decision next_stream(const std::vector<StreamBufferLevels::Level>& levels)
+    {
+        int best = -1;
+        bool all_ended = true;
+        for (size_t i = 0; i < levels.size(); ++i) {
+            if (!levels[i].tracked || ended_[i]) {
+                continue;
+            }
+            all_ended = false;
+            if (!levels[i].filling || !parked_[i].empty()) {
+                continue;
+            }
+            if (best < 0 || levels[i].buffered_us < levels[best].buffered_us) {
+                best = static_cast<int>(i);
+            }
+        }
+        if (all_ended) {
+            input_ended_ = true;
+            return { parked_packets_ == 0 ? Decision::kEnd : Decision::kWait };
+        }
+        return best >= 0 ? Decision { Decision::kRead, best } : Decision { Decision::kWait };
+    }
+
+    Decision next_interleaved(const std::vector<StreamBufferLevels::Level>& levels) const
+    {
+        bool any_filling = false;
+        for (size_t i = 0; i < levels.size(); ++i) {
+            if (levels[i].tracked && parked_[i].empty() && levels[i].filling) {
+                any_filling = true;
+            }
+        }
+        // 有流的队列满了时，为别的流读出来的包里夹着的满了的流的包只能暂存，暂存满了就等
+        const bool room = parked_packets_ < kMaxParkedPackets && parked_bytes_ < kMaxParkedBytes;
+        return { any_filling && (parked_packets_ == 0 || room) ? Decision::kRead : Decision::kWait };
+    }
+
+    std::shared_ptr<StreamBufferLevels> levels_;
+    bool per_stream_reads_ = false;
+    std::vector<std::deque<std::pair<Packet, size_t>>> parked_ = std::vector<std::deque<std::pair<Packet, size_t>>>(1);
+    std::vector<bool> ended_;
+    size_t parked_packets_ = 0;
+    size_t parked_bytes_ = 0;
+    bool input_ended_ = false;
+};
+
+} // namespace player_utils
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace player_utils {
@@ -13,6 +15,30 @@ struct VideoFrame {
     std::vector<uint8_t> data;
     std::array<int, 8> linesize;
     double pts;
+
+    // 零拷贝帧：buffer_ref 持有解码器输出的引用（av_frame_ref），planes 直接指向解码器的缓冲区，
+    // data 为空。最后一个引用释放时缓冲区才回到解码器的 buffer pool
+    std::shared_ptr<void> buffer_ref;
+    std::array<const uint8_t*, 8> planes {};
+    size_t ref_bytes = 0;
+
+    // YUV420 的第 i 个平面，两种帧都适用
+    [[nodiscard]] const uint8_t* plane(int i) const
+    {
+        if (buffer_ref) {
+            return planes[i];
+        }
+        size_t offset = 0;
+        for (int j = 0; j < i; ++j) {
+            offset += static_cast<size_t>(linesize[j]) * plane_height(j);
+        }
+        return data.data() + offset;
+    }
+
+    [[nodiscard]] int plane_height(int i) const { return i == 0 ? height : (height + 1) / 2; }
+
+    // 这一帧占用的像素内存，用于帧队列的字节背压
+    [[nodiscard]] size_t byte_size() const { return buffer_ref ? ref_bytes : data.size(); }
 };
 
 struct AudioParams {
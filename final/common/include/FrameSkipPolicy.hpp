@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace player_utils {
+
+// 视频落后音频时钟多少秒。SyncClock 在每次同步判断时发布，视频解码线程在送包之前读
+class VideoLateness {
+public:
+    void publish(double seconds) { seconds_.store(seconds > 0.0 ? seconds : 0.0, std::memory_order_relaxed); }
+    [[nodiscard]] double get() const { return seconds_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> seconds_ { 0.0 };
+};
+
+// 视频落后时让解码器少干活的档位，解码线程独占使用。
+//
+// 渲染侧丢掉一帧时，这一帧已经完整解码、转换、进过队列了；这里在更早的地方让解码器跳过一部分帧：
+//   kNonRef: 跳过非参考帧（skip_frame / skip_loop_filter = AVDISCARD_NONREF）
+//   kBidir : 跳过所有 B 帧，非关键帧不做环路滤波
+//   kNonKey: 只解关键帧
+// 落后超过某一档的阈值时立即升到那一档；落后时间降到当前档阈值的一半以下、并且连续 calm_packets 个包
+// 都是这样才降一档，避免在两档之间来回跳。从 kBidir 及以上往下降只在关键帧上进行：h264 / hevc 在
+// AVDISCARD_BIDIR 下连参考 B 帧（b-pyramid，x265 里大部分非 I 帧）也跳过，环路滤波也只在关键帧上做，
+// 中途降档的话后面的 P / B 帧引用的是没解过或者没滤波的帧，会花屏到下一个关键帧。
+// kNonRef 跳过的帧没有人引用，降到 kNone 不用等。
+class FrameSkipPolicy {
+public:
+    enum Level : int {
+        kNone = 0,
+        kNonRef = 1,
+        kBidir = 2,
+        kNonKey = 3,
+    };
+
+    explicit FrameSkipPolicy(int calm_packets = 30)
+        : calm_packets_(calm_packets)
+    {
+    }
+
+    // 每个包调用一次，返回这个包应该用的档位
+    Level update(double lateness_sec, bool keyframe)
+    {
+        int target = kNone;
+        while (target < kNonKey && lateness_sec > kEnterSec[target + 1]) {
+            ++target;
+        }
+        if (target > level_) {
+            level_ = static_cast<Level>(target);
+            calm_ = 0;
+            ++escalations_;
+            return level_;
+        }
+        if (level_ != kNone && lateness_sec < kEnterSec[level_] / 2) {
+            if (++calm_ >= calm_packets_ && (level_ < kBidir || keyframe)) {
+                level_ = static_cast<Level>(level_ - 1);
+                calm_ = 0;
+            }
+        } else {
+            calm_ = 0;
+        }
+        return level_;
+    }
+
+    // seek 之后从头开始
+    void reset()
+    {
+        level_ = kNone;
+        calm_ = 0;
+    }
+
+    [[nodiscard]] Level level() const { return level_; }
+    [[nodiscard]] uint64_t escalations() const { return escalations_; }
+
+    // 进入各档的落后时间（秒）。kNonKey 和 SyncClock 丢帧的阈值一致：再晚的帧解出来也只会被丢掉
+    static constexpr double kEnterSec[] = { 0.0, 0.06, 0.15, 0.25 };
+
+private:
+    int calm_packets_;
+    Level level_ = kNone;
+    int calm_ = 0;
+    uint64_t escalations_ = 0;
+};
+
+} // namespace player_utils
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "AvioReader.hpp"
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace player_utils {
+
+// 边录边播：文件还在被写，读到末尾时等新数据而不是当作文件结束
+struct LiveOptions {
+    bool enabled = false;
+    // 等新数据时每次最多睡这么久；inotify 不可用时就是 fstat 轮询的间隔
+    int poll_interval_ms = 100;
+    // 文件这么久没有变长就认为录制结束，按文件结束处理。0 表示一直等到停止播放
+    int idle_timeout_ms = 10000;
+    // 播放落后写入位置超过 max_latency_ms 时，丢掉中间的包追到落后 target_latency_ms 的位置。
+    // 写入位置只对分片 mp4 算得出来，其他格式只等数据、不控制延迟
+    int target_latency_ms = 2000;
+    int max_latency_ms = 6000;
+};
+
+// 读正在被追加的本地文件。读到当前末尾时在 read 里等文件变长（inotify 的 IN_MODIFY，不可用时 fstat 轮询），
+// 所以 FFmpeg 看到的总是完整的数据，不会在 box / 包的中间读到一半就当成出错；
+// 超过 idle_timeout_ms 没有变长才返回 0（文件结束），interrupt() 之后返回 -EINTR。
+// read / seek / at_write_head / wait_for_growth 只在解复用线程里调用，interrupt 可以在任何线程调用
+class GrowingFileReader : public AvioReader {
+public:
+    GrowingFileReader(int fd, const std::string& path, const LiveOptions& options)
+        : fd_(fd)
+        , poll_interval_(std::max(options.poll_interval_ms, 1))
+        , idle_timeout_(options.idle_timeout_ms)
+        , last_growth_(std::chrono::steady_clock::now())
+    {
+        inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd_ >= 0 && inotify_add_watch(inotify_fd_, path.c_str(), IN_MODIFY | IN_CLOSE_WRITE) < 0) {
+            ::close(inotify_fd_);
+            inotify_fd_ = -1;
+        }
+        refresh();
+    }
+
+    ~GrowingFileReader() override
+    {
+        if (inotify_fd_ >= 0) {
+            ::close(inotify_fd_);
+        }
+        ::close(fd_);
+    }
+
+    GrowingFileReader(const GrowingFileReader&) = delete;
+    GrowingFileReader& operator=(const GrowingFileReader&) = delete;
+
+    int64_t read(uint8_t* dst, size_t len) override
+    {
+        bool waited = false;
+        while (true) {
+            if (pos_ < size_) {
+                const ssize_t n = pread(fd_, dst, len, static_cast<off_t>(pos_));
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    return -errno;
+                }
+                if (n > 0) {
+                    pos_ += n;
+                    stats_.bytes_read += static_cast<uint64_t>(n);
+                    return n;
+                }
+                // 文件被截短了，等它重新写到这里
+                size_ = pos_;
+            }
+            if (refresh()) {
+                continue;
+            }
+            if (interrupted_.load(std::memory_order_acquire)) {
+                return -EINTR;
+            }
+            if (finished()) {
+                return 0;
+            }
+            if (!waited) {
+                ++stats_.waits;
+                waited = true;
+            }
+            wait_for_growth();
+        }
+    }
+
+    // 可以移到当前末尾之后，读的时候等写到那里
+    int64_t seek(int64_t pos) override
+    {
+        if (pos < 0) {
+            return -EINVAL;
+        }
+        pos_ = pos;
+        return pos_;
+    }
+
+    [[nodiscard]] Stats stats() const override { return stats_; }
+
+    // 重新取一次文件大小，变长了返回 true。size() 只是上次取到的值
+    bool refresh()
+    {
+        struct stat st {};
+        if (fstat(fd_, &st) != 0 || static_cast<int64_t>(st.st_size) <= size_) {
+            return false;
+        }
+        size_ = static_cast<int64_t>(st.st_size);
+        last_growth_ = std::chrono::steady_clock::now();
+        return true;
+    }
+
+    // 读到了写入位置：再读就要等
+    [[nodiscard]] bool at_write_head()
+    {
+        if (pos_ < size_) {
+            return false;
+        }
+        refresh();
+        return pos_ >= size_;
+    }
+
+    // 超过 idle_timeout_ms 没有变长
+    [[nodiscard]] bool finished() const
+    {
+        return idle_timeout_.count() > 0 && std::chrono::steady_clock::now() - last_growth_ >= idle_timeout_;
+    }
+
+    // 等到文件变长或者过了 poll_interval_ms，返回文件有没有变长
+    bool wait_for_growth()
+    {
+        if (inotify_fd_ >= 0) {
+            // 监视从构造起一直在，fstat 之后才写进来的数据也会留下事件，poll 不会漏掉
+            pollfd pfd { inotify_fd_, POLLIN, 0 };
+            if (poll(&pfd, 1, static_cast<int>(poll_interval_.count())) > 0) {
+                alignas(inotify_event) char events[4096];
+                while (::read(inotify_fd_, events, sizeof(events)) > 0) {
+                }
+            }
+        } else {
+            std::this_thread::sleep_for(poll_interval_);
+        }
+        return refresh();
+    }
+
+    // 让阻塞在 read 里的解复用线程在 poll_interval_ms 之内返回 -EINTR；重新开始解复用之前 interrupt(false)
+    void interrupt(bool on) { interrupted_.store(on, std::memory_order_release); }
+
+    [[nodiscard]] bool uses_inotify() const { return inotify_fd_ >= 0; }
+    // 给旁路扫描（Mp4FragmentScanner）用，pread 不改文件偏移，可以共用
+    [[nodiscard]] int fd() const { return fd_; }
+
+    // 打开失败或者不是普通文件时返回 nullptr
+    static std::unique_ptr<GrowingFileReader> open(const std::string& path, const LiveOptions& options)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat st {};
+        if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+            ::close(fd);
+            return nullptr;
+        }
+        return std::make_unique<GrowingFileReader>(fd, path, options);
+    }
+
+private:
+    int fd_;
+    int inotify_fd_ = -1;
+    std::chrono::milliseconds poll_interval_;
+    std::chrono::milliseconds idle_timeout_;
+    std::chrono::steady_clock::time_point last_growth_;
+    std::atomic<bool> interrupted_ { false };
+    Stats stats_;
+};
+
+} // namespace player_utils
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace player_utils {
+
+// 视频流的关键帧表，按 pts 升序。
+//
+// 打开文件时由 MediaSource 从 AVStream 的索引（mp4 的 stss / stts）建好，索引为空时扫一遍包。
+// seek 的时候先在这里二分找到目标之前的关键帧，知道 av_seek_frame 会落在哪、精确 seek 要追多少帧；
+// UI 拖进度条时可以用 snap() 吸附到关键帧上，这些位置 seek 不需要追帧。
+//
+// 可以存成一个小的旁路文件（save / load），下次打开同一个文件时不用再扫描。
+class KeyframeIndex {
+public:
+    struct Entry {
+        // 流的 time_base。取自 AVIndexEntry::timestamp，mov 里是解码时间戳，
+        // 和 av_seek_frame 用的是同一套，有 B 帧时比显示时间戳早几帧
+        int64_t pts = 0;
+        int64_t pos = -1; // 在文件里的字节偏移，-1 表示未知
+        int32_t frames = 0; // 这个 GOP 的帧数（含关键帧本身），0 表示未知
+    };
+
+    KeyframeIndex() = default;
+
+    KeyframeIndex(std::vector<Entry> entries, int time_base_num, int time_base_den)
+        : entries_(std::move(entries))
+        , tb_num_(time_base_num)
+        , tb_den_(time_base_den)
+    {
+        std::sort(entries_.begin(), entries_.end(),
+            [](const Entry& a, const Entry& b) { return a.pts < b.pts; });
+    }
+
+    [[nodiscard]] bool empty() const { return entries_.empty(); }
+    [[nodiscard]] size_t size() const { return entries_.size(); }
+    [[nodiscard]] const std::vector<Entry>& entries() const { return entries_; }
+
+    [[nodiscard]] double to_seconds(int64_t pts) const
+    {
+        return tb_den_ != 0 ? static_cast<double>(pts) * tb_num_ / tb_den_ : 0.0;
+    }
+    // 和 Demuxer::SeekTo 一样截断
+    [[nodiscard]] int64_t to_pts(double seconds) const
+    {
+        return tb_num_ != 0 ? static_cast<int64_t>(seconds * tb_den_ / tb_num_) : 0;
+    }
+
+    // pts 之前（含）最近的关键帧，没有返回 nullptr
+    [[nodiscard]] const Entry* at_or_before(int64_t pts) const
+    {
+        auto it = std::upper_bound(entries_.begin(), entries_.end(), pts,
+            [](int64_t value, const Entry& e) { return value < e.pts; });
+        return it == entries_.begin() ? nullptr : &*(it - 1);
+    }
+
+    // pts 之后（含）最近的关键帧，没有返回 nullptr
+    [[nodiscard]] const Entry* at_or_after(int64_t pts) const
+    {
+        auto it = std::lower_bound(entries_.begin(), entries_.end(), pts,
+            [](const Entry& e, int64_t value) { return e.pts < value; });
+        return it == entries_.end() ? nullptr : &*it;
+    }
+
+    // 离 seconds 最近的关键帧时刻；表为空时原样返回
+    [[nodiscard]] double snap(double seconds) const
+    {
+        const int64_t pts = to_pts(seconds);
+        const Entry* before = at_or_before(pts);
+        const Entry* after = at_or_after(pts);
+        if (before == nullptr && after == nullptr) {
+            return seconds;
+        }
+        if (before == nullptr || (after != nullptr && after->pts - pts < pts - before->pts)) {
+            return to_seconds(after->pts);
+        }
+        return to_seconds(before->pts);
+    }
+
+    // 从 pts 之前的关键帧解到 pts 大约要解多少帧（不含关键帧本身）。
+    // GOP 帧数已知时按 GOP 内均匀分布估计；表为空或者 GOP 帧数未知时返回 -1
+    [[nodiscard]] int catch_up_frames(int64_t pts) const
+    {
+        const Entry* key = at_or_before(pts);
+        if (key == nullptr || key->frames <= 0) {
+            return -1;
+        }
+        if (pts == key->pts) {
+            return 0;
+        }
+        const Entry* next = key + 1 != entries_.data() + entries_.size() ? key + 1 : nullptr;
+        if (next == nullptr || next->pts <= key->pts) {
+            return key->frames - 1;
+        }
+        const double fraction = static_cast<double>(pts - key->pts) / static_cast<double>(next->pts - key->pts);
+        return std::min(key->frames - 1, static_cast<int>(std::ceil(fraction * key->frames)));
+    }
+
+    // 按解码顺序逐个样本建表：关键帧开一个新 GOP，非关键帧计入当前 GOP。
+    // 有的样本来源只列关键帧（不少 demuxer 的 AVStream 索引就是这样），一个非关键帧都没见到时
+    // GOP 帧数是未知的，记 0 而不是 1，否则 catch_up_frames 会当成全是关键帧、精确 seek 不追帧
+    class Builder {
+    public:
+        // lists_every_sample: 来源保证列出每一个样本（比如扫包），全是关键帧就真的是全 I 帧
+        explicit Builder(bool lists_every_sample)
+            : lists_every_sample_(lists_every_sample)
+        {
+        }
+
+        void add(int64_t pts, int64_t pos, bool keyframe)
+        {
+            if (keyframe) {
+                entries_.push_back({ pts, pos, 1 });
+                return;
+            }
+            saw_non_key_ = true;
+            if (!entries_.empty()) {
+                ++entries_.back().frames;
+            }
+        }
+
+        [[nodiscard]] bool empty() const { return entries_.empty(); }
+
+        KeyframeIndex build(int time_base_num, int time_base_den)
+        {
+            if (!lists_every_sample_ && !saw_non_key_) {
+                for (Entry& e : entries_) {
+                    e.frames = 0;
+                }
+            }
+            return KeyframeIndex(std::move(entries_), time_base_num, time_base_den);
+        }
+
+    private:
+        bool lists_every_sample_;
+        bool saw_non_key_ = false;
+        std::vector<Entry> entries_;
+    };
+
+    // --- 旁路文件 ---
+    // source_size / source_mtime_ns 是源文件的字节数和修改时间，load 时任何一个对不上说明文件变了，表作废。
+    // 只看大小的话，原地重新编码成同样大小的文件（比如固定码率录制覆盖）会读到旧表
+
+    bool save(std::ostream& out, int64_t source_size, int64_t source_mtime_ns) const
+    {
+        const uint32_t count = static_cast<uint32_t>(entries_.size());
+        out.write(kMagic, sizeof(kMagic));
+        write_pod(out, source_size);
+        write_pod(out, source_mtime_ns);
+        write_pod(out, static_cast<int32_t>(tb_num_));
+        write_pod(out, static_cast<int32_t>(tb_den_));
+        write_pod(out, count);
+        for (const Entry& e : entries_) {
+            write_pod(out, e.pts);
+            write_pod(out, e.pos);
+            write_pod(out, e.frames);
+        }
+        return static_cast<bool>(out);
+    }
+
+    static bool load(std::istream& in, int64_t source_size, int64_t source_mtime_ns, KeyframeIndex& index)
+    {
+        char magic[sizeof(kMagic)] = {};
+        int64_t size = 0;
+        int64_t mtime_ns = 0;
+        int32_t num = 0;
+        int32_t den = 0;
+        uint32_t count = 0;
+        in.read(magic, sizeof(magic));
+        if (!in || std::memcmp(magic, kMagic, sizeof(kMagic)) != 0) {
+            return false;
+        }
+        if (!read_pod(in, size) || !read_pod(in, mtime_ns) || !read_pod(in, num) || !read_pod(in, den) || !read_pod(in, count)) {
+            return false;
+        }
+        if (size != source_size || mtime_ns != source_mtime_ns || den == 0 || count > kMaxEntries) {
+            return false;
+        }
+        std::vector<Entry> entries(count);
+        for (Entry& e : entries) {
+            if (!read_pod(in, e.pts) || !read_pod(in, e.pos) || !read_pod(in, e.frames)) {
+                return false;
+            }
+        }
+        index = KeyframeIndex(std::move(entries), num, den);
+        return true;
+    }
+
+    bool save_to_file(const std::string& path, int64_t source_size, int64_t source_mtime_ns) const
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        return out && save(out, source_size, source_mtime_ns);
+    }
+
+    static bool load_from_file(const std::string& path, int64_t source_size, int64_t source_mtime_ns, KeyframeIndex& index)
+    {
+        std::ifstream in(path, std::ios::binary);
+        return in && load(in, source_size, source_mtime_ns, index);
+    }
+
+private:
+    // 2：头里加了源文件的修改时间，旧格式的旁路文件直接作废重建
+    static constexpr char kMagic[4] = { 'K', 'F', 'I', '2' };
+    // 防止坏文件让 load 申请一大块内存；一天长的 1 秒 GOP 视频也才 86400 项
+    static constexpr uint32_t kMaxEntries = 1U << 22;
+
+    template <typename T>
+    static void write_pod(std::ostream& out, T value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    template <typename T>
+    static bool read_pod(std::istream& in, T& value)
+    {
+        in.read(reinterpret_cast<char*>(&value), sizeof(value));
+        return static_cast<bool>(in);
+    }
+
+    std::vector<Entry> entries_;
+    int tb_num_ = 0;
+    int tb_den_ = 1;
+};
+
+} // namespace player_utils
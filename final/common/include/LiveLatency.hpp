@@ -0,0 +1,101 @@
+#pragma once
+
+#include "GrowingFileReader.hpp"
+#include <cstdint>
+
+namespace player_utils {
+
+// 边录边播时控制播放落后写入位置多少。解复用器每读一批包之前告诉它写入位置（已经完整写出的最后时刻）
+// 和包队列里缓冲的时长，每读到一个包问它要不要丢：
+//   落后 = 写入位置 - 刚读到的包的时刻 + 已经缓冲的时长
+// 超过 max_latency_ms 就开始追：丢包直到 写入位置 - target_latency_ms 之后的第一个视频关键帧，
+// 从那个关键帧起恢复，之前的音频包也丢掉，音视频在同一时刻接上；没有视频时从第一个够得着的音频包恢复。
+// 追的时候解码器看到的只是时间戳往前跳了一段，不用 flush。
+// 用户 seek 回录好的部分（时移）之后不再追，播放重新赶到 target_latency_ms 以内才恢复控制
+class LiveLatency {
+public:
+    LiveLatency() = default;
+    LiveLatency(const LiveOptions& options, bool has_video)
+        : target_sec_(options.target_latency_ms / 1000.0)
+        , max_sec_(options.max_latency_ms / 1000.0)
+        , has_video_(has_video)
+        , enabled_(options.enabled && options.max_latency_ms > 0)
+    {
+    }
+
+    // edge_sec < 0 表示写入位置未知（不是分片 mp4，或者还没有写完一个分片），此时不控制
+    void update(double edge_sec, double buffered_sec)
+    {
+        edge_sec_ = edge_sec;
+        buffered_sec_ = buffered_sec;
+    }
+
+    // 刚读到的包要不要丢掉
+    bool should_drop(bool video, bool keyframe, double pts_sec)
+    {
+        if (!enabled_) {
+            return false;
+        }
+        if (catching_up_) {
+            const bool can_resume = has_video_ ? (video && keyframe) : !video;
+            if (!can_resume || pts_sec < skip_to_sec_) {
+                return true;
+            }
+            catching_up_ = false;
+            audio_floor_sec_ = video ? pts_sec : -1.0;
+            return false;
+        }
+        // 交错的顺序里关键帧之后还会读到时刻在它之前的音频包，也要丢掉
+        if (audio_floor_sec_ >= 0.0 && !video) {
+            if (pts_sec < audio_floor_sec_) {
+                return true;
+            }
+            audio_floor_sec_ = -1.0;
+        }
+        if (edge_sec_ < 0.0) {
+            return false;
+        }
+        latency_sec_ = edge_sec_ - pts_sec + buffered_sec_;
+        if (!armed_) {
+            armed_ = latency_sec_ <= target_sec_;
+            return false;
+        }
+        if (latency_sec_ > max_sec_) {
+            catching_up_ = true;
+            skip_to_sec_ = edge_sec_ - target_sec_;
+            ++catch_ups_;
+            return true;
+        }
+        return false;
+    }
+
+    // 用户 seek 之后调用：之前的追赶作废，赶到目标延迟以内之前不再追
+    void on_seek()
+    {
+        catching_up_ = false;
+        audio_floor_sec_ = -1.0;
+        armed_ = false;
+    }
+
+    [[nodiscard]] bool catching_up() const { return catching_up_; }
+    // 最近一次算出来的落后时长（秒），写入位置未知时不更新
+    [[nodiscard]] double latency_sec() const { return latency_sec_; }
+    [[nodiscard]] uint64_t catch_ups() const { return catch_ups_; }
+
+private:
+    double target_sec_ = 0.0;
+    double max_sec_ = 0.0;
+    bool has_video_ = false;
+    bool enabled_ = false;
+
+    double edge_sec_ = -1.0;
+    double buffered_sec_ = 0.0;
+    double latency_sec_ = 0.0;
+    bool armed_ = true;
+    bool catching_up_ = false;
+    double skip_to_sec_ = 0.0;
+    double audio_floor_sec_ = -1.0;
+    uint64_t catch_ups_ = 0;
+};
+
+} // namespace player_utils
@@ -0,0 +1,378 @@
+#pragma once
+
+#include "AvioReader.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace player_utils {
+
+// 本地文件怎么读。MediaSource 据此决定要不要自己装一个 AVIOContext
+struct FileIoOptions {
+    enum class Mode {
+        Default, // 交给 FFmpeg 的 file 协议，每次 read() 几十 KB
+        Mmap, // 整个文件映射进来，按读取位置提前 madvise(WILLNEED)
+        ReadAhead, // 后台线程按大块 pread 到对齐的缓冲区里，解复用只做内存拷贝
+    };
+
+    Mode mode = Mode::Default;
+    // ReadAhead：每块多大、最多提前读几块。Mmap：每次提前 WILLNEED 的范围是两者之积
+    size_t chunk_size = 1024 * 1024;
+    size_t chunks = 8;
+};
+
+// 本地文件的读取（mmap / 后台预读），都从 open 造出来，背后是一个普通文件的 fd
+class LocalFileReader : public AvioReader {
+public:
+    // 打开失败（或者 mode 为 Default）返回 nullptr，调用方退回 FFmpeg 自己的 file 协议
+    static std::unique_ptr<LocalFileReader> open(const std::string& path, const FileIoOptions& options);
+};
+
+// 整个文件 mmap 进来，读就是 memcpy。冷缓存时缺页由内核同步读盘，所以读到窗口边上时
+// 对下一个窗口 madvise(WILLNEED)，让内核提前异步读；seek 之后从新位置重新开始提示
+class MappedFileReader : public LocalFileReader {
+public:
+    MappedFileReader(int fd, int64_t size, const FileIoOptions& options)
+        : window_(std::max<size_t>(options.chunk_size * std::max<size_t>(options.chunks, 1), static_cast<size_t>(page_size())))
+    {
+        size_ = size;
+        if (size_ > 0) {
+            void* addr = mmap(nullptr, static_cast<size_t>(size_), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr != MAP_FAILED) {
+                data_ = static_cast<const uint8_t*>(addr);
+                madvise(const_cast<uint8_t*>(data_), static_cast<size_t>(size_), MADV_SEQUENTIAL);
+                advise(0);
+            }
+        }
+        ::close(fd);
+    }
+
+    ~MappedFileReader() override
+    {
+        if (data_ != nullptr) {
+            munmap(const_cast<uint8_t*>(data_), static_cast<size_t>(size_));
+        }
+    }
+
+    MappedFileReader(const MappedFileReader&) = delete;
+    MappedFileReader& operator=(const MappedFileReader&) = delete;
+
+    // 32 位进程映射大文件可能失败（地址空间不够），此时 open() 改用 ReadAhead
+    [[nodiscard]] bool mapped() const { return data_ != nullptr || size_ == 0; }
+
+    int64_t read(uint8_t* dst, size_t len) override
+    {
+        if (pos_ >= size_) {
+            return 0;
+        }
+        const size_t n = static_cast<size_t>(std::min<int64_t>(static_cast<int64_t>(len), size_ - pos_));
+        // 读过提示范围的一半就提示下一个窗口，内核读盘和这里的拷贝重叠起来
+        if (advised_end_ < size_ && pos_ + static_cast<int64_t>(n + window_ / 2) > advised_end_) {
+            advise(advised_end_);
+        }
+        std::memcpy(dst, data_ + pos_, n);
+        pos_ += static_cast<int64_t>(n);
+        stats_.bytes_read += n;
+        return static_cast<int64_t>(n);
+    }
+
+    int64_t seek(int64_t pos) override
+    {
+        if (pos < 0) {
+            return -EINVAL;
+        }
+        pos_ = pos;
+        if (pos_ < advised_begin_ || pos_ >= advised_end_) {
+            ++stats_.refills;
+            advised_begin_ = align_down(pos_);
+            advise(advised_begin_);
+        }
+        return pos_;
+    }
+
+    [[nodiscard]] Stats stats() const override { return stats_; }
+
+private:
+    static int64_t page_size()
+    {
+        const long page = sysconf(_SC_PAGESIZE);
+        return page > 0 ? page : 4096;
+    }
+
+    static int64_t align_down(int64_t pos) { return pos / page_size() * page_size(); }
+
+    // 对 [begin, begin + window) 提示 WILLNEED，begin 按页对齐
+    void advise(int64_t begin)
+    {
+        begin = align_down(begin);
+        const int64_t end = std::min<int64_t>(begin + static_cast<int64_t>(window_), size_);
+        if (begin < end) {
+            madvise(const_cast<uint8_t*>(data_) + begin, static_cast<size_t>(end - begin), MADV_WILLNEED);
+        }
+        advised_end_ = std::max(begin, end);
+    }
+
+    const uint8_t* data_ = nullptr;
+    size_t window_;
+    int64_t advised_begin_ = 0;
+    int64_t advised_end_ = 0;
+    Stats stats_;
+};
+
+// 后台线程按 chunk_size 对齐地 pread 到 chunks 块对齐的缓冲区里，始终领先读取位置 chunks 块。
+// 解复用线程读的时候只是在锁里 memcpy，慢盘 / FUSE 上 read() 的停顿由后台线程承担。
+// 块 k 放在槽 (k / chunk_size) % chunks；seek 到窗口之外时整个窗口从新位置重来，
+// 正在进行的那次 pread 读完之后作废
+class ReadAheadFileReader : public LocalFileReader {
+public:
+    ReadAheadFileReader(int fd, int64_t size, const FileIoOptions& options)
+        : fd_(fd)
+        , chunk_size_(align_up(std::max<size_t>(options.chunk_size, kAlignment), kAlignment))
+        , slots_(std::max<size_t>(options.chunks, 2))
+    {
+        size_ = size;
+        for (Slot& slot : slots_) {
+            void* buffer = nullptr;
+            if (posix_memalign(&buffer, kAlignment, chunk_size_) != 0) {
+                buffer = nullptr;
+            }
+            slot.data.reset(static_cast<uint8_t*>(buffer));
+        }
+        posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+        filler_ = std::thread(&ReadAheadFileReader::fill_loop, this);
+    }
+
+    ~ReadAheadFileReader() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        filler_.join();
+        ::close(fd_);
+    }
+
+    ReadAheadFileReader(const ReadAheadFileReader&) = delete;
+    ReadAheadFileReader& operator=(const ReadAheadFileReader&) = delete;
+
+    [[nodiscard]] bool ready() const
+    {
+        return std::all_of(slots_.begin(), slots_.end(), [](const Slot& s) { return s.data != nullptr; });
+    }
+
+    int64_t read(uint8_t* dst, size_t len) override
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (pos_ >= size_) {
+            return 0;
+        }
+        const int64_t chunk = chunk_begin(pos_);
+        Slot& slot = slot_for(chunk);
+        if (!(slot.offset == chunk && slot.filled)) {
+            ++stats_.waits;
+            cv_.wait(lock, [&] { return stop_ || (slot.offset == chunk && slot.filled); });
+            if (stop_) {
+                return -EIO;
+            }
+        }
+        if (slot.error != 0) {
+            return -slot.error;
+        }
+
+        const int64_t in_chunk = pos_ - chunk;
+        const size_t available = slot.length > static_cast<size_t>(in_chunk) ? slot.length - static_cast<size_t>(in_chunk) : 0;
+        if (available == 0) {
+            return 0; // 文件在打开之后被截短了
+        }
+        const size_t n = std::min(len, available);
+        std::memcpy(dst, slot.data.get() + in_chunk, n);
+        pos_ += static_cast<int64_t>(n);
+        stats_.bytes_read += n;
+        // 读完一整块，这个槽可以拿去读窗口最前面的那块了
+        if (chunk_begin(pos_) != chunk) {
+            lock.unlock();
+            cv_.notify_all();
+        }
+        return static_cast<int64_t>(n);
+    }
+
+    int64_t seek(int64_t pos) override
+    {
+        if (pos < 0) {
+            return -EINVAL;
+        }
+        bool refill = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pos_ = pos;
+            const int64_t chunk = chunk_begin(pos_);
+            // 新位置所在的块已经读好或者正在读，窗口不用动：后面的块会随读取位置前移自然补上。
+            // 槽是循环用的，往回 seek 时那块可能已经被更靠后的块覆盖了
+            if (pos_ < size_ && slot_for(chunk).offset != chunk) {
+                ++generation_;
+                ++stats_.refills;
+                for (Slot& slot : slots_) {
+                    slot.offset = -1;
+                    slot.filled = false;
+                }
+                next_fill_ = chunk;
+                refill = true;
+            }
+        }
+        if (refill) {
+            // 在后台线程赶到之前先让内核开始读
+            posix_fadvise(fd_, chunk_begin(pos), static_cast<off_t>(chunk_size_ * slots_.size()), POSIX_FADV_WILLNEED);
+            cv_.notify_all();
+        }
+        return pos;
+    }
+
+    [[nodiscard]] Stats stats() const override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    static constexpr size_t kAlignment = 4096;
+
+    struct FreeDeleter {
+        void operator()(uint8_t* p) const { std::free(p); }
+    };
+
+    struct Slot {
+        std::unique_ptr<uint8_t, FreeDeleter> data;
+        int64_t offset = -1; // 这个槽装的是文件里哪一块
+        size_t length = 0;
+        bool filled = false;
+        int error = 0;
+    };
+
+    static size_t align_up(size_t n, size_t a) { return (n + a - 1) / a * a; }
+
+    [[nodiscard]] int64_t chunk_begin(int64_t pos) const
+    {
+        return pos / static_cast<int64_t>(chunk_size_) * static_cast<int64_t>(chunk_size_);
+    }
+
+    Slot& slot_for(int64_t chunk)
+    {
+        return slots_[static_cast<size_t>(chunk / static_cast<int64_t>(chunk_size_)) % slots_.size()];
+    }
+
+    // 窗口 [读取位置所在块, 往后 chunks 块) 里还有没读的块
+    [[nodiscard]] bool can_fill() const
+    {
+        const int64_t window_end = chunk_begin(pos_) + static_cast<int64_t>(chunk_size_ * slots_.size());
+        return next_fill_ < size_ && next_fill_ < window_end;
+    }
+
+    void fill_loop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            cv_.wait(lock, [this] { return stop_ || can_fill(); });
+            if (stop_) {
+                return;
+            }
+            const int64_t offset = next_fill_;
+            const uint64_t generation = generation_;
+            next_fill_ += static_cast<int64_t>(chunk_size_);
+            Slot& slot = slot_for(offset);
+            slot.offset = offset;
+            slot.filled = false;
+            lock.unlock();
+
+            // 这个槽不在读取位置所在的块上，读线程不会碰它，可以不持锁地写
+            size_t length = 0;
+            int error = 0;
+            while (length < chunk_size_) {
+                const ssize_t n = pread(fd_, slot.data.get() + length, chunk_size_ - length, static_cast<off_t>(offset + static_cast<int64_t>(length)));
+                if (n < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    error = errno;
+                    break;
+                }
+                if (n == 0) {
+                    break;
+                }
+                length += static_cast<size_t>(n);
+            }
+            // 提示内核把窗口之后的下一块也读起来
+            posix_fadvise(fd_, static_cast<off_t>(offset + static_cast<int64_t>(chunk_size_ * slots_.size())),
+                static_cast<off_t>(chunk_size_), POSIX_FADV_WILLNEED);
+
+            lock.lock();
+            if (generation != generation_) {
+                continue; // seek 过了，这块作废（seek 时已经把槽标成了空）
+            }
+            slot.length = length;
+            slot.error = error;
+            slot.filled = true;
+            cv_.notify_all();
+        }
+    }
+
+    int fd_;
+    size_t chunk_size_;
+    std::vector<Slot> slots_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    int64_t next_fill_ = 0;
+    uint64_t generation_ = 0;
+    bool stop_ = false;
+    Stats stats_;
+    std::thread filler_;
+};
+
+inline std::unique_ptr<LocalFileReader> LocalFileReader::open(const std::string& path, const FileIoOptions& options)
+{
+    if (options.mode == FileIoOptions::Mode::Default) {
+        return nullptr;
+    }
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    if (options.mode == FileIoOptions::Mode::Mmap) {
+        const int mapped_fd = dup(fd);
+        if (mapped_fd >= 0) {
+            auto mapped = std::make_unique<MappedFileReader>(mapped_fd, static_cast<int64_t>(st.st_size), options);
+            if (mapped->mapped()) {
+                ::close(fd);
+                return mapped;
+            }
+        }
+    }
+    auto reader = std::make_unique<ReadAheadFileReader>(fd, static_cast<int64_t>(st.st_size), options);
+    if (!reader->ready()) {
+        return nullptr;
+    }
+    return reader;
+}
+
+} // namespace player_utils
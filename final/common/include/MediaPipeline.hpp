@@ -3,11 +3,29 @@
 #include "Entitys.hpp"
 #include "GLRenderHost.hpp"
 #include "Mp4Parser.hpp"
+#include "PcmRingBuffer.hpp"
+#include "QueueStats.hpp"
+#include "VideoFramePool.hpp"
 #include "SemQueue.hpp"
 #include <aaudio/AAudio.h>
 #include <android/log.h>
 #include <android/native_window.h>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <mutex>
+
+// 各级队列的统计快照，用来判断卡顿时是哪一级跟不上
+struct PipelineStats {
+    player_utils::QueueStatsSnapshot video_packets;
+    player_utils::QueueStatsSnapshot audio_packets;
+    player_utils::QueueStatsSnapshot video_frames;
+    size_t audio_ring_frames = 0;
+    uint64_t audio_ring_underruns = 0;
+    player_utils::VideoFramePool::Stats video_frame_pool;
+    // 包队列里各个流缓冲的时长，不受 collect_queue_stats 影响
+    mp4parser::BufferLevels buffer_levels;
+};
 
 class MediaPipeline {
 public:
@@ -24,10 +42,40 @@ public:
 
     [[nodiscard]] player_utils::AudioParams getAudioParams() const;
     [[nodiscard]] double getDuration() const;
+    [[nodiscard]] double snapToKeyframe(double position) const;
+    [[nodiscard]] std::vector<player_utils::TrackInfo> getTracks() const;
+    bool selectAudioTrack(int track_id);
+    [[nodiscard]] PipelineStats getStats() const;
+
+    // 解码出来的视频帧从这里进帧队列。有 Config::executor 时不阻塞：放不下的帧先留在这里，
+    // videoOutputReady() 把它们补进队列，补不完就返回 false 让解码任务挂起，帧队列腾出空位时
+    // 用 setVideoOutputWaker 交进来的唤醒函数叫醒它。解码任务每送一个包之前都先问 videoOutputReady()，
+    // 所以留在这里的最多是一个包解出来的几帧。没有 executor 时照旧阻塞在 push 上。
+    // 帧队列已经 shutdown 时返回 false
+    bool offerVideoFrame(std::shared_ptr<player_utils::VideoFrame> frame);
+    bool videoOutputReady();
+    void setVideoOutputWaker(std::function<void()> wake);
+    // seek 清空帧队列时一起丢掉还没进队列的帧，只在解码任务空闲时调用
+    void dropPendingVideoFrames();
 
     std::unique_ptr<mp4parser::Mp4Parser> parser_;
     std::unique_ptr<render_utils::GLRenderHost> video_render_;
     std::unique_ptr<AAudioRender> audio_render_;
     std::unique_ptr<player_utils::SemQueue<std::shared_ptr<player_utils::VideoFrame>>> video_frame_queue_;
-    std::unique_ptr<player_utils::SemQueue<std::shared_ptr<player_utils::AudioFrame>>> audio_frame_queue_;
+    // 音频解码线程写、AAudio 回调读，在 initialize 拿到音频参数之后创建
+    std::unique_ptr<player_utils::PcmRingBuffer> audio_ring_;
+    // 解码线程从这里取帧，帧在渲染线程释放最后一个引用时自动回到池里
+    std::shared_ptr<player_utils::VideoFramePool> video_frame_pool_;
+
+private:
+    void logStats() const;
+    void wakeVideoOutput();
+    bool collect_stats_ = false;
+
+    bool nonblocking_video_output_ = false;
+    std::mutex pending_video_mutex_;
+    std::deque<std::shared_ptr<player_utils::VideoFrame>> pending_video_frames_; // pending_video_mutex_ 保护
+    // 帧队列的 on_writable 在渲染线程上调用，解码任务在 seek 重建时换新的唤醒函数
+    std::mutex video_waker_mutex_;
+    std::function<void()> video_output_wake_; // video_waker_mutex_ 保护
 };
\ No newline at end of file
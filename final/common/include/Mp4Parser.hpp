@@ -1,11 +1,25 @@
 #pragma once
 #include "AudioFrame.hpp"
+#include "DecodeThreading.hpp"
+#include "DemuxScheduler.hpp"
 #include "Entitys.hpp"
+#include "FrameSkipPolicy.hpp"
+#include "GrowingFileReader.hpp"
+#include "KeyframeIndex.hpp"
+#include "LocalFileReader.hpp"
+#include "QueueStats.hpp"
+#include "RemoteFileReader.hpp"
+#include "StreamInfoCache.hpp"
+#include "TaskExecutor.hpp"
+#include "TrackSelection.hpp"
+#include "VideoFramePool.hpp"
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <future>
 #include <memory>
 #include <string>
+#include <vector>
 
 struct AVFrame;
 
@@ -27,6 +41,84 @@ struct Config {
     std::string file_path;
     int max_packet_queue_size = 300;
     int max_audio_packet_queue_size = 600;
+
+    // 个数上限之外再按字节 / 时长做背压，0 表示只按个数限制。
+    // 这样 4K 和 480p 占用的内存差不多，音频缓冲也总是固定的毫秒数
+    size_t max_video_packet_bytes = 16 * 1024 * 1024;
+    int max_audio_packet_ms = 2000;
+
+    int max_video_frame_queue_size = 30;
+    size_t max_video_frame_bytes = 64 * 1024 * 1024;
+    // 解码后的音频直接写进 PCM 环形缓冲区，这里是它的长度
+    int max_audio_frame_ms = 500;
+
+    // 视频帧从这个池里取，为空时每帧单独分配
+    std::shared_ptr<player_utils::VideoFramePool> video_frame_pool;
+    // 视频帧直接引用解码器输出而不复制像素（此时 video_frame_pool 不再使用）。
+    // 帧队列里的每一帧都占着解码器的一块缓冲区，所以内存上限仍由 max_video_frame_bytes 决定
+    bool zero_copy_video_frames = true;
+    // 精确 seek：从关键帧解码到目标时刻，之前的帧直接丢掉（不转换、不进队列），
+    // 第一帧就是目标时刻该显示的那一帧。关掉则停在目标之前最近的关键帧上
+    bool accurate_seek = true;
+    // 按关键帧表估计，要追的帧数超过这个值时退回关键帧 seek，0 表示不限制
+    int max_accurate_seek_frames = 0;
+    // 关键帧表的旁路文件（一般放在应用的 cache 目录），为空时不读也不写
+    std::string keyframe_index_path;
+    // 本地文件的读取方式。慢 eMMC / FUSE 上 FFmpeg 的小块 read() 会卡住解复用，
+    // 可以换成 mmap 或者后台大块预读；content:// 等非本地路径总是走 FFmpeg 自己的协议
+    player_utils::FileIoOptions file_io;
+    // 快速打开：限制探测量，mp4 头里参数齐全时不再 avformat_find_stream_info，探测结果按文件缓存
+    player_utils::FastOpenOptions fast_open;
+    // 本地 mp4 用自己解析的样本表 + pread 读包，绕过 av_read_frame 的 AVIOContext 拷贝和逐包的探测逻辑。
+    // 样本表和 FFmpeg 对不上时自动退回 av_read_frame
+    bool native_mp4_demux = false;
+    // 每个流在包队列里缓冲时长的上下限。某个流涨到高水位后解复用器不再为它读，掉到低水位以下再补；
+    // 视频队列满了时解复用器接着给音频读包，慢的视频解码不会拖得音频断流
+    player_utils::BufferWatermarks video_watermarks { 1000000, 4000000 };
+    player_utils::BufferWatermarks audio_watermarks { 500000, 1500000 };
+    // 要播的视频 / 音频 / 字幕轨道（按容器里的轨道 id），没选中的流解复用时直接跳过。
+    // 音轨和字幕播放中可以用 Mp4Parser::selectAudioTrack / selectSubtitleTrack 换
+    player_utils::TrackSelection tracks;
+    // 边录边播：文件还在被写（分片 mp4 或者其他能顺序读的格式），读到末尾等新数据，
+    // 录制停下超过 idle_timeout_ms 才算播完；分片 mp4 还把播放控制在写入位置之后 target_latency_ms 左右。
+    // 打开后不建关键帧表、不用样本表解复用，file_io 也不起作用
+    player_utils::LiveOptions live;
+    // file_path 是 lab06://host:port/path 时从 lab06 文件服务器读：按块区间请求、多连接并行预读，支持 seek
+    player_utils::RemoteOptions remote;
+
+    // 解码线程策略，音频解码器总是单线程。默认按分辨率选帧级多线程；
+    // 对首帧 / seek 延迟敏感时打开 low_delay 改用片级多线程
+    player_utils::DecodeThreading decode_threading;
+
+    // 渲染侧发布的视频落后时间（SyncClock::lateness()）。视频解码器据此跳过非参考帧 / B 帧 / 非关键帧，
+    // 而不是解码完再在同步环节丢掉。为空时不跳帧
+    std::shared_ptr<const player_utils::VideoLateness> video_lateness;
+
+    // 多个播放器共用的工作线程。设置之后解复用和解码不再各开一个线程，而是作为任务跑在上面，
+    // 输入空了 / 输出满了就让出工作线程。为空时保持每个组件一个线程
+    std::shared_ptr<player_utils::TaskExecutor> executor;
+
+    // 给包队列 / 帧队列打开 QueueTelemetry 统计，通过 MediaPipeline::getStats() 读取
+    bool collect_queue_stats = false;
+};
+
+struct PacketQueueStats {
+    player_utils::QueueStatsSnapshot video;
+    player_utils::QueueStatsSnapshot audio;
+};
+
+// 各个流当前缓冲了多久，没有这个流时 tracked 为 false
+struct BufferLevels {
+    player_utils::StreamBufferLevels::Level video;
+    player_utils::StreamBufferLevels::Level audio;
+};
+
+// 字幕包原样交出去（播放器不解码字幕）。mp4 的 mov_text 是 2 字节大端长度 + UTF-8 文本
+struct SubtitlePacket {
+    int track_id = -1;
+    double pts_sec = 0.0;
+    double duration_sec = 0.0;
+    std::vector<uint8_t> data;
 };
 
 struct Callbacks {
@@ -35,6 +127,18 @@ struct Callbacks {
     std::function<void(PlayerState& state)> on_state_changed;
     std::function<void(const std::string& msg)> on_error;
     std::function<void()> on_playback_finished;
+    // seek 时在控制线程上调用：解码器已经 flush、解复用还没重新开始，
+    // 这时清空下游的帧队列不会丢掉 seek 之后的帧，也不会混进 seek 之前的帧
+    std::function<void()> on_seek_flushed;
+    // 只在 Config::executor 下使用：下游还能不能再接收一帧。返回 false 时解码任务让出工作线程，
+    // 过几毫秒再来看，而不是在 on_*_frame_decoded 里阻塞。为空时总是认为能接收
+    std::function<bool()> video_output_ready;
+    std::function<bool()> audio_output_ready;
+    // 只在 Config::executor 下使用：每次启动视频解码任务（包括 seek 时重建）都把它的唤醒函数交给这里。
+    // 设置了它，video_output_ready 为 false 时解码任务挂起、不再轮询，下游腾出空间时要调用收到的唤醒函数
+    std::function<void(std::function<void()> wake)> on_video_output_waker;
+    // 选了字幕轨时在解复用线程上调用，按读到的顺序，会比播放进度提前几秒
+    std::function<void(const SubtitlePacket&)> on_subtitle_packet;
 };
 
 class Mp4Parser {
@@ -47,8 +151,25 @@ public:
     void seek(double time_sec, std::shared_ptr<std::promise<void>> promise);
 
     double get_duration();
+    // 视频流的关键帧表（打开文件时建好），UI 拖进度条时可以用来吸附到 seek 代价小的位置
+    [[nodiscard]] const player_utils::KeyframeIndex& getKeyframeIndex() const;
+    // 离 time_sec 最近的关键帧时刻，没有关键帧表时原样返回
+    [[nodiscard]] double snapToKeyframe(double time_sec) const;
     [[nodiscard]] player_utils::AudioParams getAudioParams() const;
+    // 音频解码输出直接转换成这个采样率 / 声道数（AAudio 流实际打开的参数），0 表示跟随源。
+    // 需要在 start() 之前调用
+    void setAudioOutputParams(const player_utils::AudioParams& params);
     [[nodiscard]] PlayerState get_state() const;
+    // 没有打开 Config::collect_queue_stats 时全为 0
+    [[nodiscard]] PacketQueueStats getPacketQueueStats() const;
+    // 解复用按流调度用的缓冲时长，没有 start() 时全为 0
+    [[nodiscard]] BufferLevels getBufferLevels() const;
+    // 容器里所有的轨道
+    [[nodiscard]] std::vector<player_utils::TrackInfo> getTracks() const;
+    // 播放中换音轨 / 字幕轨（字幕 track_id < 0 表示关掉），不重建管道：已经缓冲的旧音轨播完之后接上新音轨。
+    // 没有这个轨道时返回 false
+    bool selectAudioTrack(int track_id);
+    bool selectSubtitleTrack(int track_id);
 
     ~Mp4Parser();
 
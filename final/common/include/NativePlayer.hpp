@@ -1,10 +1,12 @@
 #pragma once
 
 #include "Entitys.hpp"
+#include "TrackSelection.hpp"
 #include <functional>
 #include <jni.h>
 #include <memory>
 #include <string>
+#include <vector>
 
 struct ANativeWindow;
 
@@ -18,6 +20,11 @@ public:
     void stop();
     void seek(double time_sec);
     double getDuration() const;
+    // 离 time_sec 最近的关键帧时刻，拖进度条时吸附到这里 seek 不用追帧
+    double snapToKeyframe(double time_sec) const;
+    // 容器里的轨道；播放中换音轨不会重新缓冲，已经缓冲的旧音轨播完之后接上新音轨
+    std::vector<player_utils::TrackInfo> getTracks() const;
+    bool selectAudioTrack(int track_id);
     player_utils::PlayerState getState() const;
     double getPosition() const;
     void setSpeed(float speed);
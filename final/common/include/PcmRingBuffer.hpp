@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+namespace player_utils {
+
+// 音频解码线程 -> AAudio 实时回调之间的交错 int16 PCM 环形缓冲区（单生产者 / 单消费者）。
+//
+// 读端（实时回调）只做 atomic load/store 和 memcpy：不分配内存、不加锁、不进内核，
+// 所以 AudioFrame 的释放、日志这些事情都留在解码线程。
+// 写端在缓冲区满时 sleep 轮询，读端不需要做任何唤醒。
+//
+// 每次 write 会在写入位置记一个 PTS 标记，读端据此推算当前读到的样本对应的 PTS，
+// 用于逐块更新 SyncClock。
+//
+// 约束：reset() 需要在两端都不活动时调用（seek 流程中音频输出已暂停、解码线程已停止）。
+class PcmRingBuffer {
+public:
+    struct ReadResult {
+        size_t frames = 0; // 实际读到的采样帧数
+        double pts = -1.0; // 第一个采样帧的 PTS，未知时为负
+    };
+
+    PcmRingBuffer(size_t capacity_frames, int channels, int sample_rate)
+        : channels_(std::max(channels, 1))
+        , sample_rate_(std::max(sample_rate, 1))
+        , capacity_(round_up_pow2(std::max<size_t>(capacity_frames, 1)))
+        , mask_(capacity_ - 1)
+        , samples_(std::make_unique<int16_t[]>(capacity_ * channels_))
+    {
+    }
+
+    PcmRingBuffer(const PcmRingBuffer&) = delete;
+    PcmRingBuffer& operator=(const PcmRingBuffer&) = delete;
+
+    // --- 写端（音频解码线程） ---
+
+    // 写入 frames 个交错采样帧，空间不够时分段写、等待读端腾出空间。
+    // 返回 false 表示被 shutdown，剩余数据被丢弃。
+    bool write(const int16_t* samples, size_t frames, double pts)
+    {
+        bool marked = false;
+        while (frames > 0) {
+            if (shutdown_.load(std::memory_order_acquire)) {
+                return false;
+            }
+
+            const uint64_t write_pos = write_pos_.load(std::memory_order_relaxed);
+            const uint64_t read_pos = read_pos_.load(std::memory_order_acquire);
+            const size_t space = capacity_ - static_cast<size_t>(write_pos - read_pos);
+            if (space == 0) {
+                std::this_thread::sleep_for(kWriterPollInterval);
+                continue;
+            }
+
+            if (!marked) {
+                push_marker(write_pos, pts);
+                marked = true;
+            }
+
+            const size_t chunk = std::min(space, frames);
+            copy_in(write_pos, samples, chunk);
+            write_pos_.store(write_pos + chunk, std::memory_order_release);
+
+            samples += chunk * channels_;
+            frames -= chunk;
+        }
+        return true;
+    }
+
+    // --- 读端（实时回调） ---
+
+    // 最多读 frames 个采样帧到 out，不足部分由调用者补静音（并计一次欠载）
+    ReadResult read(int16_t* out, size_t frames)
+    {
+        const uint64_t read_pos = read_pos_.load(std::memory_order_relaxed);
+        const uint64_t write_pos = write_pos_.load(std::memory_order_acquire);
+        const size_t n = std::min(static_cast<size_t>(write_pos - read_pos), frames);
+
+        ReadResult result;
+        result.frames = n;
+        if (n > 0) {
+            result.pts = pts_at(read_pos);
+            copy_out(read_pos, out, n);
+            read_pos_.store(read_pos + n, std::memory_order_release);
+        }
+        if (n < frames) {
+            underruns_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    // --- 控制 ---
+
+    // 解除写端的等待，之后 write 直接返回 false
+    void shutdown()
+    {
+        shutdown_.store(true, std::memory_order_release);
+    }
+
+    // 丢弃所有数据和 PTS 标记，撤销 shutdown
+    void reset()
+    {
+        read_pos_.store(0, std::memory_order_relaxed);
+        write_pos_.store(0, std::memory_order_relaxed);
+        marker_head_.store(0, std::memory_order_relaxed);
+        marker_tail_.store(0, std::memory_order_relaxed);
+        shutdown_.store(false, std::memory_order_release);
+    }
+
+    size_t available_frames() const
+    {
+        return static_cast<size_t>(write_pos_.load(std::memory_order_acquire)
+            - read_pos_.load(std::memory_order_acquire));
+    }
+
+    size_t capacity_frames() const { return capacity_; }
+    int channels() const { return channels_; }
+    int sample_rate() const { return sample_rate_; }
+
+    // 读端拿到的数据少于请求的次数
+    uint64_t underruns() const { return underruns_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr auto kWriterPollInterval = std::chrono::milliseconds(2);
+    static constexpr size_t kMaxMarkers = 256;
+
+    // 从 position（绝对采样帧序号）开始的 PTS
+    struct Marker {
+        uint64_t position;
+        double pts;
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "PcmRingBuffer needs lock-free 64-bit atomics");
+
+    static size_t round_up_pow2(size_t n)
+    {
+        size_t cap = 1;
+        while (cap < n)
+            cap <<= 1;
+        return cap;
+    }
+
+    void copy_in(uint64_t position, const int16_t* src, size_t frames)
+    {
+        const size_t offset = static_cast<size_t>(position) & mask_;
+        const size_t first = std::min(frames, capacity_ - offset);
+        std::memcpy(&samples_[offset * channels_], src, first * channels_ * sizeof(int16_t));
+        if (first < frames) {
+            std::memcpy(&samples_[0], src + first * channels_, (frames - first) * channels_ * sizeof(int16_t));
+        }
+    }
+
+    void copy_out(uint64_t position, int16_t* dst, size_t frames) const
+    {
+        const size_t offset = static_cast<size_t>(position) & mask_;
+        const size_t first = std::min(frames, capacity_ - offset);
+        std::memcpy(dst, &samples_[offset * channels_], first * channels_ * sizeof(int16_t));
+        if (first < frames) {
+            std::memcpy(dst + first * channels_, &samples_[0], (frames - first) * channels_ * sizeof(int16_t));
+        }
+    }
+
+    // 标记环满时直接丢掉这个标记：数据是连续的，读端可以从上一个标记按采样率外推
+    void push_marker(uint64_t position, double pts)
+    {
+        if (pts < 0) {
+            return;
+        }
+        const size_t tail = marker_tail_.load(std::memory_order_relaxed);
+        if (tail - marker_head_.load(std::memory_order_acquire) >= kMaxMarkers) {
+            return;
+        }
+        markers_[tail % kMaxMarkers] = { position, pts };
+        marker_tail_.store(tail + 1, std::memory_order_release);
+    }
+
+    // 找到 position 之前最近的标记，按采样率外推。最近的标记留在环里，后面的读还要用它
+    double pts_at(uint64_t position)
+    {
+        size_t head = marker_head_.load(std::memory_order_relaxed);
+        const size_t tail = marker_tail_.load(std::memory_order_acquire);
+        if (head == tail) {
+            return -1.0;
+        }
+        while (head + 1 < tail && markers_[(head + 1) % kMaxMarkers].position <= position) {
+            ++head;
+        }
+        marker_head_.store(head, std::memory_order_release);
+
+        const Marker& marker = markers_[head % kMaxMarkers];
+        if (marker.position > position) {
+            return -1.0;
+        }
+        return marker.pts + static_cast<double>(position - marker.position) / sample_rate_;
+    }
+
+    const int channels_;
+    const int sample_rate_;
+    const size_t capacity_;
+    const size_t mask_;
+    std::unique_ptr<int16_t[]> samples_;
+
+    Marker markers_[kMaxMarkers] {};
+
+    alignas(64) std::atomic<uint64_t> write_pos_ { 0 };
+    std::atomic<size_t> marker_tail_ { 0 };
+    alignas(64) std::atomic<uint64_t> read_pos_ { 0 };
+    std::atomic<size_t> marker_head_ { 0 };
+    std::atomic<uint64_t> underruns_ { 0 };
+    alignas(64) std::atomic<bool> shutdown_ { false };
+};
+
+} // namespace player_utils
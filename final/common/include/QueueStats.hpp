@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace player_utils {
+
+// 等待时间直方图：第 0 个桶是不到 2 微秒的等待，第 i 个桶是 [2^i, 2^(i+1)) 微秒，最后一个桶兜底
+constexpr size_t kQueueWaitBuckets = 24;
+
+struct QueueStatsSnapshot {
+    uint64_t pushes = 0;
+    uint64_t pops = 0;
+    uint64_t cleared = 0; // clear() 直接丢掉的元素
+    size_t size = 0;
+    size_t high_water = 0;
+
+    // 生产者等空位、消费者等数据的次数和总时长
+    uint64_t producer_waits = 0;
+    uint64_t producer_wait_ns = 0;
+    uint64_t consumer_waits = 0;
+    uint64_t consumer_wait_ns = 0;
+
+    // 非阻塞 / 超时的 pop 没拿到数据
+    uint64_t underruns = 0;
+
+    std::array<uint64_t, kQueueWaitBuckets> producer_wait_hist {};
+    std::array<uint64_t, kQueueWaitBuckets> consumer_wait_hist {};
+};
+
+// SemQueue 的可选统计。所有计数都是 relaxed atomic，只在真正阻塞时才读时钟，
+// 所以不阻塞的 push / pop 只多几次 fetch_add。
+class QueueTelemetry {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void on_push(size_t count, size_t size_after)
+    {
+        pushes_.fetch_add(count, std::memory_order_relaxed);
+        size_t high = high_water_.load(std::memory_order_relaxed);
+        while (size_after > high
+            && !high_water_.compare_exchange_weak(high, size_after, std::memory_order_relaxed)) { }
+    }
+
+    void on_pop(size_t count = 1) { pops_.fetch_add(count, std::memory_order_relaxed); }
+
+    void on_clear(size_t count) { cleared_.fetch_add(count, std::memory_order_relaxed); }
+
+    void on_underrun() { underruns_.fetch_add(1, std::memory_order_relaxed); }
+
+    void on_producer_wait(Clock::duration waited)
+    {
+        record_wait(waited, producer_waits_, producer_wait_ns_, producer_hist_);
+    }
+
+    void on_consumer_wait(Clock::duration waited)
+    {
+        record_wait(waited, consumer_waits_, consumer_wait_ns_, consumer_hist_);
+    }
+
+    // 各个计数分别读取，并发时彼此之间可能差一两个，用于观察趋势足够了
+    QueueStatsSnapshot snapshot() const
+    {
+        QueueStatsSnapshot s;
+        s.pushes = pushes_.load(std::memory_order_relaxed);
+        s.pops = pops_.load(std::memory_order_relaxed);
+        s.cleared = cleared_.load(std::memory_order_relaxed);
+        s.size = s.pushes >= s.pops + s.cleared ? static_cast<size_t>(s.pushes - s.pops - s.cleared) : 0;
+        s.high_water = high_water_.load(std::memory_order_relaxed);
+        s.producer_waits = producer_waits_.load(std::memory_order_relaxed);
+        s.producer_wait_ns = producer_wait_ns_.load(std::memory_order_relaxed);
+        s.consumer_waits = consumer_waits_.load(std::memory_order_relaxed);
+        s.consumer_wait_ns = consumer_wait_ns_.load(std::memory_order_relaxed);
+        s.underruns = underruns_.load(std::memory_order_relaxed);
+        for (size_t i = 0; i < kQueueWaitBuckets; ++i) {
+            s.producer_wait_hist[i] = producer_hist_[i].load(std::memory_order_relaxed);
+            s.consumer_wait_hist[i] = consumer_hist_[i].load(std::memory_order_relaxed);
+        }
+        return s;
+    }
+
+    static size_t bucket_for(Clock::duration waited)
+    {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(waited).count();
+        size_t bucket = 0;
+        while (us > 1 && bucket + 1 < kQueueWaitBuckets) {
+            us >>= 1;
+            ++bucket;
+        }
+        return bucket;
+    }
+
+private:
+    using Histogram = std::array<std::atomic<uint64_t>, kQueueWaitBuckets>;
+
+    static void record_wait(Clock::duration waited, std::atomic<uint64_t>& count,
+        std::atomic<uint64_t>& total_ns, Histogram& hist)
+    {
+        count.fetch_add(1, std::memory_order_relaxed);
+        total_ns.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count()),
+            std::memory_order_relaxed);
+        hist[bucket_for(waited)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> pushes_ { 0 };
+    std::atomic<uint64_t> pops_ { 0 };
+    std::atomic<uint64_t> cleared_ { 0 };
+    std::atomic<size_t> high_water_ { 0 };
+    std::atomic<uint64_t> producer_waits_ { 0 };
+    std::atomic<uint64_t> producer_wait_ns_ { 0 };
+    std::atomic<uint64_t> consumer_waits_ { 0 };
+    std::atomic<uint64_t> consumer_wait_ns_ { 0 };
+    std::atomic<uint64_t> underruns_ { 0 };
+    Histogram producer_hist_ {};
+    Histogram consumer_hist_ {};
+};
+
+} // namespace player_utils
@@ -0,0 +1,616 @@
+#pragma once
+
+#include "AvioReader.hpp"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace player_utils {
+
+// 远程文件（lab06 文件服务器）怎么读
+struct RemoteOptions {
+    // 每次区间请求取多大
+    size_t chunk_size = 512 * 1024;
+    // 读取位置之后最多提前取多少块。seek 之后从 2 块开始，顺序读一块翻一倍，直到这个上限
+    size_t read_ahead_chunks = 16;
+    // 并行取块的连接数（每个连接一个线程）
+    size_t connections = 4;
+    // 连接 / 收发超时
+    int timeout_ms = 5000;
+};
+
+// lab06://host:port/path，path 是服务器上的文件名（相对服务器的工作目录，绝对路径再多写一个 /）
+struct RemoteUrl {
+    std::string host;
+    int port = 0;
+    std::string path;
+
+    static bool is_remote(const std::string& url) { return url.compare(0, kScheme.size(), kScheme) == 0; }
+
+    static bool parse(const std::string& url, RemoteUrl& out)
+    {
+        if (!is_remote(url)) {
+            return false;
+        }
+        const size_t host_begin = kScheme.size();
+        const size_t slash = url.find('/', host_begin);
+        const size_t colon = url.rfind(':', slash);
+        if (slash == std::string::npos || colon == std::string::npos || colon < host_begin || slash + 1 >= url.size()) {
+            return false;
+        }
+        out.host = url.substr(host_begin, colon - host_begin);
+        const std::string port = url.substr(colon + 1, slash - colon - 1);
+        if (out.host.empty() || port.empty() || port.find_first_not_of("0123456789") != std::string::npos || port.size() > 5) {
+            return false;
+        }
+        out.port = std::atoi(port.c_str());
+        out.path = url.substr(slash + 1);
+        return out.port > 0 && out.port < 65536;
+    }
+
+private:
+    static inline const std::string kScheme = "lab06://";
+};
+
+// lab06 协议的一个长连接：一行 JSON 请求，一行 JSON 响应头 + 数据。
+// 区间请求 {"filename":..., "offset":..., "length":...} 的响应是 {"filesize":..., "offset":..., "length":...}，
+// 之后连接保持，可以接着发下一个请求。出错的响应 {"error":...} 之后服务器会关连接
+class Lab06Connection {
+public:
+    Lab06Connection(const RemoteUrl& url, int timeout_ms)
+        : url_(url)
+        , timeout_ms_(timeout_ms)
+    {
+    }
+
+    ~Lab06Connection() { disconnect(); }
+
+    Lab06Connection(const Lab06Connection&) = delete;
+    Lab06Connection& operator=(const Lab06Connection&) = delete;
+
+    // 取 [offset, offset + length) 放到 dst，file_size 带回整个文件的大小。
+    // 返回实际取到的字节数（文件末尾会比 length 少），负数是 -errno；服务器上没有这个文件时是 -ENOENT。
+    // 连接断了（服务器那边超时关掉、重启过）先重连再试一次
+    int64_t fetch(int64_t offset, size_t length, uint8_t* dst, int64_t& file_size)
+    {
+        int64_t n = -ECONNRESET;
+        for (int attempt = 0; attempt < 2; ++attempt) {
+            if (fd_.load() < 0 && !connect()) {
+                n = -ECONNREFUSED;
+                continue;
+            }
+            n = request(offset, length, dst, file_size);
+            if (n >= 0) {
+                return n;
+            }
+            disconnect();
+            if (n == -ENOENT || n == -EINVAL || n == -ECANCELED) {
+                break; // 重试也一样
+            }
+        }
+        return n;
+    }
+
+    // 别的线程让卡在收发上的 fetch 马上返回（析构 RemoteFileReader 时）
+    void cancel()
+    {
+        std::lock_guard<std::mutex> lock(fd_mutex_);
+        cancelled_ = true;
+        if (fd_ >= 0) {
+            ::shutdown(fd_, SHUT_RDWR);
+        }
+    }
+
+    void disconnect()
+    {
+        std::lock_guard<std::mutex> lock(fd_mutex_);
+        if (fd_ >= 0) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+        pending_.clear();
+    }
+
+private:
+    bool connect()
+    {
+        addrinfo hints {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* res = nullptr;
+        if (getaddrinfo(url_.host.c_str(), std::to_string(url_.port).c_str(), &hints, &res) != 0) {
+            return false;
+        }
+        int fd = -1;
+        for (addrinfo* ai = res; ai != nullptr && fd < 0; ai = ai->ai_next) {
+            fd = connect_with_timeout(ai);
+        }
+        freeaddrinfo(res);
+        if (fd < 0) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(fd_mutex_);
+        if (cancelled_) {
+            ::close(fd);
+            return false;
+        }
+        fd_ = fd;
+        return true;
+    }
+
+    // 非阻塞 connect + poll 等到超时，连上之后换回阻塞模式，收发超时交给 SO_RCVTIMEO / SO_SNDTIMEO
+    int connect_with_timeout(const addrinfo* ai) const
+    {
+        const int fd = ::socket(ai->ai_family, ai->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, ai->ai_protocol);
+        if (fd < 0) {
+            return -1;
+        }
+        if (::connect(fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+            pollfd pfd { fd, POLLOUT, 0 };
+            int error = 0;
+            socklen_t error_len = sizeof(error);
+            if (errno != EINPROGRESS || poll(&pfd, 1, timeout_ms_) != 1
+                || getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &error_len) != 0 || error != 0) {
+                ::close(fd);
+                return -1;
+            }
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) & ~O_NONBLOCK);
+        timeval tv { timeout_ms_ / 1000, (timeout_ms_ % 1000) * 1000 };
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        // 请求只有一行，不等 Nagle 攒包
+        const int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        return fd;
+    }
+
+    int64_t request(int64_t offset, size_t length, uint8_t* dst, int64_t& file_size)
+    {
+        const std::string line = "{\"filename\":\"" + json_escape(url_.path) + "\",\"offset\":" + std::to_string(offset)
+            + ",\"length\":" + std::to_string(length) + "}\n";
+        int error = send_all(line.data(), line.size());
+        if (error != 0) {
+            return -error;
+        }
+
+        std::string header;
+        error = read_line(header);
+        if (error != 0) {
+            return -error;
+        }
+        if (header.find("\"error\"") != std::string::npos) {
+            return header.find("not file") != std::string::npos ? -ENOENT : -EINVAL;
+        }
+        int64_t got_offset = -1;
+        int64_t got_length = -1;
+        if (!json_int(header, "filesize", file_size) || !json_int(header, "offset", got_offset)
+            || !json_int(header, "length", got_length) || got_offset != std::min(offset, file_size)
+            || got_length < 0 || got_length > static_cast<int64_t>(length)) {
+            return -EPROTO;
+        }
+        error = recv_exact(dst, static_cast<size_t>(got_length));
+        return error != 0 ? -error : got_length;
+    }
+
+    int send_all(const char* data, size_t len)
+    {
+        while (len > 0) {
+            const ssize_t n = ::send(fd_, data, len, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return io_error();
+            }
+            data += n;
+            len -= static_cast<size_t>(n);
+        }
+        return 0;
+    }
+
+    // 响应头那一行。按块收，头后面顺带收到的数据留在 pending_ 里给 recv_exact
+    int read_line(std::string& line)
+    {
+        while (true) {
+            const size_t newline = pending_.find('\n');
+            if (newline != std::string::npos) {
+                line = pending_.substr(0, newline);
+                pending_.erase(0, newline + 1);
+                return 0;
+            }
+            if (pending_.size() > kMaxHeader) {
+                return EPROTO;
+            }
+            char buffer[4096];
+            const ssize_t n = ::recv(fd_, buffer, sizeof(buffer), 0);
+            if (n == 0) {
+                return ECONNRESET;
+            }
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return io_error();
+            }
+            pending_.append(buffer, static_cast<size_t>(n));
+        }
+    }
+
+    int recv_exact(uint8_t* dst, size_t len)
+    {
+        const size_t buffered = std::min(len, pending_.size());
+        std::memcpy(dst, pending_.data(), buffered);
+        pending_.erase(0, buffered);
+        size_t received = buffered;
+        while (received < len) {
+            const ssize_t n = ::recv(fd_, dst + received, len - received, MSG_WAITALL);
+            if (n == 0) {
+                return ECONNRESET;
+            }
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return io_error();
+            }
+            received += static_cast<size_t>(n);
+        }
+        return 0;
+    }
+
+    // SO_RCVTIMEO 超时是 EAGAIN；被 cancel() 关掉的连接按取消算，不再重试
+    int io_error() const
+    {
+        if (cancelled_.load()) {
+            return ECANCELED;
+        }
+        return (errno == EAGAIN || errno == EWOULDBLOCK) ? ETIMEDOUT : errno;
+    }
+
+    static std::string json_escape(const std::string& s)
+    {
+        std::string out;
+        for (const char c : s) {
+            if (c == '"' || c == '\\') {
+                out.push_back('\\');
+                out.push_back(c);
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+                out += escaped;
+            } else {
+                out.push_back(c);
+            }
+        }
+        return out;
+    }
+
+    // 响应头是一层的 JSON 对象，只取整数字段
+    static bool json_int(const std::string& json, const char* key, int64_t& value)
+    {
+        const std::string quoted = std::string("\"") + key + "\"";
+        size_t pos = json.find(quoted);
+        if (pos == std::string::npos) {
+            return false;
+        }
+        pos = json.find(':', pos + quoted.size());
+        if (pos == std::string::npos) {
+            return false;
+        }
+        char* end = nullptr;
+        const char* begin = json.c_str() + pos + 1;
+        const long long parsed = std::strtoll(begin, &end, 10);
+        if (end == begin) {
+            return false;
+        }
+        value = parsed;
+        return true;
+    }
+
+    static constexpr size_t kMaxHeader = 4096;
+
+    RemoteUrl url_;
+    int timeout_ms_;
+    std::mutex fd_mutex_;
+    std::atomic<int> fd_ { -1 };
+    std::atomic<bool> cancelled_ { false };
+    std::string pending_;
+};
+
+// 远程文件按块缓存：读取位置所在的块和之后的 ahead_ 块由 connections 个线程各用一条长连接并行地按区间取，
+// 解复用线程读的时候只是在锁里 memcpy。顺序读时预读窗口逐块翻倍到 read_ahead_chunks，
+// seek 到缓存之外时窗口缩回 2 块，先取 seek 目标那一块，起播 / seek 不用等一整个窗口。
+// 读取位置之前留 kKeepBehind 块，FFmpeg 往回读一点（mov 找 box 边界）不用重新取；更远的块直接扔掉
+class RemoteFileReader : public AvioReader {
+public:
+    // 传输统计，和 AvioReader::Stats 分开：那边是交给解复用的，这边是从网络上取的
+    struct Transfer {
+        uint64_t chunks = 0; // 取回来的块数
+        uint64_t bytes = 0; // 取回来的字节数（包括取了没用上的）
+        uint64_t discarded = 0; // 取回来时已经不在窗口里、直接扔掉的块数
+        uint64_t retries = 0; // 取失败之后重新排队的次数
+    };
+
+    ~RemoteFileReader() override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& connection : connections_) {
+            connection->cancel();
+        }
+        for (std::thread& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    RemoteFileReader(const RemoteFileReader&) = delete;
+    RemoteFileReader& operator=(const RemoteFileReader&) = delete;
+
+    int64_t read(uint8_t* dst, size_t len) override
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (pos_ >= size_) {
+            return 0;
+        }
+        const int64_t index = chunk_index(pos_);
+        move_window(index);
+        auto it = chunks_.find(index);
+        if (it == chunks_.end() || !it->second.settled()) {
+            ++stats_.waits;
+            cv_.wait(lock, [&] {
+                it = chunks_.find(index);
+                return stop_ || (it != chunks_.end() && it->second.settled());
+            });
+            if (stop_) {
+                return -EIO;
+            }
+        }
+        if (it->second.state == Chunk::Failed) {
+            // 重试了 kMaxAttempts 次都没取到：这次报错，下次读到这块时从头再来
+            const int error = it->second.error;
+            chunks_.erase(it);
+            return -error;
+        }
+
+        const std::vector<uint8_t>& data = it->second.data;
+        const size_t in_chunk = static_cast<size_t>(pos_ - index * static_cast<int64_t>(chunk_size_));
+        if (in_chunk >= data.size()) {
+            return 0; // 服务器上的文件在打开之后被截短了
+        }
+        const size_t n = std::min(len, data.size() - in_chunk);
+        std::memcpy(dst, data.data() + in_chunk, n);
+        pos_ += static_cast<int64_t>(n);
+        stats_.bytes_read += n;
+        return static_cast<int64_t>(n);
+    }
+
+    int64_t seek(int64_t pos) override
+    {
+        if (pos < 0) {
+            return -EINVAL;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        pos_ = pos;
+        if (pos_ < size_) {
+            move_window(chunk_index(pos_));
+        }
+        return pos_;
+    }
+
+    [[nodiscard]] Stats stats() const override
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+    [[nodiscard]] Transfer transfer() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return transfer_;
+    }
+
+    // 连上服务器并取回第一块（顺便拿到文件大小）之后才返回，连不上或者没有这个文件时返回 nullptr
+    static std::unique_ptr<RemoteFileReader> open(const std::string& url, const RemoteOptions& options)
+    {
+        RemoteUrl parsed;
+        if (!RemoteUrl::parse(url, parsed)) {
+            return nullptr;
+        }
+        std::unique_ptr<RemoteFileReader> reader(new RemoteFileReader(parsed, options));
+        if (!reader->start()) {
+            return nullptr;
+        }
+        return reader;
+    }
+
+private:
+    static constexpr int64_t kKeepBehind = 2;
+    static constexpr size_t kInitialAhead = 2;
+    // 一块最多取这么多次（Lab06Connection::fetch 自己还会重连一次），都失败了才交给 read 报错
+    static constexpr int kMaxAttempts = 3;
+
+    struct Chunk {
+        // Retry：上次取失败了，等某个取块线程重新取
+        enum State { Fetching, Retry, Ready, Failed };
+        State state = Fetching;
+        uint64_t ticket = 0; // 哪一次取的，块被扔掉又重新取时旧的结果作废
+        int attempts = 0;
+        int error = 0;
+        std::vector<uint8_t> data;
+
+        [[nodiscard]] bool settled() const { return state == Ready || state == Failed; }
+    };
+
+    RemoteFileReader(const RemoteUrl& url, const RemoteOptions& options)
+        : chunk_size_(std::max<size_t>(options.chunk_size, 4096))
+        , max_ahead_(std::max(options.read_ahead_chunks, kInitialAhead))
+        , ahead_(kInitialAhead)
+    {
+        const size_t count = std::max<size_t>(options.connections, 1);
+        for (size_t i = 0; i < count; ++i) {
+            connections_.push_back(std::make_unique<Lab06Connection>(url, options.timeout_ms));
+        }
+    }
+
+    bool start()
+    {
+        Chunk first;
+        first.data.resize(chunk_size_);
+        int64_t file_size = 0;
+        const int64_t n = connections_[0]->fetch(0, chunk_size_, first.data.data(), file_size);
+        if (n < 0) {
+            return false;
+        }
+        first.data.resize(static_cast<size_t>(n));
+        first.state = Chunk::Ready;
+        size_ = file_size;
+        transfer_.chunks = 1;
+        transfer_.bytes = static_cast<uint64_t>(n);
+        chunks_.emplace(0, std::move(first));
+
+        for (auto& connection : connections_) {
+            workers_.emplace_back(&RemoteFileReader::fetch_loop, this, connection.get());
+        }
+        return true;
+    }
+
+    [[nodiscard]] int64_t chunk_index(int64_t pos) const { return pos / static_cast<int64_t>(chunk_size_); }
+
+    [[nodiscard]] int64_t chunk_count() const
+    {
+        return (size_ + static_cast<int64_t>(chunk_size_) - 1) / static_cast<int64_t>(chunk_size_);
+    }
+
+    // 读取位置到了块 index。顺着读到下一块时窗口翻倍；跳到没缓存的块时窗口缩回去重来。
+    // 窗口外的块扔掉，调用时持锁
+    void move_window(int64_t index)
+    {
+        if (index == first_) {
+            return;
+        }
+        if (index == first_ + 1) {
+            ahead_ = std::min(ahead_ * 2, max_ahead_);
+        } else if (chunks_.count(index) == 0) {
+            ++stats_.refills;
+            ahead_ = kInitialAhead;
+        }
+        first_ = index;
+        const int64_t keep_end = first_ + static_cast<int64_t>(max_ahead_);
+        for (auto it = chunks_.begin(); it != chunks_.end();) {
+            if (it->first < first_ - kKeepBehind || it->first >= keep_end) {
+                it = chunks_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        cv_.notify_all();
+    }
+
+    // 窗口里离读取位置最近的、还没开始取（或者要重取）的块，没有时返回 -1
+    [[nodiscard]] int64_t next_missing() const
+    {
+        const int64_t end = std::min(first_ + static_cast<int64_t>(ahead_), chunk_count());
+        for (int64_t index = first_; index < end; ++index) {
+            auto it = chunks_.find(index);
+            if (it == chunks_.end() || it->second.state == Chunk::Retry) {
+                return index;
+            }
+        }
+        return -1;
+    }
+
+    void fetch_loop(Lab06Connection* connection)
+    {
+        std::vector<uint8_t> buffer;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            int64_t index = -1;
+            cv_.wait(lock, [&] {
+                index = next_missing();
+                return stop_ || index >= 0;
+            });
+            if (stop_) {
+                return;
+            }
+            const uint64_t ticket = ++tickets_;
+            Chunk& pending = chunks_[index];
+            pending.state = Chunk::Fetching;
+            pending.ticket = ticket;
+            ++pending.attempts;
+            lock.unlock();
+
+            buffer.resize(chunk_size_);
+            int64_t file_size = 0;
+            const int64_t n = connection->fetch(index * static_cast<int64_t>(chunk_size_), chunk_size_, buffer.data(), file_size);
+
+            lock.lock();
+            auto it = chunks_.find(index);
+            if (n >= 0) {
+                ++transfer_.chunks;
+                transfer_.bytes += static_cast<uint64_t>(n);
+            }
+            if (it == chunks_.end() || it->second.ticket != ticket) {
+                ++transfer_.discarded; // seek 走了，这块已经不在窗口里
+                continue;
+            }
+            Chunk& chunk = it->second;
+            if (n < 0 && n != -ECANCELED && chunk.attempts < kMaxAttempts) {
+                // 预读的块偶尔失败（超时、连接被断）不直接判死刑：放回去让下一个空闲的线程再取
+                chunk.state = Chunk::Retry;
+                chunk.error = static_cast<int>(-n);
+                ++transfer_.retries;
+            } else if (n < 0) {
+                chunk.state = Chunk::Failed;
+                chunk.error = static_cast<int>(-n);
+            } else {
+                buffer.resize(static_cast<size_t>(n));
+                chunk.data.swap(buffer);
+                chunk.state = Chunk::Ready;
+            }
+            cv_.notify_all();
+        }
+    }
+
+    size_t chunk_size_;
+    size_t max_ahead_;
+    std::vector<std::unique_ptr<Lab06Connection>> connections_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::map<int64_t, Chunk> chunks_;
+    int64_t first_ = 0; // 读取位置所在的块
+    size_t ahead_; // 从 first_ 起往后取几块（包括 first_）
+    uint64_t tickets_ = 0;
+    bool stop_ = false;
+    Stats stats_;
+    Transfer transfer_;
+    std::vector<std::thread> workers_;
+};
+
+} // namespace player_utils
@@ -1,46 +1,240 @@
 #pragma once
-#include <array>
-#include <stdexcept>
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
 
+// 定长环形缓冲区，接口和 std::queue 一致，可以直接作为 SemQueue 的 Container：
+//   SemQueue<T, RingBuffer<T, N>> queue(N);
+//
+// * 逻辑容量是 N，内部存储向上取整到 2 的幂，下标用掩码而不是取模；
+// * 元素在原始存储上按需构造 / 析构，不要求 T 可默认构造，也不会有 std::deque 那样的分块分配；
+// * 本身不是线程安全的，线程安全交给 SemQueue。
+//
+// 满时 push、空时 pop / front / back 属于前置条件错误（assert），
+// 不确定的时候用 try_push / try_pop。
 template <typename T, size_t N>
 class RingBuffer {
+    static_assert(N > 0, "RingBuffer capacity must be positive");
+
+    static constexpr size_t round_up_pow2(size_t n)
+    {
+        size_t cap = 1;
+        while (cap < n)
+            cap <<= 1;
+        return cap;
+    }
+
 public:
+    using value_type = T;
+    using size_type = size_t;
+    using reference = T&;
+    using const_reference = const T&;
+
+    static constexpr size_t kCapacity = N;
+    static constexpr size_t kStorageSize = round_up_pow2(N);
+
+    // 一段连续的元素，用于批量访问
+    struct Span {
+        T* data;
+        size_t size;
+    };
+
     RingBuffer() = default;
 
-    void push(T&& value)
+    RingBuffer(const RingBuffer& other)
     {
-        if (full()) {
-            throw std::runtime_error("RingBuffer is full");
+        for (size_t i = 0; i < other.size(); ++i) {
+            emplace(other.at(i));
         }
-        buffer_[write_] = std::move(value);
-        write_ = (write_ + 1) % N;
-        ++size_;
     }
 
-    void pop()
+    RingBuffer(RingBuffer&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
     {
-        if (empty()) {
-            throw std::runtime_error("RingBuffer is empty");
+        while (!other.empty()) {
+            emplace(std::move(other.front()));
+            other.pop();
         }
-        read_ = (read_ + 1) % N;
-        --size_;
+    }
+
+    RingBuffer& operator=(const RingBuffer& other)
+    {
+        if (this != &other) {
+            clear();
+            for (size_t i = 0; i < other.size(); ++i) {
+                emplace(other.at(i));
+            }
+        }
+        return *this;
+    }
+
+    RingBuffer& operator=(RingBuffer&& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        if (this != &other) {
+            clear();
+            while (!other.empty()) {
+                emplace(std::move(other.front()));
+                other.pop();
+            }
+        }
+        return *this;
+    }
+
+    ~RingBuffer() { clear(); }
+
+    // --- std::queue 兼容接口 ---
+
+    void push(const T& value) { emplace(value); }
+    void push(T&& value) { emplace(std::move(value)); }
+
+    template <typename... Args>
+    T& emplace(Args&&... args)
+    {
+        assert(!full() && "RingBuffer is full");
+        T* element = ::new (slot_ptr(write_)) T(std::forward<Args>(args)...);
+        ++write_;
+        return *element;
+    }
+
+    void pop()
+    {
+        assert(!empty() && "RingBuffer is empty");
+        slot(read_).~T();
+        ++read_;
     }
 
     T& front()
+    {
+        assert(!empty() && "RingBuffer is empty");
+        return slot(read_);
+    }
+    const T& front() const
+    {
+        assert(!empty() && "RingBuffer is empty");
+        return slot(read_);
+    }
+
+    T& back()
+    {
+        assert(!empty() && "RingBuffer is empty");
+        return slot(write_ - 1);
+    }
+    const T& back() const
+    {
+        assert(!empty() && "RingBuffer is empty");
+        return slot(write_ - 1);
+    }
+
+    [[nodiscard]] bool empty() const { return write_ == read_; }
+    [[nodiscard]] bool full() const { return size() == N; }
+    [[nodiscard]] size_t size() const { return write_ - read_; }
+    [[nodiscard]] static constexpr size_t capacity() { return N; }
+
+    void swap(RingBuffer& other) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        if (this == &other) {
+            return;
+        }
+        RingBuffer tmp(std::move(other));
+        other = std::move(*this);
+        *this = std::move(tmp);
+    }
+
+    // --- 不抛异常、不 assert 的版本 ---
+
+    bool try_push(T&& value)
+    {
+        if (full()) {
+            return false;
+        }
+        emplace(std::move(value));
+        return true;
+    }
+
+    bool try_push(const T& value)
+    {
+        if (full()) {
+            return false;
+        }
+        emplace(value);
+        return true;
+    }
+
+    bool try_pop(T& out)
     {
         if (empty()) {
-            throw std::runtime_error("RingBuffer is empty");
+            return false;
         }
-        return buffer_[read_];
+        out = std::move(front());
+        pop();
+        return true;
     }
 
-    [[nodiscard]] bool empty() const { return size_ == 0; }
-    [[nodiscard]] bool full() const { return size_ == N; }
-    [[nodiscard]] size_t size() const { return size_; }
+    void clear()
+    {
+        if constexpr (std::is_trivially_destructible_v<T>) {
+            read_ = write_;
+        } else {
+            while (!empty()) {
+                pop();
+            }
+        }
+        read_ = write_ = 0;
+    }
+
+    // --- 批量访问 ---
+
+    // 第 i 个元素（0 是队头）
+    T& at(size_t i)
+    {
+        assert(i < size());
+        return slot(read_ + i);
+    }
+    const T& at(size_t i) const
+    {
+        assert(i < size());
+        return slot(read_ + i);
+    }
+
+    // 队头到队尾的元素在存储里最多分成两段连续内存，second 可能为空
+    std::pair<Span, Span> spans()
+    {
+        const size_t offset = read_ & kMask;
+        const size_t first = std::min(size(), kStorageSize - offset);
+        return {
+            Span { &slot(read_), first },
+            Span { first < size() ? slot_ptr_typed(0) : nullptr, size() - first },
+        };
+    }
+
+    // 丢弃队头的 n 个元素（n 不超过 size()），配合 spans() 批量消费
+    void pop_n(size_t n)
+    {
+        assert(n <= size());
+        if constexpr (std::is_trivially_destructible_v<T>) {
+            read_ += n;
+        } else {
+            for (size_t i = 0; i < n; ++i) {
+                pop();
+            }
+        }
+    }
 
 private:
-    std::array<T, N> buffer_;
+    static constexpr size_t kMask = kStorageSize - 1;
+
+    void* slot_ptr(size_t index) { return &storage_[(index & kMask) * sizeof(T)]; }
+    T* slot_ptr_typed(size_t index) { return std::launder(reinterpret_cast<T*>(slot_ptr(index))); }
+    T& slot(size_t index) { return *slot_ptr_typed(index); }
+    const T& slot(size_t index) const
+    {
+        return *std::launder(reinterpret_cast<const T*>(&storage_[(index & kMask) * sizeof(T)]));
+    }
+
+    alignas(64) alignas(T) unsigned char storage_[kStorageSize * sizeof(T)];
+    // read_ / write_ 单调递增，size = write_ - read_，不需要单独的计数
     size_t read_ = 0;
     size_t write_ = 0;
-    size_t size_ = 0;
 };
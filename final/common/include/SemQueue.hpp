@@ -1,6 +1,13 @@
 #pragma once
 
+#include "QueueStats.hpp"
 #include "Semaphore.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <queue>
@@ -12,6 +19,9 @@ using counting_semaphore = Semaphore;
 template <typename T, typename Container = std::queue<T>>
 class SemQueue {
 public:
+    // 元素的 "代价"，比如视频帧的字节数、音频帧的时长（微秒）
+    using CostFunction = std::function<size_t(const T&)>;
+
     explicit SemQueue(size_t max_size)
         : max_size_(max_size)
         , empty_slots_(max_size)
@@ -19,43 +29,88 @@ public:
     {
     }
 
+    // 除了个数上限，再按 cost_fn 累计的总代价限流：
+    // 队列里代价之和超过 cost_budget 时 push 阻塞。队列为空时总会放行一个元素，
+    // 所以单个超出预算的元素（比如一帧 8K 画面）不会把管线卡死
+    SemQueue(size_t max_size, CostFunction cost_fn, size_t cost_budget)
+        : max_size_(max_size)
+        , cost_fn_(std::move(cost_fn))
+        , cost_budget_(cost_budget)
+        , empty_slots_(max_size)
+        , filled_slots_(0)
+    {
+    }
+
     bool push(T element)
     {
         if (shutdown_)
             return false;
-        empty_slots_.acquire();
+        acquire_empty_slot();
         if (shutdown_)
             return false; // acquire 后再次检查，防止 shutdown 时死锁
 
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
+            if (cost_fn_ && !wait_for_budget_locked(lock, element)) {
+                // 等预算时被 shutdown：上面占的空位还回去
+                lock.unlock();
+                empty_slots_.release();
+                return false;
+            }
             queue_.push(std::move(element));
+            if (telemetry_)
+                telemetry_->on_push(1, queue_.size());
         }
 
         filled_slots_.release();
+        notify_readable();
         return true;
     }
 
-    bool wait_and_pop(T& out_element)
+    // 非阻塞的 push：队列满（或者超出代价预算）、已经 shutdown 时返回 false，element 保持不动。
+    // 给跑在 TaskExecutor 上的生产者用，失败时挂起，等 set_on_writable 的回调唤醒
+    bool try_push(T& element)
     {
-        if (shutdown_ && queue_is_empty_unsafe())
+        if (shutdown_ || !empty_slots_.try_acquire())
             return false;
-        filled_slots_.acquire(); // 等待已填充槽位
 
         {
             std::unique_lock<std::mutex> lock(queue_mutex_);
-            if (shutdown_ && queue_.empty()) {
-                // 如果在等待期间被 shutdown，需要把信号量还回去，以便其他等待者也能退出
-                filled_slots_.release();
+            if (shutdown_) {
+                lock.unlock();
+                empty_slots_.release();
                 return false;
             }
-            out_element = std::move(queue_.front());
-            queue_.pop();
+            if (cost_fn_) {
+                const size_t cost = cost_fn_(element);
+                if (!queue_.empty() && cost_in_queue_ + cost > cost_budget_) {
+                    lock.unlock();
+                    empty_slots_.release();
+                    return false;
+                }
+                cost_in_queue_ += cost;
+            }
+            queue_.push(std::move(element));
+            if (telemetry_)
+                telemetry_->on_push(1, queue_.size());
         }
 
-        empty_slots_.release();
+        filled_slots_.release();
+        notify_readable();
         return true;
     }
+
+    bool wait_and_pop(T& out_element)
+    {
+        while (true) {
+            if (shutdown_ && queue_is_empty_unsafe())
+                return false;
+            acquire_filled_slot(); // 等待已填充槽位
+            if (pop_one_acquired(out_element))
+                return true;
+            // 拿到的元素被 clear 丢掉了，接着等下一个
+        }
+    }
     template <typename Rep, typename Period>
     bool wait_and_pop(T& out_element, const std::chrono::duration<Rep, Period>& timeout)
     {
@@ -64,25 +119,84 @@ public:
         }
 
         // 1. 带超时地等待一个 "已填充" 信号量
-        if (!filled_slots_.try_acquire_for(timeout)) {
+        if (!try_acquire_filled_slot_for(timeout)) {
             // 如果等待超时，直接返回 false
             return false;
         }
 
-        // 2. 成功获取信号量，现在可以安全地访问队列
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            // 再次检查 shutdown 条件，防止在等待期间被关闭
-            if (shutdown_ && queue_.empty()) {
-                filled_slots_.release();
-                return false;
+        // 2. 成功获取信号量，取元素（期间被 shutdown / clear 时返回 false，和超时一样处理）
+        return pop_one_acquired(out_element);
+    }
+
+    // 一次信号量 / 加锁把 [first, last) 里的元素都推进队列。
+    // 队列空位不够时先放进去能放的，剩下的再等；返回实际推进去的个数（shutdown 时可能小于总数）
+    template <typename It>
+    size_t push_bulk(It first, It last)
+    {
+        size_t pushed = 0;
+        auto remaining = static_cast<int64_t>(std::distance(first, last));
+        while (remaining > 0) {
+            if (shutdown_)
+                return pushed;
+            acquire_empty_slot();
+            if (shutdown_)
+                return pushed;
+            int64_t batch = 1 + empty_slots_.try_acquire_up_to(remaining - 1);
+
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex_);
+                for (int64_t i = 0; i < batch; ++i, ++first) {
+                    if (cost_fn_ && !wait_for_budget_locked(lock, *first)) {
+                        // shutdown：已经推进去的照常通知消费者，没用上的空位还回去
+                        lock.unlock();
+                        filled_slots_.release(i);
+                        empty_slots_.release(batch - i);
+                        return pushed + static_cast<size_t>(i);
+                    }
+                    queue_.push(std::move(*first));
+                }
+                if (telemetry_)
+                    telemetry_->on_push(static_cast<size_t>(batch), queue_.size());
             }
-            out_element = std::move(queue_.front());
-            queue_.pop();
+
+            filled_slots_.release(batch);
+            notify_readable();
+            pushed += static_cast<size_t>(batch);
+            remaining -= batch;
         }
+        return pushed;
+    }
 
-        empty_slots_.release();
-        return true;
+    template <typename Range>
+    size_t push_bulk(Range& range)
+    {
+        return push_bulk(std::begin(range), std::end(range));
+    }
+
+    // 最多取 max_count 个元素到 out[0..)，至少等到一个元素或超时；返回取到的个数
+    template <typename Rep, typename Period>
+    size_t pop_bulk(T* out, size_t max_count, const std::chrono::duration<Rep, Period>& timeout)
+    {
+        if (max_count == 0 || (shutdown_ && queue_is_empty_unsafe())) {
+            return 0;
+        }
+        if (!try_acquire_filled_slot_for(timeout)) {
+            return 0;
+        }
+        int64_t taken = 1 + filled_slots_.try_acquire_up_to(static_cast<int64_t>(max_count) - 1);
+        return pop_acquired(out, taken);
+    }
+
+    // 非阻塞版本，给实时音频回调这种不能等待的场景用
+    size_t try_pop_bulk(T* out, size_t max_count)
+    {
+        int64_t taken = filled_slots_.try_acquire_up_to(static_cast<int64_t>(max_count));
+        if (taken == 0) {
+            if (telemetry_)
+                telemetry_->on_underrun();
+            return 0;
+        }
+        return pop_acquired(out, taken);
     }
 
     std::optional<T> front()
@@ -97,38 +211,32 @@ public:
     bool try_pop(T& out_element)
     {
         if (!filled_slots_.try_acquire()) {
+            if (telemetry_)
+                telemetry_->on_underrun();
             return false;
         }
-
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            if (shutdown_ && queue_.empty()) {
-                filled_slots_.release();
-                return false;
-            }
-            out_element = std::move(queue_.front());
-            queue_.pop();
-        }
-
-        empty_slots_.release();
-        return true;
+        return pop_one_acquired(out_element);
     }
 
     void clear()
     {
         std::unique_lock<std::mutex> lock(queue_mutex_);
 
-        size_t count = queue_.size();
+        const size_t count = queue_.size();
         Container empty_queue;
         queue_.swap(empty_queue);
+        if (telemetry_)
+            telemetry_->on_clear(count);
+        cost_in_queue_ = 0;
+        budget_cv_.notify_all();
 
-        // 消耗掉所有 filled 信号
-        for (size_t i = 0; i < count; ++i) {
-            filled_slots_.try_acquire();
-        }
-        // 返还所有 empty 信号
-        for (size_t i = 0; i < count; ++i) {
-            empty_slots_.release();
+        // 消耗掉丢弃的元素对应的 filled 信号，只返还拿到了的那么多 empty 信号。
+        // 拿不到的计数在已经 acquire 了、还没加锁的消费者手里，由它发现队列空了之后返还
+        const int64_t acquired = filled_slots_.try_acquire_up_to(static_cast<int64_t>(count));
+        empty_slots_.release(acquired);
+        lock.unlock();
+        if (count > 0) {
+            notify_writable(0);
         }
     }
     void reset()
@@ -140,14 +248,10 @@ public:
             shutdown_ = false;
         }
 
-        while (filled_slots_.try_acquire())
-            ; // 耗尽已填充信号
-        while (empty_slots_.try_acquire())
-            ; // 耗尽空槽位信号
-
-        for (size_t i = 0; i < max_size_; ++i) {
-            empty_slots_.release();
-        }
+        // shutdown() 对两个信号量调用过 release_all，这里要一并撤销，
+        // 否则 reset 之后 acquire 会直接返回，队列就不再有界了
+        filled_slots_.reset(0);
+        empty_slots_.reset(static_cast<int64_t>(max_size_));
     }
     void shutdown()
     {
@@ -160,6 +264,54 @@ public:
 
         filled_slots_.release_all();
         empty_slots_.release_all();
+        budget_cv_.notify_all();
+        notify_readable();
+        notify_writable(0);
+    }
+
+    bool is_shutdown() const
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        return shutdown_;
+    }
+
+    // 已经满了：个数到上限，或者代价预算已经用完。
+    // 有代价预算时 false 不代表下一个 push 不会阻塞：放不放得下还要看下一个元素有多大（只差一帧就到预算时，
+    // 下一帧照样要等）。不能阻塞的生产者（TaskExecutor 上的任务）要用 try_push，失败了留着元素等 on_writable。
+    // shutdown 之后 push 立刻返回 false，不算满
+    bool full() const
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        if (shutdown_) {
+            return false;
+        }
+        if (queue_.size() >= max_size_) {
+            return true;
+        }
+        return cost_fn_ && !queue_.empty() && cost_in_queue_ >= cost_budget_;
+    }
+
+    // 给 TaskExecutor 上的生产者 / 消费者用的唤醒回调，在锁外调用：
+    //   on_readable: push 进了新元素，或者 shutdown（消费者设置）
+    //   on_writable: 取走元素之后剩下的不超过 watermark 个、clear，或者 shutdown（生产者设置）。
+    //                watermark 小于容量时生产者攒够一批空位才被叫醒，不会每取一个就切换一次；
+    //                这要求消费者会一直取到 watermark 以下（暂停时不会，那时也不需要生产）
+    // 回调要很轻（一般就是 Task::wake()），需要在队列开始使用之前设置
+    void set_on_readable(std::function<void()> on_readable)
+    {
+        on_readable_ = std::move(on_readable);
+    }
+    void set_on_writable(std::function<void()> on_writable, size_t watermark = SIZE_MAX)
+    {
+        on_writable_ = std::move(on_writable);
+        writable_watermark_ = watermark;
+    }
+
+    // 每取走一个元素调用一次（锁外，clear 不调用），比如按流统计包队列里缓冲的时长。
+    // 和上面两个一样需要在队列开始使用之前设置
+    void set_on_pop(std::function<void(const T&)> on_pop)
+    {
+        on_pop_ = std::move(on_pop);
     }
 
     size_t size() const
@@ -174,19 +326,223 @@ public:
         return 0 == queue_.size();
     }
 
+    // 打开统计（见 QueueStats.hpp）。需要在队列开始使用之前调用；
+    // 传入同一个 telemetry 可以让重建的队列（比如 seek 之后）继续累计
+    void set_telemetry(std::shared_ptr<QueueTelemetry> telemetry)
+    {
+        telemetry_ = std::move(telemetry);
+    }
+
+    // 没有打开统计时只有 size 有意义
+    QueueStatsSnapshot stats() const
+    {
+        if (!telemetry_) {
+            QueueStatsSnapshot snapshot;
+            snapshot.size = size();
+            return snapshot;
+        }
+        return telemetry_->snapshot();
+    }
+
+    // 当前队列中元素的总代价，没有设置 cost_fn 时恒为 0
+    size_t cost() const
+    {
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        return cost_in_queue_;
+    }
+
 private:
     bool queue_is_empty_unsafe() const
     {
         return queue_.empty();
     }
 
+    // 打开统计时，只有 try_acquire 失败、真的要阻塞才读时钟
+    void acquire_empty_slot()
+    {
+        if (!telemetry_) {
+            empty_slots_.acquire();
+            return;
+        }
+        if (empty_slots_.try_acquire()) {
+            return;
+        }
+        auto start = QueueTelemetry::Clock::now();
+        empty_slots_.acquire();
+        telemetry_->on_producer_wait(QueueTelemetry::Clock::now() - start);
+    }
+
+    void acquire_filled_slot()
+    {
+        if (!telemetry_) {
+            filled_slots_.acquire();
+            return;
+        }
+        if (filled_slots_.try_acquire()) {
+            return;
+        }
+        auto start = QueueTelemetry::Clock::now();
+        filled_slots_.acquire();
+        telemetry_->on_consumer_wait(QueueTelemetry::Clock::now() - start);
+    }
+
+    template <typename Rep, typename Period>
+    bool try_acquire_filled_slot_for(const std::chrono::duration<Rep, Period>& timeout)
+    {
+        if (!telemetry_) {
+            return filled_slots_.try_acquire_for(timeout);
+        }
+        if (filled_slots_.try_acquire()) {
+            return true;
+        }
+        auto start = QueueTelemetry::Clock::now();
+        bool acquired = filled_slots_.try_acquire_for(timeout);
+        telemetry_->on_consumer_wait(QueueTelemetry::Clock::now() - start);
+        if (!acquired) {
+            telemetry_->on_underrun();
+        }
+        return acquired;
+    }
+
+    void pop_front_locked(T& out_element)
+    {
+        if (telemetry_)
+            telemetry_->on_pop();
+        out_element = std::move(queue_.front());
+        queue_.pop();
+        if (cost_fn_) {
+            cost_in_queue_ -= std::min(cost_in_queue_, cost_fn_(out_element));
+        }
+    }
+
+    void notify_readable()
+    {
+        if (on_readable_)
+            on_readable_();
+    }
+
+    void notify_writable(size_t remaining)
+    {
+        if (on_writable_ && remaining <= writable_watermark_)
+            on_writable_();
+    }
+
+    void notify_popped(const T& element)
+    {
+        if (on_pop_)
+            on_pop_(element);
+    }
+
+    void notify_budget()
+    {
+        if (cost_fn_) {
+            budget_cv_.notify_one();
+        }
+    }
+
+    // 等到预算足够容纳 element 并记账；shutdown 时返回 false
+    bool wait_for_budget_locked(std::unique_lock<std::mutex>& lock, const T& element)
+    {
+        const size_t cost = cost_fn_(element);
+        auto has_budget = [&] {
+            return shutdown_ || queue_.empty() || cost_in_queue_ + cost <= cost_budget_;
+        };
+        if (telemetry_ && !has_budget()) {
+            auto start = QueueTelemetry::Clock::now();
+            budget_cv_.wait(lock, has_budget);
+            telemetry_->on_producer_wait(QueueTelemetry::Clock::now() - start);
+        } else {
+            budget_cv_.wait(lock, has_budget);
+        }
+        if (shutdown_) {
+            return false;
+        }
+        cost_in_queue_ += cost;
+        return true;
+    }
+
+    // 已经从 filled_slots_ 拿到一个计数，取出队首元素。
+    // 计数对应的元素可能在加锁之前被 clear() 丢掉了（clear 不返还它没拿到计数的那些空位），
+    // 这时由这里返还空位并返回 false；shutdown 之后队列取空了也返回 false
+    bool pop_one_acquired(T& out_element)
+    {
+        size_t remaining = 0;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            if (queue_.empty()) {
+                const bool shutdown = shutdown_;
+                lock.unlock();
+                if (shutdown) {
+                    // 如果在等待期间被 shutdown，需要把信号量还回去，以便其他等待者也能退出
+                    filled_slots_.release();
+                } else {
+                    empty_slots_.release();
+                }
+                return false;
+            }
+            pop_front_locked(out_element);
+            remaining = queue_.size();
+        }
+
+        empty_slots_.release();
+        notify_budget();
+        notify_writable(remaining);
+        notify_popped(out_element);
+        return true;
+    }
+
+    // 已经从 filled_slots_ 拿到 taken 个计数，一次加锁把它们都取出来。
+    // 和 pop_one_acquired 一样，被 clear 丢掉的那部分只返还空位，返回实际取到的个数
+    size_t pop_acquired(T* out, int64_t taken)
+    {
+        size_t remaining = 0;
+        int64_t popped = 0;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex_);
+            if (shutdown_ && queue_.empty()) {
+                filled_slots_.release(taken);
+                return 0;
+            }
+            popped = std::min(taken, static_cast<int64_t>(queue_.size()));
+            for (int64_t i = 0; i < popped; ++i) {
+                pop_front_locked(out[i]);
+            }
+            remaining = queue_.size();
+        }
+
+        empty_slots_.release(taken);
+        if (popped == 0) {
+            return 0;
+        }
+        if (cost_fn_) {
+            budget_cv_.notify_all();
+        }
+        notify_writable(remaining);
+        for (int64_t i = 0; i < popped; ++i) {
+            notify_popped(out[i]);
+        }
+        return static_cast<size_t>(popped);
+    }
+
     mutable std::mutex queue_mutex_;
     Container queue_;
     bool shutdown_ = false;
     const size_t max_size_;
 
+    CostFunction cost_fn_;
+    const size_t cost_budget_ = 0;
+    size_t cost_in_queue_ = 0;
+    std::condition_variable budget_cv_;
+
     counting_semaphore empty_slots_;
     counting_semaphore filled_slots_;
+
+    std::shared_ptr<QueueTelemetry> telemetry_;
+
+    std::function<void()> on_readable_;
+    std::function<void()> on_writable_;
+    std::function<void(const T&)> on_pop_;
+    size_t writable_watermark_ = SIZE_MAX;
 };
 
 } // namespace player_utils
\ No newline at end of file
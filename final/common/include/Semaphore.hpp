@@ -1,11 +1,36 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
-#include <condition_variable>
-#include <mutex>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 namespace player_utils {
 
+namespace detail {
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32-bit int");
+
+    inline void futex_wait(std::atomic<uint32_t>* word, uint32_t expected, const timespec* timeout)
+    {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0);
+    }
+
+    inline void futex_wake(std::atomic<uint32_t>* word, int count)
+    {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+    }
+} // namespace detail
+
+// 计数信号量，接口参考 std::counting_semaphore。
+//
+// count_ 为负时表示有 -count_ 个线程在等待。没有竞争时 acquire / release
+// 都只是一次 atomic RMW，不进内核；只有 acquire 把计数减到负数才会在
+// wakeups_ 这个 futex 字上睡眠，release 看到负数时投递一个 "唤醒令牌" 并 FUTEX_WAKE。
 class Semaphore {
 public:
     explicit Semaphore(int64_t count = 0)
@@ -18,59 +43,142 @@ public:
 
     void release()
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        count_++;
-        cv_.notify_one();
+        release(1);
+    }
+
+    // 一次性归还 n 个计数，只唤醒真正在等的那部分线程
+    void release(int64_t n)
+    {
+        int64_t old = count_.fetch_add(n, std::memory_order_release);
+        if (old < 0) {
+            auto to_wake = static_cast<uint32_t>(std::min(-old, n));
+            wakeups_.fetch_add(to_wake, std::memory_order_release);
+            detail::futex_wake(&wakeups_, static_cast<int>(to_wake));
+        }
     }
 
     void acquire()
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        cv_.wait(lock, [this]() { return count_ > 0 || shutdown_; });
-        if (shutdown_) {
+        if (shutdown_.load(std::memory_order_acquire)) {
             return;
         }
-
-        count_--;
+        if (count_.fetch_sub(1, std::memory_order_acquire) > 0) {
+            return;
+        }
+        wait_for_wakeup(nullptr);
     }
 
     bool try_acquire()
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        if (count_ > 0) {
-            count_--;
-            return true;
+        int64_t current = count_.load(std::memory_order_relaxed);
+        while (current > 0) {
+            if (count_.compare_exchange_weak(current, current - 1,
+                    std::memory_order_acquire, std::memory_order_relaxed)) {
+                return true;
+            }
         }
         return false;
     }
 
+    // 非阻塞地取走最多 max_count 个计数，返回实际取到的个数
+    int64_t try_acquire_up_to(int64_t max_count)
+    {
+        int64_t current = count_.load(std::memory_order_relaxed);
+        while (current > 0 && max_count > 0) {
+            int64_t taken = std::min(current, max_count);
+            if (count_.compare_exchange_weak(current, current - taken,
+                    std::memory_order_acquire, std::memory_order_relaxed)) {
+                return taken;
+            }
+        }
+        return 0;
+    }
+
     template <typename Rep, typename Period>
     bool try_acquire_for(const std::chrono::duration<Rep, Period>& timeout)
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        if (!cv_.wait_for(lock, timeout, [this]() { return count_ > 0 || shutdown_; })) {
+        if (shutdown_.load(std::memory_order_acquire)) {
             return false;
         }
-
-        if (shutdown_) {
-            return false;
+        if (try_acquire()) {
+            return true;
         }
-
-        count_--;
-        return true;
+        if (count_.fetch_sub(1, std::memory_order_acquire) > 0) {
+            return true;
+        }
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        return wait_for_wakeup(&deadline);
     }
 
+    // 广播唤醒所有等待者，之后 acquire 直接返回、try_acquire_for 返回 false
     void release_all()
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        shutdown_ = true;
-        cv_.notify_all();
+        shutdown_.store(true, std::memory_order_release);
+        wakeups_.fetch_add(1, std::memory_order_release);
+        detail::futex_wake(&wakeups_, INT_MAX);
+    }
+
+    // 撤销 release_all 并把计数恢复为 count，只能在没有线程等待时调用（SemQueue::reset）
+    void reset(int64_t count)
+    {
+        count_.store(count, std::memory_order_relaxed);
+        wakeups_.store(0, std::memory_order_relaxed);
+        shutdown_.store(false, std::memory_order_release);
     }
 
 private:
-    std::mutex mutex_;
-    std::condition_variable cv_;
-    int64_t count_;
-    bool shutdown_ = false;
+    bool try_take_wakeup()
+    {
+        uint32_t tokens = wakeups_.load(std::memory_order_acquire);
+        while (tokens > 0) {
+            if (wakeups_.compare_exchange_weak(tokens, tokens - 1,
+                    std::memory_order_acquire, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 已经把 count_ 减成负数（登记为等待者），等 release 投递令牌
+    bool wait_for_wakeup(const std::chrono::steady_clock::time_point* deadline)
+    {
+        while (true) {
+            if (shutdown_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            if (try_take_wakeup()) {
+                return true;
+            }
+
+            if (deadline == nullptr) {
+                detail::futex_wait(&wakeups_, 0, nullptr);
+                continue;
+            }
+
+            auto remaining = *deadline - std::chrono::steady_clock::now();
+            if (remaining > std::chrono::steady_clock::duration::zero()) {
+                auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining).count();
+                timespec ts {};
+                ts.tv_sec = static_cast<time_t>(ns / 1'000'000'000);
+                ts.tv_nsec = static_cast<long>(ns % 1'000'000'000);
+                detail::futex_wait(&wakeups_, 0, &ts);
+                continue;
+            }
+
+            // 超时：把自己从等待者里撤销。如果 count_ 已经不是负数，
+            // 说明某个 release 已经（或马上就会）为我们投递令牌，只能把它取走
+            int64_t current = count_.load(std::memory_order_relaxed);
+            while (current < 0) {
+                if (count_.compare_exchange_weak(current, current + 1, std::memory_order_relaxed)) {
+                    return false;
+                }
+            }
+            deadline = nullptr;
+        }
+    }
+
+    std::atomic<int64_t> count_;
+    std::atomic<uint32_t> wakeups_ { 0 };
+    std::atomic<bool> shutdown_ { false };
 };
-} // namespace player_utils
\ No newline at end of file
+} // namespace player_utils
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+namespace player_utils {
+
+// 单生产者/单消费者的有界队列，接口与 SemQueue 保持一致，可以按 hop 逐个替换。
+//
+// push / pop 的快路径只有几次 atomic load/store（wait-free）；
+// 只有在队列满（生产者）或空（消费者）时才会在 mutex + condvar 上挂起。
+//
+// 约束：
+// * 同一时刻只能有一个线程 push，一个线程 pop/front/try_pop/clear；
+// * reset() 需要在两端都不活动时调用（与 SemQueue 在 seek 流程中的用法一致）。
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t max_size)
+        : max_size_(max_size == 0 ? 1 : max_size)
+        , mask_(round_up_pow2(max_size_) - 1)
+        , slots_(std::make_unique<std::optional<T>[]>(mask_ + 1))
+    {
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    ~SpscQueue() { drain(); }
+
+    bool push(T element)
+    {
+        if (shutdown_.load(std::memory_order_acquire))
+            return false;
+
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_cache_ >= max_size_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (tail - head_cache_ >= max_size_ && !wait_for_space(tail)) {
+                return false;
+            }
+        }
+
+        slots_[tail & mask_].emplace(std::move(element));
+        tail_.store(tail + 1, std::memory_order_release);
+        wake(consumer_waiting_, not_empty_);
+        return true;
+    }
+
+    bool wait_and_pop(T& out_element)
+    {
+        if (!has_data() && !wait_for_data(nullptr))
+            return false;
+        pop_front(out_element);
+        return true;
+    }
+
+    template <typename Rep, typename Period>
+    bool wait_and_pop(T& out_element, const std::chrono::duration<Rep, Period>& timeout)
+    {
+        if (!has_data()) {
+            auto deadline = std::chrono::steady_clock::now() + timeout;
+            if (!wait_for_data(&deadline))
+                return false;
+        }
+        pop_front(out_element);
+        return true;
+    }
+
+    bool try_pop(T& out_element)
+    {
+        if (!has_data())
+            return false;
+        pop_front(out_element);
+        return true;
+    }
+
+    // 只能在消费者线程调用
+    std::optional<T> front()
+    {
+        if (!has_data())
+            return std::nullopt;
+        return *slots_[head_.load(std::memory_order_relaxed) & mask_];
+    }
+
+    // 消费者侧操作：丢弃当前所有元素并唤醒可能在等空位的生产者
+    void clear()
+    {
+        drain();
+        wake(producer_waiting_, not_full_);
+    }
+
+    void reset()
+    {
+        clear();
+        shutdown_.store(false, std::memory_order_release);
+    }
+
+    void shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(park_mutex_);
+            if (shutdown_.load(std::memory_order_relaxed))
+                return;
+            shutdown_.store(true, std::memory_order_release);
+        }
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    size_t size() const
+    {
+        const size_t head = head_.load(std::memory_order_acquire);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    size_t capacity() const { return max_size_; }
+
+private:
+    static size_t round_up_pow2(size_t n)
+    {
+        size_t p = 1;
+        while (p < n)
+            p <<= 1;
+        return p;
+    }
+
+    bool has_data()
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (tail_cache_ != head)
+            return true;
+        tail_cache_ = tail_.load(std::memory_order_acquire);
+        return tail_cache_ != head;
+    }
+
+    void pop_front(T& out_element)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        auto& slot = slots_[head & mask_];
+        out_element = std::move(*slot);
+        slot.reset();
+        head_.store(head + 1, std::memory_order_release);
+        wake(producer_waiting_, not_full_);
+    }
+
+    void drain()
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        for (; head != tail; ++head) {
+            slots_[head & mask_].reset();
+        }
+        head_.store(head, std::memory_order_release);
+        tail_cache_ = tail;
+    }
+
+    // 对端发布数据后检查是否有人挂起；fence 保证 "先发布、再读 waiting 标志"，
+    // 与挂起方 "先置 waiting、再复查索引" 配对，避免丢失唤醒
+    void wake(std::atomic<bool>& waiting, std::condition_variable& cv)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiting.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(park_mutex_);
+            cv.notify_one();
+        }
+    }
+
+    bool wait_for_space(size_t tail)
+    {
+        std::unique_lock<std::mutex> lock(park_mutex_);
+        producer_waiting_.store(true, std::memory_order_seq_cst);
+        bool ok = true;
+        while (true) {
+            if (shutdown_.load(std::memory_order_acquire)) {
+                ok = false;
+                break;
+            }
+            head_cache_ = head_.load(std::memory_order_seq_cst);
+            if (tail - head_cache_ < max_size_)
+                break;
+            not_full_.wait(lock);
+        }
+        producer_waiting_.store(false, std::memory_order_relaxed);
+        return ok;
+    }
+
+    // shutdown 后仍允许把剩余元素取完，行为与 SemQueue 一致
+    bool wait_for_data(const std::chrono::steady_clock::time_point* deadline)
+    {
+        std::unique_lock<std::mutex> lock(park_mutex_);
+        consumer_waiting_.store(true, std::memory_order_seq_cst);
+        bool ok = true;
+        while (true) {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            tail_cache_ = tail_.load(std::memory_order_seq_cst);
+            if (tail_cache_ != head)
+                break;
+            if (shutdown_.load(std::memory_order_acquire)) {
+                ok = false;
+                break;
+            }
+            if (deadline == nullptr) {
+                not_empty_.wait(lock);
+            } else if (not_empty_.wait_until(lock, *deadline) == std::cv_status::timeout) {
+                tail_cache_ = tail_.load(std::memory_order_seq_cst);
+                ok = tail_cache_ != head;
+                break;
+            }
+        }
+        consumer_waiting_.store(false, std::memory_order_relaxed);
+        return ok;
+    }
+
+    static constexpr size_t kCacheLine = 64;
+
+    const size_t max_size_;
+    const size_t mask_;
+    std::unique_ptr<std::optional<T>[]> slots_;
+
+    // 消费者独占
+    alignas(kCacheLine) std::atomic<size_t> head_ { 0 };
+    size_t tail_cache_ = 0;
+
+    // 生产者独占
+    alignas(kCacheLine) std::atomic<size_t> tail_ { 0 };
+    size_t head_cache_ = 0;
+
+    alignas(kCacheLine) std::atomic<bool> shutdown_ { false };
+    std::atomic<bool> consumer_waiting_ { false };
+    std::atomic<bool> producer_waiting_ { false };
+    std::mutex park_mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+} // namespace player_utils
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace player_utils {
+
+// 快速打开。avformat_find_stream_info 为了补全编解码参数会读、甚至解码好几秒数据，
+// 大 mp4 的起播时间大半花在这里：
+//   probesize / analyzeduration_us: 探测最多读多少字节 / 多长时间的数据，<= 0 用 FFmpeg 默认值
+//   trust_header: 容器头（mp4 的 moov）已经把每个音视频流的参数写全了，就不再探测
+//   cache_dir   : 探测过的参数按文件身份（路径、大小、修改时间）存一份，下次直接用，为空时不缓存
+struct FastOpenOptions {
+    bool enabled = false;
+    int64_t probesize = 1024 * 1024;
+    int64_t analyzeduration_us = 1000000;
+    bool trust_header = true;
+    std::string cache_dir;
+};
+
+// 文件变了（大小或修改时间不同）缓存就作废
+struct FileIdentity {
+    std::string path;
+    int64_t size = -1;
+    int64_t mtime_ns = 0;
+
+    static bool of(const std::string& path, FileIdentity& out)
+    {
+        struct stat st {};
+        if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            return false;
+        }
+        out.path = path;
+        out.size = static_cast<int64_t>(st.st_size);
+        out.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+        return true;
+    }
+
+    bool operator==(const FileIdentity& other) const
+    {
+        return path == other.path && size == other.size && mtime_ns == other.mtime_ns;
+    }
+};
+
+// 一个流的编解码参数，字段和 AVCodecParameters 一一对应，枚举按整数存。
+// 这里不碰 FFmpeg，MediaSource 负责和 AVCodecParameters 互相转换
+struct CachedStreamInfo {
+    int32_t codec_type = -1;
+    int32_t codec_id = 0;
+    uint32_t codec_tag = 0;
+    int32_t format = -1;
+    int64_t bit_rate = 0;
+    int32_t profile = -99;
+    int32_t level = -99;
+
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t sar_num = 0;
+    int32_t sar_den = 1;
+    int32_t color_range = 0;
+    int32_t color_primaries = 2;
+    int32_t color_trc = 2;
+    int32_t color_space = 2;
+    int32_t video_delay = 0;
+
+    int32_t sample_rate = 0;
+    int32_t channels = 0;
+    uint64_t channel_mask = 0; // 0 表示不是按声道掩码描述的布局，恢复时按声道数取默认布局
+    int32_t frame_size = 0;
+
+    std::vector<uint8_t> extradata;
+};
+
+// 一个文件一项，文件名是路径的 FNV-1a 哈希；项里再存一遍完整的文件身份，哈希撞了也不会用错
+class StreamInfoCache {
+public:
+    struct Entry {
+        int64_t duration = 0; // AVFormatContext::duration，AV_TIME_BASE 为单位
+        std::vector<CachedStreamInfo> streams;
+    };
+
+    explicit StreamInfoCache(std::string dir)
+        : dir_(std::move(dir))
+    {
+    }
+
+    [[nodiscard]] std::string entry_path(const FileIdentity& id) const
+    {
+        uint64_t hash = 1469598103934665603ULL;
+        for (unsigned char c : id.path) {
+            hash = (hash ^ c) * 1099511628211ULL;
+        }
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.sinfo", static_cast<unsigned long long>(hash));
+        return dir_ + "/" + name;
+    }
+
+    bool load(const FileIdentity& id, Entry& entry) const
+    {
+        std::ifstream in(entry_path(id), std::ios::binary);
+        return in && read(in, id, entry);
+    }
+
+    bool save(const FileIdentity& id, const Entry& entry) const
+    {
+        // 先写临时文件再改名，两个播放器同时打开同一个文件也不会读到写了一半的项
+        const std::string path = entry_path(id);
+        const std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out || !write(out, id, entry)) {
+                std::remove(tmp.c_str());
+                return false;
+            }
+        }
+        return std::rename(tmp.c_str(), path.c_str()) == 0;
+    }
+
+    static bool write(std::ostream& out, const FileIdentity& id, const Entry& entry)
+    {
+        out.write(kMagic, sizeof(kMagic));
+        write_string(out, id.path);
+        write_pod(out, id.size);
+        write_pod(out, id.mtime_ns);
+        write_pod(out, entry.duration);
+        write_pod(out, static_cast<uint32_t>(entry.streams.size()));
+        for (const CachedStreamInfo& s : entry.streams) {
+            write_pod(out, s.codec_type);
+            write_pod(out, s.codec_id);
+            write_pod(out, s.codec_tag);
+            write_pod(out, s.format);
+            write_pod(out, s.bit_rate);
+            write_pod(out, s.profile);
+            write_pod(out, s.level);
+            write_pod(out, s.width);
+            write_pod(out, s.height);
+            write_pod(out, s.sar_num);
+            write_pod(out, s.sar_den);
+            write_pod(out, s.color_range);
+            write_pod(out, s.color_primaries);
+            write_pod(out, s.color_trc);
+            write_pod(out, s.color_space);
+            write_pod(out, s.video_delay);
+            write_pod(out, s.sample_rate);
+            write_pod(out, s.channels);
+            write_pod(out, s.channel_mask);
+            write_pod(out, s.frame_size);
+            write_pod(out, static_cast<uint32_t>(s.extradata.size()));
+            out.write(reinterpret_cast<const char*>(s.extradata.data()), static_cast<std::streamsize>(s.extradata.size()));
+        }
+        return static_cast<bool>(out);
+    }
+
+    // 身份对不上、版本不对或者文件坏了都返回 false，entry 不变
+    static bool read(std::istream& in, const FileIdentity& id, Entry& entry)
+    {
+        char magic[sizeof(kMagic)] = {};
+        in.read(magic, sizeof(magic));
+        if (!in || !std::equal(magic, magic + sizeof(magic), kMagic)) {
+            return false;
+        }
+        FileIdentity stored;
+        if (!read_string(in, stored.path) || !read_pod(in, stored.size) || !read_pod(in, stored.mtime_ns) || !(stored == id)) {
+            return false;
+        }
+        Entry loaded;
+        uint32_t count = 0;
+        if (!read_pod(in, loaded.duration) || !read_pod(in, count) || count == 0 || count > kMaxStreams) {
+            return false;
+        }
+        loaded.streams.resize(count);
+        for (CachedStreamInfo& s : loaded.streams) {
+            uint32_t extradata_size = 0;
+            const bool ok = read_pod(in, s.codec_type) && read_pod(in, s.codec_id) && read_pod(in, s.codec_tag)
+                && read_pod(in, s.format) && read_pod(in, s.bit_rate) && read_pod(in, s.profile) && read_pod(in, s.level)
+                && read_pod(in, s.width) && read_pod(in, s.height) && read_pod(in, s.sar_num) && read_pod(in, s.sar_den)
+                && read_pod(in, s.color_range) && read_pod(in, s.color_primaries) && read_pod(in, s.color_trc)
+                && read_pod(in, s.color_space) && read_pod(in, s.video_delay) && read_pod(in, s.sample_rate)
+                && read_pod(in, s.channels) && read_pod(in, s.channel_mask) && read_pod(in, s.frame_size)
+                && read_pod(in, extradata_size) && extradata_size <= kMaxExtradata;
+            if (!ok) {
+                return false;
+            }
+            s.extradata.resize(extradata_size);
+            in.read(reinterpret_cast<char*>(s.extradata.data()), extradata_size);
+            if (!in) {
+                return false;
+            }
+        }
+        entry = std::move(loaded);
+        return true;
+    }
+
+private:
+    static constexpr char kMagic[4] = { 'S', 'I', 'C', '1' };
+    // 防止坏文件让 read 申请一大块内存
+    static constexpr uint32_t kMaxStreams = 64;
+    static constexpr uint32_t kMaxExtradata = 1U << 20;
+    static constexpr uint32_t kMaxPath = 1U << 16;
+
+    template <typename T>
+    static void write_pod(std::ostream& out, T value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    template <typename T>
+    static bool read_pod(std::istream& in, T& value)
+    {
+        in.read(reinterpret_cast<char*>(&value), sizeof(value));
+        return static_cast<bool>(in);
+    }
+
+    static void write_string(std::ostream& out, const std::string& s)
+    {
+        write_pod(out, static_cast<uint32_t>(s.size()));
+        out.write(s.data(), static_cast<std::streamsize>(s.size()));
+    }
+
+    static bool read_string(std::istream& in, std::string& s)
+    {
+        uint32_t size = 0;
+        if (!read_pod(in, size) || size > kMaxPath) {
+            return false;
+        }
+        s.resize(size);
+        in.read(&s[0], size);
+        return static_cast<bool>(in);
+    }
+
+    std::string dir_;
+};
+
+} // namespace player_utils
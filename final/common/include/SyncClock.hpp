@@ -1,6 +1,8 @@
 #pragma once
+#include "FrameSkipPolicy.hpp"
 #include <atomic>
 #include <cstdint>
+#include <memory>
 
 class SyncClock {
 public:
@@ -19,7 +21,11 @@ public:
 
     SyncDecision checkVideoFrame(double video_pts);
 
+    // checkVideoFrame 顺带发布视频落后了多少，交给视频解码线程决定跳帧档位
+    [[nodiscard]] std::shared_ptr<const player_utils::VideoLateness> lateness() const { return lateness_; }
+
 private:
     std::atomic<double> master_clock_pts_ { 0.0 };
     std::atomic<int> frame_counter_ { 0 };
+    std::shared_ptr<player_utils::VideoLateness> lateness_ = std::make_shared<player_utils::VideoLateness>();
 };
\ No newline at end of file
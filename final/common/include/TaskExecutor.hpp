@@ -0,0 +1,370 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace player_utils {
+
+// 多个播放器共用的固定数量工作线程。
+//
+// 解复用 / 解码不再各占一个线程阻塞在队列上，而是写成可以中途让出的 step 函数，交给这里调度：
+//   kYield: 还有活，排到队尾，让别的任务先跑
+//   kWait : 输入空了或者输出满了，挂起直到有人调用 Task::wake()（一般是 SemQueue 的唤醒回调）
+//   kSleep: 挂起，过一段固定的退避时间自动醒（或者更早被 wake），用于没有唤醒回调可挂的下游
+//   kDone : 结束，wait_done() 返回
+// 每个工作线程有自己的任务队列，工作线程里唤醒的任务进自己的队列，空了就从别的线程的队尾偷；
+// 工作线程之外唤醒的任务进公共队列。step 函数不要长时间阻塞，否则会占住一个工作线程。
+class TaskExecutor {
+public:
+    enum class Step {
+        kYield,
+        kWait,
+        kSleep,
+        kDone,
+    };
+
+    struct Stats {
+        uint64_t steps = 0;
+        uint64_t steals = 0;
+        uint64_t waits = 0;
+        uint64_t sleeps = 0;
+    };
+
+    class Task : public std::enable_shared_from_this<Task> {
+    public:
+        // 挂起的任务重新排队；正在运行的任务会在这一步结束之后再跑一次，所以唤醒不会丢
+        void wake()
+        {
+            int state = state_.load(std::memory_order_acquire);
+            while (true) {
+                if (state == kIdle) {
+                    if (state_.compare_exchange_weak(state, kQueued, std::memory_order_acq_rel)) {
+                        executor_->schedule(this);
+                        return;
+                    }
+                } else if (state == kRunning) {
+                    if (state_.compare_exchange_weak(state, kNotified, std::memory_order_acq_rel)) {
+                        return;
+                    }
+                } else {
+                    return; // 已经在排队、已经被通知过，或者已经结束
+                }
+            }
+        }
+
+        void wait_done()
+        {
+            std::unique_lock<std::mutex> lock(done_mutex_);
+            done_cv_.wait(lock, [this] { return done_; });
+        }
+
+        [[nodiscard]] bool done() const { return state_.load(std::memory_order_acquire) == kDone; }
+
+    private:
+        friend class TaskExecutor;
+        enum : int {
+            kIdle,
+            kQueued,
+            kRunning,
+            kNotified,
+            kDone,
+        };
+
+        Task(TaskExecutor* executor, std::function<Step()> step, std::chrono::microseconds backoff)
+            : executor_(executor)
+            , step_(std::move(step))
+            , backoff_(backoff)
+        {
+        }
+
+        TaskExecutor* executor_;
+        std::function<Step()> step_;
+        std::chrono::microseconds backoff_;
+        std::atomic<int> state_ { kIdle };
+        // 排队期间由执行器持有一份引用，组件那边放掉 shared_ptr 也不会悬空
+        std::shared_ptr<Task> self_;
+
+        std::mutex done_mutex_;
+        std::condition_variable done_cv_;
+        bool done_ = false;
+    };
+
+    explicit TaskExecutor(unsigned workers = default_workers())
+        : workers_(std::max(1U, workers))
+    {
+        for (size_t i = 0; i < workers_.size(); ++i) {
+            workers_[i].thread = std::thread(&TaskExecutor::worker_loop, this, i);
+        }
+    }
+
+    // 还没结束的任务不再运行，它们的 wait_done() 也不会返回，所以要先停掉所有用到它的组件
+    ~TaskExecutor()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& worker : workers_) {
+            worker.thread.join();
+        }
+        // 打破排队任务的自引用
+        for (auto& worker : workers_) {
+            for (Task* task : worker.tasks) {
+                task->self_.reset();
+            }
+        }
+        for (Task* task : injected_) {
+            task->self_.reset();
+        }
+        while (!timers_.empty()) {
+            timers_.top().task->self_.reset();
+            timers_.pop();
+        }
+    }
+
+    TaskExecutor(const TaskExecutor&) = delete;
+    TaskExecutor& operator=(const TaskExecutor&) = delete;
+
+    // 创建一个挂起的任务，第一次 wake() 之后开始运行。backoff 是 kSleep 的退避时间
+    std::shared_ptr<Task> spawn(std::function<Step()> step,
+        std::chrono::microseconds backoff = std::chrono::milliseconds(4))
+    {
+        return std::shared_ptr<Task>(new Task(this, std::move(step), backoff));
+    }
+
+    [[nodiscard]] size_t worker_count() const { return workers_.size(); }
+
+    [[nodiscard]] Stats stats() const
+    {
+        Stats s;
+        s.steps = steps_.load(std::memory_order_relaxed);
+        s.steals = steals_.load(std::memory_order_relaxed);
+        s.waits = waits_.load(std::memory_order_relaxed);
+        s.sleeps = sleeps_.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // 留一个核给渲染 / 音频这些仍然独占线程的部分
+    static unsigned default_workers()
+    {
+        const unsigned cores = std::thread::hardware_concurrency();
+        return cores > 2 ? cores - 1 : 2;
+    }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task*> tasks;
+        std::thread thread;
+    };
+
+    struct Timer {
+        std::chrono::steady_clock::time_point due;
+        std::shared_ptr<Task> task;
+        bool operator>(const Timer& other) const { return due > other.due; }
+    };
+
+    // 当前线程是哪个执行器的第几个工作线程
+    struct CurrentWorker {
+        const TaskExecutor* owner = nullptr;
+        size_t index = 0;
+    };
+    static CurrentWorker& current()
+    {
+        static thread_local CurrentWorker worker;
+        return worker;
+    }
+
+    void schedule(Task* task)
+    {
+        task->self_ = task->shared_from_this();
+        const CurrentWorker& me = current();
+        if (me.owner != this) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                injected_.push_back(task);
+            }
+            queued_.fetch_add(1);
+            notify_sleeper();
+            return;
+        }
+        bool backlog = false;
+        {
+            std::lock_guard<std::mutex> lock(workers_[me.index].mutex);
+            backlog = !workers_[me.index].tasks.empty();
+            workers_[me.index].tasks.push_back(task);
+        }
+        queued_.fetch_add(1);
+        // 当前工作线程这一步跑完就会取到它；只有前面还排着别的任务时才叫醒别的线程来偷，
+        // 否则生产者 / 消费者互相唤醒时每次都要多一次线程切换
+        if (backlog) {
+            notify_sleeper();
+        }
+    }
+
+    void notify_sleeper()
+    {
+        // 和 worker_loop 里 sleepers_ / queued_ 的先后顺序配对，保证不会两边都看不到对方
+        if (sleepers_.load() > 0) {
+            { std::lock_guard<std::mutex> lock(mutex_); }
+            cv_.notify_one();
+        }
+    }
+
+    Task* take(size_t index)
+    {
+        {
+            Worker& own = workers_[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                Task* task = own.tasks.front();
+                own.tasks.pop_front();
+                return task;
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!injected_.empty()) {
+                Task* task = injected_.front();
+                injected_.pop_front();
+                return task;
+            }
+        }
+        for (size_t n = 1; n < workers_.size(); ++n) {
+            Worker& victim = workers_[(index + n) % workers_.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                Task* task = victim.tasks.back();
+                victim.tasks.pop_back();
+                steals_.fetch_add(1, std::memory_order_relaxed);
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    void run(Task* task)
+    {
+        std::shared_ptr<Task> keep = std::move(task->self_);
+        task->state_.store(Task::kRunning, std::memory_order_release);
+        const Step step = task->step_();
+        steps_.fetch_add(1, std::memory_order_relaxed);
+
+        if (step == Step::kDone) {
+            task->state_.store(Task::kDone, std::memory_order_release);
+            {
+                std::lock_guard<std::mutex> lock(task->done_mutex_);
+                task->done_ = true;
+            }
+            task->done_cv_.notify_all();
+            return;
+        }
+        if (step == Step::kSleep) {
+            sleeps_.fetch_add(1, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(mutex_);
+            timers_.push(Timer { std::chrono::steady_clock::now() + task->backoff_, keep });
+        } else if (step == Step::kWait) {
+            waits_.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (step != Step::kYield) {
+            int expected = Task::kRunning;
+            if (task->state_.compare_exchange_strong(expected, Task::kIdle, std::memory_order_acq_rel)) {
+                return;
+            }
+            // 运行期间被 wake 过，接着排队
+        }
+        task->state_.store(Task::kQueued, std::memory_order_release);
+        task->self_ = std::move(keep);
+        requeue(task);
+    }
+
+    void requeue(Task* task)
+    {
+        const CurrentWorker& me = current();
+        {
+            std::lock_guard<std::mutex> lock(workers_[me.index].mutex);
+            workers_[me.index].tasks.push_back(task);
+        }
+        queued_.fetch_add(1);
+        notify_sleeper();
+    }
+
+    // 把到期的定时任务取出来唤醒，返回下一个到期时刻（没有时为 max）
+    std::chrono::steady_clock::time_point fire_timers()
+    {
+        std::vector<std::shared_ptr<Task>> due;
+        std::chrono::steady_clock::time_point next = std::chrono::steady_clock::time_point::max();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            const auto now = std::chrono::steady_clock::now();
+            while (!timers_.empty() && timers_.top().due <= now) {
+                due.push_back(timers_.top().task);
+                timers_.pop();
+            }
+            if (!timers_.empty()) {
+                next = timers_.top().due;
+            }
+        }
+        for (auto& task : due) {
+            task->wake();
+        }
+        return next;
+    }
+
+    void worker_loop(size_t index)
+    {
+        current() = CurrentWorker { this, index };
+        while (true) {
+            const auto next_timer = fire_timers();
+            if (Task* task = take(index)) {
+                queued_.fetch_sub(1);
+                run(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (stop_) {
+                return;
+            }
+            sleepers_.fetch_add(1);
+            auto ready = [this] { return stop_ || queued_.load() > 0; };
+            if (next_timer == std::chrono::steady_clock::time_point::max()) {
+                cv_.wait(lock, ready);
+            } else {
+                cv_.wait_until(lock, next_timer, ready);
+            }
+            sleepers_.fetch_sub(1);
+        }
+    }
+
+    std::vector<Worker> workers_;
+
+    // 公共队列、定时器和休眠的工作线程共用这把锁
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Task*> injected_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<>> timers_;
+    bool stop_ = false;
+
+    std::atomic<int64_t> queued_ { 0 };
+    std::atomic<int> sleepers_ { 0 };
+
+    std::atomic<uint64_t> steps_ { 0 };
+    std::atomic<uint64_t> steals_ { 0 };
+    std::atomic<uint64_t> waits_ { 0 };
+    std::atomic<uint64_t> sleeps_ { 0 };
+};
+
+} // namespace player_utils
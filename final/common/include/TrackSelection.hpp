@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace player_utils {
+
+enum class TrackType {
+    Video,
+    Audio,
+    Subtitle,
+    Other, // 数据轨道、封面等，从不解复用
+};
+
+// 容器里的一条轨道。id 是容器自己的轨道号（mp4 的 track_ID，即 AVStream::id），
+// stream_index 是 FFmpeg 的流下标，只在这次打开里有效
+struct TrackInfo {
+    int id = -1;
+    int stream_index = -1;
+    TrackType type = TrackType::Other;
+    std::string codec;
+    std::string language; // ISO 639-2，容器没写时为空（mp4 的 "und" 也当作空）
+    bool is_default = false;
+};
+
+// 要播的轨道，按 TrackInfo::id。音视频 < 0 表示自动选最佳的一条，字幕 < 0 表示不要字幕。
+// 没选中的流在解复用时直接跳过（AVDISCARD_ALL），不再读出来再丢掉
+struct TrackSelection {
+    int video_id = -1;
+    int audio_id = -1;
+    int subtitle_id = -1;
+};
+
+// id 对应的 type 类型轨道的流下标；id < 0、没有这个 id 或者类型不对时返回 fallback
+inline int resolve_track(const std::vector<TrackInfo>& tracks, TrackType type, int id, int fallback)
+{
+    if (id < 0) {
+        return fallback;
+    }
+    for (const TrackInfo& track : tracks) {
+        if (track.id == id) {
+            return track.type == type ? track.stream_index : fallback;
+        }
+    }
+    return fallback;
+}
+
+// 流下标对应的轨道，没有时返回 nullptr
+inline const TrackInfo* find_track_by_stream(const std::vector<TrackInfo>& tracks, int stream_index)
+{
+    for (const TrackInfo& track : tracks) {
+        if (track.stream_index == stream_index) {
+            return &track;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace player_utils
@@ -0,0 +1,215 @@
+#pragma once
+
+#include "Entitys.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <tuple>
+#include <vector>
+
+namespace player_utils {
+
+// 按 (width, height, format) 回收 VideoFrame 的对象池。
+//
+// acquire 返回的 shared_ptr 带自定义 deleter：最后一个引用释放时（通常在渲染线程），
+// 帧连同 data 的容量一起回到池里，下一次同尺寸的 acquire 直接复用，
+// 既没有 new，也没有 vector::resize 的清零。shared_ptr 的控制块也从池里的空闲块分配，
+// 所以稳定状态下 解码 -> 渲染 整条路径上没有堆分配。
+//
+// 池本身可以先于帧销毁：共享状态由还在外面的帧持有，最后一帧释放时一起回收。
+class VideoFramePool {
+public:
+    struct Stats {
+        uint64_t acquires = 0;
+        uint64_t hits = 0; // 复用了池里的帧
+        size_t idle = 0; // 当前在池里等待复用的帧数
+
+        [[nodiscard]] double hit_rate() const { return acquires ? static_cast<double>(hits) / acquires : 0.0; }
+    };
+
+    // max_idle_per_key: 每种尺寸最多缓存的空闲帧数，超过的直接释放
+    explicit VideoFramePool(size_t max_idle_per_key = 8)
+        : state_(std::make_shared<State>(max_idle_per_key))
+    {
+    }
+
+    // 拿到一帧，data.size() == bytes，内容未定义（由调用者整块覆盖）
+    std::shared_ptr<VideoFrame> acquire(int width, int height, int format, size_t bytes)
+    {
+        State& state = *state_;
+        state.acquires.fetch_add(1, std::memory_order_relaxed);
+
+        std::unique_ptr<VideoFrame> frame;
+        {
+            std::lock_guard<std::mutex> lock(state.mutex);
+            auto it = state.idle.find(Key { width, height, format });
+            if (it != state.idle.end() && !it->second.empty()) {
+                frame = std::move(it->second.back());
+                it->second.pop_back();
+                --state.idle_count;
+            }
+        }
+
+        if (frame) {
+            state.hits.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            frame = std::make_unique<VideoFrame>();
+        }
+        frame->width = width;
+        frame->height = height;
+        frame->format = format;
+        frame->pts = 0.0;
+        frame->linesize.fill(0);
+        frame->buffer_ref.reset();
+        frame->planes.fill(nullptr);
+        frame->ref_bytes = 0;
+        frame->data.resize(bytes);
+
+        return std::shared_ptr<VideoFrame>(frame.release(), Recycler { state_ }, BlockAllocator<VideoFrame> { state_ });
+    }
+
+    // 预先备好 count 帧（连同控制块），避免稳定之前的几帧走分配路径。预热不计入命中率
+    void prewarm(int width, int height, int format, size_t bytes, size_t count)
+    {
+        const uint64_t hits_before = state_->hits.load(std::memory_order_relaxed);
+        std::vector<std::shared_ptr<VideoFrame>> frames;
+        frames.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            frames.push_back(acquire(width, height, format, bytes));
+        }
+        frames.clear();
+        state_->acquires.fetch_sub(count, std::memory_order_relaxed);
+        state_->hits.fetch_sub(state_->hits.load(std::memory_order_relaxed) - hits_before, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] Stats stats() const
+    {
+        Stats s;
+        s.acquires = state_->acquires.load(std::memory_order_relaxed);
+        s.hits = state_->hits.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        s.idle = state_->idle_count;
+        return s;
+    }
+
+    // 释放所有空闲帧（比如分辨率切换之后旧尺寸不会再用到）
+    void trim()
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->idle.clear();
+        state_->idle_count = 0;
+    }
+
+private:
+    using Key = std::tuple<int, int, int>;
+
+    struct State {
+        explicit State(size_t max_idle)
+            : max_idle_per_key(max_idle)
+        {
+            free_blocks.reserve(kMaxFreeBlocks);
+        }
+
+        ~State()
+        {
+            for (void* block : free_blocks) {
+                ::operator delete(block);
+            }
+        }
+
+        const size_t max_idle_per_key;
+        std::mutex mutex;
+        std::map<Key, std::vector<std::unique_ptr<VideoFrame>>> idle;
+        size_t idle_count = 0;
+
+        // shared_ptr 控制块的空闲链表，控制块大小在第一次分配时确定
+        std::vector<void*> free_blocks;
+        size_t block_size = 0;
+
+        std::atomic<uint64_t> acquires { 0 };
+        std::atomic<uint64_t> hits { 0 };
+
+        void recycle(VideoFrame* frame)
+        {
+            std::unique_ptr<VideoFrame> owned(frame);
+            std::lock_guard<std::mutex> lock(mutex);
+            auto& bucket = idle[Key { frame->width, frame->height, frame->format }];
+            if (bucket.size() < max_idle_per_key) {
+                if (bucket.capacity() < max_idle_per_key) {
+                    bucket.reserve(max_idle_per_key);
+                }
+                bucket.push_back(std::move(owned));
+                ++idle_count;
+            }
+        }
+
+        void* allocate_block(size_t bytes)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (block_size == 0) {
+                    block_size = bytes;
+                }
+                if (bytes == block_size && !free_blocks.empty()) {
+                    void* block = free_blocks.back();
+                    free_blocks.pop_back();
+                    return block;
+                }
+            }
+            return ::operator new(bytes);
+        }
+
+        void free_block(void* block, size_t bytes)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (bytes == block_size && free_blocks.size() < kMaxFreeBlocks) {
+                    free_blocks.push_back(block);
+                    return;
+                }
+            }
+            ::operator delete(block);
+        }
+
+        static constexpr size_t kMaxFreeBlocks = 256;
+    };
+
+    struct Recycler {
+        std::shared_ptr<State> state;
+        void operator()(VideoFrame* frame) const { state->recycle(frame); }
+    };
+
+    // 给 shared_ptr 控制块用的分配器
+    template <typename U>
+    struct BlockAllocator {
+        using value_type = U;
+
+        std::shared_ptr<State> state;
+
+        explicit BlockAllocator(std::shared_ptr<State> s)
+            : state(std::move(s))
+        {
+        }
+        template <typename V>
+        BlockAllocator(const BlockAllocator<V>& other) // NOLINT(google-explicit-constructor)
+            : state(other.state)
+        {
+        }
+
+        U* allocate(size_t n) { return static_cast<U*>(state->allocate_block(n * sizeof(U))); }
+        void deallocate(U* p, size_t n) { state->free_block(p, n * sizeof(U)); }
+
+        template <typename V>
+        bool operator==(const BlockAllocator<V>& other) const { return state == other.state; }
+        template <typename V>
+        bool operator!=(const BlockAllocator<V>& other) const { return state != other.state; }
+    };
+
+    std::shared_ptr<State> state_;
+};
+
+} // namespace player_utils
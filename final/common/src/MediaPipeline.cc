@@ -3,6 +3,7 @@
 #include "Entitys.hpp"
 #include "GLRenderHost.hpp"
 #include "Mp4Parser.hpp"
+#include "PcmRingBuffer.hpp"
 #include "SemQueue.hpp"
 #include <android/log.h>
 #include <cmath>
@@ -14,8 +15,8 @@
 #define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
 
 using mp4parser::Mp4Parser;
-using player_utils::AudioFrame;
 using player_utils::AudioParams;
+using player_utils::PcmRingBuffer;
 using player_utils::SemQueue;
 using player_utils::VideoFrame;
 using render_utils::GLRenderHost;
@@ -37,9 +38,24 @@ bool MediaPipeline::initialize(
     LOGI("Initializing MediaPipeline...");
 
     // ---  Queue ---
-    video_frame_queue_ = make_unique<SemQueue<shared_ptr<VideoFrame>>>(30);
-    audio_frame_queue_ = make_unique<SemQueue<shared_ptr<AudioFrame>>>(60);
-    LOGI("Frame queues created.");
+    // 视频帧按字节数限流，个数上限只是兜底
+    if (config.max_video_frame_bytes > 0) {
+        video_frame_queue_ = make_unique<SemQueue<shared_ptr<VideoFrame>>>(
+            config.max_video_frame_queue_size,
+            [](const shared_ptr<VideoFrame>& frame) { return frame ? frame->byte_size() : 0; },
+            config.max_video_frame_bytes);
+    } else {
+        video_frame_queue_ = make_unique<SemQueue<shared_ptr<VideoFrame>>>(config.max_video_frame_queue_size);
+    }
+    collect_stats_ = config.collect_queue_stats;
+    if (collect_stats_) {
+        video_frame_queue_->set_telemetry(std::make_shared<player_utils::QueueTelemetry>());
+    }
+    LOGI("Video frame queue created. Budget: %zu bytes.", config.max_video_frame_bytes);
+    nonblocking_video_output_ = config.executor != nullptr;
+    if (nonblocking_video_output_) {
+        video_frame_queue_->set_on_writable([this] { wakeVideoOutput(); });
+    }
 
     video_render_ = GLRenderHost::create();
     if (!video_render_ || !video_render_->init(window)) {
@@ -50,7 +66,11 @@ bool MediaPipeline::initialize(
     LOGI("GLRenderHost initialized.");
 
     // ---  Demuxer && Decoder ---
-    parser_ = Mp4Parser::create(config, callbacks);
+    // 池里每种尺寸缓存的帧数要盖住帧队列 + 渲染队列里同时存在的帧
+    video_frame_pool_ = std::make_shared<player_utils::VideoFramePool>(config.max_video_frame_queue_size + 8);
+    mp4parser::Config parser_config = config;
+    parser_config.video_frame_pool = video_frame_pool_;
+    parser_ = Mp4Parser::create(parser_config, callbacks);
     if (!parser_) {
         LOGE("Mp4Parser creation failed.");
         stop();
@@ -68,12 +88,28 @@ bool MediaPipeline::initialize(
     }
     LOGI("Audio params retrieved: Rate=%d, Channels=%d", audio_params.sample_rate, audio_params.channel_count);
 
+    // 采样率交给设备决定（一般是 48k），先打开流拿到实际参数，
+    // 解码线程里的 AudioConverter 一次就转换到这个采样率，AAudio 内部不用再重采样
     audio_render_ = make_unique<AAudioRender>();
-    audio_render_->configure(audio_params.sample_rate, audio_params.channel_count, AAUDIO_FORMAT_PCM_I16);
+    audio_render_->configure(AAUDIO_UNSPECIFIED, audio_params.channel_count, AAUDIO_FORMAT_PCM_I16);
+    if (audio_render_->open() != 0) {
+        LOGE("AAudioRender open failed.");
+        stop();
+        return false;
+    }
+    const AudioParams output_params { audio_render_->getSampleRate(), audio_render_->getChannelCount() };
+    parser_->setAudioOutputParams(output_params);
 
     // Note the `Audio Data Callback` should be setting
 
-    LOGI("AAudioRender configured.");
+    LOGI("AAudioRender opened: Rate=%d, Channels=%d.", output_params.sample_rate, output_params.channel_count);
+
+    const int ring_ms = config.max_audio_frame_ms > 0 ? config.max_audio_frame_ms : 500;
+    audio_ring_ = make_unique<PcmRingBuffer>(
+        static_cast<size_t>(output_params.sample_rate) * ring_ms / 1000,
+        output_params.channel_count,
+        output_params.sample_rate);
+    LOGI("PCM ring buffer created: %zu frames (%d ms requested).", audio_ring_->capacity_frames(), ring_ms);
 
     LOGI("MediaPipeline initialization successful.");
 
@@ -98,10 +134,21 @@ void MediaPipeline::stop()
 {
     LOGI("Stopping MediaPipeline and cleaning up resources.");
 
+    if (collect_stats_ && parser_) {
+        logStats();
+    }
+
+    // 先放开可能卡在 PCM 环形缓冲区上的音频解码线程，否则 parser_->stop() 会 join 不回来
+    if (audio_ring_) {
+        audio_ring_->shutdown();
+    }
+
     if (parser_) {
         parser_->stop();
         parser_.reset();
     }
+    // 解码任务已经结束，留着的帧在帧池之前释放
+    dropPendingVideoFrames();
 
     if (audio_render_) {
         audio_render_.reset();
@@ -116,10 +163,8 @@ void MediaPipeline::stop()
         video_frame_queue_->shutdown();
         video_frame_queue_.reset();
     }
-    if (audio_frame_queue_) {
-        audio_frame_queue_->shutdown();
-        audio_frame_queue_.reset();
-    }
+    audio_ring_.reset();
+    video_frame_pool_.reset();
     LOGI("All pipeline resources have been released.");
 }
 
@@ -173,4 +218,133 @@ double MediaPipeline::getDuration() const
         return parser_->get_duration();
     }
     return NAN;
-}
\ No newline at end of file
+}
+
+double MediaPipeline::snapToKeyframe(double position) const
+{
+    if (parser_) {
+        return parser_->snapToKeyframe(position);
+    }
+    return position;
+}
+
+std::vector<player_utils::TrackInfo> MediaPipeline::getTracks() const
+{
+    if (parser_) {
+        return parser_->getTracks();
+    }
+    return {};
+}
+
+bool MediaPipeline::selectAudioTrack(int track_id)
+{
+    return parser_ && parser_->selectAudioTrack(track_id);
+}
+
+PipelineStats MediaPipeline::getStats() const
+{
+    PipelineStats stats;
+    if (parser_) {
+        auto packets = parser_->getPacketQueueStats();
+        stats.video_packets = packets.video;
+        stats.audio_packets = packets.audio;
+        stats.buffer_levels = parser_->getBufferLevels();
+    }
+    if (video_frame_queue_) {
+        stats.video_frames = video_frame_queue_->stats();
+    }
+    if (audio_ring_) {
+        stats.audio_ring_frames = audio_ring_->available_frames();
+        stats.audio_ring_underruns = audio_ring_->underruns();
+    }
+    if (video_frame_pool_) {
+        stats.video_frame_pool = video_frame_pool_->stats();
+    }
+    return stats;
+}
+
+bool MediaPipeline::offerVideoFrame(shared_ptr<VideoFrame> frame)
+{
+    if (!video_frame_queue_) {
+        return false;
+    }
+    if (!nonblocking_video_output_) {
+        return video_frame_queue_->push(std::move(frame));
+    }
+    std::lock_guard<std::mutex> lock(pending_video_mutex_);
+    // 前面还有没进队列的帧时直接排在后面，保持顺序
+    if (pending_video_frames_.empty() && video_frame_queue_->try_push(frame)) {
+        return true;
+    }
+    if (video_frame_queue_->is_shutdown()) {
+        return false;
+    }
+    pending_video_frames_.push_back(std::move(frame));
+    return true;
+}
+
+bool MediaPipeline::videoOutputReady()
+{
+    if (!video_frame_queue_) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(pending_video_mutex_);
+    while (!pending_video_frames_.empty() && video_frame_queue_->try_push(pending_video_frames_.front())) {
+        pending_video_frames_.pop_front();
+    }
+    // shutdown 之后不让解码任务等：它接着会发现包队列也关了，或者 offerVideoFrame 返回 false
+    if (video_frame_queue_->is_shutdown()) {
+        return true;
+    }
+    return pending_video_frames_.empty() && !video_frame_queue_->full();
+}
+
+void MediaPipeline::setVideoOutputWaker(std::function<void()> wake)
+{
+    std::lock_guard<std::mutex> lock(video_waker_mutex_);
+    video_output_wake_ = std::move(wake);
+}
+
+void MediaPipeline::dropPendingVideoFrames()
+{
+    std::lock_guard<std::mutex> lock(pending_video_mutex_);
+    pending_video_frames_.clear();
+}
+
+void MediaPipeline::wakeVideoOutput()
+{
+    std::function<void()> wake;
+    {
+        std::lock_guard<std::mutex> lock(video_waker_mutex_);
+        wake = video_output_wake_;
+    }
+    if (wake) {
+        wake();
+    }
+}
+
+void MediaPipeline::logStats() const
+{
+    auto log_queue = [](const char* name, const player_utils::QueueStatsSnapshot& q) {
+        LOGI("[stats] %-13s push=%llu pop=%llu size=%zu high=%zu "
+             "producer_wait=%llu/%.1fms consumer_wait=%llu/%.1fms underrun=%llu",
+            name,
+            static_cast<unsigned long long>(q.pushes), static_cast<unsigned long long>(q.pops),
+            q.size, q.high_water,
+            static_cast<unsigned long long>(q.producer_waits), q.producer_wait_ns / 1e6,
+            static_cast<unsigned long long>(q.consumer_waits), q.consumer_wait_ns / 1e6,
+            static_cast<unsigned long long>(q.underruns));
+    };
+
+    PipelineStats stats = getStats();
+    log_queue("video_packets", stats.video_packets);
+    log_queue("audio_packets", stats.audio_packets);
+    log_queue("video_frames", stats.video_frames);
+    LOGI("[stats] audio_ring    frames=%zu underrun=%llu",
+        stats.audio_ring_frames, static_cast<unsigned long long>(stats.audio_ring_underruns));
+    LOGI("[stats] frame_pool    acquire=%llu hit_rate=%.3f idle=%zu",
+        static_cast<unsigned long long>(stats.video_frame_pool.acquires),
+        stats.video_frame_pool.hit_rate(), stats.video_frame_pool.idle);
+    LOGI("[stats] buffered      video=%.0fms audio=%.0fms",
+        stats.buffer_levels.video.buffered_us / 1e3, stats.buffer_levels.audio.buffered_us / 1e3);
+}
@@ -0,0 +1,739 @@
+#include "NativePlayer.hpp"
+#include "AAudioRender.h"
+#include "Entitys.hpp"
+#include "GLRenderHost.hpp"
+#include "JniCallbackHandler.hpp"
+#include "MediaPipeline.hpp"
+#include "Mp4Parser.hpp"
+#include "PcmRingBuffer.hpp"
+#include "SemQueue.hpp"
+#include "SyncClock.hpp"
+#include "TaskExecutor.hpp"
+#include <aaudio/AAudio.h>
+#include <android/log.h>
+#include <android/native_window.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <sstream> // Required for std::stringstream
+#include <thread>
+#include <utility>
+#include <variant>
+
+// Helper to get thread ID as a string
+inline std::string get_thread_id_str()
+{
+    std::stringstream ss;
+    ss << std::this_thread::get_id();
+    return ss.str();
+}
+
+#undef LOG_TAG
+#define LOG_TAG "NativePlayerFSM"
+#define LOG_BUFFER_SIZE 1024
+
+#define LOGE(...)                                                                                                           \
+    do {                                                                                                                    \
+        char buf[LOG_BUFFER_SIZE];                                                                                          \
+        snprintf(buf, LOG_BUFFER_SIZE, __VA_ARGS__);                                                                        \
+        __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, "[TID:%s] %s: %s", get_thread_id_str().c_str(), __FUNCTION__, buf); \
+    } while (0)
+
+#define LOGI(...)                                                                                                          \
+    do {                                                                                                                   \
+        char buf[LOG_BUFFER_SIZE];                                                                                         \
+        snprintf(buf, LOG_BUFFER_SIZE, __VA_ARGS__);                                                                       \
+        __android_log_print(ANDROID_LOG_INFO, LOG_TAG, "[TID:%s] %s: %s", get_thread_id_str().c_str(), __FUNCTION__, buf); \
+    } while (0)
+
+#define LOGW(...)                                                                                                          \
+    do {                                                                                                                   \
+        char buf[LOG_BUFFER_SIZE];                                                                                         \
+        snprintf(buf, LOG_BUFFER_SIZE, __VA_ARGS__);                                                                       \
+        __android_log_print(ANDROID_LOG_WARN, LOG_TAG, "[TID:%s] %s: %s", get_thread_id_str().c_str(), __FUNCTION__, buf); \
+    } while (0)
+
+#define LOGD(...)                                                                                                           \
+    do {                                                                                                                    \
+        char buf[LOG_BUFFER_SIZE];                                                                                          \
+        snprintf(buf, LOG_BUFFER_SIZE, __VA_ARGS__);                                                                        \
+        __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, "[TID:%s] %s: %s", get_thread_id_str().c_str(), __FUNCTION__, buf); \
+    } while (0)
+
+namespace {
+
+// 同一进程里的所有播放器（预览 + 主播放器）共用一组解复用 / 解码工作线程，
+// 最后一个播放器释放之后线程也跟着退出
+std::shared_ptr<player_utils::TaskExecutor> shared_decode_executor()
+{
+    static std::mutex mutex;
+    static std::weak_ptr<player_utils::TaskExecutor> weak;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto executor = weak.lock();
+    if (!executor) {
+        executor = std::make_shared<player_utils::TaskExecutor>();
+        weak = executor;
+    }
+    return executor;
+}
+
+// 解码任务写 PCM 之前要求环形缓冲区里至少空出这么长（一个 AAC 帧在 48k 下约 21 ms）
+constexpr int kAudioOutputHeadroomMs = 50;
+
+} // namespace
+
+using player_utils::AudioFrame;
+using player_utils::PcmRingBuffer;
+using player_utils::PlayerState;
+using player_utils::SemQueue;
+using player_utils::VideoFrame;
+using std::shared_ptr;
+using std::unique_ptr;
+
+struct CommandPlay {
+    std::string path;
+    ANativeWindow* window {};
+};
+
+struct CommandPause {
+    bool is_paused;
+};
+
+struct CommandStop { };
+
+struct CommandSeek {
+    double position;
+};
+
+struct CommandShutdown { };
+
+struct CommandSetSpeed {
+    float speed;
+};
+
+struct AudioCallbackState {
+    std::atomic<bool> is_active { true };
+
+    // 实时回调里只从这里 memcpy，不碰任何会加锁 / 分配 / 释放内存的东西
+    PcmRingBuffer* audio_ring {};
+    SyncClock* clock {}; // 用于更新主时钟
+    std::atomic<bool>* is_logically_paused {};
+    bool video_first_frame_rendered = false;
+    bool audio_started = false;
+};
+// 放在 NativePlayer::Impl 的定义之上
+class AudioCallbackGuard {
+public:
+    explicit AudioCallbackGuard(AudioCallbackState* state)
+        : state_(state)
+    {
+        if (state_) {
+            // 进入危险区域，关闭回调
+            state_->is_active.store(false);
+            // 等待，确保正在执行的回调能完成
+            std::this_thread::sleep_for(std::chrono::milliseconds(20)); // 等待时间可以缩短
+        }
+    }
+
+    ~AudioCallbackGuard()
+    {
+        if (state_) {
+            // 离开危险区域，重新打开回调
+            state_->is_active.store(true);
+        }
+    }
+
+    // 禁止拷贝
+    AudioCallbackGuard(const AudioCallbackGuard&) = delete;
+    AudioCallbackGuard& operator=(const AudioCallbackGuard&) = delete;
+
+private:
+    AudioCallbackState* state_;
+};
+using Command = std::variant<
+    CommandPlay,
+    CommandPause,
+    CommandStop,
+    CommandSeek,
+    CommandSetSpeed,
+    CommandShutdown>;
+
+struct NativePlayer::Impl {
+    explicit Impl(NativePlayer* self);
+    ~Impl();
+
+    void fsm_loop();
+    void set_state(PlayerState new_state);
+
+    // --- 状态和线程 ---
+    NativePlayer* self_;
+    std::atomic<PlayerState> state_ { PlayerState::None };
+    std::thread fsm_thread_;
+    std::queue<Command> command_queue_;
+    std::mutex queue_mutex_;
+    std::condition_variable queue_cond_;
+    bool shutdown_requested_ = false;
+
+    // --- core ---
+    unique_ptr<MediaPipeline> pipeline_;
+    unique_ptr<AudioCallbackState> audio_cb_state_;
+    unique_ptr<SyncClock> clock_;
+    unique_ptr<JniCallbackHandler> jni_handler_;
+
+    // --- 回调 ---
+    static int audio_data_callback(AAudioStream* stream, void* userData, void* audioData, int32_t numFrames);
+    std::function<void(PlayerState)> on_state_changed_cb_;
+    std::function<void(const std::string&)> on_error_cb_;
+
+    std::atomic<bool> is_logically_paused_ { false };
+    std::atomic<bool> video_first_frame_rendered_ = false;
+    std::atomic<bool> audio_started_ = false;
+
+private:
+    void handle_play(const CommandPlay& cmd);
+    void handle_pause(const CommandPause& cmd);
+    void handle_stop();
+    void handle_seek(const CommandSeek& cmd);
+    void handle_set_speed(const CommandSetSpeed& cmd);
+    void cleanup_resources();
+    void run_sync_cycle();
+};
+
+// --- Public API (Dispatch) ---
+
+NativePlayer::NativePlayer()
+    : impl_(std::make_unique<Impl>(this))
+{
+}
+NativePlayer::~NativePlayer()
+{
+    LOGI("NativePlayer destructor called.");
+}
+void NativePlayer::setJniEnv(JavaVM* vm, jobject player_object)
+{
+    JNIEnv* env = nullptr;
+    if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        LOGE("Failed to get JNIEnv in setJniEnv");
+        return;
+    }
+    jobject global_player_ref = env->NewGlobalRef(player_object);
+    if (global_player_ref == nullptr) {
+        LOGE("Failed to create global reference for player object");
+        return;
+    }
+
+    impl_->jni_handler_ = std::make_unique<JniCallbackHandler>(vm, global_player_ref);
+    LOGI("JniCallbackHandler created.");
+}
+
+void NativePlayer::play(const std::string& path, ANativeWindow* window)
+{
+    LOGI("Dispatching PLAY command.");
+    if (window != nullptr) {
+        ANativeWindow_acquire(window);
+        LOGI("ANativeWindow acquired in play().");
+    }
+    {
+        std::lock_guard lock(impl_->queue_mutex_);
+        impl_->command_queue_.emplace(CommandPlay { path, window });
+    }
+    impl_->queue_cond_.notify_one();
+}
+
+void NativePlayer::pause(bool is_paused)
+{
+    LOGI("Dispatching PAUSE command with is_paused = %d", is_paused);
+    {
+        std::lock_guard lock(impl_->queue_mutex_);
+        impl_->command_queue_.emplace(CommandPause { is_paused });
+    }
+    impl_->queue_cond_.notify_one();
+}
+
+void NativePlayer::stop()
+{
+    LOGI("Dispatching STOP command.");
+    {
+        std::lock_guard lock(impl_->queue_mutex_);
+        impl_->command_queue_.emplace(CommandStop {});
+    }
+    impl_->queue_cond_.notify_one();
+}
+
+void NativePlayer::seek(double time_sec)
+{
+    LOGI("Dispatching SEEK command.");
+    {
+        std::lock_guard lock(impl_->queue_mutex_);
+        impl_->command_queue_.emplace(CommandSeek { time_sec });
+    }
+    impl_->queue_cond_.notify_one();
+}
+
+double NativePlayer::getDuration() const
+{
+    if (impl_ && impl_->pipeline_) {
+        return impl_->pipeline_->getDuration();
+    }
+    return 0.0;
+}
+
+double NativePlayer::snapToKeyframe(double time_sec) const
+{
+    if (impl_ && impl_->pipeline_) {
+        return impl_->pipeline_->snapToKeyframe(time_sec);
+    }
+    return time_sec;
+}
+
+std::vector<player_utils::TrackInfo> NativePlayer::getTracks() const
+{
+    if (impl_ && impl_->pipeline_) {
+        return impl_->pipeline_->getTracks();
+    }
+    return {};
+}
+
+bool NativePlayer::selectAudioTrack(int track_id)
+{
+    return impl_ && impl_->pipeline_ && impl_->pipeline_->selectAudioTrack(track_id);
+}
+
+void NativePlayer::setSpeed(float speed)
+{
+    LOGI("Dispatching SET_SPEED command with speed = %.2f", speed);
+    {
+        std::lock_guard lock(impl_->queue_mutex_);
+        impl_->command_queue_.emplace(CommandSetSpeed { speed });
+    }
+    impl_->queue_cond_.notify_one();
+}
+
+void NativePlayer::setOnStateChangedCallback(std::function<void(PlayerState)> cb)
+{
+    impl_->on_state_changed_cb_ = std::move(cb);
+}
+
+void NativePlayer::setOnErrorCallback(std::function<void(const std::string&)> cb)
+{
+    impl_->on_error_cb_ = std::move(cb);
+}
+
+// --- impl ---
+
+NativePlayer::Impl::Impl(NativePlayer* self)
+    : self_(self)
+{
+    fsm_thread_ = std::thread(&Impl::fsm_loop, this);
+}
+
+NativePlayer::Impl::~Impl()
+{
+    {
+        std::lock_guard lock(queue_mutex_);
+        shutdown_requested_ = true;
+        command_queue_.emplace(CommandShutdown {});
+    }
+    queue_cond_.notify_one();
+    if (fsm_thread_.joinable()) {
+        fsm_thread_.join();
+    }
+}
+
+void NativePlayer::Impl::fsm_loop()
+{
+    LOGI("FSM thread started.");
+    while (!shutdown_requested_) {
+        // --- 等待事件 ---
+        std::unique_lock lock(queue_mutex_);
+        if (state_.load() == PlayerState::Playing) {
+            // 播放时，以10ms为超时进行等待。超时后可以执行一轮同步逻辑。
+            queue_cond_.wait_for(lock, std::chrono::milliseconds(10), [this] { return !command_queue_.empty(); });
+        } else {
+            // 其他状态下，无限等待命令。
+            queue_cond_.wait(lock, [this] { return !command_queue_.empty(); });
+        }
+
+        while (!command_queue_.empty()) {
+            Command cmd = std::move(command_queue_.front());
+            command_queue_.pop();
+            lock.unlock();
+
+            if (std::holds_alternative<CommandShutdown>(cmd)) {
+                LOGI("FSM received SHUTDOWN command. Exiting loop.");
+                cleanup_resources();
+                shutdown_requested_ = true;
+                break;
+            }
+
+            switch (state_.load()) {
+            case PlayerState::None:
+            case PlayerState::End:
+                if (std::holds_alternative<CommandPlay>(cmd)) {
+                    handle_play(std::get<CommandPlay>(cmd));
+                }
+                break;
+            case PlayerState::Playing:
+            case PlayerState::Paused:
+                if (std::holds_alternative<CommandPause>(cmd)) {
+                    handle_pause(std::get<CommandPause>(cmd));
+                } else if (std::holds_alternative<CommandStop>(cmd)) {
+                    handle_stop();
+                } else if (std::holds_alternative<CommandSeek>(cmd)) {
+                    handle_seek(std::get<CommandSeek>(cmd));
+                } else if (std::holds_alternative<CommandSetSpeed>(cmd)) {
+                    handle_set_speed(std::get<CommandSetSpeed>(cmd));
+                }
+                break;
+            default:
+                LOGW("Command received in unhandled state: %d", static_cast<int>(state_.load()));
+                break;
+            }
+            lock.lock();
+        }
+
+        if (shutdown_requested_)
+            break;
+
+        // --- 如果处于播放状态，则执行音视频同步 ---
+        if (state_.load() == PlayerState::Playing) {
+            lock.unlock();
+            run_sync_cycle();
+        }
+    }
+    LOGI("FSM thread finished.");
+}
+
+void NativePlayer::Impl::set_state(PlayerState new_state)
+{
+    if (state_ == new_state)
+        return;
+
+    state_ = new_state;
+    LOGI("State changed to: %d", static_cast<int>(new_state));
+
+    if (on_state_changed_cb_) {
+        on_state_changed_cb_(new_state);
+    }
+
+    if (jni_handler_) {
+        jni_handler_->notifyStateChanged(new_state);
+    }
+}
+
+void NativePlayer::Impl::handle_play(const CommandPlay& cmd)
+{
+    LOGI("FSM: Handling PLAY.");
+    cleanup_resources();
+
+    // --- Core ---
+    pipeline_ = std::make_unique<MediaPipeline>();
+    clock_ = std::make_unique<SyncClock>();
+    audio_cb_state_ = std::make_unique<AudioCallbackState>();
+
+    // --- callbacks ---
+    mp4parser::Callbacks callbacks;
+
+    callbacks.on_video_frame_decoded = [this](auto frame) {
+        if (!frame || !pipeline_) {
+            return false;
+        }
+        LOGD("Video frame decoded callback triggered. PTS: %.3f", frame->pts);
+        return pipeline_->offerVideoFrame(std::move(frame));
+    };
+    // 在解码线程里把 PCM 拷进环形缓冲区，AudioFrame 也在这里释放，而不是在实时回调里
+    callbacks.on_audio_frame_decoded = [this](auto frame) {
+        if (!frame || !pipeline_ || !pipeline_->audio_ring_) {
+            return false;
+        }
+        auto& ring = *pipeline_->audio_ring_;
+        const size_t frames = frame->interleaved_size / (ring.channels() * sizeof(int16_t));
+        return ring.write(reinterpret_cast<const int16_t*>(frame->interleaved_pcm), frames, frame->pts);
+    };
+
+    // 解码任务在下游满的时候让出工作线程，而不是阻塞在上面两个回调里
+    callbacks.video_output_ready = [this]() {
+        return !pipeline_ || pipeline_->videoOutputReady();
+    };
+    // 帧队列腾出空位时叫醒挂起的视频解码任务，不靠轮询
+    callbacks.on_video_output_waker = [this](std::function<void()> wake) {
+        if (pipeline_) {
+            pipeline_->setVideoOutputWaker(std::move(wake));
+        }
+    };
+    callbacks.audio_output_ready = [this]() {
+        if (!pipeline_ || !pipeline_->audio_ring_) {
+            return true;
+        }
+        const auto& ring = *pipeline_->audio_ring_;
+        const size_t headroom = static_cast<size_t>(ring.sample_rate()) * kAudioOutputHeadroomMs / 1000;
+        return ring.capacity_frames() - ring.available_frames() >= headroom;
+    };
+
+    // 旧帧已经不会再来、新帧还没开始，在这里清空帧队列和 PCM 环形缓冲区
+    // （音频输出在 handle_seek 第 1 步已经暂停，环形缓冲区两端都不活动）
+    callbacks.on_seek_flushed = [this]() {
+        if (pipeline_ && pipeline_->video_frame_queue_) {
+            pipeline_->video_frame_queue_->reset();
+            pipeline_->dropPendingVideoFrames();
+        }
+        if (pipeline_ && pipeline_->audio_ring_) {
+            pipeline_->audio_ring_->reset();
+        }
+    };
+
+    std::weak_ptr<NativePlayer> weak_self = self_->shared_from_this();
+    callbacks.on_error = [weak_self](const std::string& msg) {
+        if (auto strong_self = weak_self.lock()) {
+            LOGE("Native error: %s", msg.c_str());
+            if (strong_self->impl_->on_error_cb_) {
+                strong_self->impl_->on_error_cb_(msg);
+            }
+            if (strong_self->impl_->on_state_changed_cb_) {
+                strong_self->impl_->on_state_changed_cb_(PlayerState::Error);
+            }
+        }
+    };
+
+    set_state(PlayerState::Seeking);
+
+    // --- 初始化 pipeline ---
+    mp4parser::Config config;
+    config.file_path = cmd.path;
+    config.video_lateness = clock_->lateness();
+    config.executor = shared_decode_executor();
+
+    if (!pipeline_->initialize(config, cmd.window, callbacks)) {
+        LOGE("FSM: MediaPipeline initialization failed.");
+        cleanup_resources();
+        set_state(PlayerState::End);
+        return;
+    }
+
+    // --- Audio callback ---
+    audio_cb_state_->audio_ring = pipeline_->audio_ring_.get();
+    audio_cb_state_->clock = clock_.get();
+    audio_cb_state_->is_logically_paused = &is_logically_paused_;
+
+    pipeline_->audio_render_->setCallback(Impl::audio_data_callback, audio_cb_state_.get());
+
+    pipeline_->start();
+
+    set_state(PlayerState::Playing);
+}
+
+void NativePlayer::Impl::handle_set_speed(const CommandSetSpeed& cmd)
+{
+    LOGI("DO NOTHING NOW");
+}
+
+void NativePlayer::Impl::handle_pause(const CommandPause& cmd)
+{
+    LOGI("FSM: Handling PAUSE (%d).", cmd.is_paused);
+    is_logically_paused_ = cmd.is_paused;
+
+    if (pipeline_) {
+        pipeline_->pause(cmd.is_paused);
+    }
+
+    set_state(cmd.is_paused ? PlayerState::Paused : PlayerState::Playing);
+}
+
+void NativePlayer::Impl::handle_stop()
+{
+    LOGI("FSM: Handling STOP.");
+    cleanup_resources();
+    set_state(PlayerState::End);
+}
+
+// 在 NativePlayer::Impl 中
+void NativePlayer::Impl::handle_seek(const CommandSeek& cmd)
+{
+    LOGI("FSM: Handling SEEK to %.2f. Orchestrating shutdown sequence...", cmd.position);
+
+    // 1. 立即暂停音频输出，这是最外层的消费者
+    if (pipeline_ && pipeline_->audio_render_) {
+        pipeline_->audio_render_->pause(true);
+    }
+    set_state(PlayerState::Seeking);
+
+    // 2. 【核心】关闭“下游”的帧队列 (Frame Queues)。
+    // 这会解除解码器线程的阻塞，如果它们正卡在 push() 操作上的话。
+    LOGI("Seek Orchestrator: Shutting down FRAME queues...");
+    if (pipeline_ && pipeline_->video_frame_queue_) {
+        pipeline_->video_frame_queue_->shutdown();
+    }
+    if (pipeline_ && pipeline_->audio_ring_) {
+        pipeline_->audio_ring_->shutdown();
+    }
+
+    // 3. 现在，向下游的 Mp4Parser 发送 seek 命令。
+    // Mp4Parser 内部的 handle_seek 逻辑（清空 packet_queue -> 等解码线程 flush）现在可以安全执行了，
+    // 因为我们已经从外部解除了它解码器线程的最大阻塞源。
+    if (pipeline_) {
+        auto promise = std::make_shared<std::promise<void>>();
+        pipeline_->seek(cmd.position, promise);
+
+        LOGI("FSM thread is now BLOCKED, waiting for pipeline (Mp4Parser) seek to complete...");
+        auto future = promise->get_future();
+        future.wait(); // 等待 Mp4Parser 完成它的内部 seek 流程
+        LOGI("FSM thread UNBLOCKED. Mp4Parser has finished its seek operation.");
+    }
+
+    // 4. 帧队列和 PCM 环形缓冲区已经在 on_seek_flushed 回调里（解码器 flush 之后、解复用重新开始之前）重置过了
+
+    // 5. 清理渲染器中的残留帧
+    LOGI("Seek Orchestrator: Flushing renderers.");
+    if (pipeline_) {
+        pipeline_->flush();
+    }
+
+    // 6. 重置主时钟
+    if (clock_) {
+        clock_->reset(cmd.position);
+    }
+
+    // 7. 如果不是逻辑暂停状态，则恢复音频播放
+    if (!is_logically_paused_.load()) {
+        if (pipeline_ && pipeline_->audio_render_) {
+            pipeline_->audio_render_->pause(false);
+        }
+    }
+
+    // 8. 设置最终状态
+    set_state(is_logically_paused_ ? PlayerState::Paused : PlayerState::Playing);
+    LOGI("Seek orchestration complete. Player state is now %s.", (is_logically_paused_ ? "Paused" : "Playing"));
+}
+
+void NativePlayer::Impl::cleanup_resources()
+{
+    LOGI("FSM: Cleaning up resources, starting shutdown sequence...");
+
+    // --- FIX: Explicitly pause the stream before doing anything else. ---
+    if (pipeline_ && pipeline_->audio_render_) {
+        pipeline_->audio_render_->pause(true);
+    }
+
+    // The guard is still useful to ensure no callback logic runs while we reset pointers.
+    AudioCallbackGuard cb_guard(audio_cb_state_.get());
+
+    if (pipeline_) {
+        pipeline_->stop();
+        pipeline_.reset();
+    }
+
+    if (clock_) {
+        clock_.reset();
+    }
+
+    if (audio_cb_state_) {
+        audio_cb_state_.reset();
+    }
+
+    LOGI("FSM: All resources have been cleaned up.");
+}
+
+PlayerState NativePlayer::getState() const
+{
+    if (impl_) {
+        return impl_->state_.load();
+    }
+    return PlayerState::None;
+}
+
+double NativePlayer::getPosition() const
+{
+    if (impl_ && impl_->clock_) {
+        return impl_->clock_->get();
+    }
+    return 0.0;
+}
+void NativePlayer::Impl::run_sync_cycle()
+{
+    if (!pipeline_->video_frame_queue_ || pipeline_->video_frame_queue_->empty()) {
+        // LOGD("SYNC: Video queue is empty, waiting for buffer.");
+        return;
+    }
+
+    std::optional<std::shared_ptr<VideoFrame>> video_frame_opt = pipeline_->video_frame_queue_->front();
+    if (!video_frame_opt) {
+        LOGW("SYNC: Queue not empty, but front() returned nullopt. Race condition?");
+        return;
+    }
+
+    const std::shared_ptr<VideoFrame>& video_frame = *video_frame_opt;
+    if (!video_frame) {
+        LOGE("SYNC: Popped a null video frame pointer!");
+        // std::shared_ptr<VideoFrame> dummy;
+        // pipeline_->video_frame_queue_->try_pop(dummy);
+        return;
+    }
+
+    auto decision = clock_->checkVideoFrame(video_frame->pts);
+
+    switch (decision) {
+    case SyncClock::SyncDecision::Wait:
+        return;
+    case SyncClock::SyncDecision::Drop: {
+        std::shared_ptr<VideoFrame> dropped;
+        pipeline_->video_frame_queue_->try_pop(dropped);
+        LOGW("SYNC: Dropped frame PTS=%.3f", video_frame->pts);
+        return;
+    }
+    case SyncClock::SyncDecision::Render:
+        break;
+    }
+
+    std::shared_ptr<VideoFrame> frame_to_process;
+    if (!pipeline_->video_frame_queue_->try_pop(frame_to_process)) {
+        LOGW("SYNC: front() had a frame, but try_pop() failed. Race condition?");
+        return;
+    }
+    if (pipeline_->video_render_) {
+        pipeline_->video_render_->submitFrame(std::move(frame_to_process));
+        audio_cb_state_->video_first_frame_rendered = true;
+    }
+}
+int NativePlayer::Impl::audio_data_callback(AAudioStream* stream,
+    void* userData,
+    void* audioData,
+    int32_t numFrames)
+{
+    auto* state = static_cast<AudioCallbackState*>(userData);
+    if (!state || !state->is_active.load()) {
+        return AAUDIO_CALLBACK_RESULT_STOP;
+    }
+
+    PcmRingBuffer* ring = state->audio_ring;
+    const int32_t channelCount = ring->channels();
+    const size_t bytesNeeded = static_cast<size_t>(numFrames) * channelCount * sizeof(int16_t);
+    auto* outputBuffer = static_cast<int16_t*>(audioData);
+
+    if (!state->audio_started) {
+        if (!state->video_first_frame_rendered) {
+            memset(outputBuffer, 0, bytesNeeded);
+            return AAUDIO_CALLBACK_RESULT_CONTINUE;
+        }
+        state->audio_started = true;
+    }
+
+    if (state->is_logically_paused->load()) {
+        memset(outputBuffer, 0, bytesNeeded);
+        return AAUDIO_CALLBACK_RESULT_CONTINUE;
+    }
+
+    PcmRingBuffer::ReadResult result = ring->read(outputBuffer, static_cast<size_t>(numFrames));
+    if (result.pts >= 0) {
+        state->clock->update(result.pts);
+    }
+    if (result.frames < static_cast<size_t>(numFrames)) {
+        // 欠载：剩下的部分补静音，次数由 ring->underruns() 统计，这里不打日志
+        memset(outputBuffer + result.frames * channelCount, 0,
+            (static_cast<size_t>(numFrames) - result.frames) * channelCount * sizeof(int16_t));
+    }
+
+    return AAUDIO_CALLBACK_RESULT_CONTINUE;
+}
\ No newline at end of file
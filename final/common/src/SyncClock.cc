@@ -26,12 +26,14 @@ double SyncClock::get() const
 void SyncClock::reset(double position)
 {
     master_clock_pts_ = position;
+    lateness_->publish(0.0);
 }
 
 SyncClock::SyncDecision SyncClock::checkVideoFrame(double video_pts)
 {
     double audio = master_clock_pts_.load();
     double diff = video_pts - audio;
+    lateness_->publish(-diff);
 
     // 前 N 帧宽松处理，避免冷启动黑屏
     if (frame_counter_ < 10) {
@@ -1,9 +1,16 @@
 #pragma once
 #include "DecoderContext.hpp"
+#include "FrameSkipPolicy.hpp"
 #include "Packet.hpp"
 #include "SemQueue.hpp"
+#include "TaskExecutor.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -14,6 +21,10 @@ extern "C" {
 class Decoder {
 public:
     using FrameSink = std::function<bool(const AVFrame*)>;
+    // 下游还能不能接收一帧，为 false 时解码任务让出工作线程，过一会儿再来看
+    using OutputReady = std::function<bool()>;
+    // 给某个流建 codec context，失败时返回 nullptr
+    using ContextFactory = std::function<std::shared_ptr<DecoderContext>(int stream_index)>;
 
     Decoder(std::shared_ptr<DecoderContext> ctx,
         player_utils::SemQueue<ffmpeg_utils::Packet>& source_queue);
@@ -23,12 +34,56 @@ public:
 
     void flush();
     void Start(FrameSink frame_sink);
+    // 不开线程，作为可中断的任务跑在共享的 executor 上：包队列空了就挂起，等队列的唤醒回调
+    // （占用包队列的 on_readable 回调）。output_ready 为 false 时，output_wakes 为 true 就挂起等 OutputWaker()
+    // 被调用（下游腾出空间时），否则按退避时间轮询。executor 要比解码器活得长
+    void Start(FrameSink frame_sink, player_utils::TaskExecutor& executor, OutputReady output_ready = {},
+        bool output_wakes = false);
     void Stop();
     void run();
 
+    // 唤醒等下游的解码任务，Start(executor) 之后取。只持有任务的 weak_ptr，
+    // 可以在任何线程、解码器销毁之后调用（那时什么也不做）
+    [[nodiscard]] std::function<void()> OutputWaker() const;
+
+    // seek 用：丢掉队列里还没解码的包，投递一个 flush 哨兵包，等解码线程执行完 avcodec_flush_buffers。
+    // 返回 true 时解码线程空闲地等在队列上，之后不会再输出 flush 之前的包解出来的帧；
+    // 解码线程卡在 FrameSink 里超过 timeout 时返回 false。线程和 codec context 都保留
+    bool FlushAndWait(std::chrono::milliseconds timeout);
+
+    // 精确 seek：pts（流的 time_base）之前的帧不交给 FrameSink，从目标时刻正在显示的那一帧开始输出。
+    // 追帧期间，结束时间在目标之前的包以 AVDISCARD_NONREF 解码（skip_frame / skip_loop_filter / skip_idct），
+    // 参考帧照常完整解码，所以目标帧不受影响。
+    // 需要在解码线程空闲时调用（FlushAndWait 之后、新的包进队列之前），flush() 会取消
+    void SkipUntil(int64_t pts);
+
+    // 视频落后时按 FrameSkipPolicy 逐级提高 skip_frame / skip_loop_filter，追上之后再降回来。
+    // 为空时不跳帧；需要在 Start 之前设置
+    void SetLatenessSource(std::shared_ptr<const player_utils::VideoLateness> lateness);
+
+    // 播放中换音轨：队列里来了另一个流的包时，先把旧解码器里剩下的帧都输出，再用 factory 给新的流建 codec context
+    // （在解码线程上调用）。为空时不看包属于哪个流；需要在 Start 之前设置
+    void SetContextFactory(ContextFactory factory);
+
 private:
+    // 跑在 executor 上时每一步最多解这么多个包，然后让别的任务先跑
+    static constexpr int kPacketsPerStep = 8;
+
+    bool running() const;
+    player_utils::TaskExecutor::Step step();
+    void decode_packet(ffmpeg_utils::Packet& packet);
+    // 包队列关闭之后把解码器里剩下的帧都取出来
+    void finish_stream();
     void receive_all_available_frames();
     void flush_eof();
+    void set_catch_up_discard(const AVPacket* pkt);
+    // 追帧阶段：返回 false 表示这一帧被吞掉（留作候选或者丢弃）
+    bool pass_catch_up(bool& sink_is_ok);
+    // 码流结束时还没追到目标，输出留着的最后一帧
+    void publish_held_frame();
+    void end_catch_up();
+    void apply_frame_skip(const AVPacket* pkt);
+    void switch_stream(int stream_index);
 
     player_utils::SemQueue<ffmpeg_utils::Packet>& queue_;
     std::shared_ptr<DecoderContext> ctx_ = nullptr;
@@ -37,5 +92,32 @@ private:
 
     int64_t last_packet_pts_ = AV_NOPTS_VALUE;
 
+    ContextFactory context_factory_;
+    // 当前 codec context 对应的流，收到第一个包之前为 -1
+    int stream_index_ = -1;
+
+    // 精确 seek 的目标 pts，AV_NOPTS_VALUE 表示没有在追帧
+    int64_t skip_until_pts_ = AV_NOPTS_VALUE;
+    // 目标之前最近的一帧：下一帧越过目标时，目标时刻显示的正是它
+    AVFrame* held_frame_ = nullptr;
+    int skipped_frames_ = 0;
+
+    std::shared_ptr<const player_utils::VideoLateness> lateness_;
+    player_utils::FrameSkipPolicy skip_policy_;
+    // 当前写进 codec context 的档位
+    player_utils::FrameSkipPolicy::Level applied_skip_level_ = player_utils::FrameSkipPolicy::kNone;
+
+    // 解码线程每处理完一个 flush 哨兵包加一
+    std::mutex flush_mutex_;
+    std::condition_variable flush_cv_;
+    uint64_t flushes_done_ = 0;
+    // FlushAndWait 投递了哨兵包、解码任务还没处理到，这期间 step 不等下游
+    std::atomic<bool> flush_requested_ { false };
+
     std::thread thread_;
+
+    std::shared_ptr<player_utils::TaskExecutor::Task> task_;
+    OutputReady output_ready_;
+    bool output_wakes_ = false;
+    ffmpeg_utils::Packet step_packet_ { nullptr };
 };
@@ -1,4 +1,5 @@
 #pragma once
+#include "DecodeThreading.hpp"
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -7,7 +8,8 @@ extern "C" {
 
 class DecoderContext {
 public:
-    explicit DecoderContext(const AVCodecParameters* codec_params);
+    // threading 在 avcodec_open2 之前生效，之后不能再改
+    explicit DecoderContext(const AVCodecParameters* codec_params, const player_utils::DecodeThreading& threading = {});
     ~DecoderContext();
 
     DecoderContext(const DecoderContext&) = delete;
@@ -19,8 +21,11 @@ public:
     [[nodiscard]] AVCodecContext* get() const { return codec_ctx_; }
     [[nodiscard]] int width() const { return (codec_ctx_ != nullptr) ? codec_ctx_->width : 0; }
     [[nodiscard]] int height() const { return (codec_ctx_ != nullptr) ? codec_ctx_->height : 0; }
+    // 实际生效的线程策略（avcodec_open2 之后从 codec context 读回来的）
+    [[nodiscard]] player_utils::ResolvedDecodeThreading threading() const { return threading_; }
 
 protected:
     DecoderContext() = default;
     AVCodecContext* codec_ctx_ = nullptr;
+    player_utils::ResolvedDecodeThreading threading_;
 };
@@ -1,18 +1,28 @@
 #pragma once
 
+#include "DemuxScheduler.hpp"
+#include "LiveLatency.hpp"
 #include "MediaSource.hpp"
 #include "Packet.hpp"
+#include "TaskExecutor.hpp"
+#include "TrackSelection.hpp"
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <utility>
+#include <vector>
 
 class Demuxer {
 public:
     using Packet = ffmpeg_utils::Packet;
-    using PacketSink = std::function<bool(Packet&)>;
+
+    // 非阻塞 sink：kFull 时包保持不动，交给 DemuxScheduler 暂存或者挂起，等 Wake() 之后重试
+    using SinkResult = player_utils::SinkResult;
+    using TryPacketSink = std::function<SinkResult(Packet&)>;
 
     explicit Demuxer(std::shared_ptr<MediaSource> source);
     ~Demuxer();
@@ -20,20 +30,61 @@ public:
     Demuxer(const Demuxer&) = delete;
     Demuxer& operator=(const Demuxer&) = delete;
 
-    void Start(PacketSink sink);
+    // 自己开一个线程，但按 TryPacketSink 非阻塞地放包：某个流的队列满了不会卡住其他流（见 DemuxScheduler）
+    void Start(TryPacketSink sink);
+    // 作为可中断的任务跑在共享的 executor 上。下游队列腾出空位时调用 Wake()
+    // （一般挂在包队列的 on_writable 上）；executor 要比解复用器活得长
+    void Start(TryPacketSink sink, player_utils::TaskExecutor& executor);
+    // 让挂起的解复用任务 / 线程重新看一次（队列腾出了空位，或者某个流掉到了低水位以下）
+    void Wake();
+    // 各个流的缓冲水位，Start 之前设置。设置之后按流调度读包，为空时有包放不进去就等
+    void SetBufferLevels(std::shared_ptr<player_utils::StreamBufferLevels> levels);
+    // 播放中换音轨 / 字幕轨（字幕 stream_index < 0 表示关掉）。解复用线程在读下一个包之前切过去：
+    // 旧轨道已经读出来的包照常播完，新轨道从当前读到的位置接上，不用重建管道。线程安全
+    void SelectStream(player_utils::TrackType type, int stream_index);
     void Stop();
+    // 只置停止标志、不等线程退出，之后再 Stop() 回收线程
+    void RequestStop();
     void Pause();
     void Resume();
     void SeekTo(double timestamp_sec);
     double GetDuration() const;
 
 private:
-    void run();
+    // 跑在 executor 上时每一步最多读这么多个包
+    static constexpr int kPacketsPerStep = 16;
+
+    // TryPacketSink 线程模式下等 Wake() 的上限，防止漏掉唤醒时一直睡着
+    static constexpr std::chrono::milliseconds kIdleWait { 50 };
+
+    void run_scheduled();
+    player_utils::TaskExecutor::Step step();
+    void reset_scheduler();
+    void apply_stream_selection();
+    // 样本表解复用并且没有字幕时按流读；字幕包稀疏又不进包队列，按流读时没法跟着播放进度读
+    bool per_stream_reads() const;
+    // 启用了样本表解复用时从 Mp4SampleReader 读（stream >= 0 时只读这个流），否则 av_read_frame
+    int read_packet(AVPacket* pkt, int stream = -1);
+    // 边录边播：更新写入位置和缓冲时长；落后写入位置太多时丢包追上去（见 LiveLatency）
+    void update_live_latency();
+    bool drop_for_live_latency(Packet& packet);
 
     std::shared_ptr<MediaSource> source_;
-    PacketSink packet_sink_;
     std::thread demux_thread_;
 
+    TryPacketSink try_packet_sink_;
+    // Wake() 可能在别的线程和 Start / Stop 同时发生
+    std::mutex task_mutex_;
+    std::shared_ptr<player_utils::TaskExecutor::Task> task_;
+    // 下游还没收下的 EOF 包
+    std::unique_ptr<Packet> pending_;
+    std::shared_ptr<player_utils::StreamBufferLevels> levels_;
+    // 只在解复用线程 / 任务里用
+    player_utils::DemuxScheduler<Packet> scheduler_;
+    player_utils::LiveLatency live_latency_; // 只在解复用线程 / 任务里用（SeekTo 时解复用器停着）
+    bool wake_requested_ = false; // mutex_ 保护
+    std::vector<std::pair<player_utils::TrackType, int>> pending_selection_; // mutex_ 保护
+
     std::atomic<bool> stop_requested_ { false };
     std::atomic<bool> pause_requested_ { false };
     std::atomic<bool> seek_requested_ { false };
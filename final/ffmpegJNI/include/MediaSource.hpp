@@ -1,7 +1,19 @@
 #pragma once
 
+#include "AvioReader.hpp"
 #include "Entitys.hpp"
+#include "GrowingFileReader.hpp"
+#include "KeyframeIndex.hpp"
+#include "LocalFileReader.hpp"
+#include "Mp4SampleReader.hpp"
+#include "Mp4SampleTable.hpp"
+#include "RemoteFileReader.hpp"
+#include "StreamInfoCache.hpp"
+#include "TrackSelection.hpp"
+#include <atomic>
+#include <memory>
 #include <string>
+#include <vector>
 
 extern "C" {
 #include <libavformat/avformat.h>
@@ -10,10 +22,30 @@ extern "C" {
 
 class MediaSource {
 public:
+    // 编解码参数从哪来的
+    enum class StreamInfoOrigin {
+        Probe, // avformat_find_stream_info
+        Header, // 容器头已经写全，跳过了探测
+        Cache, // StreamInfoCache
+    };
+
     MediaSource() = default;
     ~MediaSource();
 
-    bool open(const std::string& filename);
+    // keyframe_index_path 不为空时，关键帧表先从这个旁路文件读，读不到（或者源文件变了）就重建后写回去。
+    // file_io 不是 Default 且 filename 是本地普通文件时，用 mmap / 后台预读代替 FFmpeg 的 file 协议。
+    // fast_open 打开时限制探测量，容器头够用或者缓存命中时跳过 avformat_find_stream_info。
+    // tracks 选要播的轨道，其余的流设成 AVDISCARD_ALL。
+    // live.enabled 且 filename 是本地文件时按边录边播打开：读到末尾等新数据（见 GrowingFileReader），
+    // 此时 file_io 不起作用，也不建关键帧表、不用样本表解复用。
+    // filename 是 lab06://host:port/path 时从 lab06 文件服务器按区间取（见 RemoteFileReader），按 remote 预读
+    bool open(const std::string& filename, const std::string& keyframe_index_path = {},
+        const player_utils::FileIoOptions& file_io = {}, const player_utils::FastOpenOptions& fast_open = {},
+        const player_utils::TrackSelection& tracks = {}, const player_utils::LiveOptions& live = {},
+        const player_utils::RemoteOptions& remote = {});
+
+    MediaSource(const MediaSource&) = delete;
+    MediaSource& operator=(const MediaSource&) = delete;
 
     [[nodiscard]] AVFormatContext* get_format_context() const { return fmt_ctx_; }
 
@@ -43,8 +75,78 @@ public:
     bool has_audio_stream() const { return audio_stream_index_ != -1; };
     bool has_video_stream() const { return video_stream_index_ != -1; };
 
+    // 字幕，没选时为 -1
+    [[nodiscard]] int get_subtitle_stream_index() const { return subtitle_stream_index_; }
+
+    // 容器里所有的轨道（打开之后不再变）
+    [[nodiscard]] const std::vector<player_utils::TrackInfo>& tracks() const { return tracks_; }
+    // 播放中换音轨 / 字幕轨（字幕 stream_index < 0 表示关掉）：改 discard，样本表解复用时换读的轨道，
+    // 新轨道从旧轨道读到的位置接着读。只能在解复用线程上（或者解复用器停着时）调用
+    bool select_stream(player_utils::TrackType type, int stream_index);
+
+    // 视频流的关键帧表，没有视频流或者建不出来时为空
+    [[nodiscard]] const player_utils::KeyframeIndex& keyframe_index() const { return keyframe_index_; }
+
+    [[nodiscard]] StreamInfoOrigin stream_info_origin() const { return stream_info_origin_; }
+
+    // 自己装了 AVIOContext 时的读取统计，没装时为 nullptr
+    [[nodiscard]] const player_utils::AvioReader* file_reader() const { return file_reader_.get(); }
+
+    // 边录边播。下面几个只在解复用线程上（或者解复用器停着时）调用，interrupt_reads 除外
+    [[nodiscard]] bool is_live() const { return growing_reader_ != nullptr; }
+    [[nodiscard]] const player_utils::LiveOptions& live_options() const { return live_; }
+    // 再读一个包不会一开始就卡在等新数据上：AVIOContext 的缓冲区里还有数据、文件比读到的位置长，
+    // 或者录制已经结束（接下来读到的是文件结束）。包的后半截还没写出来时仍然会在读里等一会儿。不是边录边播时总是 true
+    bool live_data_ready();
+    // 等文件变长，最多 LiveOptions::poll_interval_ms
+    void wait_for_live_data();
+    // 让卡在等新数据上的读取返回错误（停止解复用时），重新开始解复用之前 interrupt_reads(false)。线程安全
+    void interrupt_reads(bool on);
+    // 主视频流（没有视频时主音频流）已经完整写出的最后时刻，秒。按分片的解码时间算，和 pts 差一个编辑列表 / B 帧的偏移。
+    // 不是分片 mp4 或者还没写完一个分片时返回 -1
+    double live_edge_seconds();
+
+    // 本地 mp4 改用自己解析的样本表 + pread 读包（只接最佳的音视频流）。样本表先和 FFmpeg 的索引、
+    // 开头的一段包逐项核对，对不上（分片 mp4、多段编辑列表、音频起始裁剪等）就返回 false，照旧走 av_read_frame
+    bool enable_sample_table_demux();
+    // 启用了样本表解复用时，解复用器从这里读包、seek，否则为 nullptr
+    [[nodiscard]] ffmpeg_utils::Mp4SampleReader* sample_reader() const { return sample_reader_.get(); }
+
 private:
+    bool open_custom_io(const std::string& filename, const player_utils::FileIoOptions& file_io,
+        const player_utils::FastOpenOptions& fast_open);
+    bool open_live_io(const std::string& filename, const player_utils::FastOpenOptions& fast_open);
+    bool open_remote_io(const std::string& filename, const player_utils::RemoteOptions& remote,
+        const player_utils::FastOpenOptions& fast_open);
+    bool install_avio(std::unique_ptr<player_utils::AvioReader> reader);
+    bool find_stream_info(const std::string& filename, const player_utils::FastOpenOptions& fast_open);
+    void close();
+    void build_keyframe_index(const std::string& sidecar_path);
+    bool index_from_stream();
+    bool index_from_scan();
+    bool verify_sample_table(ffmpeg_utils::Mp4SampleTable& table);
+    bool verify_first_packets(ffmpeg_utils::Mp4SampleReader& reader);
+    void list_tracks();
+    void apply_discard();
+
+    std::string filename_;
     AVFormatContext* fmt_ctx_ = nullptr;
+    // 自定义 IO：fmt_ctx_->pb 就是 avio_，带着 AVFMT_FLAG_CUSTOM_IO，关闭时要自己释放
+    AVIOContext* avio_ = nullptr;
+    // 本地文件、边录边播的文件或者远程文件，看是从 open_custom_io / open_live_io / open_remote_io 哪个装上的
+    std::unique_ptr<player_utils::AvioReader> file_reader_;
+    // 边录边播时 file_reader_ 就是它
+    player_utils::GrowingFileReader* growing_reader_ = nullptr;
+    player_utils::LiveOptions live_;
+    // 从旁边扫新写出的分片，算写入位置；不是分片 mp4 时关掉
+    ffmpeg_utils::Mp4FragmentScanner fragment_scanner_;
+    bool scan_fragments_ = false;
+    std::unique_ptr<ffmpeg_utils::Mp4SampleReader> sample_reader_;
+    StreamInfoOrigin stream_info_origin_ = StreamInfoOrigin::Probe;
     int video_stream_index_ = -1;
-    int audio_stream_index_ = -1;
+    // 播放中可以换，解复用线程写，其他线程读
+    std::atomic<int> audio_stream_index_ { -1 };
+    std::atomic<int> subtitle_stream_index_ { -1 };
+    std::vector<player_utils::TrackInfo> tracks_;
+    player_utils::KeyframeIndex keyframe_index_;
 };
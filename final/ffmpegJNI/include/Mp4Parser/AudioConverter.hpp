@@ -0,0 +1,71 @@
+// AudioConverter.hpp
+#pragma once
+#include "AudioFrame.hpp"
+extern "C" {
+#include <libavutil/channel_layout.h>
+#include <libavutil/rational.h>
+#include <libavutil/samplefmt.h>
+}
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+struct AVFrame;
+struct SwrContext;
+
+namespace mp4parser {
+
+// 一路音频流的 解码输出 -> 交错 S16 PCM 转换器，由音频解码线程独占使用。
+//
+// * SwrContext 跨帧复用，只有输入的采样格式 / 采样率 / 声道布局变化时才重建，
+//   重采样器内部的滤波状态在帧与帧之间是连续的，不会在帧边界上产生断点；
+// * 输出直接是 AAudio 设备实际打开的采样率和声道数，不再经过 AAudio 内部的二次重采样；
+// * 输出的 AudioFrame 连同 PCM 缓冲区从池里取，最后一个引用释放时自动回到池里。
+class AudioConverter {
+public:
+    // 0 表示跟随输入
+    struct OutputFormat {
+        int sample_rate = 0;
+        int channels = 0;
+    };
+
+    AudioConverter(AVRational time_base, OutputFormat output);
+    ~AudioConverter();
+
+    AudioConverter(const AudioConverter&) = delete;
+    AudioConverter& operator=(const AudioConverter&) = delete;
+
+    // 失败时返回 nullptr
+    std::shared_ptr<player_utils::AudioFrame> convert(const AVFrame* frame);
+
+    // seek 之后丢掉重采样器里缓存的旧样本
+    void reset();
+
+    // 换了音轨，输入帧的 pts 按新轨道的时间基算
+    void set_time_base(AVRational time_base) { time_base_ = time_base; }
+
+    // SwrContext 创建 / 重建的次数，正常播放时应该一直是 1
+    [[nodiscard]] uint64_t rebuilds() const { return rebuilds_; }
+
+private:
+    struct FramePool;
+
+    bool ensure_context(const AVFrame* frame);
+    void release_context();
+
+    AVRational time_base_;
+    OutputFormat output_;
+
+    SwrContext* swr_ = nullptr;
+    // 当前 swr_ 对应的输入参数
+    AVSampleFormat in_format_ = AV_SAMPLE_FMT_NONE;
+    int in_rate_ = 0;
+    AVChannelLayout in_layout_ {};
+    AVChannelLayout out_layout_ {};
+    int out_rate_ = 0;
+    uint64_t rebuilds_ = 0;
+
+    std::shared_ptr<FramePool> pool_;
+};
+
+} // namespace mp4parser
@@ -1,7 +1,7 @@
 // FrameProcessor.hpp
 #pragma once
-#include "AudioFrame.hpp"
 #include "Entitys.hpp"
+#include "VideoFramePool.hpp"
 extern "C" {
 #include <libavutil/frame.h>
 }
@@ -11,7 +11,12 @@ struct AVStream;
 
 namespace mp4parser {
 
-std::shared_ptr<player_utils::VideoFrame> convert_video_frame(AVStream* stream, const AVFrame* frame);
-std::shared_ptr<player_utils::AudioFrame> convert_audio_frame(AVStream* stream, const AVFrame* frame);
+// pool 不为空时从池里取帧，避免每帧都重新分配、清零 data
+std::shared_ptr<player_utils::VideoFrame> convert_video_frame(AVStream* stream, const AVFrame* frame,
+    player_utils::VideoFramePool* pool = nullptr);
+// 零拷贝：不复制像素，VideoFrame 持有 frame 的一个引用（av_frame_ref），平面指针直接指向解码器的缓冲区。
+// frame 不是引用计数的（没有 buf[0]）时退化为 convert_video_frame
+std::shared_ptr<player_utils::VideoFrame> ref_video_frame(AVStream* stream, const AVFrame* frame,
+    player_utils::VideoFramePool* pool = nullptr);
 
 } // namespace mp4parser
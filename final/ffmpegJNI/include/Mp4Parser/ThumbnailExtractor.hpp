@@ -0,0 +1,116 @@
+// ThumbnailExtractor.hpp
+#pragma once
+#include "BoxFilter.hpp"
+#include "Entitys.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+class DecoderContext;
+class MediaSource;
+struct AVFrame;
+struct AVPacket;
+
+namespace mp4parser {
+
+// 进度条预览图。
+//
+// 自己打开一份 MediaSource / DecoderContext，和播放用的解复用、解码线程互不干扰。
+// 只解关键帧：按关键帧表 seek 到目标之前的关键帧，非关键帧的包直接跳过不送进解码器，
+// 解码器本身也设成 AVDISCARD_NONKEY；解出来的帧用 BoxFilter 缩成小图（YUV420P，data 紧凑排列）。
+//
+// 结果按时间桶（bucket_sec）放进 LRU 缓存，同一个桶里的请求只解一次。
+// request() 交给后台线程：只保留最新的请求，拖进度条时旧的请求要么还没开始就被替换掉，
+// 要么在读包的间隙发现自己被取消，直接放弃。
+class ThumbnailExtractor {
+public:
+    struct Options {
+        int width = 160;
+        int height = 0; // 0 表示按源的宽高比
+        double bucket_sec = 1.0;
+        size_t cache_capacity = 256;
+    };
+
+    struct Stats {
+        uint64_t requests = 0;
+        uint64_t cache_hits = 0;
+        uint64_t decoded = 0;
+        uint64_t cancelled = 0;
+    };
+
+    using Thumbnail = std::shared_ptr<const player_utils::VideoFrame>;
+    // 在后台线程上调用；解码失败时 thumbnail 为空，被取消的请求不回调
+    using Callback = std::function<void(double time_sec, Thumbnail thumbnail)>;
+
+    // 打不开文件或者没有视频流时返回 nullptr
+    static std::unique_ptr<ThumbnailExtractor> create(const std::string& path, const Options& options);
+    ~ThumbnailExtractor();
+
+    ThumbnailExtractor(const ThumbnailExtractor&) = delete;
+    ThumbnailExtractor& operator=(const ThumbnailExtractor&) = delete;
+
+    // 在调用线程上同步取一张，缓存命中时直接返回
+    Thumbnail extract(double time_sec);
+
+    // 异步取一张，替换掉还没完成的上一个请求
+    void request(double time_sec, Callback callback);
+    // 取消还没完成的请求
+    void cancel();
+
+    [[nodiscard]] Stats stats() const;
+    // 片长（秒），未知时为 0
+    [[nodiscard]] double duration() const;
+
+private:
+    ThumbnailExtractor(std::shared_ptr<MediaSource> source, std::unique_ptr<DecoderContext> ctx, const Options& options);
+
+    using CancelToken = std::function<bool()>;
+
+    Thumbnail lookup(int64_t bucket);
+    void store(int64_t bucket, const Thumbnail& thumbnail);
+    Thumbnail extract(double time_sec, const CancelToken& cancelled);
+    // 已经持有 decode_mutex_
+    Thumbnail decode_keyframe(double time_sec, const CancelToken& cancelled);
+    Thumbnail downscale(const AVFrame* frame);
+    void run();
+
+    std::shared_ptr<MediaSource> source_;
+    std::unique_ptr<DecoderContext> ctx_;
+    Options options_;
+    int thumb_width_ = 0;
+    int thumb_height_ = 0;
+
+    // 解复用 / 解码 / 缩放都在这把锁下，同步和异步的请求共用一套 FFmpeg 上下文
+    std::mutex decode_mutex_;
+    AVPacket* packet_ = nullptr;
+    AVFrame* frame_ = nullptr;
+    player_utils::BoxFilter filter_;
+
+    mutable std::mutex cache_mutex_;
+    std::list<std::pair<int64_t, Thumbnail>> lru_; // 最近用过的在前面
+    std::unordered_map<int64_t, std::list<std::pair<int64_t, Thumbnail>>::iterator> cache_;
+    Stats stats_;
+
+    // 后台线程：pending_ 只有一个位置，新请求直接覆盖；generation_ 每次 request / cancel 加一，
+    // 正在解码的请求发现 generation_ 变了就放弃
+    struct Pending {
+        double time_sec = 0.0;
+        Callback callback;
+        uint64_t generation = 0;
+    };
+    std::mutex worker_mutex_;
+    std::condition_variable worker_cv_;
+    std::unique_ptr<Pending> pending_;
+    std::atomic<uint64_t> generation_ { 0 };
+    bool stop_ = false;
+    std::thread worker_;
+};
+
+} // namespace mp4parser
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Mp4SampleTable.hpp"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct AVBufferPool;
+struct AVBufferRef;
+struct AVPacket;
+
+namespace ffmpeg_utils {
+
+// 照着 Mp4SampleTable 直接 pread 样本，代替 av_read_frame。
+// 接上的几条轨道交错输出，规则和 FFmpeg 的 mov 解复用器一样：dts 相差 1 秒以内时按文件偏移，否则按 dts，
+// 这样读盘基本是顺序的。payload 来自按 2 的幂分桶的 AVBufferPool，稳定之后读包不再 malloc。
+// 只在解复用线程上用（seek 也是），不加锁
+class Mp4SampleReader {
+public:
+    struct Stats {
+        uint64_t packets = 0;
+        uint64_t bytes = 0;
+    };
+
+    // 接管 fd，析构时 close
+    Mp4SampleReader(int fd, std::shared_ptr<const Mp4SampleTable> table);
+    ~Mp4SampleReader();
+
+    Mp4SampleReader(const Mp4SampleReader&) = delete;
+    Mp4SampleReader& operator=(const Mp4SampleReader&) = delete;
+
+    // 把一条轨道接到 stream_index 上，时间戳按轨道的 timescale 输出（即 AVStream::time_base = 1/timescale）。
+    // 没接的轨道不读
+    bool add_stream(int stream_index, uint32_t track_id);
+
+    // 同 av_read_frame：成功返回 0，读完返回 AVERROR_EOF，IO 出错返回 AVERROR(errno)
+    int read(AVPacket* pkt);
+    // 只读 stream_index 的下一个样本，每个流有自己的读位置，互不影响（DemuxScheduler 按流调度时用）。
+    // 这个流读完或者没接上时返回 AVERROR_EOF
+    int read(int stream_index, AVPacket* pkt);
+    // 同 av_seek_frame(..., AVSEEK_FLAG_BACKWARD)：ts 按 stream_index 的时间基，这个流回到 ts 之前（含）的关键帧，
+    // 其余流回到那个关键帧时刻之前（含）的关键帧
+    bool seek(int stream_index, int64_t ts);
+    // 所有流回到第一个样本
+    void rewind();
+    // 播放中换轨：from 上的轨道换成 track_id 接到 to 上，新轨道从 from 读到的时刻接着读（第一个 dts 不早于它的样本）。
+    // from < 0 时新接一条轨道，从其余流里读得最靠后的时刻开始；to < 0 时只摘掉 from
+    bool switch_stream(int from, int to, uint32_t track_id);
+
+    [[nodiscard]] const Stats& stats() const { return stats_; }
+
+private:
+    // 4 KB ~ 64 MB，更大的样本单独分配
+    static constexpr int kMinBucketLog2 = 12;
+    static constexpr int kBuckets = 15;
+
+    struct Cursor {
+        int stream_index = -1;
+        const Mp4SampleTable::Track* track = nullptr;
+        size_t next = 0;
+    };
+
+    Cursor* next_cursor();
+    // 这个流下一个要读的样本的时刻（秒），读完了就是轨道的结束时刻
+    static double position(const Cursor& cursor);
+    int read_from(Cursor& cursor, AVPacket* pkt);
+    AVBufferRef* get_buffer(size_t size);
+
+    int fd_;
+    std::shared_ptr<const Mp4SampleTable> table_;
+    std::vector<Cursor> cursors_;
+    std::array<AVBufferPool*, kBuckets> pools_ {};
+    Stats stats_;
+};
+
+} // namespace ffmpeg_utils
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace ffmpeg_utils {
+
+// mp4 的样本表：从 moov/trak/mdia/minf/stbl 里的 stsz(stz2) / stco(co64) / stsc / stts / ctts / stss
+// 展开成每条轨道一个平铺的样本数组，Mp4SampleReader 照着它直接 pread 样本，不再经过 av_read_frame。
+//
+// 不依赖 FFmpeg，可以单测。时间戳的约定尽量和 FFmpeg 的 mov 解复用器一致（编辑列表平移、负 ctts 时 dts 前移），
+// 但 MediaSource 启用之前还会和 AVStream 的索引逐项核对，对不上就不用。
+// 分片 mp4（样本在 moof 里）、多段编辑列表这些情况直接返回 false，交给 FFmpeg
+class Mp4SampleTable {
+public:
+    enum : uint32_t {
+        kKeyframe = 1,
+        kDiscard = 2, // 编辑列表之外的样本，解码但不输出（AV_PKT_FLAG_DISCARD）
+    };
+
+    struct Sample {
+        int64_t offset = 0; // 在文件里的字节偏移
+        int64_t dts = 0; // 轨道 timescale 为单位
+        int32_t pts_offset = 0; // pts = dts + pts_offset
+        uint32_t size = 0;
+        uint32_t duration = 0;
+        uint32_t flags = 0;
+    };
+
+    struct Track {
+        uint32_t id = 0; // tkhd 的 track_ID，FFmpeg 里是 AVStream::id
+        uint32_t handler = 0; // hdlr 的 handler_type，'vide' / 'soun' / ...
+        uint32_t timescale = 0;
+        uint32_t max_sample_size = 0;
+        std::vector<Sample> samples;
+
+        [[nodiscard]] bool is_video() const { return handler == fourcc("vide"); }
+        [[nodiscard]] bool is_audio() const { return handler == fourcc("soun"); }
+    };
+
+    static constexpr uint32_t fourcc(const char (&s)[5])
+    {
+        return (static_cast<uint32_t>(static_cast<uint8_t>(s[0])) << 24) | (static_cast<uint32_t>(static_cast<uint8_t>(s[1])) << 16)
+            | (static_cast<uint32_t>(static_cast<uint8_t>(s[2])) << 8) | static_cast<uint32_t>(static_cast<uint8_t>(s[3]));
+    }
+
+    // 在文件的顶层 box 里找 moov 读进来解析。失败时 error（可以为 nullptr）说明原因
+    bool parse_file(int fd, std::string* error = nullptr);
+    // moov box 的内容（不含 box 头），单测直接喂。file_size 是整个文件的大小，stsz 里的样本加起来不能比它还大，不知道时传 -1
+    bool parse_moov(const uint8_t* data, size_t size, std::string* error = nullptr, int64_t file_size = -1);
+
+    [[nodiscard]] const std::vector<Track>& tracks() const { return tracks_; }
+    [[nodiscard]] const Track* find_track(uint32_t id) const;
+    [[nodiscard]] Track* find_track(uint32_t id);
+
+    // dts <= 给定值的最后一个样本 / 它之前（含）最近的关键帧的下标，没有时返回 0
+    [[nodiscard]] static size_t sample_at_or_before(const Track& track, int64_t dts);
+    [[nodiscard]] static size_t keyframe_at_or_before(const Track& track, int64_t dts);
+
+private:
+    std::vector<Track> tracks_;
+};
+
+// 边写边读的分片 mp4：从上次扫到的地方接着扫新写出来的顶层 box，记下每条轨道已经完整写出的最后时刻（写入位置）。
+// moov 里取 timescale 和 trex 的默认样本时长，每个 moof 按 tfdt + trun 的样本时长算出分片的结束时刻，
+// 等它后面的 mdat 也写完了才算数。写了一半的 box 留到下次再扫
+class Mp4FragmentScanner {
+public:
+    // 接着扫 fd 里 [已扫到的位置, file_size) 的顶层 box。格式不对（不是分片 mp4）返回 false，之后不用再扫
+    bool scan(int fd, int64_t file_size);
+    // 单测直接喂 box 的内容（不含 box 头）
+    bool parse_moov(const uint8_t* data, size_t size);
+    bool parse_moof(const uint8_t* data, size_t size);
+    // 最近一个 moof 后面的 mdat 写完了，这个分片的样本算作已写出
+    void commit_fragment();
+
+    // 轨道已经写出的最后时刻（秒），还没有写完的分片时返回 -1
+    [[nodiscard]] double end_seconds(uint32_t track_id) const;
+    // 到这里为止的顶层 box 都是完整的
+    [[nodiscard]] int64_t scanned_bytes() const { return offset_; }
+    [[nodiscard]] bool has_moov() const { return !tracks_.empty(); }
+
+private:
+    struct TrackState {
+        uint32_t id = 0;
+        uint32_t timescale = 0;
+        uint32_t default_duration = 0; // trex
+        int64_t end = -1; // 已写出的分片的结束时刻，轨道 timescale
+        int64_t pending_end = -1; // 最近一个 moof 算出来、还在等 mdat 的结束时刻
+    };
+
+    TrackState* find(uint32_t id);
+
+    std::vector<TrackState> tracks_;
+    int64_t offset_ = 0;
+};
+
+} // namespace ffmpeg_utils
@@ -1,6 +1,8 @@
 // packet.hpp
 #pragma once
 
+#include "PacketPool.hpp"
+
 extern "C" {
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
@@ -8,9 +10,13 @@ extern "C" {
 
 namespace ffmpeg_utils {
 
+// AVPacket 的 RAII 包装。数据包从 PacketPool 取、析构时还回去；
+// flush / EOF 哨兵包不带 AVPacket，创建和销毁都不碰分配器。
 class Packet {
 public:
+    // 从 PacketPool::global() 取一个空的 AVPacket
     Packet();
+    // 接管 pkt（可以是 nullptr，表示空包），析构时还给 PacketPool::global()
     explicit Packet(AVPacket* pkt);
     ~Packet();
     Packet(const Packet&) = delete;
@@ -23,19 +29,15 @@ public:
 
     static Packet createFlushPacket()
     {
-        Packet pkt;
+        Packet pkt(nullptr);
         pkt.is_flush_packet_ = true;
-        av_packet_free(&pkt.pkt_);
-        pkt.pkt_ = nullptr;
         return pkt;
     }
 
     static Packet createEofPacket()
     {
-        Packet pkt;
+        Packet pkt(nullptr);
         pkt.is_eof_packet_ = true;
-        av_packet_free(&pkt.pkt_);
-        pkt.pkt_ = nullptr;
         return pkt;
     }
 
@@ -44,6 +46,8 @@ public:
     bool isData() const { return pkt_ != nullptr && !is_flush_packet_ && !is_eof_packet_; }
 
 private:
+    void reset();
+
     AVPacket* pkt_ = nullptr;
     bool is_flush_packet_ = false;
     bool is_eof_packet_ = false;
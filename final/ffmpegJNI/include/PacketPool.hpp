@@ -0,0 +1,53 @@
+// PacketPool.hpp
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+struct AVPacket;
+
+namespace ffmpeg_utils {
+
+// AVPacket 外壳的回收池，线程安全。
+// 解复用线程 acquire、解码线程 release，稳定之后 Packet 的构造 / 析构不再走 av_packet_alloc / av_packet_free。
+// 只回收 AVPacket 结构体本身，payload 的引用在 release 时由 av_packet_unref 交还给 FFmpeg。
+class PacketPool {
+public:
+    struct Stats {
+        uint64_t acquires = 0;
+        uint64_t allocations = 0; // 真正调用 av_packet_alloc 的次数
+        size_t idle = 0;
+    };
+
+    explicit PacketPool(size_t max_idle = kDefaultMaxIdle);
+    ~PacketPool();
+
+    PacketPool(const PacketPool&) = delete;
+    PacketPool& operator=(const PacketPool&) = delete;
+
+    // 取一个空的 AVPacket，分配失败时返回 nullptr
+    AVPacket* acquire();
+    // 归还，pkt 可以是 nullptr
+    void release(AVPacket* pkt);
+
+    [[nodiscard]] Stats stats() const;
+
+    // Packet 默认使用的进程级实例
+    static PacketPool& global();
+
+    // 够放下 视频包队列 + 音频包队列 的默认上限
+    static constexpr size_t kDefaultMaxIdle = 1024;
+
+private:
+    const size_t max_idle_;
+    mutable std::mutex mutex_;
+    std::vector<AVPacket*> idle_;
+
+    std::atomic<uint64_t> acquires_ { 0 };
+    std::atomic<uint64_t> allocations_ { 0 };
+};
+
+} // namespace ffmpeg_utils
@@ -30,7 +30,10 @@ Decoder::Decoder(shared_ptr<DecoderContext> ctx,
     }
 
     decoded_frame_ = av_frame_alloc();
-    if (decoded_frame_ == nullptr) {
+    held_frame_ = av_frame_alloc();
+    if (decoded_frame_ == nullptr || held_frame_ == nullptr) {
+        av_frame_free(&decoded_frame_);
+        av_frame_free(&held_frame_);
         throw std::runtime_error("Decoder: Failed to allocate frame.");
     }
     std::cout << "Decoder initialized with existing DecoderContext." << '\n';
@@ -42,6 +45,7 @@ Decoder::~Decoder()
     if (decoded_frame_ != nullptr) {
         av_frame_free(&decoded_frame_);
     }
+    av_frame_free(&held_frame_);
     std::cout << "Decoder destroyed." << '\n';
 }
 
@@ -59,8 +63,38 @@ void Decoder::Start(FrameSink frame_sink)
     thread_ = std::thread(&Decoder::run, this);
 }
 
+void Decoder::Start(FrameSink frame_sink, player_utils::TaskExecutor& executor, OutputReady output_ready, bool output_wakes)
+{
+    if (running()) {
+        LOGW("Decoder::Start called but it is already running.");
+        return;
+    }
+    if (!frame_sink) {
+        throw std::invalid_argument("Decoder: FrameSink cannot be null.");
+    }
+    frame_sink_ = std::move(frame_sink);
+    output_ready_ = std::move(output_ready);
+    output_wakes_ = output_wakes;
+    task_ = executor.spawn([this] { return step(); });
+    // 只持有 weak_ptr：解码器销毁之后队列上的回调什么也不做
+    std::weak_ptr<player_utils::TaskExecutor::Task> weak = task_;
+    queue_.set_on_readable([weak] {
+        if (auto task = weak.lock()) {
+            task->wake();
+        }
+    });
+    task_->wake();
+}
+
 void Decoder::Stop()
 {
+    if (task_) {
+        queue_.shutdown();
+        task_->wait_done();
+        task_.reset();
+        LOGI("Decoder task has finished.");
+        return;
+    }
     if (!thread_.joinable()) {
         return;
     }
@@ -71,37 +105,129 @@ void Decoder::Stop()
     LOGI("Decoder thread has been stopped and joined.");
 }
 
+std::function<void()> Decoder::OutputWaker() const
+{
+    std::weak_ptr<player_utils::TaskExecutor::Task> weak = task_;
+    return [weak] {
+        if (auto task = weak.lock()) {
+            task->wake();
+        }
+    };
+}
+
+bool Decoder::running() const
+{
+    return thread_.joinable() || task_ != nullptr;
+}
+
+bool Decoder::FlushAndWait(std::chrono::milliseconds timeout)
+{
+    if (!running()) {
+        flush();
+        queue_.clear();
+        return true;
+    }
+
+    uint64_t target = 0;
+    {
+        std::lock_guard<std::mutex> lock(flush_mutex_);
+        target = flushes_done_ + 1;
+    }
+    // 先清空再投递，哨兵包前面不会再有旧的包。
+    // 下游这时可能是满的（seek 时帧队列只 shutdown、不取空），先告诉解码任务别等下游
+    flush_requested_ = true;
+    queue_.clear();
+    if (!queue_.push(Packet::createFlushPacket())) {
+        flush_requested_ = false;
+        return false;
+    }
+
+    std::unique_lock<std::mutex> lock(flush_mutex_);
+    return flush_cv_.wait_for(lock, timeout, [&] { return flushes_done_ >= target; });
+}
+
 void Decoder::run()
 {
-    Packet packet;
+    // 空的外壳，wait_and_pop 直接把队列里的包移进来
+    Packet packet(nullptr);
 
     while (queue_.wait_and_pop(packet)) {
-        if (packet.isFlush()) {
-            LOGI("Decoder: Received flush packet. Flushing codec...");
-            flush();
-            continue;
-        }
+        decode_packet(packet);
+    }
+    finish_stream();
+}
 
-        if ((packet.get() != nullptr) && packet.get()->pts != AV_NOPTS_VALUE) {
-            last_packet_pts_ = packet.get()->pts;
+player_utils::TaskExecutor::Step Decoder::step()
+{
+    using Step = player_utils::TaskExecutor::Step;
+    for (int i = 0; i < kPacketsPerStep; ++i) {
+        // 停止时不再等下游（暂停的播放器帧队列一直是满的），剩下的包直接丢掉
+        if (queue_.is_shutdown()) {
+            queue_.clear();
+            finish_stream();
+            return Step::kDone;
         }
+        // 下游满了就先让出工作线程，不占着它等 FrameSink。
+        // 有 flush 在等时不看下游：队列里只剩哨兵包，它不输出帧
+        if (output_ready_ && !flush_requested_.load() && !output_ready_()) {
+            return output_wakes_ ? Step::kWait : Step::kSleep;
+        }
+        if (!queue_.try_pop(step_packet_)) {
+            return Step::kWait;
+        }
+        decode_packet(step_packet_);
+    }
+    return Step::kYield;
+}
 
-        // send -> 指把 packet send 到 codec 的内部队列
-        int ret = avcodec_send_packet(ctx_->get(), packet.get());
-        if (ret < 0) {
-            LOGE("Decoder: avcodec_send_packet failed: %s", av_err2str(ret));
-            // 发送失败后，重置我们保存的pts，因为它没有被消费
-            last_packet_pts_ = AV_NOPTS_VALUE;
-            continue;
+void Decoder::decode_packet(Packet& packet)
+{
+    if (packet.isFlush()) {
+        LOGI("Decoder: Received flush packet. Flushing codec...");
+        flush();
+        {
+            std::lock_guard<std::mutex> lock(flush_mutex_);
+            ++flushes_done_;
         }
+        flush_requested_ = false;
+        flush_cv_.notify_all();
+        return;
+    }
 
-        receive_all_available_frames();
+    if (context_factory_ && packet.isData()) {
+        switch_stream(packet.streamIndex());
+    }
+    if ((packet.get() != nullptr) && packet.get()->pts != AV_NOPTS_VALUE) {
+        last_packet_pts_ = packet.get()->pts;
+    }
+    if (skip_until_pts_ != AV_NOPTS_VALUE) {
+        set_catch_up_discard(packet.get());
+    } else if (lateness_) {
+        apply_frame_skip(packet.get());
     }
 
+    // send -> 指把 packet send 到 codec 的内部队列
+    int ret = avcodec_send_packet(ctx_->get(), packet.get());
+    if (ret < 0) {
+        LOGE("Decoder: avcodec_send_packet failed: %s", av_err2str(ret));
+        // 发送失败后，重置我们保存的pts，因为它没有被消费
+        last_packet_pts_ = AV_NOPTS_VALUE;
+        return;
+    }
+
+    receive_all_available_frames();
+    if (packet.isEof()) {
+        publish_held_frame();
+    }
+}
+
+void Decoder::finish_stream()
+{
     LOGI("Decoder: End of packet stream. Flushing final frames (EOF)...");
     // 发送一个空包以触发EOF
     avcodec_send_packet(ctx_->get(), nullptr);
     receive_all_available_frames();
+    publish_held_frame();
 
     LOGI("Decoder thread finished cleanly.");
 }
@@ -127,7 +253,11 @@ void Decoder::receive_all_available_frames()
 
         LOGD("VideoDecoder output frame with pts: %.3f", decoded_frame_->pts * av_q2d(ctx_->get()->time_base));
 
-        if (frame_sink_) {
+        if (skip_until_pts_ != AV_NOPTS_VALUE && !pass_catch_up(sink_is_ok)) {
+            continue;
+        }
+
+        if (sink_is_ok && frame_sink_) {
             if (!frame_sink_(decoded_frame_)) {
                 LOGI("Decoder: Frame sink returned false. Aborting receive loop.");
                 sink_is_ok = false; // 设置标志以退出循环
@@ -144,6 +274,134 @@ void Decoder::flush()
         LOGI("Flushing decoder buffers...");
         avcodec_flush_buffers(ctx_->get());
         last_packet_pts_ = AV_NOPTS_VALUE;
+        end_catch_up();
+        skip_policy_.reset();
         LOGI("Decoder buffers flushed.");
     }
 }
+
+void Decoder::SkipUntil(int64_t pts)
+{
+    end_catch_up();
+    skip_until_pts_ = pts;
+    skipped_frames_ = 0;
+}
+
+void Decoder::SetLatenessSource(std::shared_ptr<const player_utils::VideoLateness> lateness)
+{
+    lateness_ = std::move(lateness);
+}
+
+void Decoder::SetContextFactory(ContextFactory factory)
+{
+    context_factory_ = std::move(factory);
+}
+
+void Decoder::switch_stream(int stream_index)
+{
+    if (stream_index == stream_index_) {
+        return;
+    }
+    if (stream_index_ < 0) {
+        stream_index_ = stream_index;
+        return;
+    }
+    LOGI("Decoder: stream %d -> %d, re-creating codec context.", stream_index_, stream_index);
+    // 旧轨道解码器里还压着的帧照常输出，新轨道的第一帧紧接在它们后面
+    avcodec_send_packet(ctx_->get(), nullptr);
+    receive_all_available_frames();
+    if (auto ctx = context_factory_(stream_index)) {
+        ctx_ = std::move(ctx);
+    } else {
+        LOGE("Decoder: cannot create codec context for stream %d, keeping the old one.", stream_index);
+        avcodec_flush_buffers(ctx_->get());
+    }
+    stream_index_ = stream_index;
+    last_packet_pts_ = AV_NOPTS_VALUE;
+}
+
+void Decoder::apply_frame_skip(const AVPacket* pkt)
+{
+    using player_utils::FrameSkipPolicy;
+    // 每一档的 skip_frame / skip_loop_filter
+    static constexpr AVDiscard kSkipFrame[] = { AVDISCARD_DEFAULT, AVDISCARD_NONREF, AVDISCARD_BIDIR, AVDISCARD_NONKEY };
+    static constexpr AVDiscard kSkipLoopFilter[] = { AVDISCARD_DEFAULT, AVDISCARD_NONREF, AVDISCARD_NONKEY, AVDISCARD_NONKEY };
+
+    const bool keyframe = pkt != nullptr && (pkt->flags & AV_PKT_FLAG_KEY) != 0;
+    const double lateness = lateness_->get();
+    const FrameSkipPolicy::Level level = skip_policy_.update(lateness, keyframe);
+    if (level == applied_skip_level_) {
+        return;
+    }
+    LOGI("Decoder: frame skip level %d -> %d (video %.0f ms late).", applied_skip_level_, level, lateness * 1000);
+    AVCodecContext* ctx = ctx_->get();
+    ctx->skip_frame = kSkipFrame[level];
+    ctx->skip_loop_filter = kSkipLoopFilter[level];
+    applied_skip_level_ = level;
+}
+
+void Decoder::set_catch_up_discard(const AVPacket* pkt)
+{
+    if (pkt == nullptr || pkt->pts == AV_NOPTS_VALUE) {
+        return;
+    }
+    // 这个包解出来的帧在目标时刻之前就结束了，它只可能被当作参考帧用到
+    const bool before_target = pkt->duration > 0 ? pkt->pts + pkt->duration <= skip_until_pts_
+                                                 : pkt->pts < skip_until_pts_;
+    const AVDiscard discard = before_target ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+    AVCodecContext* ctx = ctx_->get();
+    ctx->skip_frame = discard;
+    ctx->skip_loop_filter = discard;
+    ctx->skip_idct = discard;
+}
+
+bool Decoder::pass_catch_up(bool& sink_is_ok)
+{
+    if (decoded_frame_->pts != AV_NOPTS_VALUE && decoded_frame_->pts < skip_until_pts_) {
+        if (held_frame_->buf[0] != nullptr) {
+            ++skipped_frames_;
+        }
+        av_frame_unref(held_frame_);
+        av_frame_move_ref(held_frame_, decoded_frame_);
+        return false;
+    }
+
+    // 第一帧越过目标：目标时刻显示的是上一帧（如果这一帧不是正好落在目标上）
+    const bool publish_held = decoded_frame_->pts != skip_until_pts_ && held_frame_->buf[0] != nullptr;
+    if (publish_held && frame_sink_ && !frame_sink_(held_frame_)) {
+        sink_is_ok = false;
+    }
+    if (!publish_held && held_frame_->buf[0] != nullptr) {
+        ++skipped_frames_;
+    }
+    LOGI("Decoder: accurate seek reached target, skipped %d frames.", skipped_frames_);
+    end_catch_up();
+    return true;
+}
+
+void Decoder::publish_held_frame()
+{
+    // 目标在最后一帧之后：停在最后一帧上
+    if (skip_until_pts_ != AV_NOPTS_VALUE && held_frame_->buf[0] != nullptr && frame_sink_) {
+        frame_sink_(held_frame_);
+    }
+    end_catch_up();
+}
+
+void Decoder::end_catch_up()
+{
+    if (held_frame_ != nullptr) {
+        av_frame_unref(held_frame_);
+    }
+    if (skip_until_pts_ == AV_NOPTS_VALUE) {
+        return;
+    }
+    skip_until_pts_ = AV_NOPTS_VALUE;
+    if (ctx_ && ctx_->get() != nullptr) {
+        AVCodecContext* ctx = ctx_->get();
+        ctx->skip_frame = AVDISCARD_DEFAULT;
+        ctx->skip_loop_filter = AVDISCARD_DEFAULT;
+        ctx->skip_idct = AVDISCARD_DEFAULT;
+    }
+    applied_skip_level_ = player_utils::FrameSkipPolicy::kNone;
+}
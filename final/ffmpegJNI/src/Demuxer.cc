@@ -1,5 +1,6 @@
 #include "Demuxer.hpp"
 #include "MediaSource.hpp"
+#include <algorithm>
 #include <iostream>
 
 // 引入 FFmpeg 头文件
@@ -40,35 +41,143 @@ static void log_thread_exit()
 
 Demuxer::Demuxer(std::shared_ptr<MediaSource> source)
     : source_(std::move(source))
+    , live_latency_(source_->live_options(), source_->has_video_stream())
 {
 }
 
 Demuxer::~Demuxer()
 {
-    if (demux_thread_.joinable()) {
-        Stop();
+    Stop();
+}
+
+void Demuxer::Start(TryPacketSink sink, player_utils::TaskExecutor& executor)
+{
+    std::lock_guard<std::mutex> lock(task_mutex_);
+    if (demux_thread_.joinable() || task_) {
+        return;
     }
+    try_packet_sink_ = std::move(sink);
+    source_->interrupt_reads(false);
+    stop_requested_.store(false);
+    pause_requested_.store(false);
+    seek_requested_.store(false);
+    reset_scheduler();
+    // 边录边播时追上写入位置之后按轮询间隔回来看文件有没有变长
+    if (source_->is_live()) {
+        task_ = executor.spawn([this] { return step(); }, std::chrono::milliseconds(source_->live_options().poll_interval_ms));
+    } else {
+        task_ = executor.spawn([this] { return step(); });
+    }
+    task_->wake();
 }
 
-void Demuxer::Start(PacketSink sink)
+void Demuxer::Start(TryPacketSink sink)
 {
-    if (demux_thread_.joinable()) {
+    std::lock_guard<std::mutex> lock(task_mutex_);
+    if (demux_thread_.joinable() || task_) {
         return;
     }
-    packet_sink_ = std::move(sink);
+    try_packet_sink_ = std::move(sink);
+    source_->interrupt_reads(false);
     stop_requested_.store(false);
     pause_requested_.store(false);
     seek_requested_.store(false);
-    demux_thread_ = std::thread(&Demuxer::run, this);
+    reset_scheduler();
+    demux_thread_ = std::thread(&Demuxer::run_scheduled, this);
 }
 
-void Demuxer::Stop()
+void Demuxer::Wake()
 {
-    stop_requested_.store(true);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wake_requested_ = true;
+    }
     cv_.notify_one();
+    std::lock_guard<std::mutex> lock(task_mutex_);
+    if (task_) {
+        task_->wake();
+    }
+}
+
+void Demuxer::SetBufferLevels(std::shared_ptr<player_utils::StreamBufferLevels> levels)
+{
+    levels_ = std::move(levels);
+}
+
+void Demuxer::reset_scheduler()
+{
+    pending_.reset();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wake_requested_ = false;
+    }
+    scheduler_.reset(levels_, per_stream_reads());
+}
+
+bool Demuxer::per_stream_reads() const
+{
+    // 样本表解复用时每个流有自己的读位置，可以只读需要数据的流
+    return source_->sample_reader() != nullptr && source_->get_subtitle_stream_index() < 0;
+}
+
+void Demuxer::SelectStream(player_utils::TrackType type, int stream_index)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_selection_.emplace_back(type, stream_index);
+    }
+    Wake();
+}
+
+void Demuxer::apply_stream_selection()
+{
+    std::vector<std::pair<player_utils::TrackType, int>> requests;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        requests.swap(pending_selection_);
+    }
+    for (const auto& [type, stream_index] : requests) {
+        const bool audio = type == player_utils::TrackType::Audio;
+        const int previous = audio ? source_->get_audio_stream_index() : source_->get_subtitle_stream_index();
+        if (!source_->select_stream(type, stream_index)) {
+            LOGE("Demuxer: cannot select stream %d.", stream_index);
+            continue;
+        }
+        // 新音轨接着旧音轨的缓冲时长，旧音轨还在队列里的包出队时按新音轨记
+        if (audio && levels_) {
+            levels_->retarget(previous, stream_index);
+        }
+    }
+    if (!requests.empty()) {
+        scheduler_.set_per_stream_reads(per_stream_reads());
+    }
+}
+
+void Demuxer::Stop()
+{
+    RequestStop();
     if (demux_thread_.joinable()) {
         demux_thread_.join();
     }
+    std::shared_ptr<player_utils::TaskExecutor::Task> task;
+    {
+        std::lock_guard<std::mutex> lock(task_mutex_);
+        task = std::move(task_);
+    }
+    if (task) {
+        task->wait_done();
+    }
+    // 暂存的包和队列里的一样作废（seek 时正是要丢掉它们）
+    reset_scheduler();
+}
+
+void Demuxer::RequestStop()
+{
+    stop_requested_.store(true);
+    // 边录边播时解复用线程可能在等文件变长
+    source_->interrupt_reads(true);
+    cv_.notify_one();
+    Wake();
 }
 
 void Demuxer::Pause()
@@ -80,6 +189,7 @@ void Demuxer::Resume()
 {
     pause_requested_.store(false);
     cv_.notify_one();
+    Wake();
 }
 
 void Demuxer::SeekTo(double time_sec)
@@ -88,6 +198,11 @@ void Demuxer::SeekTo(double time_sec)
         return;
     }
 
+    // 停着的时候换的轨道先生效，seek 按新的选择定位
+    apply_stream_selection();
+    // 边录边播时往回拖是在看录好的部分，不能马上又被追回写入位置
+    live_latency_.on_seek();
+
     auto* format_context = source_->get_format_context();
     int stream_index = source_->get_video_stream_index(); // 通常以视频流为基准 seek
     if (stream_index < 0) {
@@ -105,6 +220,23 @@ void Demuxer::SeekTo(double time_sec)
 
     log_seek_message(stream_index, time_sec, target_ts);
 
+    // 有关键帧表时直接 seek 到表里目标之前的关键帧，落点是确定的，也知道要追多少帧
+    const auto& index = source_->keyframe_index();
+    if (stream_index == source_->get_video_stream_index() && !index.empty()) {
+        if (const auto* key = index.at_or_before(target_ts)) {
+            LOGI("Demuxer: keyframe at %.3f sec, ~%d frames to catch up.",
+                index.to_seconds(key->pts), index.catch_up_frames(target_ts));
+            target_ts = key->pts;
+        }
+    }
+
+    if (auto* reader = source_->sample_reader()) {
+        if (!reader->seek(stream_index, target_ts)) {
+            LOGE("Demuxer: sample table seek failed on stream %d.", stream_index);
+        }
+        return;
+    }
+
     // av_seek_frame 是一个复杂的函数。
     // AVSEEK_FLAG_BACKWARD 标志意味着它会 seek 到目标时间戳之前的最近的一个关键帧（keyframe）。
     // 这是最常用、最稳妥的方式。
@@ -130,137 +262,144 @@ double Demuxer::GetDuration() const
     return static_cast<double>(ctx->duration) / AV_TIME_BASE;
 }
 
-// void Demuxer::run()
-// {
-//     log_thread_entry();
-
-//     AVFormatContext* ctx = source_->get_format_context();
-//     if (!ctx) {
-//         std::cerr << "[Demuxer Thread] Error: AVFormatContext is null." << std::endl;
-//         return;
-//     }
-
-//     bool discarding_packets_after_seek = false;
-//     double current_seek_time = 0.0;
-//     int video_idx = source_->get_video_stream_index();
-
-//     while (!stop_requested_.load()) {
-//         {
-//             std::unique_lock<std::mutex> lock(mutex_);
-//             cv_.wait(lock, [this] {
-//                 return !pause_requested_.load() || stop_requested_.load() || seek_requested_.load();
-//             });
-//         }
-
-//         if (stop_requested_.load())
-//             break;
-
-//         if (seek_requested_.exchange(false)) {
-//             current_seek_time = seek_timestamp_sec_.load();
-//             int64_t seek_target = static_cast<int64_t>(current_seek_time * AV_TIME_BASE);
-
-//             std::cout << "[Demuxer Thread] Seeking to " << current_seek_time << "s" << '\n';
-//             int ret = av_seek_frame(ctx, -1, seek_target, AVSEEK_FLAG_BACKWARD);
-//             if (ret < 0) {
-//                 std::cerr << "[Demuxer Thread] Error seeking: " << ret << '\n';
-//             } else {
-//                 avformat_flush(ctx);
-//                 if (packet_sink_) {
-//                     Packet flush_packet = Packet::createFlushPacket();
-//                     packet_sink_(flush_packet);
-//                 }
-//                 discarding_packets_after_seek = true;
-//             }
-//             continue;
-//         }
-
-//         Packet packet;
-//         int ret = av_read_frame(ctx, packet.get());
-//         AVStream* stream = ctx->streams[packet.streamIndex()];
-//         AVRational tb = stream->time_base;
-//         LOGD("Sending packet with pts=%.3f", packet.get()->pts * av_q2d(tb));
-
-//         if (ret < 0) {
-//             // EOF or error: send EOF packet and exit
-//             if (packet_sink_) {
-//                 Packet eof = Packet::createEofPacket();
-//                 packet_sink_(eof);
-//             }
-//             break;
-//         }
-
-//         if (discarding_packets_after_seek) {
-//             if (video_idx >= 0 && packet.streamIndex() == video_idx) {
-//                 AVRational tb = ctx->streams[video_idx]->time_base;
-//                 double pts_sec = packet.get()->pts * av_q2d(tb);
-//                 if (pts_sec < current_seek_time) {
-//                     continue; // still before seek target
-//                 }
-//                 // reached target, stop discarding
-//                 discarding_packets_after_seek = false;
-//             } else if (video_idx >= 0) {
-//                 continue; // drop non-video until first video at/after target
-//             }
-//         }
-
-//         if (packet_sink_) {
-//             if (!packet_sink_(packet)) {
-//                 stop_requested_.store(true);
-//             }
-//         }
-//     }
-//     log_thread_exit();
-// }
-
-// 在 Demuxer.cpp 中
-void Demuxer::run()
+int Demuxer::read_packet(AVPacket* pkt, int stream)
 {
-    log_thread_entry();
-    AVFormatContext* ctx = source_->get_format_context();
-    if (!ctx) {
-        LOGE("[Demuxer Thread] Error: AVFormatContext is null.");
-        return;
+    if (auto* reader = source_->sample_reader()) {
+        return stream >= 0 ? reader->read(stream, pkt) : reader->read(pkt);
     }
+    return av_read_frame(source_->get_format_context(), pkt);
+}
 
-    while (!stop_requested_.load()) {
-        // 1. 将暂停检查放在循环的开头
-        {
+// TryPacketSink 的线程版本：和任务共用 step()，要等的时候睡到 Wake()
+void Demuxer::run_scheduled()
+{
+    using Step = player_utils::TaskExecutor::Step;
+    log_thread_entry();
+    while (true) {
+        const Step result = step();
+        if (result == Step::kDone) {
+            break;
+        }
+        if (result == Step::kWait) {
             std::unique_lock<std::mutex> lock(mutex_);
-            // 如果被要求暂停，就一直等待，直到被唤醒并且 pause_requested_ 变为 false
-            cv_.wait(lock, [this] {
-                return !pause_requested_.load() || stop_requested_.load();
-            });
+            cv_.wait_for(lock, kIdleWait, [this] { return wake_requested_ || stop_requested_.load(); });
+            wake_requested_ = false;
+        } else if (result == Step::kSleep) {
+            // 只有边录边播读到写入位置时才会 kSleep
+            source_->wait_for_live_data();
         }
+    }
+    log_thread_exit();
+}
+
+// 暂停时挂起等 Resume()；读什么、放不进去的包怎么办由 DemuxScheduler 决定，要等的时候挂起等 Wake()
+player_utils::TaskExecutor::Step Demuxer::step()
+{
+    using Step = player_utils::TaskExecutor::Step;
+    using Decision = player_utils::DemuxScheduler<Packet>::Decision;
+    AVFormatContext* ctx = source_->get_format_context();
+    if (!ctx) {
+        LOGE("[Demuxer Task] Error: AVFormatContext is null.");
+        return Step::kDone;
+    }
 
-        // 2. 检查是否在等待期间被要求停止
+    apply_stream_selection();
+    update_live_latency();
+    for (int i = 0; i < kPacketsPerStep; ++i) {
         if (stop_requested_.load()) {
-            break;
+            return Step::kDone;
+        }
+        if (pause_requested_.load()) {
+            return Step::kWait;
         }
 
-        // 3. 读取数据包
-        Packet packet;
-        int ret = av_read_frame(ctx, packet.get());
+        if (pending_) {
+            switch (try_packet_sink_(*pending_)) {
+            case SinkResult::kAccepted:
+            case SinkResult::kClosed:
+                pending_.reset();
+                return Step::kDone;
+            case SinkResult::kFull:
+                return Step::kWait;
+            }
+        }
 
-        if (ret < 0) {
+        const Decision decision = scheduler_.next(try_packet_sink_);
+        switch (decision.kind) {
+        case Decision::kClosed:
+            LOGI("Demuxer: Packet sink is closed. Assuming shutdown and exiting.");
+            return Step::kDone;
+        case Decision::kWait:
+            return Step::kWait;
+        case Decision::kEnd:
             LOGI("Demuxer: End of file or error reached.");
-            if (packet_sink_) {
-                // 发送一个空的 packet 作为 EOF 信号
-                auto eofP = Packet::createEofPacket();
-                packet_sink_(eofP);
-            }
+            pending_ = std::make_unique<Packet>(Packet::createEofPacket());
+            continue;
+        case Decision::kRead:
             break;
         }
+        // 读到写入位置了：不在读里干等（那样会占住 executor 的工作线程），过一个轮询间隔再来
+        if (!source_->live_data_ready()) {
+            return Step::kSleep;
+        }
 
-        // 4. 推送数据包
-        if (packet_sink_) {
-            // packet_sink_ 应该返回一个 bool 值，如果下游（队列）已关闭或无法接收，
-            // 它应该返回 false，我们就可以停止 demuxing。
-            // 你的 Decoder::run() 已经是这样做的，所以这里也需要
-            if (!packet_sink_(packet)) {
-                LOGI("Demuxer: Packet sink returned false. Assuming shutdown and exiting.");
-                break; // 下游无法接收，停止工作
+        Packet packet;
+        if (read_packet(packet.get(), decision.stream) < 0) {
+            if (decision.stream >= 0) {
+                scheduler_.stream_ended(decision.stream);
+            } else {
+                scheduler_.input_ended();
             }
+            continue;
+        }
+        if (drop_for_live_latency(packet)) {
+            continue;
+        }
+        const int stream = packet.streamIndex();
+        const auto bytes = static_cast<size_t>(packet.get()->size);
+        if (!scheduler_.deliver(packet, stream, bytes, try_packet_sink_)) {
+            LOGI("Demuxer: Packet sink is closed. Assuming shutdown and exiting.");
+            return Step::kDone;
         }
     }
-    log_thread_exit();
-}
\ No newline at end of file
+    return Step::kYield;
+}
+
+void Demuxer::update_live_latency()
+{
+    if (!source_->is_live()) {
+        return;
+    }
+    int64_t buffered_us = 0;
+    if (levels_) {
+        for (const auto& level : levels_->snapshot()) {
+            buffered_us = std::max(buffered_us, level.buffered_us);
+        }
+    }
+    live_latency_.update(source_->live_edge_seconds(), static_cast<double>(buffered_us) / 1e6);
+}
+
+bool Demuxer::drop_for_live_latency(Packet& packet)
+{
+    if (!source_->is_live()) {
+        return false;
+    }
+    const int stream = packet.streamIndex();
+    const bool video = stream == source_->get_video_stream_index();
+    // 字幕包照常交出去
+    if (!video && stream != source_->get_audio_stream_index()) {
+        return false;
+    }
+    const AVPacket* pkt = packet.get();
+    const int64_t ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+    if (ts == AV_NOPTS_VALUE) {
+        return false;
+    }
+    const double pts_sec = static_cast<double>(ts) * av_q2d(source_->get_format_context()->streams[stream]->time_base);
+    const uint64_t catch_ups = live_latency_.catch_ups();
+    const bool drop = live_latency_.should_drop(video, (pkt->flags & AV_PKT_FLAG_KEY) != 0, pts_sec);
+    if (live_latency_.catch_ups() != catch_ups) {
+        LOGI("Demuxer: %.1f sec behind the write head, skipping ahead.", live_latency_.latency_sec());
+    }
+    return drop;
+}
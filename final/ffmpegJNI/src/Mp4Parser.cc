@@ -3,11 +3,15 @@
 #include "DecoderContext.hpp"
 #include "Demuxer.hpp"
 #include "MediaSource.hpp"
+#include "Mp4Parser/AudioConverter.hpp"
 #include "Mp4Parser/FrameProcessor.hpp"
 #include "Packet.hpp"
+#include "RingBuffer.hpp"
 #include "SemQueue.hpp"
 #include <android/log.h>
+#include <chrono>
 #include <future>
+#include <iterator>
 #include <memory>
 
 #define LOG_TAG "Mp4Parser"
@@ -23,11 +27,15 @@ enum class CommandType { START,
     STOP,
     PAUSE,
     RESUME,
-    SEEK };
+    SEEK,
+    SELECT_TRACK };
 struct Command {
     CommandType type;
     double time_sec = 0.0; // 仅用于 SEEK
     std::shared_ptr<std::promise<void>> promise;
+    // 仅用于 SELECT_TRACK
+    player_utils::TrackType track_type = player_utils::TrackType::Audio;
+    int stream_index = -1;
 };
 
 using ffmpeg_utils::Packet;
@@ -39,7 +47,8 @@ struct Mp4Parser::Impl {
 
     std::atomic<PlayerState> state_ { PlayerState::Stopped };
     std::thread control_thread_;
-    std::unique_ptr<SemQueue<Command>> command_queue_;
+    static constexpr size_t kCommandQueueSize = 16;
+    std::unique_ptr<SemQueue<Command, RingBuffer<Command, kCommandQueueSize>>> command_queue_;
     std::atomic<bool> parser_loop_should_exit_ { false };
 
     // --- Core Components ---
@@ -53,12 +62,33 @@ struct Mp4Parser::Impl {
     // 音频处理管道
     std::unique_ptr<SemQueue<Packet>> audio_packet_queue_;
     std::unique_ptr<Decoder> audio_decoder_;
+    // 只在音频解码线程里用，seek 时解码线程已经停下，直接 reset
+    std::unique_ptr<AudioConverter> audio_converter_;
+    AudioConverter::OutputFormat audio_output_;
+
+    // 解复用的回调（非阻塞，队列满了交给 DemuxScheduler 处理），seek 之后重启解复用时复用
+    Demuxer::TryPacketSink try_packet_sink_;
+    // 当前这个 EOF 包已经送进了 视频 / 音频 包队列，只在解复用线程上用（seek 时解复用器已经停下）
+    bool eof_delivered_[2] = { false, false };
+    // 各个流在包队列里缓冲了多久，解复用器据此决定先读哪个流。每次 START 重建
+    std::shared_ptr<player_utils::StreamBufferLevels> buffer_levels_;
+
+    // seek 时等解码线程处理 flush 哨兵包的上限，超时就退回到重建整条管道
+    static constexpr std::chrono::milliseconds kSeekFlushTimeout { 500 };
+
+    // 队列在 seek 时会重建，统计放在这里，让新队列接着累计
+    std::shared_ptr<player_utils::QueueTelemetry> video_packet_stats_;
+    std::shared_ptr<player_utils::QueueTelemetry> audio_packet_stats_;
 
     Impl(Config cfg, Callbacks cbs)
         : config(std::move(cfg))
         , callbacks(std::move(cbs))
     {
-        command_queue_ = std::make_unique<SemQueue<Command>>(16);
+        command_queue_ = std::make_unique<SemQueue<Command, RingBuffer<Command, kCommandQueueSize>>>(kCommandQueueSize);
+        if (config.collect_queue_stats) {
+            video_packet_stats_ = std::make_shared<player_utils::QueueTelemetry>();
+            audio_packet_stats_ = std::make_shared<player_utils::QueueTelemetry>();
+        }
         LOGI("Creating control thread...");
         control_thread_ = std::thread(&Impl::parser_loop, this);
     }
@@ -92,6 +122,24 @@ struct Mp4Parser::Impl {
         }
     }
 
+    // 轨道 id 在这里就检查好，切换本身在解复用线程上做
+    bool post_track_selection(player_utils::TrackType type, int track_id)
+    {
+        if (!source) {
+            return false;
+        }
+        const int stream_index = player_utils::resolve_track(source->tracks(), type, track_id, -1);
+        if (stream_index < 0 && (track_id >= 0 || type != player_utils::TrackType::Subtitle)) {
+            LOGW("No %s track with id %d.", type == player_utils::TrackType::Audio ? "audio" : "subtitle", track_id);
+            return false;
+        }
+        Command cmd { CommandType::SELECT_TRACK };
+        cmd.track_type = type;
+        cmd.stream_index = stream_index;
+        post_command(std::move(cmd));
+        return true;
+    }
+
     void parser_loop()
     {
         LOGI("Control thread started.");
@@ -136,6 +184,11 @@ struct Mp4Parser::Impl {
                     }
                 }
                 break;
+            case CommandType::SELECT_TRACK:
+                if (demuxer) {
+                    demuxer->SelectStream(cmd.track_type, cmd.stream_index);
+                }
+                break;
             }
         }
         if (state_ != PlayerState::Stopped) {
@@ -154,21 +207,28 @@ private:
         }
         LOGI("Handling START command...");
 
+        buffer_levels_ = std::make_shared<player_utils::StreamBufferLevels>(source->get_format_context()->nb_streams);
+
         // [日志] 管道初始化日志
         LOGI("Initializing video pipeline...");
         try {
-            video_packet_queue_ = std::make_unique<SemQueue<Packet>>(config.max_packet_queue_size);
-            auto video_codec_context = std::make_shared<DecoderContext>(source->get_video_codecpar());
+            video_packet_queue_ = make_video_packet_queue();
+            auto video_codec_context = std::make_shared<DecoderContext>(source->get_video_codecpar(), config.decode_threading);
             video_decoder_ = std::make_unique<Decoder>(video_codec_context, *video_packet_queue_);
+            video_decoder_->SetLatenessSource(config.video_lateness);
+            const auto threading = video_codec_context->threading();
+            LOGI("Video decoder threading: type=%d threads=%d low_delay=%d",
+                static_cast<int>(threading.mode), threading.thread_count, threading.low_delay ? 1 : 0);
 
             auto on_video_frame_cb = [this](const AVFrame* frame) {
                 // [日志] 确认视频帧解码回调被触发
                 LOGD("Video frame decoded callback triggered. PTS: %.3f", frame->pts * av_q2d(source->get_video_stream()->time_base));
                 if (callbacks.on_video_frame_decoded) {
-                    return callbacks.on_video_frame_decoded(convert_video_frame(source->get_video_stream(), frame));
+                    return callbacks.on_video_frame_decoded(to_video_frame(frame));
                 }
             };
-            video_decoder_->Start(on_video_frame_cb);
+            start_decoder(*video_decoder_, on_video_frame_cb, callbacks.video_output_ready, callbacks.on_video_output_waker);
+            buffer_levels_->track(source->get_video_stream_index(), config.video_watermarks);
             LOGI("Video pipeline initialized successfully.");
         } catch (const std::exception& e) {
             LOGE("Failed to initialize video pipeline: %s. Continuing with audio only.", e.what());
@@ -179,18 +239,21 @@ private:
         LOGI("Initializing audio pipeline...");
         if (source->has_audio_stream()) {
             try {
-                audio_packet_queue_ = std::make_unique<SemQueue<Packet>>(config.max_audio_packet_queue_size);
-                auto audio_codec_context = std::make_shared<DecoderContext>(source->get_audio_codecpar());
+                audio_packet_queue_ = make_audio_packet_queue();
+                auto audio_codec_context = std::make_shared<DecoderContext>(source->get_audio_codecpar(), config.decode_threading);
                 audio_decoder_ = std::make_unique<Decoder>(audio_codec_context, *audio_packet_queue_);
+                audio_converter_ = std::make_unique<AudioConverter>(source->get_audio_stream()->time_base, audio_output_);
+                allow_audio_track_switch(*audio_decoder_);
 
                 auto on_audio_frame_cb = [this](const AVFrame* frame) {
                     // [日志] 确认音频帧解码回调被触发
                     LOGD("Audio frame decoded callback triggered. PTS: %.3f", frame->pts * av_q2d(source->get_audio_stream()->time_base));
                     if (callbacks.on_audio_frame_decoded) {
-                        return callbacks.on_audio_frame_decoded(convert_audio_frame(source->get_audio_stream(), frame));
+                        return callbacks.on_audio_frame_decoded(audio_converter_->convert(frame));
                     }
                 };
-                audio_decoder_->Start(on_audio_frame_cb);
+                start_decoder(*audio_decoder_, on_audio_frame_cb, callbacks.audio_output_ready);
+                buffer_levels_->track(source->get_audio_stream_index(), config.audio_watermarks);
                 LOGI("Audio pipeline initialized successfully.");
             } catch (const std::exception& e) {
                 LOGE("Failed to initialize audio pipeline: %s. Continuing with video only.", e.what());
@@ -207,30 +270,48 @@ private:
             return;
         }
 
-        auto on_packet_cb = [this](Packet& packet) -> bool {
-            // if (state_.load() != PlayerState::Running) {
-            //     // [日志] 如果不是Running状态，Demuxer应该停止
-            //     LOGD("Demuxer callback: state is not Running, requesting stop.");
-            //     return false;
-            // }
-
-            // [日志] 确认数据包路由
-            if (video_decoder_ && packet.streamIndex() == source->get_video_stream_index()) {
-                // LOGD("Routing video packet (PTS: %ld) to video queue. Queue size: %zu", packet.get()->pts, video_packet_queue_->size());
-                return video_packet_queue_->push(std::move(packet));
+        // 按流的类型分：换音轨之后旧音轨已经读出来的包还要照常进音频队列
+        try_packet_sink_ = [this](Packet& packet) -> Demuxer::SinkResult {
+            if (packet.isEof()) {
+                return deliver_eof();
             }
-            if (audio_decoder_ && packet.streamIndex() == source->get_audio_stream_index()) {
-                // LOGD("Routing audio packet (PTS: %ld) to audio queue. Queue size: %zu", packet.get()->pts, audio_packet_queue_->size());
-                return audio_packet_queue_->push(std::move(packet));
+            SemQueue<Packet>* queue = nullptr;
+            switch (packet_track_type(packet)) {
+            case player_utils::TrackType::Video:
+                queue = video_decoder_ ? video_packet_queue_.get() : nullptr;
+                break;
+            case player_utils::TrackType::Audio:
+                queue = audio_decoder_ ? audio_packet_queue_.get() : nullptr;
+                break;
+            case player_utils::TrackType::Subtitle:
+                deliver_subtitle(packet);
+                break;
+            case player_utils::TrackType::Other:
+                break;
             }
-
-            LOGD("Dropping packet from unknown stream index: %d", packet.streamIndex());
-            return true;
+            if (queue == nullptr) {
+                return Demuxer::SinkResult::kAccepted;
+            }
+            // try_push 成功后 packet 已经被移走，先算好时长
+            const int stream = packet.streamIndex();
+            const int64_t duration_us = packet_duration_us(packet);
+            if (queue->try_push(packet)) {
+                buffer_levels_->on_push(stream, duration_us);
+                return Demuxer::SinkResult::kAccepted;
+            }
+            return queue->is_shutdown() ? Demuxer::SinkResult::kClosed : Demuxer::SinkResult::kFull;
         };
+        // 某个流掉到低水位以下时叫醒解复用器去补这个流
+        buffer_levels_->set_on_refill([this] {
+            if (demuxer) {
+                demuxer->Wake();
+            }
+        });
+        demuxer->SetBufferLevels(buffer_levels_);
 
         // [日志] 启动Demuxer
         LOGI("Starting Demuxer...");
-        demuxer->Start(on_packet_cb);
+        start_demuxer();
         set_state(PlayerState::Running);
         LOGI("Parser started.");
     }
@@ -242,7 +323,14 @@ private:
         set_state(PlayerState::Stopped);
 
         // [日志] 停止各个组件
+        // 解复用线程可能卡在满的包队列上，先让包队列关闭再 join
         LOGI("Stopping Demuxer...");
+        if (demuxer)
+            demuxer->RequestStop();
+        if (video_packet_queue_)
+            video_packet_queue_->shutdown();
+        if (audio_packet_queue_)
+            audio_packet_queue_->shutdown();
         if (demuxer)
             demuxer->Stop();
 
@@ -283,81 +371,357 @@ private:
         PlayerState previous_state = state_.load();
         set_state(PlayerState::Seeking);
 
-        // --- 1. 停止所有活动 ---
-        demuxer->Pause();
+        // --- 1. 停掉解复用线程，丢掉还没解码的包 ---
+        stop_demuxer_for_seek();
+
+        // --- 2. 解码器：原地 flush，线程和 codec context 都保留；不行再整条重建 ---
+        if (!flush_decoders_in_place()) {
+            LOGW("Seek: in-place decoder flush failed, re-creating pipeline...");
+            if (!rebuild_decoders()) {
+                report_error("Failed to re-create pipeline after seek.");
+                if (cmd.promise)
+                    cmd.promise->set_value();
+                handle_stop();
+                return;
+            }
+        }
+
+        if (config.accurate_seek && worth_catching_up(cmd.time_sec)) {
+            skip_decoders_until(cmd.time_sec);
+        }
+
+        // 解码线程现在都空闲，不会再输出 seek 之前的帧，下游可以在这里清空自己的队列
+        if (callbacks.on_seek_flushed) {
+            callbacks.on_seek_flushed();
+        }
+
+        // --- 3. 操作数据源 ---
+        LOGI("Seek: Seeking demuxer...");
+        demuxer->SeekTo(cmd.time_sec);
+
+        // --- 4. 恢复 ---
+        start_demuxer();
+        if (previous_state != PlayerState::Running) {
+            demuxer->Pause();
+        }
+        set_state(previous_state);
+
+        // --- 5. 完成 ---
+        if (cmd.promise) {
+            cmd.promise->set_value();
+        }
+    }
+
+    // 有 Config::executor 时解复用 / 解码都作为任务跑在上面，否则各开一个线程
+    void start_demuxer()
+    {
+        if (config.executor) {
+            demuxer->Start(try_packet_sink_, *config.executor);
+        } else {
+            demuxer->Start(try_packet_sink_);
+        }
+    }
+
+    void start_decoder(Decoder& decoder, Decoder::FrameSink sink, const Decoder::OutputReady& output_ready,
+        const std::function<void(std::function<void()>)>& on_output_waker = {})
+    {
+        if (!config.executor) {
+            decoder.Start(std::move(sink));
+            return;
+        }
+        decoder.Start(std::move(sink), *config.executor, output_ready, static_cast<bool>(on_output_waker));
+        if (on_output_waker) {
+            auto wake = decoder.OutputWaker();
+            on_output_waker(wake);
+            // 交出唤醒函数之前任务可能已经因为下游满了挂起，补一次唤醒
+            wake();
+        }
+    }
+
+    // 包队列空出一半时唤醒挂起的解复用器，一次读一批包，而不是每解一个包就切换一次；
+    // 取走的包同时从这个流的缓冲时长里减掉
+    void wake_demuxer_on_pop(SemQueue<Packet>& queue, size_t capacity, bool audio) const
+    {
+        queue.set_on_writable(
+            [this] {
+                if (demuxer) {
+                    demuxer->Wake();
+                }
+            },
+            capacity / 2);
+        // 按队列当前对应的流记：换音轨之后旧音轨的包出队时算在新音轨上（见 StreamBufferLevels::retarget）
+        queue.set_on_pop([this, audio](const Packet& packet) {
+            if (buffer_levels_) {
+                const int stream = audio ? source->get_audio_stream_index() : source->get_video_stream_index();
+                buffer_levels_->on_pop(stream, packet_duration_us(packet));
+            }
+        });
+    }
+
+    // EOF 包不属于哪个流，两个解码器各送一个：把解码器里压着的帧冲出来，
+    // 精确 seek 越过了最后一帧时输出留着的那一帧。某个队列满了返回 kFull，
+    // 解复用器之后拿同一个 EOF 包重试，已经送到的队列不再重复送
+    Demuxer::SinkResult deliver_eof()
+    {
+        SemQueue<Packet>* queues[] = {
+            video_decoder_ ? video_packet_queue_.get() : nullptr,
+            audio_decoder_ ? audio_packet_queue_.get() : nullptr,
+        };
+        bool full = false;
+        for (size_t i = 0; i < std::size(queues); ++i) {
+            if (queues[i] == nullptr || eof_delivered_[i]) {
+                continue;
+            }
+            Packet eof = Packet::createEofPacket();
+            if (queues[i]->try_push(eof)) {
+                eof_delivered_[i] = true;
+            } else if (queues[i]->is_shutdown()) {
+                return Demuxer::SinkResult::kClosed;
+            } else {
+                full = true;
+            }
+        }
+        if (full) {
+            return Demuxer::SinkResult::kFull;
+        }
+        eof_delivered_[0] = eof_delivered_[1] = false;
+        return Demuxer::SinkResult::kAccepted;
+    }
+
+    player_utils::TrackType packet_track_type(const Packet& packet) const
+    {
+        const player_utils::TrackInfo* track = player_utils::find_track_by_stream(source->tracks(), packet.streamIndex());
+        return track != nullptr ? track->type : player_utils::TrackType::Other;
+    }
+
+    // 在解复用线程上调用，没有 on_subtitle_packet 时直接丢掉
+    void deliver_subtitle(const Packet& packet) const
+    {
+        if (!callbacks.on_subtitle_packet || !packet.isData()) {
+            return;
+        }
+        const AVPacket* pkt = packet.get();
+        const AVStream* stream = source->get_format_context()->streams[pkt->stream_index];
+        SubtitlePacket subtitle;
+        subtitle.track_id = stream->id;
+        subtitle.pts_sec = pkt->pts != AV_NOPTS_VALUE ? pkt->pts * av_q2d(stream->time_base) : 0.0;
+        subtitle.duration_sec = pkt->duration * av_q2d(stream->time_base);
+        subtitle.data.assign(pkt->data, pkt->data + pkt->size);
+        callbacks.on_subtitle_packet(subtitle);
+    }
+
+    // 音频队列里来了新音轨的包时，音频解码器在解码线程上给它建 codec context，转换器跟着换时间基
+    void allow_audio_track_switch(Decoder& decoder)
+    {
+        decoder.SetContextFactory([this](int stream_index) -> std::shared_ptr<DecoderContext> {
+            const AVStream* stream = source->get_format_context()->streams[stream_index];
+            try {
+                auto ctx = std::make_shared<DecoderContext>(stream->codecpar, config.decode_threading);
+                audio_converter_->set_time_base(stream->time_base);
+                return ctx;
+            } catch (const std::exception& e) {
+                LOGE("Audio track switch: %s", e.what());
+                return nullptr;
+            }
+        });
+    }
+
+    // 包的时长（微秒），用来记各个流缓冲了多久。mp4 的包都带 duration，没有时按帧率估
+    int64_t packet_duration_us(const Packet& packet) const
+    {
+        if (!packet.isData()) {
+            return 0;
+        }
+        const AVPacket* pkt = packet.get();
+        const AVFormatContext* ctx = source->get_format_context();
+        if (pkt->stream_index < 0 || static_cast<unsigned>(pkt->stream_index) >= ctx->nb_streams) {
+            return 0;
+        }
+        const AVStream* stream = ctx->streams[pkt->stream_index];
+        if (pkt->duration > 0) {
+            return av_rescale_q(pkt->duration, stream->time_base, AVRational { 1, 1000000 });
+        }
+        if (stream->avg_frame_rate.num > 0 && stream->avg_frame_rate.den > 0) {
+            return av_rescale(1000000, stream->avg_frame_rate.den, stream->avg_frame_rate.num);
+        }
+        return 0;
+    }
+
+    void stop_demuxer_for_seek()
+    {
+        demuxer->RequestStop();
+        // 清空之后卡在 push 上的解复用线程会返回，看到停止标志退出
+        if (video_packet_queue_)
+            video_packet_queue_->clear();
+        if (audio_packet_queue_)
+            audio_packet_queue_->clear();
+        demuxer->Stop();
+        // clear() 不走 on_pop，缓冲时长在这里一起清零
+        if (buffer_levels_)
+            buffer_levels_->reset();
+        // 送了一半的 EOF 包已经随队列清掉了，重启之后的 EOF 两边都要重新送
+        eof_delivered_[0] = eof_delivered_[1] = false;
+    }
+
+    // 给每个解码线程投递 flush 哨兵包并等它处理完。
+    // 返回 false 时（某一路解码器不存在，或者解码线程卡住了）由调用者重建
+    bool flush_decoders_in_place()
+    {
+        if (!video_decoder_ || (source->has_audio_stream() && !audio_decoder_)) {
+            return false;
+        }
+        if (!video_decoder_->FlushAndWait(kSeekFlushTimeout)) {
+            return false;
+        }
+        if (audio_decoder_) {
+            if (!audio_decoder_->FlushAndWait(kSeekFlushTimeout)) {
+                return false;
+            }
+            // 音频解码线程现在空闲，可以直接动它的转换器
+            audio_converter_->reset();
+        }
+        return true;
+    }
+
+    // 按关键帧表估计追帧的代价：正好落在关键帧上不用追，超过 max_accurate_seek_frames 退回关键帧 seek。
+    // 没有关键帧表时总是追
+    bool worth_catching_up(double time_sec) const
+    {
+        const auto& index = source->keyframe_index();
+        if (index.empty()) {
+            return true;
+        }
+        const int frames = index.catch_up_frames(index.to_pts(time_sec));
+        if (frames == 0) {
+            return false;
+        }
+        if (config.max_accurate_seek_frames > 0 && frames > config.max_accurate_seek_frames) {
+            LOGI("Seek: ~%d frames to catch up (limit %d), stopping at the keyframe.", frames, config.max_accurate_seek_frames);
+            return false;
+        }
+        return true;
+    }
+
+    // 解复用器 seek 到目标之前的关键帧，解码器从那里追到目标时刻
+    void skip_decoders_until(double time_sec)
+    {
+        // 和 Demuxer::SeekTo 的换算一致
+        auto to_pts = [time_sec](const AVStream* stream) {
+            return static_cast<int64_t>(time_sec / av_q2d(stream->time_base));
+        };
         if (video_decoder_) {
-            if (video_packet_queue_)
-                video_packet_queue_->shutdown();
-            video_decoder_->Stop();
+            video_decoder_->SkipUntil(to_pts(source->get_video_stream()));
         }
         if (audio_decoder_) {
-            if (audio_packet_queue_)
-                audio_packet_queue_->shutdown();
-            audio_decoder_->Stop();
+            audio_decoder_->SkipUntil(to_pts(source->get_audio_stream()));
         }
+    }
+
+    // 原来的 seek 流程：销毁解码器和包队列，重新打开 codec、创建线程
+    bool rebuild_decoders()
+    {
+        if (video_packet_queue_)
+            video_packet_queue_->shutdown();
+        if (audio_packet_queue_)
+            audio_packet_queue_->shutdown();
 
-        // --- 2. 彻底销毁旧的管道组件 (下游到上游) ---
         LOGI("Seek: Destroying old pipeline components...");
         video_decoder_.reset();
         audio_decoder_.reset();
         video_packet_queue_.reset();
         audio_packet_queue_.reset();
 
-        // --- 3. 操作数据源 ---
-        LOGI("Seek: Seeking demuxer...");
-        if (demuxer) {
-            demuxer->SeekTo(cmd.time_sec);
-        }
-
-        // --- 4. 重建全新的管道 ---
         LOGI("Seek: Re-creating pipeline components...");
         try {
             // 创建新队列
-            video_packet_queue_ = std::make_unique<SemQueue<Packet>>(config.max_packet_queue_size);
-            audio_packet_queue_ = std::make_unique<SemQueue<Packet>>(config.max_audio_packet_queue_size);
+            video_packet_queue_ = make_video_packet_queue();
+            audio_packet_queue_ = make_audio_packet_queue();
 
             // 定义回调
             auto on_video_frame_cb = [this](const AVFrame* frame) -> bool {
                 if (callbacks.on_video_frame_decoded) {
-                    return callbacks.on_video_frame_decoded(convert_video_frame(source->get_video_stream(), frame));
+                    return callbacks.on_video_frame_decoded(to_video_frame(frame));
                 }
                 return false;
             };
             auto on_audio_frame_cb = [this](const AVFrame* frame) -> bool {
                 if (callbacks.on_audio_frame_decoded) {
-                    return callbacks.on_audio_frame_decoded(convert_audio_frame(source->get_audio_stream(), frame));
+                    return callbacks.on_audio_frame_decoded(audio_converter_->convert(frame));
                 }
                 return false;
             };
 
             // 创建并启动新解码器
-            auto video_codec_context = std::make_shared<DecoderContext>(source->get_video_codecpar());
+            auto video_codec_context = std::make_shared<DecoderContext>(source->get_video_codecpar(), config.decode_threading);
             video_decoder_ = std::make_unique<Decoder>(video_codec_context, *video_packet_queue_);
-            video_decoder_->Start(on_video_frame_cb);
+            video_decoder_->SetLatenessSource(config.video_lateness);
+            start_decoder(*video_decoder_, on_video_frame_cb, callbacks.video_output_ready, callbacks.on_video_output_waker);
 
             if (source->has_audio_stream()) {
-                auto audio_codec_context = std::make_shared<DecoderContext>(source->get_audio_codecpar());
+                if (audio_converter_) {
+                    audio_converter_->reset();
+                } else {
+                    audio_converter_ = std::make_unique<AudioConverter>(source->get_audio_stream()->time_base, audio_output_);
+                }
+                auto audio_codec_context = std::make_shared<DecoderContext>(source->get_audio_codecpar(), config.decode_threading);
                 audio_decoder_ = std::make_unique<Decoder>(audio_codec_context, *audio_packet_queue_);
-                audio_decoder_->Start(on_audio_frame_cb);
+                allow_audio_track_switch(*audio_decoder_);
+                start_decoder(*audio_decoder_, on_audio_frame_cb, callbacks.audio_output_ready);
             }
         } catch (const std::exception& e) {
-            report_error("Failed to re-create pipeline after seek.");
-            if (cmd.promise)
-                cmd.promise->set_value();
-            handle_stop();
-            return;
+            LOGE("Seek: %s", e.what());
+            return false;
         }
+        return true;
+    }
 
-        // --- 5. 恢复 ---
-        set_state(previous_state);
-        if (previous_state == PlayerState::Running) {
-            demuxer->Resume();
+    std::shared_ptr<VideoFrame> to_video_frame(const AVFrame* frame) const
+    {
+        if (config.zero_copy_video_frames) {
+            return ref_video_frame(source->get_video_stream(), frame, config.video_frame_pool.get());
         }
+        return convert_video_frame(source->get_video_stream(), frame, config.video_frame_pool.get());
+    }
 
-        // --- 6. 完成 ---
-        if (cmd.promise) {
-            cmd.promise->set_value();
+    // 视频包按字节数限流，音频包按时长（微秒）限流
+    std::unique_ptr<SemQueue<Packet>> make_video_packet_queue() const
+    {
+        std::unique_ptr<SemQueue<Packet>> queue;
+        if (config.max_video_packet_bytes == 0) {
+            queue = std::make_unique<SemQueue<Packet>>(config.max_packet_queue_size);
+        } else {
+            queue = std::make_unique<SemQueue<Packet>>(
+                config.max_packet_queue_size,
+                [](const Packet& packet) -> size_t {
+                    return packet.isData() ? static_cast<size_t>(packet.get()->size) : 0;
+                },
+                config.max_video_packet_bytes);
+        }
+        queue->set_telemetry(video_packet_stats_);
+        wake_demuxer_on_pop(*queue, config.max_packet_queue_size, false);
+        return queue;
+    }
+
+    std::unique_ptr<SemQueue<Packet>> make_audio_packet_queue() const
+    {
+        std::unique_ptr<SemQueue<Packet>> queue;
+        if (config.max_audio_packet_ms <= 0 || !source->has_audio_stream()) {
+            queue = std::make_unique<SemQueue<Packet>>(config.max_audio_packet_queue_size);
+        } else {
+            AVRational time_base = source->get_audio_stream()->time_base;
+            queue = std::make_unique<SemQueue<Packet>>(
+                config.max_audio_packet_queue_size,
+                [time_base](const Packet& packet) -> size_t {
+                    if (!packet.isData() || packet.get()->duration <= 0) {
+                        return 0;
+                    }
+                    return static_cast<size_t>(av_rescale_q(packet.get()->duration, time_base, AVRational { 1, 1000000 }));
+                },
+                static_cast<size_t>(config.max_audio_packet_ms) * 1000);
         }
+        queue->set_telemetry(audio_packet_stats_);
+        wake_demuxer_on_pop(*queue, config.max_audio_packet_queue_size, true);
+        return queue;
     }
 
     void cleanup_resources()
@@ -368,9 +732,11 @@ private:
 
         audio_decoder_.reset();
         audio_packet_queue_.reset();
+        audio_converter_.reset();
 
         demuxer.reset();
         source.reset();
+        eof_delivered_[0] = eof_delivered_[1] = false;
         LOGI("Core components cleaned up.");
     }
 
@@ -408,7 +774,11 @@ std::unique_ptr<Mp4Parser> Mp4Parser::create(const Config& config, const Callbac
     try {
         LOGI("Mp4Parser::create - Initializing media source for: %s", config.file_path.c_str());
         auto source = std::make_shared<MediaSource>();
-        source->open(config.file_path);
+        source->open(config.file_path, config.keyframe_index_path, config.file_io, config.fast_open, config.tracks,
+            config.live, config.remote);
+        if (config.native_mp4_demux && !source->enable_sample_table_demux()) {
+            LOGW("Native mp4 demux unavailable, using av_read_frame.");
+        }
 
         // [日志] 检查流信息
         if (source->has_video_stream()) {
@@ -483,6 +853,20 @@ double Mp4Parser::get_duration()
     return -1.0;
 }
 
+const player_utils::KeyframeIndex& Mp4Parser::getKeyframeIndex() const
+{
+    static const player_utils::KeyframeIndex empty;
+    if (impl_ && impl_->source) {
+        return impl_->source->keyframe_index();
+    }
+    return empty;
+}
+
+double Mp4Parser::snapToKeyframe(double time_sec) const
+{
+    return getKeyframeIndex().snap(time_sec);
+}
+
 player_utils::AudioParams Mp4Parser::getAudioParams() const
 {
     if (impl_ && impl_->source) {
@@ -490,9 +874,56 @@ player_utils::AudioParams Mp4Parser::getAudioParams() const
     }
     return { 0, 0 }; // 返回无效值
 }
+void Mp4Parser::setAudioOutputParams(const player_utils::AudioParams& params)
+{
+    if (impl_) {
+        impl_->audio_output_ = { params.sample_rate, params.channel_count };
+    }
+}
+
 PlayerState Mp4Parser::get_state() const
 {
     return impl_ ? impl_->state_.load() : PlayerState::Stopped;
 }
 
+std::vector<player_utils::TrackInfo> Mp4Parser::getTracks() const
+{
+    if (impl_ && impl_->source) {
+        return impl_->source->tracks();
+    }
+    return {};
+}
+
+bool Mp4Parser::selectAudioTrack(int track_id)
+{
+    return impl_ && impl_->post_track_selection(player_utils::TrackType::Audio, track_id);
+}
+
+bool Mp4Parser::selectSubtitleTrack(int track_id)
+{
+    return impl_ && impl_->post_track_selection(player_utils::TrackType::Subtitle, track_id);
+}
+
+BufferLevels Mp4Parser::getBufferLevels() const
+{
+    BufferLevels levels;
+    if (impl_ && impl_->buffer_levels_ && impl_->source) {
+        levels.video = impl_->buffer_levels_->level(impl_->source->get_video_stream_index());
+        levels.audio = impl_->buffer_levels_->level(impl_->source->get_audio_stream_index());
+    }
+    return levels;
+}
+
+PacketQueueStats Mp4Parser::getPacketQueueStats() const
+{
+    PacketQueueStats stats;
+    if (impl_ && impl_->video_packet_stats_) {
+        stats.video = impl_->video_packet_stats_->snapshot();
+    }
+    if (impl_ && impl_->audio_packet_stats_) {
+        stats.audio = impl_->audio_packet_stats_->snapshot();
+    }
+    return stats;
+}
+
 } // namespace mp4parser
\ No newline at end of file
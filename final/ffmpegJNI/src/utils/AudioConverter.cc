@@ -0,0 +1,163 @@
+#include "Mp4Parser/AudioConverter.hpp"
+#include <mutex>
+#include <vector>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/mem.h>
+#include <libswresample/swresample.h>
+}
+
+namespace mp4parser {
+using player_utils::AudioFrame;
+
+// 输出 AudioFrame 的回收池。和转换器分开持有，帧可以比转换器活得久
+struct AudioConverter::FramePool {
+    static constexpr size_t kMaxIdle = 8;
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<AudioFrame>> idle;
+
+    FramePool() { idle.reserve(kMaxIdle); }
+
+    std::unique_ptr<AudioFrame> take()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (idle.empty()) {
+            return nullptr;
+        }
+        auto frame = std::move(idle.back());
+        idle.pop_back();
+        return frame;
+    }
+
+    void give_back(AudioFrame* frame)
+    {
+        std::unique_ptr<AudioFrame> owned(frame);
+        std::lock_guard<std::mutex> lock(mutex);
+        if (idle.size() < kMaxIdle) {
+            idle.push_back(std::move(owned));
+        }
+    }
+};
+
+AudioConverter::AudioConverter(AVRational time_base, OutputFormat output)
+    : time_base_(time_base)
+    , output_(output)
+    , pool_(std::make_shared<FramePool>())
+{
+}
+
+AudioConverter::~AudioConverter()
+{
+    release_context();
+}
+
+void AudioConverter::release_context()
+{
+    swr_free(&swr_);
+    av_channel_layout_uninit(&in_layout_);
+    av_channel_layout_uninit(&out_layout_);
+    in_format_ = AV_SAMPLE_FMT_NONE;
+    in_rate_ = 0;
+    out_rate_ = 0;
+}
+
+bool AudioConverter::ensure_context(const AVFrame* frame)
+{
+    if (swr_ && swr_is_initialized(swr_)
+        && frame->format == in_format_
+        && frame->sample_rate == in_rate_
+        && av_channel_layout_compare(&frame->ch_layout, &in_layout_) == 0) {
+        return true;
+    }
+
+    release_context();
+
+    const int out_channels = output_.channels > 0 ? output_.channels : frame->ch_layout.nb_channels;
+    const int out_rate = output_.sample_rate > 0 ? output_.sample_rate : frame->sample_rate;
+    av_channel_layout_default(&out_layout_, out_channels);
+
+    int ret = swr_alloc_set_opts2(
+        &swr_,
+        &out_layout_, AV_SAMPLE_FMT_S16, out_rate,
+        &frame->ch_layout, static_cast<AVSampleFormat>(frame->format), frame->sample_rate,
+        0, nullptr);
+    if (ret < 0 || swr_init(swr_) < 0 || av_channel_layout_copy(&in_layout_, &frame->ch_layout) < 0) {
+        release_context();
+        return false;
+    }
+
+    in_format_ = static_cast<AVSampleFormat>(frame->format);
+    in_rate_ = frame->sample_rate;
+    out_rate_ = out_rate;
+    ++rebuilds_;
+    return true;
+}
+
+void AudioConverter::reset()
+{
+    // swr_close + swr_init 清空内部缓存，参数保持不变
+    if (swr_) {
+        swr_close(swr_);
+        if (swr_init(swr_) < 0) {
+            release_context();
+        }
+    }
+}
+
+std::shared_ptr<AudioFrame> AudioConverter::convert(const AVFrame* frame)
+{
+    if (!frame || frame->nb_samples <= 0 || !ensure_context(frame)) {
+        return nullptr;
+    }
+
+    const int channels = out_layout_.nb_channels;
+    // 重采样器里还缓存着上一帧的尾巴，这一次输出的第一个样本比 frame->pts 早这么多
+    const int64_t delay = swr_get_delay(swr_, out_rate_);
+    const int max_samples = swr_get_out_samples(swr_, frame->nb_samples);
+    if (max_samples < 0) {
+        return nullptr;
+    }
+    const int capacity = av_samples_get_buffer_size(nullptr, channels, max_samples, AV_SAMPLE_FMT_S16, 1);
+    if (capacity < 0) {
+        return nullptr;
+    }
+
+    std::unique_ptr<AudioFrame> out = pool_->take();
+    if (!out) {
+        out = std::make_unique<AudioFrame>();
+    }
+    if (out->interleaved_capacity < capacity) {
+        av_free(out->interleaved_pcm);
+        out->interleaved_pcm = static_cast<uint8_t*>(av_malloc(capacity));
+        out->interleaved_capacity = out->interleaved_pcm ? capacity : 0;
+        if (!out->interleaved_pcm) {
+            return nullptr;
+        }
+    }
+
+    uint8_t* dst[] = { out->interleaved_pcm };
+    const int converted = swr_convert(swr_, dst, max_samples,
+        const_cast<const uint8_t**>(frame->extended_data), frame->nb_samples);
+    if (converted < 0) {
+        pool_->give_back(out.release());
+        return nullptr;
+    }
+
+    out->nb_samples = converted;
+    out->sample_rate = out_rate_;
+    out->channels = channels;
+    out->interleaved_size = converted * channels * static_cast<int>(sizeof(int16_t));
+    out->duration = static_cast<double>(converted) / out_rate_;
+    if (frame->pts != AV_NOPTS_VALUE) {
+        out->pts = static_cast<double>(frame->pts) * av_q2d(time_base_) - static_cast<double>(delay) / out_rate_;
+    } else {
+        out->pts = -1.0; // 表示无效
+    }
+
+    std::shared_ptr<FramePool> pool = pool_;
+    return std::shared_ptr<AudioFrame>(out.release(), [pool](AudioFrame* f) { pool->give_back(f); });
+}
+
+} // namespace mp4parser
@@ -1,7 +1,56 @@
 #include "DecoderContext.hpp"
 #include <stdexcept>
 
-DecoderContext::DecoderContext(const AVCodecParameters* codec_params)
+namespace {
+
+using player_utils::DecodeThreading;
+using player_utils::ResolvedDecodeThreading;
+
+void apply_threading(AVCodecContext* ctx, const AVCodec* codec, const DecodeThreading& policy)
+{
+    player_utils::DecoderThreadCaps caps;
+    caps.frame = (codec->capabilities & AV_CODEC_CAP_FRAME_THREADS) != 0;
+    caps.slice = (codec->capabilities & AV_CODEC_CAP_SLICE_THREADS) != 0;
+    const bool is_video = ctx->codec_type == AVMEDIA_TYPE_VIDEO;
+    const auto resolved = player_utils::resolve_decode_threading(policy, caps,
+        is_video ? ctx->width : 0, is_video ? ctx->height : 0);
+
+    switch (resolved.mode) {
+    case DecodeThreading::Mode::Frame:
+        ctx->thread_type = FF_THREAD_FRAME;
+        break;
+    case DecodeThreading::Mode::Slice:
+        ctx->thread_type = FF_THREAD_SLICE;
+        break;
+    default:
+        ctx->thread_type = 0;
+        break;
+    }
+    ctx->thread_count = resolved.thread_count;
+    if (resolved.low_delay) {
+        ctx->flags |= AV_CODEC_FLAG_LOW_DELAY;
+    }
+}
+
+// 解码器可能不接受请求的方式（比如码流里只有一个 slice），以 open 之后的值为准
+ResolvedDecodeThreading read_back(const AVCodecContext* ctx)
+{
+    ResolvedDecodeThreading out;
+    out.thread_count = ctx->thread_count > 0 ? ctx->thread_count : 1;
+    if (out.thread_count > 1 && (ctx->active_thread_type & FF_THREAD_FRAME) != 0) {
+        out.mode = DecodeThreading::Mode::Frame;
+    } else if (out.thread_count > 1 && (ctx->active_thread_type & FF_THREAD_SLICE) != 0) {
+        out.mode = DecodeThreading::Mode::Slice;
+    } else {
+        out.thread_count = 1;
+    }
+    out.low_delay = (ctx->flags & AV_CODEC_FLAG_LOW_DELAY) != 0;
+    return out;
+}
+
+} // namespace
+
+DecoderContext::DecoderContext(const AVCodecParameters* codec_params, const DecodeThreading& threading)
 {
     const AVCodec* codec = avcodec_find_decoder(codec_params->codec_id);
     if (codec == nullptr)
@@ -11,15 +60,18 @@ DecoderContext::DecoderContext(const AVCodecParameters* codec_params)
     if (codec_ctx_ == nullptr)
         throw std::runtime_error("Could not allocate AVCodecContext");
 
-    if (avcodec_parameters_to_context(codec_ctx_, codec_params) < 0 || avcodec_open2(codec_ctx_, codec, nullptr) < 0) {
+    if (avcodec_parameters_to_context(codec_ctx_, codec_params) < 0) {
         avcodec_free_context(&codec_ctx_);
         throw std::runtime_error("Could not initialize codec context");
     }
 
+    apply_threading(codec_ctx_, codec, threading);
+
     if (avcodec_open2(codec_ctx_, codec, nullptr) < 0) {
         avcodec_free_context(&codec_ctx_);
         throw std::runtime_error("Decoder: Failed to open codec.");
     }
+    threading_ = read_back(codec_ctx_);
 }
 
 DecoderContext::~DecoderContext()
@@ -29,6 +81,7 @@ DecoderContext::~DecoderContext()
 
 DecoderContext::DecoderContext(DecoderContext&& other) noexcept
     : codec_ctx_(other.codec_ctx_)
+    , threading_(other.threading_)
 {
     other.codec_ctx_ = nullptr;
 }
@@ -38,6 +91,7 @@ DecoderContext& DecoderContext::operator=(DecoderContext&& other) noexcept
     if (this != &other) {
         avcodec_free_context(&codec_ctx_);
         codec_ctx_ = other.codec_ctx_;
+        threading_ = other.threading_;
         other.codec_ctx_ = nullptr;
     }
     return *this;
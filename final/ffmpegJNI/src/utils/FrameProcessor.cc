@@ -5,9 +5,7 @@
 
 extern "C" {
 #include "libavformat/avformat.h"
-#include <libavutil/channel_layout.h>
 #include <libavutil/imgutils.h>
-#include <libswresample/swresample.h>
 }
 
 #define LOG_TAG "FrameProcessor"
@@ -16,28 +14,15 @@ extern "C" {
 #define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
 
 namespace mp4parser {
-using player_utils::AudioFrame;
 
-std::shared_ptr<player_utils::VideoFrame> convert_video_frame(AVStream* stream, const AVFrame* frame)
+std::shared_ptr<player_utils::VideoFrame> convert_video_frame(AVStream* stream, const AVFrame* frame,
+    player_utils::VideoFramePool* pool)
 {
     if (!frame || !frame->data[0]) {
         LOGE("Invalid AVFrame: data[0] is null.");
         return nullptr;
     }
 
-    auto out = std::make_shared<player_utils::VideoFrame>();
-    out->width = frame->width;
-    out->height = frame->height;
-    out->format = static_cast<AVPixelFormat>(frame->format);
-
-    if (frame->pts != AV_NOPTS_VALUE) {
-        out->pts = static_cast<double>(frame->pts) * av_q2d(stream->time_base);
-        LOGD("Converted video frame: %dx%d, PTS=%.3f", frame->width, frame->height, out->pts);
-    } else {
-        out->pts = 0.0;
-        LOGD("Converted video frame without PTS.");
-    }
-
     // 预估数据大小
     int total_size = 0;
     for (int i = 0; i < AV_NUM_DATA_POINTERS && frame->data[i]; ++i) {
@@ -50,7 +35,25 @@ std::shared_ptr<player_utils::VideoFrame> convert_video_frame(AVStream* stream,
         return nullptr;
     }
 
-    out->data.resize(total_size);
+    std::shared_ptr<player_utils::VideoFrame> out;
+    if (pool) {
+        out = pool->acquire(frame->width, frame->height, frame->format, static_cast<size_t>(total_size));
+    } else {
+        out = std::make_shared<player_utils::VideoFrame>();
+        out->width = frame->width;
+        out->height = frame->height;
+        out->format = static_cast<AVPixelFormat>(frame->format);
+        out->data.resize(total_size);
+    }
+
+    if (frame->pts != AV_NOPTS_VALUE) {
+        out->pts = static_cast<double>(frame->pts) * av_q2d(stream->time_base);
+        LOGD("Converted video frame: %dx%d, PTS=%.3f", frame->width, frame->height, out->pts);
+    } else {
+        out->pts = 0.0;
+        LOGD("Converted video frame without PTS.");
+    }
+
     uint8_t* dst = out->data.data();
 
     for (int i = 0; i < AV_NUM_DATA_POINTERS && frame->data[i]; ++i) {
@@ -65,83 +68,40 @@ std::shared_ptr<player_utils::VideoFrame> convert_video_frame(AVStream* stream,
     return out;
 }
 
-std::shared_ptr<AudioFrame> convert_audio_frame(AVStream* stream, const AVFrame* frame)
+std::shared_ptr<player_utils::VideoFrame> ref_video_frame(AVStream* stream, const AVFrame* frame,
+    player_utils::VideoFramePool* pool)
 {
-    auto audio_frame = std::make_shared<AudioFrame>();
-
-    // --- 计算并设置 PTS 和 Duration ---
-
-    // 检查输入的 AVFrame 是否有有效的时间戳
-    if (frame->pts != AV_NOPTS_VALUE) {
-        // 将以 time_base 为单位的整数 pts 转换为以秒为单位的 double
-        // av_q2d 是一个将 AVRational (分数) 转换为 double 的辅助函数
-        audio_frame->pts = frame->pts * av_q2d(stream->time_base);
-    } else {
-        // 如果没有 PTS，可以赋一个特殊值，或者基于之前的帧估算
-        // 但对于调试，先赋一个无效值并打印警告
-        audio_frame->pts = -1.0; // 表示无效
-        LOGW("Audio frame found with no PTS (AV_NOPTS_VALUE).");
-    }
-
-    // 根据采样数和采样率计算这一帧的播放时长（秒）
-    audio_frame->duration = (double)frame->nb_samples / frame->sample_rate;
-
-    // --- 音频重采样 ---
-
-    audio_frame->nb_samples = frame->nb_samples;
-    audio_frame->sample_rate = frame->sample_rate;
-    audio_frame->channels = frame->ch_layout.nb_channels;
-
-    AVChannelLayout in_layout = frame->ch_layout;
-    AVChannelLayout out_layout;
-    av_channel_layout_default(&out_layout, audio_frame->channels);
-
-    SwrContext* swr_ctx = nullptr;
-    int ret = swr_alloc_set_opts2(
-        &swr_ctx,
-        &out_layout, AV_SAMPLE_FMT_S16, audio_frame->sample_rate,
-        &in_layout, (AVSampleFormat)frame->format, frame->sample_rate,
-        0, nullptr);
-
-    if (ret < 0 || swr_init(swr_ctx) < 0) {
-        LOGE("swr_alloc_set_opts2 or swr_init failed.");
-        swr_free(&swr_ctx);
-        av_channel_layout_uninit(&out_layout);
+    if (!frame || !frame->data[0]) {
+        LOGE("Invalid AVFrame: data[0] is null.");
         return nullptr;
     }
-
-    // 注意：这里的 dst_nb_samples 计算方式可能会引入微小的延迟，
-    // 但对于大多数情况是可接受的。
-    int dst_nb_samples = av_rescale_rnd(
-        swr_get_delay(swr_ctx, frame->sample_rate) + frame->nb_samples,
-        frame->sample_rate, frame->sample_rate, AV_ROUND_UP);
-
-    int out_buf_size = av_samples_get_buffer_size(
-        nullptr, audio_frame->channels, dst_nb_samples, AV_SAMPLE_FMT_S16, 1);
-
-    // 使用 av_mallocz 可以确保内存被清零，是一个好习惯
-    uint8_t* out_buf = (uint8_t*)av_mallocz(out_buf_size);
-    if (!out_buf) {
-        LOGE("av_mallocz failed to allocate audio buffer.");
-        swr_free(&swr_ctx);
-        av_channel_layout_uninit(&out_layout);
-        return nullptr;
+    if (!frame->buf[0]) {
+        return convert_video_frame(stream, frame, pool);
     }
 
-    uint8_t* out[] = { out_buf };
-    int samples_converted = swr_convert(
-        swr_ctx,
-        out, dst_nb_samples,
-        (const uint8_t**)frame->extended_data,
-        frame->nb_samples);
-
-    audio_frame->interleaved_pcm = out_buf;
-    audio_frame->interleaved_size = samples_converted * audio_frame->channels * sizeof(int16_t);
-
-    swr_free(&swr_ctx);
-    av_channel_layout_uninit(&out_layout);
+    AVFrame* ref = av_frame_alloc();
+    if (!ref || av_frame_ref(ref, frame) < 0) {
+        LOGE("av_frame_ref failed, falling back to copy.");
+        av_frame_free(&ref);
+        return convert_video_frame(stream, frame, pool);
+    }
 
-    return audio_frame;
+    auto out = std::make_shared<player_utils::VideoFrame>();
+    out->width = ref->width;
+    out->height = ref->height;
+    out->format = ref->format;
+    out->pts = ref->pts != AV_NOPTS_VALUE ? static_cast<double>(ref->pts) * av_q2d(stream->time_base) : 0.0;
+    for (int i = 0; i < AV_NUM_DATA_POINTERS && ref->data[i]; ++i) {
+        out->planes[i] = ref->data[i];
+        out->linesize[i] = ref->linesize[i];
+        out->ref_bytes += static_cast<size_t>(ref->linesize[i]) * out->plane_height(i);
+    }
+    // 渲染线程丢掉最后一个引用时释放，缓冲区回到解码器的 buffer pool
+    out->buffer_ref = std::shared_ptr<void>(ref, [](void* p) {
+        auto* f = static_cast<AVFrame*>(p);
+        av_frame_free(&f);
+    });
+    return out;
 }
 
 } // namespace mp4parser
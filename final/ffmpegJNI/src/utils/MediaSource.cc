@@ -1,25 +1,781 @@
 #include "MediaSource.hpp"
+#include <android/log.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avio.h>
+#include <libavutil/dict.h>
+#include <libavutil/mem.h>
+}
+
+#define LOG_TAG "MediaSource"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+using ffmpeg_utils::Mp4SampleReader;
+using ffmpeg_utils::Mp4SampleTable;
+using player_utils::AvioReader;
+using player_utils::CachedStreamInfo;
+using player_utils::FastOpenOptions;
+using player_utils::FileIdentity;
+using player_utils::FileIoOptions;
+using player_utils::GrowingFileReader;
+using player_utils::KeyframeIndex;
+using player_utils::LocalFileReader;
+using player_utils::RemoteFileReader;
+using player_utils::RemoteOptions;
+using player_utils::RemoteUrl;
+using player_utils::StreamInfoCache;
+using player_utils::TrackInfo;
+using player_utils::TrackType;
+
+namespace {
+
+// AVIOContext 的缓冲区。解复用按这个大小向 AvioReader 要数据，
+// 真正的磁盘读取粒度由 FileIoOptions::chunk_size 决定
+constexpr int kAvioBufferSize = 64 * 1024;
+
+int read_packet(void* opaque, uint8_t* buf, int buf_size)
+{
+    auto* reader = static_cast<AvioReader*>(opaque);
+    const int64_t n = reader->read(buf, static_cast<size_t>(buf_size));
+    if (n == 0) {
+        return AVERROR_EOF;
+    }
+    return n < 0 ? AVERROR(static_cast<int>(-n)) : static_cast<int>(n);
+}
+
+int64_t seek_packet(void* opaque, int64_t offset, int whence)
+{
+    auto* reader = static_cast<AvioReader*>(opaque);
+    switch (whence & ~AVSEEK_FORCE) {
+    case AVSEEK_SIZE:
+        return reader->size();
+    case SEEK_SET:
+        break;
+    case SEEK_CUR:
+        offset += reader->position();
+        break;
+    case SEEK_END:
+        offset += reader->size();
+        break;
+    default:
+        return AVERROR(EINVAL);
+    }
+    const int64_t pos = reader->seek(offset);
+    return pos < 0 ? AVERROR(static_cast<int>(-pos)) : pos;
+}
+
+// content:// 、http:// 之类交给 FFmpeg 自己的协议
+bool is_local_path(const std::string& filename)
+{
+    return filename.find("://") == std::string::npos;
+}
+
+// 快速打开时限制探测量，其余参数和原来一样交给 FFmpeg
+int open_input(AVFormatContext** fmt_ctx, const std::string& filename, const FastOpenOptions& fast_open)
+{
+    AVDictionary* options = nullptr;
+    if (fast_open.enabled) {
+        if (fast_open.probesize > 0) {
+            av_dict_set_int(&options, "probesize", fast_open.probesize, 0);
+        }
+        if (fast_open.analyzeduration_us > 0) {
+            av_dict_set_int(&options, "analyzeduration", fast_open.analyzeduration_us, 0);
+        }
+    }
+    const int ret = avformat_open_input(fmt_ctx, filename.c_str(), nullptr, &options);
+    av_dict_free(&options);
+    return ret;
+}
+
+// 这些编解码器的参数集在 mp4 里放在 extradata（avcC / hvcC / esds），容器头没带就只能靠探测补
+bool needs_extradata(AVCodecID id)
+{
+    return id == AV_CODEC_ID_H264 || id == AV_CODEC_ID_HEVC || id == AV_CODEC_ID_AAC;
+}
+
+// 容器头里每个音视频流都有解码器初始化要用的参数，不用 avformat_find_stream_info 再补
+bool header_is_complete(const AVFormatContext* fmt)
+{
+    bool has_media = false;
+    for (unsigned i = 0; i < fmt->nb_streams; ++i) {
+        const AVCodecParameters* par = fmt->streams[i]->codecpar;
+        if (par->codec_type != AVMEDIA_TYPE_VIDEO && par->codec_type != AVMEDIA_TYPE_AUDIO) {
+            continue;
+        }
+        has_media = true;
+        if (par->codec_id == AV_CODEC_ID_NONE || (needs_extradata(par->codec_id) && par->extradata_size <= 0)) {
+            return false;
+        }
+        if (par->codec_type == AVMEDIA_TYPE_VIDEO && (par->width <= 0 || par->height <= 0)) {
+            return false;
+        }
+        if (par->codec_type == AVMEDIA_TYPE_AUDIO && (par->sample_rate <= 0 || par->ch_layout.nb_channels <= 0)) {
+            return false;
+        }
+    }
+    return has_media;
+}
 
-bool MediaSource::open(const std::string& filename)
+// 总时长原本由 avformat_find_stream_info 估出来，跳过探测时取各个流里最长的
+void fill_duration_from_streams(AVFormatContext* fmt)
 {
-    if (avformat_open_input(&fmt_ctx_, filename.c_str(), nullptr, nullptr) < 0)
+    if (fmt->duration != AV_NOPTS_VALUE) {
+        return;
+    }
+    for (unsigned i = 0; i < fmt->nb_streams; ++i) {
+        const AVStream* st = fmt->streams[i];
+        if (st->duration != AV_NOPTS_VALUE) {
+            const int64_t duration = av_rescale_q(st->duration, st->time_base, AV_TIME_BASE_Q);
+            if (fmt->duration == AV_NOPTS_VALUE || duration > fmt->duration) {
+                fmt->duration = duration;
+            }
+        }
+    }
+}
+
+StreamInfoCache::Entry snapshot_stream_info(const AVFormatContext* fmt)
+{
+    StreamInfoCache::Entry entry;
+    entry.duration = fmt->duration;
+    for (unsigned i = 0; i < fmt->nb_streams; ++i) {
+        const AVCodecParameters* par = fmt->streams[i]->codecpar;
+        CachedStreamInfo s;
+        s.codec_type = par->codec_type;
+        s.codec_id = par->codec_id;
+        s.codec_tag = par->codec_tag;
+        s.format = par->format;
+        s.bit_rate = par->bit_rate;
+        s.profile = par->profile;
+        s.level = par->level;
+        s.width = par->width;
+        s.height = par->height;
+        s.sar_num = par->sample_aspect_ratio.num;
+        s.sar_den = par->sample_aspect_ratio.den;
+        s.color_range = par->color_range;
+        s.color_primaries = par->color_primaries;
+        s.color_trc = par->color_trc;
+        s.color_space = par->color_space;
+        s.video_delay = par->video_delay;
+        s.sample_rate = par->sample_rate;
+        s.channels = par->ch_layout.nb_channels;
+        s.channel_mask = par->ch_layout.order == AV_CHANNEL_ORDER_NATIVE ? par->ch_layout.u.mask : 0;
+        s.frame_size = par->frame_size;
+        if (par->extradata_size > 0) {
+            s.extradata.assign(par->extradata, par->extradata + par->extradata_size);
+        }
+        entry.streams.push_back(std::move(s));
+    }
+    return entry;
+}
+
+// 流的个数、类型、编解码器都和缓存对得上才用
+bool apply_stream_info(AVFormatContext* fmt, const StreamInfoCache::Entry& entry)
+{
+    if (entry.streams.size() != fmt->nb_streams) {
         return false;
+    }
+    for (unsigned i = 0; i < fmt->nb_streams; ++i) {
+        const AVCodecParameters* par = fmt->streams[i]->codecpar;
+        if (entry.streams[i].codec_type != par->codec_type || entry.streams[i].codec_id != par->codec_id) {
+            return false;
+        }
+    }
+    for (unsigned i = 0; i < fmt->nb_streams; ++i) {
+        AVCodecParameters* par = fmt->streams[i]->codecpar;
+        const CachedStreamInfo& s = entry.streams[i];
+        if (!s.extradata.empty()) {
+            auto* extradata = static_cast<uint8_t*>(av_mallocz(s.extradata.size() + AV_INPUT_BUFFER_PADDING_SIZE));
+            if (extradata == nullptr) {
+                return false;
+            }
+            std::memcpy(extradata, s.extradata.data(), s.extradata.size());
+            av_freep(&par->extradata);
+            par->extradata = extradata;
+            par->extradata_size = static_cast<int>(s.extradata.size());
+        }
+        par->codec_tag = s.codec_tag;
+        par->format = s.format;
+        par->bit_rate = s.bit_rate;
+        par->profile = s.profile;
+        par->level = s.level;
+        if (par->codec_type == AVMEDIA_TYPE_VIDEO) {
+            par->width = s.width;
+            par->height = s.height;
+            par->sample_aspect_ratio = AVRational { s.sar_num, s.sar_den };
+            par->color_range = static_cast<AVColorRange>(s.color_range);
+            par->color_primaries = static_cast<AVColorPrimaries>(s.color_primaries);
+            par->color_trc = static_cast<AVColorTransferCharacteristic>(s.color_trc);
+            par->color_space = static_cast<AVColorSpace>(s.color_space);
+            par->video_delay = s.video_delay;
+        } else if (par->codec_type == AVMEDIA_TYPE_AUDIO) {
+            par->sample_rate = s.sample_rate;
+            par->frame_size = s.frame_size;
+            av_channel_layout_uninit(&par->ch_layout);
+            if (s.channel_mask != 0) {
+                av_channel_layout_from_mask(&par->ch_layout, s.channel_mask);
+            } else {
+                av_channel_layout_default(&par->ch_layout, s.channels);
+            }
+        }
+    }
+    if (entry.duration != AV_NOPTS_VALUE) {
+        fmt->duration = entry.duration;
+    }
+    return true;
+}
 
-    if (avformat_find_stream_info(fmt_ctx_, nullptr) < 0)
+// 核对样本表解复用时比较的字段
+struct PacketBrief {
+    int64_t pts;
+    int64_t dts;
+    int64_t duration;
+    int64_t pos;
+    int size;
+    int flags;
+
+    bool operator==(const PacketBrief& other) const
+    {
+        return pts == other.pts && dts == other.dts && duration == other.duration && pos == other.pos
+            && size == other.size && flags == other.flags;
+    }
+};
+
+PacketBrief brief(const AVPacket* pkt)
+{
+    return { pkt->pts, pkt->dts, pkt->duration, pkt->pos, pkt->size, pkt->flags & (AV_PKT_FLAG_KEY | AV_PKT_FLAG_DISCARD) };
+}
+
+TrackType track_type(const AVStream* st)
+{
+    switch (st->codecpar->codec_type) {
+    case AVMEDIA_TYPE_VIDEO:
+        // mp3 / m4a 的封面图也是一个视频流
+        return (st->disposition & AV_DISPOSITION_ATTACHED_PIC) != 0 ? TrackType::Other : TrackType::Video;
+    case AVMEDIA_TYPE_AUDIO:
+        return TrackType::Audio;
+    case AVMEDIA_TYPE_SUBTITLE:
+        return TrackType::Subtitle;
+    default:
+        return TrackType::Other;
+    }
+}
+
+} // namespace
+
+bool MediaSource::open(const std::string& filename, const std::string& keyframe_index_path, const FileIoOptions& file_io,
+    const FastOpenOptions& fast_open, const player_utils::TrackSelection& tracks, const player_utils::LiveOptions& live,
+    const RemoteOptions& remote)
+{
+    filename_ = filename;
+    live_ = live;
+    // 边录边播：文件还在变，探测结果不缓存；头里参数齐全（分片 mp4 的 moov 一般都是）就不用等写出几秒数据去探测
+    FastOpenOptions open_options = fast_open;
+    if (RemoteUrl::is_remote(filename)) {
+        // FFmpeg 不认识这个协议，没有退路
+        if (!open_remote_io(filename, remote, fast_open)) {
+            LOGW("Failed to open %s from the file server.", filename.c_str());
+            return false;
+        }
+    } else if (live.enabled && is_local_path(filename)) {
+        open_options.enabled = true;
+        open_options.trust_header = true;
+        open_options.cache_dir.clear();
+        if (!open_live_io(filename, open_options)) {
+            LOGW("Live playback unavailable for %s, opening it as a finished file.", filename.c_str());
+        }
+    } else if (file_io.mode != FileIoOptions::Mode::Default && is_local_path(filename)) {
+        if (!open_custom_io(filename, file_io, fast_open)) {
+            LOGW("Custom file IO unavailable for %s, falling back to the file protocol.", filename.c_str());
+        }
+    }
+    if (fmt_ctx_ == nullptr && open_input(&fmt_ctx_, filename, open_options) < 0)
+        return false;
+
+    if (!find_stream_info(filename, open_options))
         return false;
+    scan_fragments_ = is_live() && std::strstr(fmt_ctx_->iformat->name, "mp4") != nullptr;
 
-    video_stream_index_ = av_find_best_stream(fmt_ctx_, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
-    audio_stream_index_ = av_find_best_stream(fmt_ctx_, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    list_tracks();
+    video_stream_index_ = player_utils::resolve_track(tracks_, TrackType::Video, tracks.video_id,
+        av_find_best_stream(fmt_ctx_, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0));
+    audio_stream_index_ = player_utils::resolve_track(tracks_, TrackType::Audio, tracks.audio_id,
+        av_find_best_stream(fmt_ctx_, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0));
+    subtitle_stream_index_ = player_utils::resolve_track(tracks_, TrackType::Subtitle, tracks.subtitle_id, -1);
+    apply_discard();
+
+    // 边录边播时文件没写完，扫包建表会一直等到录制结束
+    if (video_stream_index_ >= 0 && !is_live()) {
+        build_keyframe_index(keyframe_index_path);
+    }
 
     return video_stream_index_ >= 0 || audio_stream_index_ >= 0;
 }
 
-MediaSource::~MediaSource()
+void MediaSource::list_tracks()
+{
+    tracks_.clear();
+    for (unsigned i = 0; i < fmt_ctx_->nb_streams; ++i) {
+        const AVStream* st = fmt_ctx_->streams[i];
+        TrackInfo track;
+        track.id = st->id;
+        track.stream_index = static_cast<int>(i);
+        track.type = track_type(st);
+        track.codec = avcodec_get_name(st->codecpar->codec_id);
+        const AVDictionaryEntry* language = av_dict_get(st->metadata, "language", nullptr, 0);
+        if (language != nullptr && std::strcmp(language->value, "und") != 0) {
+            track.language = language->value;
+        }
+        track.is_default = (st->disposition & AV_DISPOSITION_DEFAULT) != 0;
+        tracks_.push_back(std::move(track));
+    }
+}
+
+// 没选中的流 FFmpeg 在解复用时直接跳过：mov 只推进这个流的样本位置，不读数据，也不交出包
+void MediaSource::apply_discard()
+{
+    for (unsigned i = 0; i < fmt_ctx_->nb_streams; ++i) {
+        const int index = static_cast<int>(i);
+        const bool selected = index == video_stream_index_ || index == audio_stream_index_ || index == subtitle_stream_index_;
+        fmt_ctx_->streams[i]->discard = selected ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+    }
+}
+
+bool MediaSource::select_stream(TrackType type, int stream_index)
+{
+    if (type != TrackType::Audio && type != TrackType::Subtitle) {
+        return false;
+    }
+    std::atomic<int>& current = type == TrackType::Audio ? audio_stream_index_ : subtitle_stream_index_;
+    const int previous = current.load();
+    if (stream_index == previous) {
+        return true;
+    }
+    const TrackInfo* track = player_utils::find_track_by_stream(tracks_, stream_index);
+    if ((stream_index >= 0 || type == TrackType::Audio) && (track == nullptr || track->type != type)) {
+        return false;
+    }
+    if (sample_reader_ && !sample_reader_->switch_stream(previous, stream_index, track != nullptr ? static_cast<uint32_t>(track->id) : 0)) {
+        LOGW("Sample table demux cannot switch stream %d -> %d.", previous, stream_index);
+        return false;
+    }
+    if (previous >= 0) {
+        fmt_ctx_->streams[previous]->discard = AVDISCARD_ALL;
+    }
+    if (stream_index >= 0) {
+        fmt_ctx_->streams[stream_index]->discard = AVDISCARD_DEFAULT;
+    }
+    current = stream_index;
+    LOGI("Switched %s stream %d -> %d.", type == TrackType::Audio ? "audio" : "subtitle", previous, stream_index);
+    return true;
+}
+
+bool MediaSource::open_custom_io(const std::string& filename, const FileIoOptions& file_io, const FastOpenOptions& fast_open)
+{
+    if (!install_avio(LocalFileReader::open(filename, file_io))) {
+        return false;
+    }
+    // 失败时 avformat_open_input 会释放 fmt_ctx_ 并置空，avio_ 还要自己放
+    if (open_input(&fmt_ctx_, filename, fast_open) < 0) {
+        close();
+        return false;
+    }
+    const bool mapped = dynamic_cast<const player_utils::MappedFileReader*>(file_reader_.get()) != nullptr;
+    LOGI("Opened %s with %s file IO.", filename.c_str(), mapped ? "mmap" : "read-ahead");
+    return true;
+}
+
+bool MediaSource::open_live_io(const std::string& filename, const FastOpenOptions& fast_open)
+{
+    auto reader = GrowingFileReader::open(filename, live_);
+    GrowingFileReader* growing = reader.get();
+    if (!install_avio(std::move(reader))) {
+        return false;
+    }
+    growing_reader_ = growing;
+    // 打开时按不能 seek 的流读头：mov 不会按打开时的文件大小去界定顶层 box，
+    // 也不会去文件末尾找 mfra，读到哪个分片写了一半就在那里等。打开之后允许 seek，已经读过的分片之间可以来回拖
+    avio_->seekable = 0;
+    if (open_input(&fmt_ctx_, filename, fast_open) < 0) {
+        close();
+        return false;
+    }
+    avio_->seekable = AVIO_SEEKABLE_NORMAL;
+    LOGI("Opened %s for live playback (%s).", filename.c_str(), growing->uses_inotify() ? "inotify" : "polling");
+    return true;
+}
+
+bool MediaSource::open_remote_io(const std::string& filename, const RemoteOptions& remote, const FastOpenOptions& fast_open)
+{
+    if (!install_avio(RemoteFileReader::open(filename, remote))) {
+        return false;
+    }
+    // 容器格式按文件名的扩展名和开头的数据探测，不会去打开 lab06:// 这个 URL
+    if (open_input(&fmt_ctx_, filename, fast_open) < 0) {
+        close();
+        return false;
+    }
+    LOGI("Opened %s from the file server: %lld bytes, %zu KB chunks over %zu connections.", filename.c_str(),
+        static_cast<long long>(file_reader_->size()), remote.chunk_size / 1024, remote.connections);
+    return true;
+}
+
+// 用 reader 装一个 AVIOContext 和带着它的 fmt_ctx_，之后由调用方 open_input
+bool MediaSource::install_avio(std::unique_ptr<AvioReader> reader)
 {
+    file_reader_ = std::move(reader);
+    if (!file_reader_) {
+        return false;
+    }
+    auto* buffer = static_cast<uint8_t*>(av_malloc(kAvioBufferSize));
+    if (buffer == nullptr) {
+        close();
+        return false;
+    }
+    avio_ = avio_alloc_context(buffer, kAvioBufferSize, 0, file_reader_.get(), read_packet, nullptr, seek_packet);
+    if (avio_ == nullptr) {
+        av_free(buffer);
+        close();
+        return false;
+    }
+    fmt_ctx_ = avformat_alloc_context();
+    if (fmt_ctx_ == nullptr) {
+        close();
+        return false;
+    }
+    fmt_ctx_->pb = avio_;
+    fmt_ctx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+    return true;
+}
+
+bool MediaSource::live_data_ready()
+{
+    if (growing_reader_ == nullptr || avio_->buf_ptr < avio_->buf_end) {
+        return true;
+    }
+    return !growing_reader_->at_write_head() || growing_reader_->finished();
+}
+
+void MediaSource::wait_for_live_data()
+{
+    if (growing_reader_ != nullptr) {
+        growing_reader_->wait_for_growth();
+    }
+}
+
+void MediaSource::interrupt_reads(bool on)
+{
+    if (growing_reader_ == nullptr) {
+        return;
+    }
+    growing_reader_->interrupt(on);
+    if (!on) {
+        // 被打断的那次读在 AVIOContext 上留下了错误，seek / 重新开始之前清掉
+        avio_->error = 0;
+        avio_->eof_reached = 0;
+    }
+}
+
+double MediaSource::live_edge_seconds()
+{
+    if (growing_reader_ == nullptr || !scan_fragments_) {
+        return -1.0;
+    }
+    growing_reader_->refresh();
+    if (!fragment_scanner_.scan(growing_reader_->fd(), growing_reader_->size())) {
+        LOGW("%s is not a fragmented mp4, live latency is not bounded.", filename_.c_str());
+        scan_fragments_ = false;
+        return -1.0;
+    }
+    const int index = video_stream_index_ >= 0 ? video_stream_index_ : audio_stream_index_.load();
+    if (index < 0) {
+        return -1.0;
+    }
+    return fragment_scanner_.end_seconds(static_cast<uint32_t>(fmt_ctx_->streams[index]->id));
+}
+
+bool MediaSource::find_stream_info(const std::string& filename, const FastOpenOptions& fast_open)
+{
+    if (!fast_open.enabled) {
+        stream_info_origin_ = StreamInfoOrigin::Probe;
+        return avformat_find_stream_info(fmt_ctx_, nullptr) >= 0;
+    }
+
+    const StreamInfoCache cache(fast_open.cache_dir);
+    FileIdentity identity;
+    const bool cacheable = !fast_open.cache_dir.empty() && is_local_path(filename) && FileIdentity::of(filename, identity);
+    StreamInfoCache::Entry entry;
+    if (cacheable && cache.load(identity, entry) && apply_stream_info(fmt_ctx_, entry)) {
+        stream_info_origin_ = StreamInfoOrigin::Cache;
+        LOGI("Stream info for %s restored from cache.", filename.c_str());
+        return true;
+    }
+    if (fast_open.trust_header && header_is_complete(fmt_ctx_)) {
+        fill_duration_from_streams(fmt_ctx_);
+        stream_info_origin_ = StreamInfoOrigin::Header;
+        LOGI("Stream info for %s taken from the container header, probing skipped.", filename.c_str());
+        return true;
+    }
+
+    if (avformat_find_stream_info(fmt_ctx_, nullptr) < 0)
+        return false;
+    stream_info_origin_ = StreamInfoOrigin::Probe;
+    // 只缓存探测出来的结果：头里就全的文件下次照样不用探测
+    if (cacheable && !cache.save(identity, snapshot_stream_info(fmt_ctx_))) {
+        LOGW("Failed to write stream info cache for %s.", filename.c_str());
+    }
+    return true;
+}
+
+void MediaSource::close()
+{
+    sample_reader_.reset();
     if (fmt_ctx_ != nullptr) {
         avformat_close_input(&fmt_ctx_);
         fmt_ctx_ = nullptr;
     }
+    if (avio_ != nullptr) {
+        av_freep(&avio_->buffer);
+        avio_context_free(&avio_);
+    }
+    file_reader_.reset();
+    growing_reader_ = nullptr;
+    scan_fragments_ = false;
+}
+
+void MediaSource::build_keyframe_index(const std::string& sidecar_path)
+{
+    // 本地文件用 stat 的大小和修改时间；远程文件拿不到修改时间，只能按大小
+    FileIdentity identity;
+    if (!is_local_path(filename_) || !FileIdentity::of(filename_, identity)) {
+        identity.size = fmt_ctx_->pb != nullptr ? avio_size(fmt_ctx_->pb) : -1;
+    }
+    if (!sidecar_path.empty() && KeyframeIndex::load_from_file(sidecar_path, identity.size, identity.mtime_ns, keyframe_index_)) {
+        LOGI("Keyframe index loaded from %s: %zu keyframes.", sidecar_path.c_str(), keyframe_index_.size());
+        return;
+    }
+
+    // mp4 的 moov 里有完整的样本表，avformat_find_stream_info 之后索引就是全的；
+    // 没有索引（比如分片 mp4）才扫一遍包
+    // 远程文件扫一遍等于整个下载下来，宁可 seek 时交给 av_seek_frame
+    const bool from_stream = index_from_stream();
+    if (!from_stream && (RemoteUrl::is_remote(filename_) || !index_from_scan())) {
+        LOGW("No keyframe index available, seeks will go through av_seek_frame only.");
+        return;
+    }
+    LOGI("Keyframe index built from %s: %zu keyframes.", from_stream ? "stream index" : "packet scan", keyframe_index_.size());
+
+    if (!sidecar_path.empty() && !keyframe_index_.save_to_file(sidecar_path, identity.size, identity.mtime_ns)) {
+        LOGW("Failed to write keyframe index to %s.", sidecar_path.c_str());
+    }
+}
+
+bool MediaSource::index_from_stream()
+{
+    AVStream* stream = get_video_stream();
+    const int count = avformat_index_get_entries_count(stream);
+    // 索引可能只有关键帧，这时 GOP 帧数记为未知
+    KeyframeIndex::Builder builder(false);
+    for (int i = 0; i < count; ++i) {
+        const AVIndexEntry* entry = avformat_index_get_entry(stream, i);
+        if (entry == nullptr) {
+            continue;
+        }
+        builder.add(entry->timestamp, entry->pos, (entry->flags & AVINDEX_KEYFRAME) != 0);
+    }
+    if (builder.empty()) {
+        return false;
+    }
+    keyframe_index_ = builder.build(stream->time_base.num, stream->time_base.den);
+    return true;
+}
+
+bool MediaSource::index_from_scan()
+{
+    if (fmt_ctx_->pb == nullptr || (fmt_ctx_->pb->seekable & AVIO_SEEKABLE_NORMAL) == 0) {
+        return false;
+    }
+
+    // 扫描时只读视频流的包，其他流先丢掉
+    std::vector<AVDiscard> saved_discard(fmt_ctx_->nb_streams);
+    for (unsigned i = 0; i < fmt_ctx_->nb_streams; ++i) {
+        saved_discard[i] = fmt_ctx_->streams[i]->discard;
+        if (static_cast<int>(i) != video_stream_index_) {
+            fmt_ctx_->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+
+    KeyframeIndex::Builder builder(true);
+    AVPacket* packet = av_packet_alloc();
+    while (packet != nullptr && av_read_frame(fmt_ctx_, packet) >= 0) {
+        if (packet->stream_index == video_stream_index_) {
+            const int64_t ts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+            builder.add(ts, packet->pos, (packet->flags & AV_PKT_FLAG_KEY) != 0 && ts != AV_NOPTS_VALUE);
+        }
+        av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+
+    for (unsigned i = 0; i < fmt_ctx_->nb_streams; ++i) {
+        fmt_ctx_->streams[i]->discard = saved_discard[i];
+    }
+    // 回到开头，解复用线程从头读
+    AVStream* stream = get_video_stream();
+    const int64_t start = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+    av_seek_frame(fmt_ctx_, video_stream_index_, start, AVSEEK_FLAG_BACKWARD);
+
+    if (builder.empty()) {
+        return false;
+    }
+    keyframe_index_ = builder.build(stream->time_base.num, stream->time_base.den);
+    return true;
+}
+
+bool MediaSource::enable_sample_table_demux()
+{
+    if (fmt_ctx_ == nullptr || is_live() || !is_local_path(filename_) || fmt_ctx_->iformat == nullptr
+        || std::strstr(fmt_ctx_->iformat->name, "mp4") == nullptr) {
+        return false;
+    }
+    const int fd = ::open(filename_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    auto table = std::make_shared<Mp4SampleTable>();
+    std::string error;
+    if (!table->parse_file(fd, &error)) {
+        LOGW("Sample table demux unavailable for %s: %s.", filename_.c_str(), error.c_str());
+        ::close(fd);
+        return false;
+    }
+    if (!verify_sample_table(*table)) {
+        ::close(fd);
+        return false;
+    }
+
+    auto reader = std::make_unique<Mp4SampleReader>(fd, table);
+    for (int index : { video_stream_index_, audio_stream_index_.load(), subtitle_stream_index_.load() }) {
+        if (index >= 0 && !reader->add_stream(index, static_cast<uint32_t>(fmt_ctx_->streams[index]->id))) {
+            return false;
+        }
+    }
+    const bool same_packets = verify_first_packets(*reader);
+    // 核对时 FFmpeg 读走了开头一段，回到开头；不用样本表时解复用器接着用它
+    const int index = video_stream_index_ >= 0 ? video_stream_index_ : audio_stream_index_.load();
+    const AVStream* stream = fmt_ctx_->streams[index];
+    av_seek_frame(fmt_ctx_, index, stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0, AVSEEK_FLAG_BACKWARD);
+    if (!same_packets) {
+        LOGW("Sample table demux disabled for %s: first packets differ from av_read_frame.", filename_.c_str());
+        return false;
+    }
+    reader->rewind();
+    sample_reader_ = std::move(reader);
+    LOGI("Sample table demux enabled for %s.", filename_.c_str());
+    return true;
+}
+
+// 样本表和 FFmpeg 的索引逐项对：个数、位置、大小、关键帧一致，时间戳只差一个常数。
+// FFmpeg 处理编辑列表更全，时间戳平移量和丢弃标记都以它为准。
+// 播放中可能换过去的音轨 / 字幕轨也一起对，换轨时不用退回 av_read_frame
+bool MediaSource::verify_sample_table(Mp4SampleTable& table)
+{
+    for (const TrackInfo& info : tracks_) {
+        const int index = info.stream_index;
+        if (index != video_stream_index_ && info.type != TrackType::Audio && info.type != TrackType::Subtitle) {
+            continue;
+        }
+        AVStream* stream = fmt_ctx_->streams[index];
+        Mp4SampleTable::Track* track = table.find_track(static_cast<uint32_t>(stream->id));
+        if (track == nullptr || stream->time_base.num != 1 || static_cast<uint32_t>(stream->time_base.den) != track->timescale) {
+            LOGW("Sample table demux: no track matches stream %d.", index);
+            return false;
+        }
+        const int count = avformat_index_get_entries_count(stream);
+        if (count < 0 || static_cast<size_t>(count) != track->samples.size()) {
+            LOGW("Sample table demux: stream %d has %d index entries but %zu samples.", index, count, track->samples.size());
+            return false;
+        }
+        int64_t delta = 0;
+        for (int i = 0; i < count; ++i) {
+            const AVIndexEntry* entry = avformat_index_get_entry(stream, i);
+            const Mp4SampleTable::Sample& sample = track->samples[i];
+            if (entry == nullptr) {
+                return false;
+            }
+            if (i == 0) {
+                delta = entry->timestamp - sample.dts;
+            }
+            const bool key = (entry->flags & AVINDEX_KEYFRAME) != 0;
+            if (entry->pos != sample.offset || static_cast<uint32_t>(entry->size) != sample.size
+                || key != ((sample.flags & Mp4SampleTable::kKeyframe) != 0) || entry->timestamp - sample.dts != delta) {
+                LOGW("Sample table demux: stream %d sample %d differs from FFmpeg's index.", index, i);
+                return false;
+            }
+        }
+        for (int i = 0; i < count; ++i) {
+            const AVIndexEntry* entry = avformat_index_get_entry(stream, i);
+            Mp4SampleTable::Sample& sample = track->samples[i];
+            sample.dts += delta;
+            sample.flags &= ~Mp4SampleTable::kDiscard;
+            if ((entry->flags & AVINDEX_DISCARD_FRAME) != 0) {
+                sample.flags |= Mp4SampleTable::kDiscard;
+            }
+        }
+    }
+    return true;
+}
+
+// 索引里没有 pts 和附加数据，再拿开头一段包和 av_read_frame 逐个比（按流比，交错顺序可以不同）
+bool MediaSource::verify_first_packets(Mp4SampleReader& reader)
+{
+    constexpr int kPackets = 64;
+    std::vector<std::vector<PacketBrief>> expected(fmt_ctx_->nb_streams);
+    std::vector<std::vector<PacketBrief>> actual(fmt_ctx_->nb_streams);
+    AVPacket* packet = av_packet_alloc();
+    if (packet == nullptr) {
+        return false;
+    }
+    bool ok = true;
+    int wanted = 0;
+    for (int i = 0; i < 4 * kPackets && wanted < kPackets && av_read_frame(fmt_ctx_, packet) >= 0; ++i) {
+        const int index = packet->stream_index;
+        if (fmt_ctx_->streams[index]->discard != AVDISCARD_ALL) {
+            // 音频起始裁剪（skip samples）之类的附加数据样本表给不出来
+            ok = ok && packet->side_data_elems == 0;
+            expected[index].push_back(brief(packet));
+            ++wanted;
+        }
+        av_packet_unref(packet);
+    }
+    auto behind = [&] {
+        for (size_t i = 0; i < expected.size(); ++i) {
+            if (actual[i].size() < expected[i].size()) {
+                return true;
+            }
+        }
+        return false;
+    };
+    for (int i = 0; ok && i < 4 * kPackets && behind() && reader.read(packet) >= 0; ++i) {
+        actual[packet->stream_index].push_back(brief(packet));
+        av_packet_unref(packet);
+    }
+    av_packet_free(&packet);
+    for (size_t i = 0; ok && i < expected.size(); ++i) {
+        ok = actual[i].size() >= expected[i].size() && std::equal(expected[i].begin(), expected[i].end(), actual[i].begin());
+    }
+    return ok && wanted > 0;
+}
+
+MediaSource::~MediaSource()
+{
+    close();
     avformat_network_deinit();
 }
@@ -0,0 +1,226 @@
+#include "Mp4SampleReader.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/buffer.h>
+#include <libavutil/error.h>
+}
+
+namespace ffmpeg_utils {
+
+namespace {
+
+double seconds(const Mp4SampleTable::Track& track, int64_t ts)
+{
+    return static_cast<double>(ts) / track.timescale;
+}
+
+} // namespace
+
+Mp4SampleReader::Mp4SampleReader(int fd, std::shared_ptr<const Mp4SampleTable> table)
+    : fd_(fd)
+    , table_(std::move(table))
+{
+}
+
+Mp4SampleReader::~Mp4SampleReader()
+{
+    // 还在队列里的包持有的缓冲区会在最后一个引用释放时才真正回收
+    for (AVBufferPool*& pool : pools_) {
+        av_buffer_pool_uninit(&pool);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool Mp4SampleReader::add_stream(int stream_index, uint32_t track_id)
+{
+    const Mp4SampleTable::Track* track = table_->find_track(track_id);
+    if (track == nullptr || track->samples.empty()) {
+        return false;
+    }
+    cursors_.push_back({ stream_index, track, 0 });
+    return true;
+}
+
+Mp4SampleReader::Cursor* Mp4SampleReader::next_cursor()
+{
+    Cursor* best = nullptr;
+    double best_dts = 0.0;
+    for (Cursor& c : cursors_) {
+        if (c.next >= c.track->samples.size()) {
+            continue;
+        }
+        const Mp4SampleTable::Sample& sample = c.track->samples[c.next];
+        const double dts = seconds(*c.track, sample.dts);
+        if (best == nullptr) {
+            best = &c;
+            best_dts = dts;
+            continue;
+        }
+        const bool close = dts - best_dts <= 1.0 && best_dts - dts <= 1.0;
+        if ((close && sample.offset < best->track->samples[best->next].offset) || (!close && dts < best_dts)) {
+            best = &c;
+            best_dts = dts;
+        }
+    }
+    return best;
+}
+
+AVBufferRef* Mp4SampleReader::get_buffer(size_t size)
+{
+    int bucket = 0;
+    while (bucket < kBuckets && (size_t { 1 } << (kMinBucketLog2 + bucket)) < size) {
+        ++bucket;
+    }
+    if (bucket == kBuckets) {
+        return av_buffer_alloc(size);
+    }
+    if (pools_[bucket] == nullptr) {
+        pools_[bucket] = av_buffer_pool_init(size_t { 1 } << (kMinBucketLog2 + bucket), nullptr);
+        if (pools_[bucket] == nullptr) {
+            return nullptr;
+        }
+    }
+    return av_buffer_pool_get(pools_[bucket]);
+}
+
+int Mp4SampleReader::read(AVPacket* pkt)
+{
+    Cursor* cursor = next_cursor();
+    return cursor != nullptr ? read_from(*cursor, pkt) : AVERROR_EOF;
+}
+
+int Mp4SampleReader::read(int stream_index, AVPacket* pkt)
+{
+    for (Cursor& c : cursors_) {
+        if (c.stream_index == stream_index) {
+            return c.next < c.track->samples.size() ? read_from(c, pkt) : AVERROR_EOF;
+        }
+    }
+    return AVERROR_EOF;
+}
+
+int Mp4SampleReader::read_from(Cursor& cursor, AVPacket* pkt)
+{
+    const Mp4SampleTable::Sample& sample = cursor.track->samples[cursor.next];
+
+    AVBufferRef* buf = get_buffer(static_cast<size_t>(sample.size) + AV_INPUT_BUFFER_PADDING_SIZE);
+    if (buf == nullptr) {
+        return AVERROR(ENOMEM);
+    }
+    size_t done = 0;
+    while (done < sample.size) {
+        const ssize_t n = pread(fd_, buf->data + done, sample.size - done, static_cast<off_t>(sample.offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            // 文件被截断时和 av_read_frame 一样当作读完
+            const int err = n == 0 ? AVERROR_EOF : AVERROR(errno);
+            av_buffer_unref(&buf);
+            return err;
+        }
+        done += static_cast<size_t>(n);
+    }
+    std::memset(buf->data + sample.size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+    av_packet_unref(pkt);
+    pkt->buf = buf;
+    pkt->data = buf->data;
+    pkt->size = static_cast<int>(sample.size);
+    pkt->stream_index = cursor.stream_index;
+    pkt->dts = sample.dts;
+    pkt->pts = sample.dts + sample.pts_offset;
+    pkt->duration = sample.duration;
+    pkt->pos = sample.offset;
+    pkt->flags = 0;
+    if ((sample.flags & Mp4SampleTable::kKeyframe) != 0) {
+        pkt->flags |= AV_PKT_FLAG_KEY;
+    }
+    if ((sample.flags & Mp4SampleTable::kDiscard) != 0) {
+        pkt->flags |= AV_PKT_FLAG_DISCARD;
+    }
+
+    ++cursor.next;
+    ++stats_.packets;
+    stats_.bytes += sample.size;
+    return 0;
+}
+
+bool Mp4SampleReader::seek(int stream_index, int64_t ts)
+{
+    const Cursor* target = nullptr;
+    for (const Cursor& c : cursors_) {
+        if (c.stream_index == stream_index) {
+            target = &c;
+        }
+    }
+    if (target == nullptr) {
+        return false;
+    }
+    const size_t key = Mp4SampleTable::keyframe_at_or_before(*target->track, ts);
+    const double key_time = seconds(*target->track, target->track->samples[key].dts);
+    for (Cursor& c : cursors_) {
+        const auto c_ts = static_cast<int64_t>(key_time * c.track->timescale);
+        c.next = &c == target ? key : Mp4SampleTable::keyframe_at_or_before(*c.track, c_ts);
+    }
+    return true;
+}
+
+double Mp4SampleReader::position(const Cursor& cursor)
+{
+    const auto& samples = cursor.track->samples;
+    if (cursor.next < samples.size()) {
+        return seconds(*cursor.track, samples[cursor.next].dts);
+    }
+    return seconds(*cursor.track, samples.back().dts + samples.back().duration);
+}
+
+bool Mp4SampleReader::switch_stream(int from, int to, uint32_t track_id)
+{
+    auto old = std::find_if(cursors_.begin(), cursors_.end(), [from](const Cursor& c) { return c.stream_index == from; });
+    double at = 0.0;
+    if (old != cursors_.end()) {
+        at = position(*old);
+    } else {
+        for (const Cursor& c : cursors_) {
+            at = std::max(at, position(c));
+        }
+    }
+
+    Cursor added;
+    if (to >= 0) {
+        const Mp4SampleTable::Track* track = table_->find_track(track_id);
+        if (track == nullptr || track->samples.empty()) {
+            return false;
+        }
+        const auto& samples = track->samples;
+        const auto next = std::lower_bound(samples.begin(), samples.end(), at,
+            [track](const Mp4SampleTable::Sample& sample, double t) { return seconds(*track, sample.dts) < t; });
+        added = { to, track, static_cast<size_t>(next - samples.begin()) };
+    }
+    if (old != cursors_.end()) {
+        cursors_.erase(old);
+    }
+    if (added.track != nullptr) {
+        cursors_.push_back(added);
+    }
+    return true;
+}
+
+void Mp4SampleReader::rewind()
+{
+    for (Cursor& c : cursors_) {
+        c.next = 0;
+    }
+}
+
+} // namespace ffmpeg_utils
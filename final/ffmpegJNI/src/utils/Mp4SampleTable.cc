@@ -0,0 +1,894 @@
+#include "Mp4SampleTable.hpp"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+
+namespace ffmpeg_utils {
+
+namespace {
+
+// moov 一般几百 KB，几个小时的长视频也就几十 MB
+constexpr uint64_t kMaxMoovSize = 64ULL * 1024 * 1024;
+// 防止坏文件让解析申请一大块内存；一天长的 30fps 视频也才 260 万个样本
+constexpr uint32_t kMaxSamples = 1U << 24;
+
+constexpr uint32_t box_type(const char (&s)[5]) { return Mp4SampleTable::fourcc(s); }
+
+// 大端读取。越界之后 ok() 一直为 false，读出来都是 0
+class ByteReader {
+public:
+    ByteReader(const uint8_t* data, size_t size)
+        : data_(data)
+        , size_(size)
+    {
+    }
+
+    uint8_t u8() { return static_cast<uint8_t>(take(1)); }
+    uint16_t u16() { return static_cast<uint16_t>(take(2)); }
+    uint32_t u24() { return static_cast<uint32_t>(take(3)); }
+    uint32_t u32() { return static_cast<uint32_t>(take(4)); }
+    uint64_t u64() { return take(8); }
+
+    void skip(size_t n)
+    {
+        if (size_ - pos_ < n) {
+            ok_ = false;
+            pos_ = size_;
+        } else {
+            pos_ += n;
+        }
+    }
+
+    [[nodiscard]] size_t remaining() const { return size_ - pos_; }
+    [[nodiscard]] const uint8_t* current() const { return data_ + pos_; }
+    [[nodiscard]] bool ok() const { return ok_; }
+
+private:
+    uint64_t take(size_t n)
+    {
+        if (size_ - pos_ < n) {
+            ok_ = false;
+            pos_ = size_;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (size_t i = 0; i < n; ++i) {
+            value = (value << 8) | data_[pos_++];
+        }
+        return value;
+    }
+
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+struct Box {
+    uint32_t type = 0;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+// 把 [data, data + size) 拆成一串 box，格式不对返回 false
+bool split_boxes(const uint8_t* data, size_t size, std::vector<Box>& boxes)
+{
+    ByteReader r(data, size);
+    while (r.remaining() >= 8) {
+        const uint8_t* start = r.current();
+        const size_t remaining = r.remaining();
+        uint64_t box_size = r.u32();
+        const uint32_t type = r.u32();
+        size_t header = 8;
+        if (box_size == 1) {
+            box_size = r.u64();
+            header = 16;
+        } else if (box_size == 0) {
+            box_size = remaining;
+        }
+        if (!r.ok() || box_size < header || box_size > remaining) {
+            return false;
+        }
+        boxes.push_back({ type, start + header, static_cast<size_t>(box_size - header) });
+        r.skip(static_cast<size_t>(box_size - header));
+    }
+    return true;
+}
+
+const Box* find_box(const std::vector<Box>& boxes, uint32_t type)
+{
+    for (const Box& box : boxes) {
+        if (box.type == type) {
+            return &box;
+        }
+    }
+    return nullptr;
+}
+
+// 按路径往下找，比如 { "mdia", "minf", "stbl" }
+bool descend(const Box& parent, std::initializer_list<uint32_t> path, Box& out)
+{
+    Box current = parent;
+    for (uint32_t type : path) {
+        std::vector<Box> children;
+        if (!split_boxes(current.data, current.size, children)) {
+            return false;
+        }
+        const Box* child = find_box(children, type);
+        if (child == nullptr) {
+            return false;
+        }
+        current = *child;
+    }
+    out = current;
+    return true;
+}
+
+struct Run {
+    uint32_t count = 0;
+    int64_t value = 0;
+};
+
+struct ChunkRun {
+    uint32_t first_chunk = 0; // 从 1 开始
+    uint32_t samples_per_chunk = 0;
+};
+
+// stbl 里的原始表
+struct RawTables {
+    uint32_t sample_count = 0;
+    uint32_t constant_size = 0;
+    std::vector<uint32_t> sizes;
+    std::vector<uint64_t> chunk_offsets;
+    std::vector<ChunkRun> chunks;
+    std::vector<Run> stts;
+    std::vector<Run> ctts;
+    bool has_stss = false;
+    std::vector<uint32_t> sync_samples; // 从 1 开始
+};
+
+// 只支持 [可选的一段空编辑] + 一段正常编辑，这也是编码器 / 封装器最常写的形式
+struct EditList {
+    int64_t empty_duration = 0; // movie timescale
+    int64_t media_time = 0; // 轨道 timescale
+};
+
+class MoovParser {
+public:
+    MoovParser(std::string& error, int64_t file_size)
+        : error_(error)
+        , file_size_(file_size)
+    {
+    }
+
+    bool parse(const uint8_t* data, size_t size, std::vector<Mp4SampleTable::Track>& tracks)
+    {
+        std::vector<Box> boxes;
+        if (!split_boxes(data, size, boxes)) {
+            return fail("malformed moov");
+        }
+        if (find_box(boxes, box_type("mvex")) != nullptr) {
+            return fail("fragmented mp4 (mvex present)");
+        }
+        const Box* mvhd = find_box(boxes, box_type("mvhd"));
+        if (mvhd == nullptr || !parse_mvhd(*mvhd)) {
+            return fail("missing or malformed mvhd");
+        }
+        for (const Box& box : boxes) {
+            if (box.type != box_type("trak")) {
+                continue;
+            }
+            Mp4SampleTable::Track track;
+            if (!parse_trak(box, track)) {
+                return false;
+            }
+            tracks.push_back(std::move(track));
+        }
+        if (tracks.empty()) {
+            return fail("no tracks");
+        }
+        return true;
+    }
+
+private:
+    bool fail(const std::string& message)
+    {
+        error_ = message;
+        return false;
+    }
+
+    bool parse_mvhd(const Box& box)
+    {
+        ByteReader r(box.data, box.size);
+        const uint8_t version = r.u8();
+        r.skip(3);
+        r.skip(version == 1 ? 16 : 8); // creation / modification time
+        movie_timescale_ = r.u32();
+        return r.ok() && movie_timescale_ != 0;
+    }
+
+    bool parse_trak(const Box& trak, Mp4SampleTable::Track& track)
+    {
+        std::vector<Box> children;
+        if (!split_boxes(trak.data, trak.size, children)) {
+            return fail("malformed trak");
+        }
+        const Box* tkhd = find_box(children, box_type("tkhd"));
+        if (tkhd == nullptr) {
+            return fail("trak without tkhd");
+        }
+        {
+            ByteReader r(tkhd->data, tkhd->size);
+            const uint8_t version = r.u8();
+            r.skip(3);
+            r.skip(version == 1 ? 16 : 8);
+            track.id = r.u32();
+            if (!r.ok()) {
+                return fail("malformed tkhd");
+            }
+        }
+
+        Box mdhd;
+        Box hdlr;
+        Box stbl;
+        if (!descend(trak, { box_type("mdia"), box_type("mdhd") }, mdhd)
+            || !descend(trak, { box_type("mdia"), box_type("hdlr") }, hdlr)
+            || !descend(trak, { box_type("mdia"), box_type("minf"), box_type("stbl") }, stbl)) {
+            return fail("trak " + std::to_string(track.id) + " without mdhd / hdlr / stbl");
+        }
+        {
+            ByteReader r(mdhd.data, mdhd.size);
+            const uint8_t version = r.u8();
+            r.skip(3);
+            r.skip(version == 1 ? 16 : 8);
+            track.timescale = r.u32();
+            if (!r.ok() || track.timescale == 0) {
+                return fail("malformed mdhd");
+            }
+        }
+        {
+            ByteReader r(hdlr.data, hdlr.size);
+            r.skip(8); // version / flags / pre_defined
+            track.handler = r.u32();
+            if (!r.ok()) {
+                return fail("malformed hdlr");
+            }
+        }
+
+        EditList edits;
+        Box elst;
+        if (descend(trak, { box_type("edts"), box_type("elst") }, elst) && !parse_elst(elst, edits)) {
+            return false;
+        }
+        RawTables tables;
+        if (!parse_stbl(stbl, tables)) {
+            return false;
+        }
+        return build(tables, edits, track);
+    }
+
+    bool parse_elst(const Box& box, EditList& edits)
+    {
+        ByteReader r(box.data, box.size);
+        const uint8_t version = r.u8();
+        r.skip(3);
+        const uint32_t count = r.u32();
+        bool have_media = false;
+        for (uint32_t i = 0; i < count && r.ok(); ++i) {
+            const int64_t duration = version == 1 ? static_cast<int64_t>(r.u64()) : r.u32();
+            const int64_t media_time = version == 1 ? static_cast<int64_t>(r.u64()) : static_cast<int32_t>(r.u32());
+            const uint32_t rate = r.u32();
+            if (media_time == -1) {
+                if (have_media || i != 0) {
+                    return fail("unsupported edit list (empty edit after media)");
+                }
+                edits.empty_duration = duration;
+                continue;
+            }
+            if (have_media) {
+                return fail("unsupported edit list (multiple edits)");
+            }
+            if (rate != 0x00010000) {
+                return fail("unsupported edit list (rate != 1)");
+            }
+            edits.media_time = media_time;
+            have_media = true;
+        }
+        return r.ok() ? true : fail("malformed elst");
+    }
+
+    bool parse_stbl(const Box& stbl, RawTables& t)
+    {
+        std::vector<Box> boxes;
+        if (!split_boxes(stbl.data, stbl.size, boxes)) {
+            return fail("malformed stbl");
+        }
+        for (const Box& box : boxes) {
+            ByteReader r(box.data, box.size);
+            const uint8_t version = r.u8();
+            r.skip(3);
+            if (box.type == box_type("stsz")) {
+                t.constant_size = r.u32();
+                t.sample_count = r.u32();
+                if (t.sample_count > kMaxSamples) {
+                    return fail("too many samples");
+                }
+                if (t.constant_size == 0) {
+                    if (r.remaining() / 4 < t.sample_count) {
+                        return fail("truncated stsz");
+                    }
+                    t.sizes.resize(t.sample_count);
+                    for (uint32_t& size : t.sizes) {
+                        size = r.u32();
+                    }
+                }
+            } else if (box.type == box_type("stz2")) {
+                r.skip(3);
+                const uint8_t field_size = r.u8();
+                t.sample_count = r.u32();
+                if (t.sample_count > kMaxSamples || (field_size != 4 && field_size != 8 && field_size != 16)) {
+                    return fail("unsupported stz2");
+                }
+                if (r.remaining() * 8 / field_size < t.sample_count) {
+                    return fail("truncated stz2");
+                }
+                t.sizes.resize(t.sample_count);
+                for (uint32_t i = 0; i < t.sample_count; ++i) {
+                    if (field_size == 16) {
+                        t.sizes[i] = r.u16();
+                    } else if (field_size == 8) {
+                        t.sizes[i] = r.u8();
+                    } else {
+                        // 4 位一个，两个样本共用一个字节，高半字节在前
+                        const uint8_t byte = r.current()[0];
+                        t.sizes[i] = (i % 2 == 0) ? (byte >> 4) : (byte & 0x0F);
+                        if (i % 2 == 1 || i + 1 == t.sample_count) {
+                            r.skip(1);
+                        }
+                    }
+                }
+            } else if (box.type == box_type("stco") || box.type == box_type("co64")) {
+                const uint32_t count = r.u32();
+                const size_t width = box.type == box_type("co64") ? 8 : 4;
+                if (r.remaining() / width < count) {
+                    return fail("truncated chunk offsets");
+                }
+                t.chunk_offsets.resize(count);
+                for (uint64_t& offset : t.chunk_offsets) {
+                    offset = width == 8 ? r.u64() : r.u32();
+                }
+            } else if (box.type == box_type("stsc")) {
+                const uint32_t count = r.u32();
+                if (r.remaining() / 12 < count) {
+                    return fail("truncated stsc");
+                }
+                t.chunks.resize(count);
+                for (ChunkRun& run : t.chunks) {
+                    run.first_chunk = r.u32();
+                    run.samples_per_chunk = r.u32();
+                    r.skip(4); // sample_description_index
+                }
+            } else if (box.type == box_type("stts") || box.type == box_type("ctts")) {
+                const uint32_t count = r.u32();
+                if (r.remaining() / 8 < count) {
+                    return fail("truncated stts / ctts");
+                }
+                std::vector<Run>& runs = box.type == box_type("stts") ? t.stts : t.ctts;
+                runs.resize(count);
+                for (Run& run : runs) {
+                    run.count = r.u32();
+                    // ctts 的偏移按有符号读：version 0 规定是无符号，但不少封装器照样写负数，FFmpeg 也是这么读的
+                    run.value = box.type == box_type("stts") ? static_cast<int64_t>(r.u32()) : static_cast<int32_t>(r.u32());
+                }
+            } else if (box.type == box_type("stss")) {
+                const uint32_t count = r.u32();
+                if (r.remaining() / 4 < count) {
+                    return fail("truncated stss");
+                }
+                t.has_stss = true;
+                t.sync_samples.resize(count);
+                for (uint32_t& n : t.sync_samples) {
+                    n = r.u32();
+                }
+            }
+            (void)version;
+            if (!r.ok()) {
+                return fail("malformed stbl child box");
+            }
+        }
+        return true;
+    }
+
+    bool build(const RawTables& t, const EditList& edits, Mp4SampleTable::Track& track)
+    {
+        const uint32_t count = t.sample_count;
+        if (count == 0) {
+            return fail("track " + std::to_string(track.id) + " has no samples");
+        }
+        // stsz 的样本数是坏文件随便写的：先和 stts / stsc 能覆盖的样本数、文件大小对上，再按它申请样本数组
+        if (stts_capacity(t, count) < count) {
+            return fail("stts covers fewer samples than stsz");
+        }
+        uint64_t chunk_capacity = 0;
+        if (!stsc_capacity(t, count, chunk_capacity)) {
+            return fail("malformed stsc");
+        }
+        if (chunk_capacity < count) {
+            return fail("stsc / stco cover fewer samples than stsz");
+        }
+        if (file_size_ >= 0 && total_sample_bytes(t) > static_cast<uint64_t>(file_size_)) {
+            return fail("stsz claims more data than the file holds");
+        }
+
+        auto& samples = track.samples;
+        samples.resize(count);
+        for (uint32_t i = 0; i < count; ++i) {
+            samples[i].size = t.constant_size != 0 ? t.constant_size : t.sizes[i];
+            track.max_sample_size = std::max(track.max_sample_size, samples[i].size);
+        }
+
+        // stsc 的每一段覆盖 [first_chunk, 下一段的 first_chunk)，每块 samples_per_chunk 个样本，在块内紧挨着
+        uint32_t sample = 0;
+        for (size_t e = 0; e < t.chunks.size() && sample < count; ++e) {
+            const uint32_t first = t.chunks[e].first_chunk;
+            const uint64_t last = last_chunk(t, e);
+            for (uint64_t chunk = first; chunk <= last && sample < count; ++chunk) {
+                auto offset = static_cast<int64_t>(t.chunk_offsets[chunk - 1]);
+                for (uint32_t k = 0; k < t.chunks[e].samples_per_chunk && sample < count; ++k) {
+                    samples[sample].offset = offset;
+                    offset += samples[sample].size;
+                    ++sample;
+                }
+            }
+        }
+
+        sample = 0;
+        int64_t dts = 0;
+        for (const Run& run : t.stts) {
+            for (uint32_t k = 0; k < run.count && sample < count; ++k, ++sample) {
+                samples[sample].dts = dts;
+                samples[sample].duration = static_cast<uint32_t>(run.value);
+                dts += run.value;
+            }
+        }
+
+        int64_t min_ctts = 0;
+        sample = 0;
+        for (const Run& run : t.ctts) {
+            for (uint32_t k = 0; k < run.count && sample < count; ++k, ++sample) {
+                samples[sample].pts_offset = static_cast<int32_t>(run.value);
+                min_ctts = std::min(min_ctts, run.value);
+            }
+        }
+
+        if (t.has_stss) {
+            for (uint32_t n : t.sync_samples) {
+                if (n >= 1 && n <= count) {
+                    samples[n - 1].flags |= Mp4SampleTable::kKeyframe;
+                }
+            }
+        } else {
+            for (auto& s : samples) {
+                s.flags |= Mp4SampleTable::kKeyframe;
+            }
+        }
+
+        // 编辑列表：媒体时间 media_time 对应到轨道开始 + 空编辑的时长；
+        // ctts 有负数时 dts 整体前移，保证 dts <= pts（和 FFmpeg 的 dts_shift 一样）。
+        // elst 的时长 / 媒体时间可以是任意 64 位数，这里每一步都检查溢出
+        int64_t scaled = 0;
+        if (edits.empty_duration < 0 || __builtin_mul_overflow(edits.empty_duration, static_cast<int64_t>(track.timescale), &scaled)) {
+            return fail("edit list out of range");
+        }
+        const int64_t start = scaled / movie_timescale_;
+        const int64_t dts_shift = -min_ctts;
+        int64_t shift = 0;
+        if (__builtin_sub_overflow(start, edits.media_time, &shift) || __builtin_sub_overflow(shift, dts_shift, &shift)) {
+            return fail("edit list out of range");
+        }
+        for (auto& s : samples) {
+            int64_t end = 0;
+            int32_t pts_offset = 0;
+            if (__builtin_add_overflow(s.dts, shift, &s.dts) || __builtin_add_overflow(s.pts_offset, dts_shift, &pts_offset)
+                || __builtin_add_overflow(s.dts, static_cast<int64_t>(pts_offset) + s.duration, &end)) {
+                return fail("edit list out of range");
+            }
+            s.pts_offset = pts_offset;
+            if (end <= start && edits.media_time > 0) {
+                s.flags |= Mp4SampleTable::kDiscard;
+            }
+        }
+        return true;
+    }
+
+    // stsc 第 e 段的最后一块（从 1 开始）：下一段开始之前，最后一段到 stco 的最后一块
+    static uint64_t last_chunk(const RawTables& t, size_t e)
+    {
+        return e + 1 < t.chunks.size() ? static_cast<uint64_t>(t.chunks[e + 1].first_chunk) - 1 : t.chunk_offsets.size();
+    }
+
+    // stts 一共覆盖多少个样本，数到 limit 就停
+    static uint64_t stts_capacity(const RawTables& t, uint64_t limit)
+    {
+        uint64_t total = 0;
+        for (size_t i = 0; i < t.stts.size() && total < limit; ++i) {
+            total += t.stts[i].count;
+        }
+        return total;
+    }
+
+    // stsc + stco 一共能放下多少个样本，数到 limit 就停。stsc 的段不递增或者指到 stco 之外时返回 false
+    static bool stsc_capacity(const RawTables& t, uint64_t limit, uint64_t& total)
+    {
+        total = 0;
+        for (size_t e = 0; e < t.chunks.size() && total < limit; ++e) {
+            const uint32_t first = t.chunks[e].first_chunk;
+            const uint64_t last = last_chunk(t, e);
+            if (first == 0 || last > t.chunk_offsets.size() || (e + 1 < t.chunks.size() && t.chunks[e + 1].first_chunk <= first)) {
+                return false;
+            }
+            // 最后一段的 first_chunk 可以超出 stco，这一段就没有块。
+            // 块数和每块样本数都不超过 2^32，乘积放得下，加上之前不到 limit 的部分也放得下
+            if (last >= first) {
+                total += (last + 1 - first) * t.chunks[e].samples_per_chunk;
+            }
+        }
+        return true;
+    }
+
+    static uint64_t total_sample_bytes(const RawTables& t)
+    {
+        if (t.constant_size != 0) {
+            return static_cast<uint64_t>(t.sample_count) * t.constant_size;
+        }
+        uint64_t total = 0;
+        for (uint32_t size : t.sizes) {
+            total += size;
+        }
+        return total;
+    }
+
+    std::string& error_;
+    int64_t file_size_;
+    uint32_t movie_timescale_ = 0;
+};
+
+bool pread_all(int fd, uint8_t* dst, size_t size, int64_t offset)
+{
+    while (size > 0) {
+        const ssize_t n = pread(fd, dst, size, static_cast<off_t>(offset));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        dst += n;
+        size -= static_cast<size_t>(n);
+        offset += n;
+    }
+    return true;
+}
+
+} // namespace
+
+bool Mp4SampleTable::parse_file(int fd, std::string* error)
+{
+    std::string message;
+    struct stat st {};
+    if (fstat(fd, &st) != 0) {
+        message = "fstat failed";
+    } else {
+        const auto file_size = static_cast<int64_t>(st.st_size);
+        int64_t pos = 0;
+        while (pos + 8 <= file_size) {
+            uint8_t header[16];
+            if (!pread_all(fd, header, 8, pos)) {
+                message = "read failed";
+                break;
+            }
+            ByteReader r(header, 8);
+            uint64_t box_size = r.u32();
+            const uint32_t type = r.u32();
+            int64_t header_size = 8;
+            if (box_size == 1) {
+                if (!pread_all(fd, header + 8, 8, pos + 8)) {
+                    message = "read failed";
+                    break;
+                }
+                ByteReader large(header + 8, 8);
+                box_size = large.u64();
+                header_size = 16;
+            } else if (box_size == 0) {
+                box_size = static_cast<uint64_t>(file_size - pos);
+            }
+            if (box_size < static_cast<uint64_t>(header_size) || box_size > static_cast<uint64_t>(file_size - pos)) {
+                message = "malformed top-level box";
+                break;
+            }
+            if (type == box_type("moov")) {
+                const uint64_t content = box_size - static_cast<uint64_t>(header_size);
+                if (content > kMaxMoovSize) {
+                    message = "moov too large";
+                    break;
+                }
+                std::vector<uint8_t> moov(static_cast<size_t>(content));
+                if (!pread_all(fd, moov.data(), moov.size(), pos + header_size)) {
+                    message = "read failed";
+                    break;
+                }
+                return parse_moov(moov.data(), moov.size(), error, file_size);
+            }
+            pos += static_cast<int64_t>(box_size);
+        }
+        if (message.empty()) {
+            message = "no moov box";
+        }
+    }
+    if (error != nullptr) {
+        *error = message;
+    }
+    return false;
+}
+
+bool Mp4SampleTable::parse_moov(const uint8_t* data, size_t size, std::string* error, int64_t file_size)
+{
+    std::string message;
+    std::vector<Track> tracks;
+    MoovParser parser(message, file_size);
+    if (!parser.parse(data, size, tracks)) {
+        if (error != nullptr) {
+            *error = message;
+        }
+        return false;
+    }
+    tracks_ = std::move(tracks);
+    return true;
+}
+
+const Mp4SampleTable::Track* Mp4SampleTable::find_track(uint32_t id) const
+{
+    for (const Track& track : tracks_) {
+        if (track.id == id) {
+            return &track;
+        }
+    }
+    return nullptr;
+}
+
+Mp4SampleTable::Track* Mp4SampleTable::find_track(uint32_t id)
+{
+    return const_cast<Track*>(static_cast<const Mp4SampleTable*>(this)->find_track(id));
+}
+
+size_t Mp4SampleTable::sample_at_or_before(const Track& track, int64_t dts)
+{
+    const auto& samples = track.samples;
+    auto it = std::upper_bound(samples.begin(), samples.end(), dts,
+        [](int64_t value, const Sample& s) { return value < s.dts; });
+    return it == samples.begin() ? 0 : static_cast<size_t>(it - samples.begin()) - 1;
+}
+
+size_t Mp4SampleTable::keyframe_at_or_before(const Track& track, int64_t dts)
+{
+    size_t i = sample_at_or_before(track, dts);
+    while (i > 0 && (track.samples[i].flags & kKeyframe) == 0) {
+        --i;
+    }
+    return i;
+}
+
+
+Mp4FragmentScanner::TrackState* Mp4FragmentScanner::find(uint32_t id)
+{
+    for (TrackState& track : tracks_) {
+        if (track.id == id) {
+            return &track;
+        }
+    }
+    return nullptr;
+}
+
+bool Mp4FragmentScanner::scan(int fd, int64_t file_size)
+{
+    while (offset_ + 8 <= file_size) {
+        uint8_t header[16];
+        if (!pread_all(fd, header, 8, offset_)) {
+            return true; // 下次再试
+        }
+        ByteReader r(header, 8);
+        uint64_t box_size = r.u32();
+        const uint32_t type = r.u32();
+        int64_t header_size = 8;
+        if (box_size == 1) {
+            if (offset_ + 16 > file_size || !pread_all(fd, header + 8, 8, offset_ + 8)) {
+                return true;
+            }
+            ByteReader large(header + 8, 8);
+            box_size = large.u64();
+            header_size = 16;
+        } else if (box_size == 0) {
+            return true; // 一直到文件末尾的 box，文件还在长，不知道它什么时候写完
+        }
+        if (box_size < static_cast<uint64_t>(header_size)) {
+            return false;
+        }
+        if (box_size > static_cast<uint64_t>(file_size - offset_)) {
+            return true; // 还没写完
+        }
+        if (type == box_type("moov") || type == box_type("moof")) {
+            const uint64_t content = box_size - static_cast<uint64_t>(header_size);
+            if (content > kMaxMoovSize) {
+                return false;
+            }
+            std::vector<uint8_t> data(static_cast<size_t>(content));
+            if (!pread_all(fd, data.data(), data.size(), offset_ + header_size)) {
+                return true;
+            }
+            const bool ok = type == box_type("moov") ? parse_moov(data.data(), data.size()) : parse_moof(data.data(), data.size());
+            if (!ok) {
+                return false;
+            }
+        } else if (type == box_type("mdat")) {
+            commit_fragment();
+        }
+        offset_ += static_cast<int64_t>(box_size);
+    }
+    return true;
+}
+
+bool Mp4FragmentScanner::parse_moov(const uint8_t* data, size_t size)
+{
+    std::vector<Box> boxes;
+    if (!split_boxes(data, size, boxes)) {
+        return false;
+    }
+    const Box* mvex = find_box(boxes, box_type("mvex"));
+    if (mvex == nullptr) {
+        return false; // 样本都在 moov 里，不是分片 mp4
+    }
+    std::vector<TrackState> tracks;
+    for (const Box& box : boxes) {
+        if (box.type != box_type("trak")) {
+            continue;
+        }
+        Box tkhd;
+        Box mdhd;
+        if (!descend(box, { box_type("tkhd") }, tkhd) || !descend(box, { box_type("mdia"), box_type("mdhd") }, mdhd)) {
+            return false;
+        }
+        TrackState track;
+        ByteReader id(tkhd.data, tkhd.size);
+        id.skip(id.u8() == 1 ? 19 : 11); // version / flags / creation / modification time
+        track.id = id.u32();
+        ByteReader timescale(mdhd.data, mdhd.size);
+        timescale.skip(timescale.u8() == 1 ? 19 : 11);
+        track.timescale = timescale.u32();
+        if (!id.ok() || !timescale.ok() || track.timescale == 0) {
+            return false;
+        }
+        tracks.push_back(track);
+    }
+
+    std::vector<Box> defaults;
+    if (!split_boxes(mvex->data, mvex->size, defaults)) {
+        return false;
+    }
+    for (const Box& box : defaults) {
+        if (box.type != box_type("trex")) {
+            continue;
+        }
+        ByteReader r(box.data, box.size);
+        r.skip(4);
+        const uint32_t track_id = r.u32();
+        r.skip(4); // default_sample_description_index
+        const uint32_t duration = r.u32();
+        for (TrackState& track : tracks) {
+            if (track.id == track_id && r.ok()) {
+                track.default_duration = duration;
+            }
+        }
+    }
+    if (tracks.empty()) {
+        return false;
+    }
+    tracks_ = std::move(tracks);
+    return true;
+}
+
+bool Mp4FragmentScanner::parse_moof(const uint8_t* data, size_t size)
+{
+    std::vector<Box> boxes;
+    if (!split_boxes(data, size, boxes)) {
+        return false;
+    }
+    for (const Box& traf : boxes) {
+        if (traf.type != box_type("traf")) {
+            continue;
+        }
+        std::vector<Box> children;
+        if (!split_boxes(traf.data, traf.size, children)) {
+            return false;
+        }
+        const Box* tfhd = find_box(children, box_type("tfhd"));
+        if (tfhd == nullptr) {
+            return false;
+        }
+        ByteReader header(tfhd->data, tfhd->size);
+        const uint32_t tf_flags = header.u32() & 0xffffff;
+        TrackState* track = find(header.u32());
+        if (track == nullptr) {
+            continue; // moov 之前的分片，或者 moov 里没有的轨道
+        }
+        header.skip((tf_flags & 0x1) != 0 ? 8 : 0); // base_data_offset
+        header.skip((tf_flags & 0x2) != 0 ? 4 : 0); // sample_description_index
+        const uint32_t default_duration = (tf_flags & 0x8) != 0 ? header.u32() : track->default_duration;
+        if (!header.ok()) {
+            return false;
+        }
+
+        // 没有 tfdt 时接着上一个分片
+        int64_t time = track->pending_end >= 0 ? track->pending_end : std::max<int64_t>(track->end, 0);
+        if (const Box* tfdt = find_box(children, box_type("tfdt"))) {
+            ByteReader r(tfdt->data, tfdt->size);
+            const uint8_t version = r.u8();
+            r.skip(3);
+            time = version == 1 ? static_cast<int64_t>(r.u64()) : r.u32();
+            if (!r.ok()) {
+                return false;
+            }
+        }
+        for (const Box& trun : children) {
+            if (trun.type != box_type("trun")) {
+                continue;
+            }
+            ByteReader r(trun.data, trun.size);
+            const uint32_t flags = r.u32() & 0xffffff;
+            const uint32_t count = r.u32();
+            r.skip((flags & 0x1) != 0 ? 4 : 0); // data_offset
+            r.skip((flags & 0x4) != 0 ? 4 : 0); // first_sample_flags
+            size_t per_sample = 0;
+            for (uint32_t bit : { 0x100U, 0x200U, 0x400U, 0x800U }) {
+                per_sample += (flags & bit) != 0 ? 4 : 0;
+            }
+            if (!r.ok() || count > kMaxSamples || (per_sample > 0 && r.remaining() / per_sample < count)) {
+                return false;
+            }
+            if ((flags & 0x100) == 0) {
+                time += static_cast<int64_t>(count) * default_duration;
+                continue;
+            }
+            for (uint32_t i = 0; i < count; ++i) {
+                time += r.u32();
+                r.skip(per_sample - 4);
+            }
+        }
+        track->pending_end = time;
+    }
+    return true;
+}
+
+void Mp4FragmentScanner::commit_fragment()
+{
+    for (TrackState& track : tracks_) {
+        if (track.pending_end >= 0) {
+            track.end = track.pending_end;
+            track.pending_end = -1;
+        }
+    }
+}
+
+double Mp4FragmentScanner::end_seconds(uint32_t track_id) const
+{
+    for (const TrackState& track : tracks_) {
+        if (track.id == track_id) {
+            return track.end >= 0 ? static_cast<double>(track.end) / track.timescale : -1.0;
+        }
+    }
+    return -1.0;
+}
+
+} // namespace ffmpeg_utils
@@ -3,7 +3,7 @@
 namespace ffmpeg_utils {
 
 Packet::Packet()
-    : pkt_(av_packet_alloc())
+    : pkt_(PacketPool::global().acquire())
 {
 }
 Packet::Packet(AVPacket* pkt)
@@ -12,29 +12,41 @@ Packet::Packet(AVPacket* pkt)
 }
 Packet::~Packet()
 {
-    if (pkt_ != nullptr) {
-        av_packet_free(&pkt_);
-    }
+    reset();
 }
 
 Packet::Packet(Packet&& other) noexcept
     : pkt_(other.pkt_)
+    , is_flush_packet_(other.is_flush_packet_)
+    , is_eof_packet_(other.is_eof_packet_)
 {
     other.pkt_ = nullptr;
+    other.is_flush_packet_ = false;
+    other.is_eof_packet_ = false;
 }
 
 Packet& Packet::operator=(Packet&& other) noexcept
 {
     if (this != &other) {
-        if (pkt_ != nullptr) {
-            av_packet_free(&pkt_);
-        }
+        reset();
         pkt_ = other.pkt_;
+        is_flush_packet_ = other.is_flush_packet_;
+        is_eof_packet_ = other.is_eof_packet_;
         other.pkt_ = nullptr;
+        other.is_flush_packet_ = false;
+        other.is_eof_packet_ = false;
     }
     return *this;
 }
 
+void Packet::reset()
+{
+    if (pkt_ != nullptr) {
+        PacketPool::global().release(pkt_);
+        pkt_ = nullptr;
+    }
+}
+
 AVPacket* Packet::get() const { return pkt_; }
 
 int Packet::streamIndex() const
@@ -45,4 +57,4 @@ int Packet::streamIndex() const
     return pkt_->stream_index;
 }
 
-} // namespace ffmpeg_utils
\ No newline at end of file
+} // namespace ffmpeg_utils
@@ -0,0 +1,71 @@
+#include "PacketPool.hpp"
+
+extern "C" {
+#include <libavcodec/packet.h>
+}
+
+namespace ffmpeg_utils {
+
+PacketPool::PacketPool(size_t max_idle)
+    : max_idle_(max_idle)
+{
+    idle_.reserve(max_idle_);
+}
+
+PacketPool::~PacketPool()
+{
+    for (AVPacket* pkt : idle_) {
+        av_packet_free(&pkt);
+    }
+}
+
+AVPacket* PacketPool::acquire()
+{
+    acquires_.fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            AVPacket* pkt = idle_.back();
+            idle_.pop_back();
+            return pkt;
+        }
+    }
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    return av_packet_alloc();
+}
+
+void PacketPool::release(AVPacket* pkt)
+{
+    if (pkt == nullptr) {
+        return;
+    }
+    // 在锁外 unref，payload 的释放不占着锁
+    av_packet_unref(pkt);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (idle_.size() < max_idle_) {
+            idle_.push_back(pkt);
+            return;
+        }
+    }
+    av_packet_free(&pkt);
+}
+
+PacketPool::Stats PacketPool::stats() const
+{
+    Stats s;
+    s.acquires = acquires_.load(std::memory_order_relaxed);
+    s.allocations = allocations_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    s.idle = idle_.size();
+    return s;
+}
+
+PacketPool& PacketPool::global()
+{
+    // 故意不析构：解码线程可能在静态析构阶段之后还在释放 Packet
+    static auto* pool = new PacketPool();
+    return *pool;
+}
+
+} // namespace ffmpeg_utils
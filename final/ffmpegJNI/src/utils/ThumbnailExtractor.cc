@@ -0,0 +1,297 @@
+// ThumbnailExtractor.cc
+#include "Mp4Parser/ThumbnailExtractor.hpp"
+#include "DecoderContext.hpp"
+#include "MediaSource.hpp"
+#include <algorithm>
+#include <android/log.h>
+#include <cmath>
+#include <exception>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/pixfmt.h>
+}
+
+#define LOG_TAG "ThumbnailExtractor"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+
+namespace mp4parser {
+
+using player_utils::VideoFrame;
+
+std::unique_ptr<ThumbnailExtractor> ThumbnailExtractor::create(const std::string& path, const Options& options)
+{
+    auto source = std::make_shared<MediaSource>();
+    if (!source->open(path) || !source->has_video_stream()) {
+        LOGE("Cannot open video stream in %s", path.c_str());
+        return nullptr;
+    }
+    std::unique_ptr<DecoderContext> ctx;
+    try {
+        // 每解一个关键帧就 drain 一次，帧级多线程只会多压帧、多开线程，用片级多线程
+        player_utils::DecodeThreading threading;
+        threading.mode = player_utils::DecodeThreading::Mode::Slice;
+        ctx = std::make_unique<DecoderContext>(source->get_video_codecpar(), threading);
+    } catch (const std::exception& e) {
+        LOGE("Cannot create decoder: %s", e.what());
+        return nullptr;
+    }
+    return std::unique_ptr<ThumbnailExtractor>(new ThumbnailExtractor(std::move(source), std::move(ctx), options));
+}
+
+ThumbnailExtractor::ThumbnailExtractor(std::shared_ptr<MediaSource> source, std::unique_ptr<DecoderContext> ctx, const Options& options)
+    : source_(std::move(source))
+    , ctx_(std::move(ctx))
+    , options_(options)
+    , packet_(av_packet_alloc())
+    , frame_(av_frame_alloc())
+{
+    if (options_.bucket_sec <= 0.0) {
+        options_.bucket_sec = 1.0;
+    }
+    // 只要关键帧：解码器丢掉其余帧，解复用器不读其他流
+    ctx_->get()->skip_frame = AVDISCARD_NONKEY;
+    AVFormatContext* fmt = source_->get_format_context();
+    for (unsigned i = 0; i < fmt->nb_streams; ++i) {
+        if (static_cast<int>(i) != source_->get_video_stream_index()) {
+            fmt->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+
+    // 缩略图尺寸：YUV420 要求偶数
+    const int src_width = ctx_->width();
+    const int src_height = ctx_->height();
+    thumb_width_ = std::max(2, options_.width & ~1);
+    thumb_height_ = options_.height > 0 || src_width <= 0
+        ? options_.height
+        : static_cast<int>(std::lround(static_cast<double>(thumb_width_) * src_height / src_width));
+    thumb_height_ = std::max(2, thumb_height_ & ~1);
+
+    worker_ = std::thread(&ThumbnailExtractor::run, this);
+}
+
+ThumbnailExtractor::~ThumbnailExtractor()
+{
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        stop_ = true;
+        generation_.fetch_add(1);
+    }
+    worker_cv_.notify_one();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    av_packet_free(&packet_);
+    av_frame_free(&frame_);
+}
+
+ThumbnailExtractor::Thumbnail ThumbnailExtractor::extract(double time_sec)
+{
+    return extract(time_sec, [] { return false; });
+}
+
+void ThumbnailExtractor::request(double time_sec, Callback callback)
+{
+    auto job = std::make_unique<Pending>();
+    job->time_sec = time_sec;
+    job->callback = std::move(callback);
+    bool replaced = false;
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        job->generation = generation_.fetch_add(1) + 1;
+        replaced = pending_ != nullptr;
+        pending_ = std::move(job);
+    }
+    worker_cv_.notify_one();
+    if (replaced) {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        ++stats_.cancelled;
+    }
+}
+
+void ThumbnailExtractor::cancel()
+{
+    bool dropped = false;
+    {
+        std::lock_guard<std::mutex> lock(worker_mutex_);
+        generation_.fetch_add(1);
+        dropped = pending_ != nullptr;
+        pending_.reset();
+    }
+    if (dropped) {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        ++stats_.cancelled;
+    }
+}
+
+ThumbnailExtractor::Stats ThumbnailExtractor::stats() const
+{
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    return stats_;
+}
+
+double ThumbnailExtractor::duration() const
+{
+    const AVFormatContext* fmt = source_->get_format_context();
+    if (fmt->duration == AV_NOPTS_VALUE) {
+        return 0.0;
+    }
+    return static_cast<double>(fmt->duration) / AV_TIME_BASE;
+}
+
+void ThumbnailExtractor::run()
+{
+    for (;;) {
+        std::unique_ptr<Pending> job;
+        {
+            std::unique_lock<std::mutex> lock(worker_mutex_);
+            worker_cv_.wait(lock, [this] { return stop_ || pending_ != nullptr; });
+            if (stop_) {
+                return;
+            }
+            job = std::move(pending_);
+        }
+
+        const uint64_t generation = job->generation;
+        auto cancelled = [this, generation] { return generation_.load() != generation; };
+        Thumbnail thumbnail = extract(job->time_sec, cancelled);
+        if (!cancelled() && job->callback) {
+            job->callback(job->time_sec, std::move(thumbnail));
+        }
+    }
+}
+
+ThumbnailExtractor::Thumbnail ThumbnailExtractor::lookup(int64_t bucket)
+{
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    auto it = cache_.find(bucket);
+    if (it == cache_.end()) {
+        return nullptr;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    ++stats_.cache_hits;
+    return it->second->second;
+}
+
+void ThumbnailExtractor::store(int64_t bucket, const Thumbnail& thumbnail)
+{
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    ++stats_.decoded;
+    if (options_.cache_capacity == 0) {
+        return;
+    }
+    auto it = cache_.find(bucket);
+    if (it != cache_.end()) {
+        it->second->second = thumbnail;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return;
+    }
+    lru_.emplace_front(bucket, thumbnail);
+    cache_[bucket] = lru_.begin();
+    if (lru_.size() > options_.cache_capacity) {
+        cache_.erase(lru_.back().first);
+        lru_.pop_back();
+    }
+}
+
+ThumbnailExtractor::Thumbnail ThumbnailExtractor::extract(double time_sec, const CancelToken& cancelled)
+{
+    const auto bucket = static_cast<int64_t>(std::floor(std::max(0.0, time_sec) / options_.bucket_sec));
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        ++stats_.requests;
+    }
+    if (Thumbnail hit = lookup(bucket)) {
+        return hit;
+    }
+
+    std::lock_guard<std::mutex> lock(decode_mutex_);
+    // 等锁的时候别的请求可能已经解好了
+    if (Thumbnail hit = lookup(bucket)) {
+        return hit;
+    }
+    Thumbnail thumbnail = decode_keyframe(static_cast<double>(bucket) * options_.bucket_sec, cancelled);
+    if (thumbnail) {
+        store(bucket, thumbnail);
+    }
+    return thumbnail;
+}
+
+ThumbnailExtractor::Thumbnail ThumbnailExtractor::decode_keyframe(double time_sec, const CancelToken& cancelled)
+{
+    AVFormatContext* fmt = source_->get_format_context();
+    AVCodecContext* ctx = ctx_->get();
+    const AVStream* stream = source_->get_video_stream();
+    const int video_index = source_->get_video_stream_index();
+
+    int64_t target = static_cast<int64_t>(time_sec / av_q2d(stream->time_base));
+    if (const auto* key = source_->keyframe_index().at_or_before(target)) {
+        target = key->pts;
+    }
+    if (av_seek_frame(fmt, video_index, target, AVSEEK_FLAG_BACKWARD) < 0) {
+        return nullptr;
+    }
+    // 上一次 drain 之后解码器处在 EOF 状态，flush 之后才能继续送包
+    avcodec_flush_buffers(ctx);
+
+    while (!cancelled()) {
+        if (av_read_frame(fmt, packet_) < 0) {
+            return nullptr;
+        }
+        if (packet_->stream_index != video_index || (packet_->flags & AV_PKT_FLAG_KEY) == 0) {
+            av_packet_unref(packet_);
+            continue;
+        }
+        const int ret = avcodec_send_packet(ctx, packet_);
+        av_packet_unref(packet_);
+        if (ret < 0) {
+            return nullptr;
+        }
+        // 马上 drain：有重排序延迟的解码器不用再等后面的包就能吐出这一帧
+        avcodec_send_packet(ctx, nullptr);
+        if (avcodec_receive_frame(ctx, frame_) < 0) {
+            return nullptr;
+        }
+        Thumbnail thumbnail = downscale(frame_);
+        av_frame_unref(frame_);
+        return thumbnail;
+    }
+
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    ++stats_.cancelled;
+    return nullptr;
+}
+
+ThumbnailExtractor::Thumbnail ThumbnailExtractor::downscale(const AVFrame* frame)
+{
+    if (frame->format != AV_PIX_FMT_YUV420P && frame->format != AV_PIX_FMT_YUVJ420P) {
+        LOGW("Unsupported pixel format %d for thumbnails.", frame->format);
+        return nullptr;
+    }
+
+    auto out = std::make_shared<VideoFrame>();
+    out->width = thumb_width_;
+    out->height = thumb_height_;
+    out->format = frame->format;
+    out->linesize = {};
+    out->linesize[0] = thumb_width_;
+    out->linesize[1] = thumb_width_ / 2;
+    out->linesize[2] = thumb_width_ / 2;
+    out->pts = frame->pts == AV_NOPTS_VALUE ? 0.0 : frame->pts * av_q2d(source_->get_video_stream()->time_base);
+    out->data.resize(static_cast<size_t>(thumb_width_) * thumb_height_ * 3 / 2);
+
+    uint8_t* dst = out->data.data();
+    for (int i = 0; i < 3; ++i) {
+        const int src_width = i == 0 ? frame->width : (frame->width + 1) / 2;
+        const int src_height = i == 0 ? frame->height : (frame->height + 1) / 2;
+        const int dst_height = out->plane_height(i);
+        filter_.scale(frame->data[i], src_width, src_height, frame->linesize[i],
+            dst, out->linesize[i], dst_height, out->linesize[i]);
+        dst += static_cast<size_t>(out->linesize[i]) * dst_height;
+    }
+    return out;
+}
+
+} // namespace mp4parser
@@ -8,7 +8,7 @@
 
 class MockPacketSink {
 public:
-    bool operator()(Demuxer::Packet& packet)
+    Demuxer::SinkResult operator()(Demuxer::Packet& packet)
     {
         std::unique_lock<std::mutex> lock(mutex_);
         if (packet.isData()) {
@@ -28,7 +28,7 @@ public:
         }
 
         cv_.notify_all();
-        return true;
+        return Demuxer::SinkResult::kAccepted;
     }
 
     // ... 其他函数保持不变 ...
@@ -0,0 +1,172 @@
+// bench_accurate_seek.cc
+// 关键帧 seek 和精确 seek 的对比：从发起 seek 到解码线程输出第一帧的延迟，以及这一帧离目标时刻有多远。
+//   keyframe: 只 FlushAndWait，输出的是目标之前最近的关键帧
+//   accurate: FlushAndWait 之后 Decoder::SkipUntil，从关键帧追到目标，之前的帧不输出
+// 追帧的代价和 GOP 长度成正比，用同一段素材按不同的关键帧间隔转码后各跑一遍，例如：
+//   ffmpeg -i in.mp4 -an -c:v libx264 -g 12  -keyint_min 12  -sc_threshold 0 gop12.mp4
+//   ffmpeg -i in.mp4 -an -c:v libx264 -g 60  -keyint_min 60  -sc_threshold 0 gop60.mp4
+//   ffmpeg -i in.mp4 -an -c:v libx264 -g 250 -keyint_min 250 -sc_threshold 0 gop250.mp4
+// 用法：bench_accurate_seek gop12.mp4 gop60.mp4 gop250.mp4，不带参数时读当前目录下的 test.mp4
+#include "Decoder.hpp"
+#include "DecoderContext.hpp"
+#include "Demuxer.hpp"
+#include "MediaSource.hpp"
+#include "Packet.hpp"
+#include "SemQueue.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+using ffmpeg_utils::Packet;
+using player_utils::SemQueue;
+
+namespace {
+
+constexpr int kSeeks = 30;
+constexpr size_t kPacketQueueSize = 300;
+constexpr std::chrono::milliseconds kFlushTimeout { 500 };
+
+// 记下解码线程输出的帧数和最近一帧的 pts
+struct FrameCounter {
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint64_t frames = 0;
+    int64_t last_pts = AV_NOPTS_VALUE;
+
+    bool on_frame(const AVFrame* frame)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++frames;
+            last_pts = frame->pts;
+        }
+        cv.notify_all();
+        return true;
+    }
+
+    uint64_t current()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return frames;
+    }
+
+    // 等到 seen 之后的第一帧，返回它的 pts；超时返回 AV_NOPTS_VALUE
+    int64_t wait_beyond(uint64_t seen)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!cv.wait_for(lock, std::chrono::seconds(5), [&] { return frames > seen; })) {
+            return AV_NOPTS_VALUE;
+        }
+        return last_pts;
+    }
+};
+
+struct Result {
+    std::vector<double> latency_ms;
+    std::vector<double> error_ms; // 第一帧 pts 和目标时刻之差
+};
+
+Result run(const char* path, bool accurate)
+{
+    Result result;
+    auto source = std::make_shared<MediaSource>();
+    if (!source->open(path) || !source->has_video_stream()) {
+        std::fprintf(stderr, "cannot open video in %s\n", path);
+        return result;
+    }
+    const AVStream* stream = source->get_video_stream();
+    const int video_index = source->get_video_stream_index();
+
+    Demuxer demuxer(source);
+    SemQueue<Packet> queue(kPacketQueueSize);
+    queue.set_on_writable([&demuxer] { demuxer.Wake(); });
+    FrameCounter counter;
+    Decoder decoder(std::make_shared<DecoderContext>(stream->codecpar), queue);
+    decoder.Start([&counter](const AVFrame* frame) { return counter.on_frame(frame); });
+
+    auto start_demuxer = [&] {
+        demuxer.Start([&queue, video_index](Packet& packet) {
+            if (!packet.isEof() && packet.streamIndex() != video_index) {
+                return Demuxer::SinkResult::kAccepted;
+            }
+            if (queue.try_push(packet)) {
+                return Demuxer::SinkResult::kAccepted;
+            }
+            return queue.is_shutdown() ? Demuxer::SinkResult::kClosed : Demuxer::SinkResult::kFull;
+        });
+    };
+    start_demuxer();
+    counter.wait_beyond(0);
+
+    const double duration = demuxer.GetDuration();
+    for (int i = 0; i < kSeeks; ++i) {
+        // 在片长的 10%..90% 之间来回跳，目标一般不落在关键帧上
+        const double target = duration * (0.1 + 0.8 * ((i * 7) % kSeeks) / kSeeks);
+        const auto start = Clock::now();
+        demuxer.RequestStop();
+        queue.clear();
+        demuxer.Stop();
+        decoder.FlushAndWait(kFlushTimeout);
+        if (accurate) {
+            decoder.SkipUntil(static_cast<int64_t>(target / av_q2d(stream->time_base)));
+        }
+        const uint64_t seen = counter.current();
+        demuxer.SeekTo(target);
+        start_demuxer();
+        const int64_t pts = counter.wait_beyond(seen);
+        if (pts == AV_NOPTS_VALUE) {
+            std::fprintf(stderr, "no frame after seek to %.3f\n", target);
+            continue;
+        }
+        result.latency_ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+        result.error_ms.push_back(std::fabs(pts * av_q2d(stream->time_base) - target) * 1000.0);
+    }
+    demuxer.RequestStop();
+    queue.shutdown();
+    demuxer.Stop();
+    decoder.Stop();
+    return result;
+}
+
+double mean(const std::vector<double>& v)
+{
+    double sum = 0;
+    for (double x : v) {
+        sum += x;
+    }
+    return v.empty() ? 0 : sum / v.size();
+}
+
+void report(const char* name, Result r)
+{
+    if (r.latency_ms.empty()) {
+        std::printf("  %-8s no samples\n", name);
+        return;
+    }
+    std::sort(r.latency_ms.begin(), r.latency_ms.end());
+    const auto& ms = r.latency_ms;
+    std::printf("  %-8s latency mean %7.2f ms  p50 %7.2f ms  p90 %7.2f ms  | first frame off by %7.2f ms (mean)\n",
+        name, mean(ms), ms[ms.size() / 2], ms[ms.size() * 9 / 10], mean(r.error_ms));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::vector<const char*> paths(argv + 1, argv + argc);
+    if (paths.empty()) {
+        paths.push_back("test.mp4");
+    }
+    for (const char* path : paths) {
+        std::printf("%s\n", path);
+        report("keyframe", run(path, false));
+        report("accurate", run(path, true));
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+// bench_audio_convert.cc
+// 每帧音频转换的开销：
+//   legacy   : 原来 convert_audio_frame 的做法，每帧 swr_alloc_set_opts2 + swr_init + av_mallocz + swr_free
+//   converter: AudioConverter，SwrContext 跨帧复用，输出缓冲区从池里取
+// 输入是 AAC 解码器典型的输出（FLTP 立体声，每帧 1024 个样本），
+// 分别测 同采样率（44.1k -> 44.1k，只做格式转换）和 44.1k -> 48k（设备原生采样率）两种情况。
+#include "Mp4Parser/AudioConverter.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/mem.h>
+#include <libswresample/swresample.h>
+}
+
+using Clock = std::chrono::steady_clock;
+using mp4parser::AudioConverter;
+
+namespace {
+
+constexpr int kFrames = 5000;
+constexpr int kSamples = 1024;
+constexpr int kInRate = 44100;
+constexpr int kOutRates[] = { kInRate, 48000 };
+
+AVFrame* make_input_frame()
+{
+    AVFrame* frame = av_frame_alloc();
+    frame->format = AV_SAMPLE_FMT_FLTP;
+    frame->sample_rate = kInRate;
+    frame->nb_samples = kSamples;
+    av_channel_layout_default(&frame->ch_layout, 2);
+    if (av_frame_get_buffer(frame, 0) < 0) {
+        std::fprintf(stderr, "av_frame_get_buffer failed\n");
+        std::abort();
+    }
+    for (int ch = 0; ch < 2; ++ch) {
+        auto* samples = reinterpret_cast<float*>(frame->extended_data[ch]);
+        for (int i = 0; i < kSamples; ++i) {
+            samples[i] = 0.5F * std::sin(2.0F * 3.14159265F * 440.0F * i / kInRate);
+        }
+    }
+    return frame;
+}
+
+// 原来的实现（去掉日志），返回转换出的样本数
+int legacy_convert(const AVFrame* frame, int out_rate)
+{
+    AVChannelLayout out_layout;
+    av_channel_layout_default(&out_layout, frame->ch_layout.nb_channels);
+
+    SwrContext* swr_ctx = nullptr;
+    int ret = swr_alloc_set_opts2(&swr_ctx,
+        &out_layout, AV_SAMPLE_FMT_S16, out_rate,
+        &frame->ch_layout, static_cast<AVSampleFormat>(frame->format), frame->sample_rate,
+        0, nullptr);
+    if (ret < 0 || swr_init(swr_ctx) < 0) {
+        swr_free(&swr_ctx);
+        av_channel_layout_uninit(&out_layout);
+        return -1;
+    }
+
+    int dst_nb_samples = static_cast<int>(av_rescale_rnd(
+        swr_get_delay(swr_ctx, frame->sample_rate) + frame->nb_samples,
+        out_rate, frame->sample_rate, AV_ROUND_UP));
+    int out_buf_size = av_samples_get_buffer_size(nullptr, out_layout.nb_channels, dst_nb_samples, AV_SAMPLE_FMT_S16, 1);
+    auto* out_buf = static_cast<uint8_t*>(av_mallocz(out_buf_size));
+    uint8_t* out[] = { out_buf };
+    int converted = swr_convert(swr_ctx, out, dst_nb_samples,
+        const_cast<const uint8_t**>(frame->extended_data), frame->nb_samples);
+
+    av_free(out_buf);
+    swr_free(&swr_ctx);
+    av_channel_layout_uninit(&out_layout);
+    return converted;
+}
+
+template <typename Convert>
+void run(const char* name, int out_rate, Convert convert)
+{
+    long samples = 0;
+    const auto start = Clock::now();
+    for (int n = 0; n < kFrames; ++n) {
+        samples += convert();
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    std::printf("%-9s %5d -> %5d  %8.2f us/frame  (%ld samples out)\n",
+        name, kInRate, out_rate, seconds * 1e6 / kFrames, samples);
+}
+
+} // namespace
+
+int main()
+{
+    AVFrame* frame = make_input_frame();
+    for (int out_rate : kOutRates) {
+        run("legacy", out_rate, [&] { return legacy_convert(frame, out_rate); });
+
+        AudioConverter converter(AVRational { 1, kInRate }, AudioConverter::OutputFormat { out_rate, 2 });
+        run("converter", out_rate, [&] {
+            auto out = converter.convert(frame);
+            return out ? out->nb_samples : -1;
+        });
+        std::printf("          swr rebuilds: %llu\n", static_cast<unsigned long long>(converter.rebuilds()));
+    }
+    av_frame_free(&frame);
+    return 0;
+}
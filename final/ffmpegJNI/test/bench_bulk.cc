@@ -0,0 +1,140 @@
+// bench_bulk.cc
+// 模拟音频回调：每次回调需要 callback_frames 个采样帧，解码端的 AudioFrame 很小（默认 64 个采样），
+// 对比 "逐个 try_pop" 和 "try_pop_bulk 一次取一批" 每个元素的同步开销。
+// 生产者同样对比逐个 push 和 push_bulk。
+#include "SemQueue.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+using player_utils::SemQueue;
+
+namespace {
+
+constexpr int kSamplesPerFrame = 64;
+constexpr int kTotalFrames = 400000;
+constexpr size_t kQueueSize = 256;
+constexpr size_t kMaxBatch = 32;
+
+struct FakeAudioFrame {
+    int samples = kSamplesPerFrame;
+};
+using FramePtr = std::shared_ptr<FakeAudioFrame>;
+
+struct Result {
+    double consumer_ns_per_frame;
+    double wall_ms;
+};
+
+Result run(int callback_frames, bool bulk)
+{
+    SemQueue<FramePtr> queue(kQueueSize);
+    // 预先分配好帧，排除 make_shared 的干扰
+    std::vector<FramePtr> frames(kTotalFrames);
+    for (auto& f : frames)
+        f = std::make_shared<FakeAudioFrame>();
+
+    std::thread producer([&] {
+        if (bulk) {
+            for (size_t i = 0; i < frames.size(); i += kMaxBatch) {
+                size_t end = std::min(frames.size(), i + kMaxBatch);
+                queue.push_bulk(frames.begin() + i, frames.begin() + end);
+            }
+        } else {
+            for (auto& f : frames)
+                queue.push(std::move(f));
+        }
+    });
+
+    const int frames_per_callback = (callback_frames + kSamplesPerFrame - 1) / kSamplesPerFrame;
+    std::vector<FramePtr> out(kMaxBatch);
+    int consumed = 0;
+    Clock::duration in_consumer {};
+    auto wall_start = Clock::now();
+
+    while (consumed < kTotalFrames) {
+        auto t0 = Clock::now();
+        int got = 0;
+        while (got < frames_per_callback && consumed + got < kTotalFrames) {
+            if (bulk) {
+                size_t want = std::min<size_t>(kMaxBatch, frames_per_callback - got);
+                size_t n = queue.try_pop_bulk(out.data(), want);
+                if (n == 0)
+                    break;
+                got += static_cast<int>(n);
+            } else {
+                if (!queue.try_pop(out[0]))
+                    break;
+                ++got;
+            }
+        }
+        in_consumer += Clock::now() - t0;
+        consumed += got;
+        if (got == 0)
+            std::this_thread::yield(); // 欠载，相当于这次回调填了静音
+    }
+    auto wall = Clock::now() - wall_start;
+    producer.join();
+
+    return {
+        std::chrono::duration<double, std::nano>(in_consumer).count() / kTotalFrames,
+        std::chrono::duration<double, std::milli>(wall).count(),
+    };
+}
+
+// 无竞争：队列预先填满再按回调粒度取空，只看同步本身的开销
+double run_uncontended(int callback_frames, bool bulk)
+{
+    const int frames_per_callback = (callback_frames + kSamplesPerFrame - 1) / kSamplesPerFrame;
+    SemQueue<FramePtr> queue(kQueueSize);
+    std::vector<FramePtr> batch(kQueueSize);
+    for (auto& f : batch)
+        f = std::make_shared<FakeAudioFrame>();
+    std::vector<FramePtr> out(kMaxBatch);
+
+    Clock::duration in_consumer {};
+    long popped = 0;
+    for (int round = 0; round < kTotalFrames / static_cast<int>(kQueueSize); ++round) {
+        queue.push_bulk(batch);
+        for (auto& f : batch)
+            f = std::make_shared<FakeAudioFrame>();
+
+        auto t0 = Clock::now();
+        while (true) {
+            size_t n = 0;
+            if (bulk) {
+                n = queue.try_pop_bulk(out.data(), std::min<size_t>(kMaxBatch, frames_per_callback));
+            } else {
+                while (n < static_cast<size_t>(frames_per_callback) && queue.try_pop(out[n % kMaxBatch]))
+                    ++n;
+            }
+            if (n == 0)
+                break;
+            popped += static_cast<long>(n);
+        }
+        in_consumer += Clock::now() - t0;
+    }
+    return std::chrono::duration<double, std::nano>(in_consumer).count() / popped;
+}
+
+} // namespace
+
+int main()
+{
+    std::printf("frames of %d samples, %d frames total, queue size %zu\n", kSamplesPerFrame, kTotalFrames, kQueueSize);
+    std::printf("%-16s %-8s %22s %24s %12s\n", "callback_frames", "mode",
+        "uncontended ns/frame", "with producer ns/frame", "wall ms");
+    for (int callback_frames : { 192, 256, 480, 960, 1024 }) {
+        for (bool bulk : { false, true }) {
+            double uncontended = run_uncontended(callback_frames, bulk);
+            Result r = run(callback_frames, bulk);
+            std::printf("%-16d %-8s %22.1f %24.1f %12.1f\n", callback_frames, bulk ? "bulk" : "single",
+                uncontended, r.consumer_ns_per_frame, r.wall_ms);
+        }
+    }
+    return 0;
+}
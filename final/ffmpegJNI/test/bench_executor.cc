@@ -0,0 +1,231 @@
+// bench_executor.cc
+// 多个播放器同时跑时，"每个组件一个线程" 和 "共用 TaskExecutor" 的吞吐和上下文切换次数。
+//
+// 不需要视频文件：每个播放器是 解复用 -> 包队列 -> 解码 -> 帧队列 -> 渲染 的一条管线，
+// 解复用 / 解码 / 渲染分别用固定的忙等时间模拟一个包 / 一帧的开销。
+//   threads : 解复用、解码各一个线程，阻塞在 SemQueue 上（原来的做法）
+//   executor: 解复用、解码是 TaskExecutor 上的任务，靠 try_push / try_pop 和队列的唤醒回调推进
+// 两种模式下渲染都是每个播放器一个线程（和 GLRenderHost 一样）。
+// 上下文切换数来自 getrusage（自愿 + 非自愿），统计整个进程。
+// 用法：bench_executor
+#include "SemQueue.hpp"
+#include "TaskExecutor.hpp"
+#include <sys/resource.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+using player_utils::SemQueue;
+using player_utils::TaskExecutor;
+using Step = TaskExecutor::Step;
+
+namespace {
+
+constexpr int kPacketsPerPlayer = 4000;
+constexpr size_t kPacketQueueSize = 32;
+constexpr size_t kFrameQueueSize = 8;
+constexpr auto kDemuxCost = std::chrono::microseconds(5);
+constexpr auto kDecodeCost = std::chrono::microseconds(60);
+constexpr auto kRenderCost = std::chrono::microseconds(5);
+
+void busy(std::chrono::microseconds cost)
+{
+    const auto until = Clock::now() + cost;
+    while (Clock::now() < until) {
+    }
+}
+
+struct Player {
+    SemQueue<int> packets { kPacketQueueSize };
+    SemQueue<int> frames { kFrameQueueSize };
+    std::atomic<uint64_t> rendered { 0 };
+    std::thread render_thread;
+
+    // executor 模式下任务的状态，只在任务里访问
+    int next_packet = 0;
+    int pending_packet = -1;
+    int pending_frame = -1;
+    std::shared_ptr<TaskExecutor::Task> demux_task;
+    std::shared_ptr<TaskExecutor::Task> decode_task;
+
+    void start_render()
+    {
+        render_thread = std::thread([this] {
+            int frame = 0;
+            while (frames.wait_and_pop(frame)) {
+                busy(kRenderCost);
+                rendered.fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+};
+
+uint64_t context_switches()
+{
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return static_cast<uint64_t>(usage.ru_nvcsw + usage.ru_nivcsw);
+}
+
+void run_threads(std::vector<std::unique_ptr<Player>>& players)
+{
+    std::vector<std::thread> threads;
+    for (auto& p : players) {
+        Player* player = p.get();
+        threads.emplace_back([player] {
+            for (int i = 0; i < kPacketsPerPlayer; ++i) {
+                busy(kDemuxCost);
+                player->packets.push(i);
+            }
+            player->packets.shutdown();
+        });
+        threads.emplace_back([player] {
+            int packet = 0;
+            while (player->packets.wait_and_pop(packet)) {
+                busy(kDecodeCost);
+                player->frames.push(packet);
+            }
+            player->frames.shutdown();
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+Step demux_step(Player& p)
+{
+    for (int i = 0; i < 16; ++i) {
+        if (p.pending_packet < 0) {
+            if (p.next_packet == kPacketsPerPlayer) {
+                p.packets.shutdown();
+                return Step::kDone;
+            }
+            busy(kDemuxCost);
+            p.pending_packet = p.next_packet++;
+        }
+        if (!p.packets.try_push(p.pending_packet)) {
+            return Step::kWait;
+        }
+        p.pending_packet = -1;
+    }
+    return Step::kYield;
+}
+
+// 和 Decoder::step 一样：输出满了就让出，输入空了就挂起
+Step decode_step(Player& p)
+{
+    for (int i = 0; i < 8; ++i) {
+        if (p.pending_frame >= 0) {
+            if (!p.frames.try_push(p.pending_frame)) {
+                return Step::kWait;
+            }
+            p.pending_frame = -1;
+        }
+        int packet = 0;
+        if (!p.packets.try_pop(packet)) {
+            if (p.packets.is_shutdown() && p.packets.empty()) {
+                p.frames.shutdown();
+                return Step::kDone;
+            }
+            return Step::kWait;
+        }
+        busy(kDecodeCost);
+        p.pending_frame = packet;
+    }
+    return Step::kYield;
+}
+
+std::function<void()> waker(const std::shared_ptr<TaskExecutor::Task>& task)
+{
+    std::weak_ptr<TaskExecutor::Task> weak = task;
+    return [weak] {
+        if (auto t = weak.lock()) {
+            t->wake();
+        }
+    };
+}
+
+void run_executor(std::vector<std::unique_ptr<Player>>& players, TaskExecutor& executor)
+{
+    for (auto& p : players) {
+        Player* player = p.get();
+        player->demux_task = executor.spawn([player] { return demux_step(*player); });
+        player->decode_task = executor.spawn([player] { return decode_step(*player); });
+        // 生产者等队列空出一半再醒，和 Mp4Parser 里包队列的设置一样
+        player->packets.set_on_writable(waker(player->demux_task), kPacketQueueSize / 2);
+        player->packets.set_on_readable(waker(player->decode_task));
+        player->frames.set_on_writable(waker(player->decode_task), kFrameQueueSize / 2);
+    }
+    for (auto& p : players) {
+        p->demux_task->wake();
+        p->decode_task->wake();
+    }
+    for (auto& p : players) {
+        p->demux_task->wait_done();
+        p->decode_task->wait_done();
+    }
+}
+
+void run(int player_count, bool use_executor)
+{
+    std::vector<std::unique_ptr<Player>> players;
+    for (int i = 0; i < player_count; ++i) {
+        players.push_back(std::make_unique<Player>());
+    }
+    // 工作线程先建好，不算进计时
+    std::unique_ptr<TaskExecutor> executor;
+    if (use_executor) {
+        executor = std::make_unique<TaskExecutor>();
+    }
+
+    const uint64_t switches_before = context_switches();
+    const auto start = Clock::now();
+    for (auto& p : players) {
+        p->start_render();
+    }
+    if (use_executor) {
+        run_executor(players, *executor);
+    } else {
+        run_threads(players);
+    }
+    uint64_t rendered = 0;
+    for (auto& p : players) {
+        p->render_thread.join();
+        rendered += p->rendered.load();
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    const uint64_t switches = context_switches() - switches_before;
+
+    const size_t threads = use_executor ? player_count + executor->worker_count() : player_count * 3;
+    std::printf("%2d players  %-8s  threads %3zu  %8.0f frames/s  %8llu ctx switches  %7.1f switches/frame",
+        player_count, use_executor ? "executor" : "threads", threads, rendered / elapsed,
+        static_cast<unsigned long long>(switches), static_cast<double>(switches) / rendered);
+    if (use_executor) {
+        const auto stats = executor->stats();
+        std::printf("  (%llu steps, %llu steals)", static_cast<unsigned long long>(stats.steps),
+            static_cast<unsigned long long>(stats.steals));
+    }
+    std::printf("\n");
+}
+
+} // namespace
+
+int main()
+{
+    std::printf("%u cores, %d packets per player, decode %lld us / packet\n", std::thread::hardware_concurrency(),
+        kPacketsPerPlayer, static_cast<long long>(kDecodeCost.count()));
+    for (int players : { 1, 4, 16 }) {
+        run(players, false);
+        run(players, true);
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+// bench_fast_open.cc
+// 快速打开（FastOpenOptions）对起播时间的影响。起播时间 = MediaSource::open + 打开视频解码器 + 读包解出第一帧。
+//   full    : 原来的 avformat_find_stream_info，FFmpeg 默认探测量
+//   bounded : 限制 probesize / analyzeduration，但仍然探测
+//   header  : 容器头里参数齐全时跳过探测
+//   cache   : 不信任容器头，第一次探测后写缓存（cold），之后从缓存恢复（warm）
+// 文件先完整打开一次，页缓存是热的，比较的只是探测本身的开销；每项跑 kRuns 次取中位数。
+// 用法：bench_fast_open [file...]，默认读当前目录下的 test.mp4
+#include "DecoderContext.hpp"
+#include "MediaSource.hpp"
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+using Clock = std::chrono::steady_clock;
+using player_utils::FastOpenOptions;
+
+namespace {
+
+constexpr int kRuns = 5;
+
+const char* origin_name(MediaSource::StreamInfoOrigin origin)
+{
+    switch (origin) {
+    case MediaSource::StreamInfoOrigin::Header:
+        return "header";
+    case MediaSource::StreamInfoOrigin::Cache:
+        return "cache";
+    default:
+        return "probe";
+    }
+}
+
+struct Sample {
+    double open_ms = -1.0;
+    double first_frame_ms = -1.0;
+    MediaSource::StreamInfoOrigin origin = MediaSource::StreamInfoOrigin::Probe;
+};
+
+Sample time_to_first_frame(const char* path, const FastOpenOptions& fast_open)
+{
+    Sample sample;
+    const auto start = Clock::now();
+    MediaSource source;
+    if (!source.open(path, {}, {}, fast_open) || !source.has_video_stream()) {
+        return sample;
+    }
+    sample.open_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    sample.origin = source.stream_info_origin();
+
+    DecoderContext ctx(source.get_video_codecpar());
+    AVPacket* pkt = av_packet_alloc();
+    AVFrame* frame = av_frame_alloc();
+    bool got_frame = false;
+    while (!got_frame && av_read_frame(source.get_format_context(), pkt) >= 0) {
+        if (pkt->stream_index == source.get_video_stream_index() && avcodec_send_packet(ctx.get(), pkt) >= 0) {
+            got_frame = avcodec_receive_frame(ctx.get(), frame) >= 0;
+        }
+        av_packet_unref(pkt);
+    }
+    if (!got_frame) {
+        // 帧级多线程的解码器要多喂几个包才出帧，读完了就冲一下
+        avcodec_send_packet(ctx.get(), nullptr);
+        got_frame = avcodec_receive_frame(ctx.get(), frame) >= 0;
+    }
+    av_frame_free(&frame);
+    av_packet_free(&pkt);
+    if (got_frame) {
+        sample.first_frame_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+    return sample;
+}
+
+double median(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    return values.empty() ? -1.0 : values[values.size() / 2];
+}
+
+struct Result {
+    double open_ms;
+    double first_frame_ms;
+};
+
+Result run(const char* path, const char* name, const FastOpenOptions& fast_open, int runs = kRuns)
+{
+    std::vector<double> open_ms;
+    std::vector<double> first_frame_ms;
+    Sample last;
+    for (int i = 0; i < runs; ++i) {
+        last = time_to_first_frame(path, fast_open);
+        open_ms.push_back(last.open_ms);
+        first_frame_ms.push_back(last.first_frame_ms);
+    }
+    const Result result { median(open_ms), median(first_frame_ms) };
+    std::printf("  %-12s open %8.2f ms  first frame %8.2f ms  (stream info: %s)\n", name, result.open_ms,
+        result.first_frame_ms, origin_name(last.origin));
+    return result;
+}
+
+FastOpenOptions make(bool trust_header, const std::string& cache_dir = {})
+{
+    FastOpenOptions options;
+    options.enabled = true;
+    options.trust_header = trust_header;
+    options.cache_dir = cache_dir;
+    return options;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::vector<const char*> files(argv + 1, argv + argc);
+    if (files.empty()) {
+        files.push_back("test.mp4");
+    }
+    char dir[] = "/tmp/bench_fast_open_XXXXXX";
+    if (mkdtemp(dir) == nullptr) {
+        std::perror("mkdtemp");
+        return 1;
+    }
+    const std::string cache_dir = dir;
+
+    double full_total = 0.0;
+    double header_total = 0.0;
+    double warm_total = 0.0;
+    int counted = 0;
+    for (const char* path : files) {
+        std::printf("%s:\n", path);
+        // 预热页缓存
+        if (time_to_first_frame(path, {}).first_frame_ms < 0) {
+            std::fprintf(stderr, "cannot decode video in %s\n", path);
+            continue;
+        }
+        const Result full = run(path, "full", {});
+        run(path, "bounded", make(false));
+        const Result header = run(path, "header", make(true));
+        run(path, "cache cold", make(false, cache_dir), 1);
+        const Result warm = run(path, "cache warm", make(false, cache_dir));
+        full_total += full.first_frame_ms;
+        header_total += header.first_frame_ms;
+        warm_total += warm.first_frame_ms;
+        ++counted;
+    }
+    const player_utils::StreamInfoCache cache(cache_dir);
+    for (const char* path : files) {
+        player_utils::FileIdentity id;
+        if (player_utils::FileIdentity::of(path, id)) {
+            std::remove(cache.entry_path(id).c_str());
+        }
+    }
+    rmdir(dir);
+
+    if (counted > 1) {
+        std::printf("average over %d files: full %.2f ms, header %.2f ms, cache warm %.2f ms\n", counted,
+            full_total / counted, header_total / counted, warm_total / counted);
+    }
+    return 0;
+}
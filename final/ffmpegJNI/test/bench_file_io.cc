@@ -0,0 +1,137 @@
+// bench_file_io.cc
+// 不同本地文件读取方式（FileIoOptions）下的解复用速度和 seek 延迟，每一项之前都把文件从页缓存里赶出去：
+//   open    : MediaSource::open 的耗时（avformat_open_input + find_stream_info + 关键帧表）
+//   demux   : 从头 av_read_frame 到文件结束的速度
+//   seek    : 冷缓存下随机 seek 到某个时刻、读到第一个包的耗时（平均 / 最大）
+// 赶页缓存用的是 posix_fadvise(DONTNEED)，不需要 root；文件在 FUSE 上时效果取决于具体实现。
+// 用法：bench_file_io [file...]，默认读当前目录下的 test.mp4
+#include "LocalFileReader.hpp"
+#include "MediaSource.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+using Clock = std::chrono::steady_clock;
+using player_utils::FileIoOptions;
+
+namespace {
+
+constexpr int kSeeks = 20;
+
+double ms_since(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+void drop_page_cache(const char* path)
+{
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+FileIoOptions make(FileIoOptions::Mode mode, size_t chunk_size = 1024 * 1024, size_t chunks = 8)
+{
+    FileIoOptions options;
+    options.mode = mode;
+    options.chunk_size = chunk_size;
+    options.chunks = chunks;
+    return options;
+}
+
+void run(const char* path, const char* name, const FileIoOptions& options)
+{
+    drop_page_cache(path);
+    auto start = Clock::now();
+    MediaSource source;
+    if (!source.open(path, {}, options)) {
+        std::fprintf(stderr, "cannot open %s\n", path);
+        return;
+    }
+    const double open_ms = ms_since(start);
+    AVFormatContext* fmt = source.get_format_context();
+
+    AVPacket* pkt = av_packet_alloc();
+    size_t packets = 0;
+    int64_t bytes = 0;
+    start = Clock::now();
+    while (av_read_frame(fmt, pkt) >= 0) {
+        ++packets;
+        bytes += pkt->size;
+        av_packet_unref(pkt);
+    }
+    const double demux_s = ms_since(start) / 1000.0;
+
+    // 固定种子，几种方式 seek 到同一组时刻
+    std::mt19937 rng(1234);
+    const int64_t duration = fmt->duration > 0 ? fmt->duration : AV_TIME_BASE;
+    std::vector<double> seek_ms;
+    for (int i = 0; i < kSeeks; ++i) {
+        const int64_t target = static_cast<int64_t>(rng() % static_cast<uint64_t>(duration));
+        drop_page_cache(path);
+        start = Clock::now();
+        if (av_seek_frame(fmt, -1, target, AVSEEK_FLAG_BACKWARD) >= 0 && av_read_frame(fmt, pkt) >= 0) {
+            seek_ms.push_back(ms_since(start));
+            av_packet_unref(pkt);
+        }
+    }
+    av_packet_free(&pkt);
+
+    double seek_avg = 0.0;
+    for (double ms : seek_ms) {
+        seek_avg += ms;
+    }
+    seek_avg = seek_ms.empty() ? 0.0 : seek_avg / seek_ms.size();
+    const double seek_max = seek_ms.empty() ? 0.0 : *std::max_element(seek_ms.begin(), seek_ms.end());
+
+    std::printf("  %-18s open %7.1f ms  demux %8.1f MB/s %9.0f pkt/s  seek avg %6.1f ms  max %6.1f ms",
+        name, open_ms, bytes / demux_s / (1024.0 * 1024.0), packets / demux_s, seek_avg, seek_max);
+    if (const auto* reader = source.file_reader()) {
+        const auto stats = reader->stats();
+        std::printf("  (%llu waits, %llu refills)", static_cast<unsigned long long>(stats.waits),
+            static_cast<unsigned long long>(stats.refills));
+    }
+    std::printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    using Mode = FileIoOptions::Mode;
+    struct Variant {
+        const char* name;
+        FileIoOptions options;
+    };
+    const Variant variants[] = {
+        { "default", make(Mode::Default) },
+        { "mmap 8 MB", make(Mode::Mmap) },
+        { "read-ahead 1Mx8", make(Mode::ReadAhead) },
+        { "read-ahead 256Kx16", make(Mode::ReadAhead, 256 * 1024, 16) },
+    };
+
+    std::vector<const char*> files(argv + 1, argv + argc);
+    if (files.empty()) {
+        files.push_back("test.mp4");
+    }
+    for (const char* path : files) {
+        std::printf("%s:\n", path);
+        for (const Variant& v : variants) {
+            run(path, v.name, v.options);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,188 @@
+// bench_frame_skip.cc
+// 视频落后时解码端跳帧（FrameSkipPolicy）的效果。
+//
+// 不需要视频文件，也不真的去压 CPU：按 1 ms 步长模拟一条 30 fps、GOP 60（I 后面循环 P Br b b）的流，
+// 每种帧有固定的解码代价，乘上 CPU 降频系数后就是它占用解码线程的时间。
+// 解码出的帧进容量为 kQueueCapacity 的队列，渲染侧按 SyncClock 的规则等待 / 渲染 / 丢弃，
+// 并像 SyncClock 一样发布落后时间。对每个降频系数分别跑一遍"不跳帧"和"FrameSkipPolicy"，统计：
+//   decoded  : 完整解码的帧数
+//   rendered : 真正显示的帧数
+//   wasted   : 解码完之后又被渲染侧丢掉的帧数，以及它们占用的解码时间
+//   max late : 渲染时刻的最大落后
+// 用法：bench_frame_skip
+#include "FrameSkipPolicy.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <initializer_list>
+
+using player_utils::FrameSkipPolicy;
+using player_utils::VideoLateness;
+
+namespace {
+
+constexpr int kFps = 30;
+constexpr int kGop = 60;
+constexpr int kDurationMs = 120 * 1000;
+constexpr size_t kQueueCapacity = 8;
+constexpr double kUnitMs = 36.0; // 降频系数 1.0 下一个 P 帧的解码时间
+
+enum class FrameType {
+    I,
+    P,
+    Br, // 被其他 B 帧参考的 B 帧
+    B, // 非参考 B 帧
+};
+
+FrameType frame_type(int index)
+{
+    const int pos = index % kGop;
+    if (pos == 0) {
+        return FrameType::I;
+    }
+    static constexpr FrameType kPattern[] = { FrameType::P, FrameType::Br, FrameType::B, FrameType::B };
+    return kPattern[(pos - 1) % 4];
+}
+
+double decode_units(FrameType type)
+{
+    switch (type) {
+    case FrameType::I:
+        return 2.0;
+    case FrameType::P:
+        return 1.0;
+    case FrameType::Br:
+        return 0.7;
+    case FrameType::B:
+        return 0.5;
+    }
+    return 1.0;
+}
+
+// 和 Decoder::apply_frame_skip 里的 skip_frame / skip_loop_filter 对应
+bool skipped(FrameSkipPolicy::Level level, FrameType type)
+{
+    switch (level) {
+    case FrameSkipPolicy::kNone:
+        return false;
+    case FrameSkipPolicy::kNonRef:
+        return type == FrameType::B;
+    case FrameSkipPolicy::kBidir:
+        return type == FrameType::B || type == FrameType::Br;
+    case FrameSkipPolicy::kNonKey:
+        return type != FrameType::I;
+    }
+    return false;
+}
+
+bool loop_filter_skipped(FrameSkipPolicy::Level level, FrameType type)
+{
+    if (level == FrameSkipPolicy::kNonRef) {
+        return type == FrameType::B;
+    }
+    return level >= FrameSkipPolicy::kBidir && type != FrameType::I;
+}
+
+struct Result {
+    int decoded = 0;
+    int skipped = 0;
+    int rendered = 0;
+    int wasted = 0;
+    double wasted_ms = 0.0;
+    double decode_ms = 0.0;
+    double max_late = 0.0;
+    uint64_t escalations = 0;
+};
+
+struct Decoded {
+    double pts;
+    double cost_ms;
+};
+
+Result simulate(double throttle, bool use_policy)
+{
+    Result result;
+    VideoLateness lateness;
+    FrameSkipPolicy policy;
+    std::deque<Decoded> queue;
+
+    int next_packet = 0;
+    double busy_until_ms = 0.0; // 当前包解完的时刻
+    Decoded in_flight { -1.0, 0.0 };
+    int frame_counter = 0;
+
+    for (int now = 0; now < kDurationMs; ++now) {
+        // 解码线程：上一个包解完就交出去，队列有空位再取下一个包
+        while (busy_until_ms <= now) {
+            if (in_flight.pts >= 0.0) {
+                if (queue.size() >= kQueueCapacity) {
+                    break; // 和 SemQueue 一样阻塞在 push 上
+                }
+                queue.push_back(in_flight);
+                in_flight.pts = -1.0;
+            }
+            const FrameType type = frame_type(next_packet);
+            const double pts = static_cast<double>(next_packet) / kFps;
+            ++next_packet;
+
+            const auto level = use_policy ? policy.update(lateness.get(), type == FrameType::I) : FrameSkipPolicy::kNone;
+            if (skipped(level, type)) {
+                ++result.skipped;
+                busy_until_ms += 0.05 * kUnitMs * throttle;
+                continue;
+            }
+            double cost = decode_units(type) * kUnitMs * throttle;
+            if (loop_filter_skipped(level, type)) {
+                cost *= 0.75;
+            }
+            ++result.decoded;
+            result.decode_ms += cost;
+            busy_until_ms = std::max(busy_until_ms, static_cast<double>(now)) + cost;
+            in_flight = { pts, cost };
+        }
+
+        // 渲染线程：音频时钟就是真实时间
+        const double audio = now / 1000.0;
+        while (!queue.empty()) {
+            const double diff = queue.front().pts - audio;
+            lateness.publish(-diff);
+            if (frame_counter < 10) {
+                ++frame_counter;
+            } else if (diff > 0.01) {
+                break;
+            } else if (diff < -0.25) {
+                ++result.wasted;
+                result.wasted_ms += queue.front().cost_ms;
+                queue.pop_front();
+                continue;
+            }
+            result.max_late = std::max(result.max_late, -diff);
+            ++result.rendered;
+            queue.pop_front();
+            break; // 一个刷新周期最多显示一帧
+        }
+    }
+    result.escalations = policy.escalations();
+    return result;
+}
+
+} // namespace
+
+int main()
+{
+    std::printf("%d s of %d fps video, GOP %d, queue %zu, decode cost per P frame %.0f ms x throttle\n",
+        kDurationMs / 1000, kFps, kGop, kQueueCapacity, kUnitMs);
+    std::printf("%-8s %-7s %8s %8s %9s %7s %11s %10s %9s\n",
+        "throttle", "policy", "decoded", "skipped", "rendered", "wasted", "wasted cpu", "max late", "escalate");
+    for (double throttle : { 0.8, 1.2, 1.6, 2.0 }) {
+        for (bool use_policy : { false, true }) {
+            const Result r = simulate(throttle, use_policy);
+            std::printf("%-8.1f %-7s %8d %8d %9d %7d %10.1f%% %9.3fs %9llu\n",
+                throttle, use_policy ? "skip" : "off", r.decoded, r.skipped, r.rendered, r.wasted,
+                r.decode_ms > 0.0 ? r.wasted_ms * 100.0 / r.decode_ms : 0.0, r.max_late,
+                static_cast<unsigned long long>(r.escalations));
+        }
+    }
+    return 0;
+}
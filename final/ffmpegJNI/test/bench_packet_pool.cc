@@ -0,0 +1,143 @@
+// bench_packet_pool.cc
+// 模拟一段播放中 解复用线程 -> 包队列 -> 两个解码线程 的 Packet 流转，统计每分钟 AVPacket 的分配次数：
+//   legacy: 原来的 Packet，每个包 av_packet_alloc / av_packet_free，哨兵包也先分配再释放
+//   pooled: 现在的 Packet，从 PacketPool::global() 取、还
+// 码流按 30fps 视频 + 44.1kHz AAC（每包 1024 个采样）估算，payload 用 av_new_packet 模拟 av_read_frame。
+// payload 本身的分配两种方式一样，这里只统计 AVPacket 外壳。
+#include "Packet.hpp"
+#include "SemQueue.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+using ffmpeg_utils::Packet;
+using ffmpeg_utils::PacketPool;
+using player_utils::SemQueue;
+
+namespace {
+
+constexpr int kMinutes = 10;
+constexpr int kVideoPacketsPerMinute = 30 * 60;
+constexpr int kAudioPacketsPerMinute = 44100 * 60 / 1024;
+constexpr int kSeeksPerMinute = 2; // 每次 seek 发 flush + EOF 哨兵
+constexpr int kVideoPayload = 40 * 1024;
+constexpr int kAudioPayload = 400;
+constexpr size_t kQueueSize = 300;
+
+std::atomic<long> g_legacy_allocations { 0 };
+
+// 原来的 Packet（只保留这里用到的部分）
+class LegacyPacket {
+public:
+    LegacyPacket()
+        : pkt_(av_packet_alloc())
+    {
+        g_legacy_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    ~LegacyPacket() { av_packet_free(&pkt_); }
+    LegacyPacket(LegacyPacket&& other) noexcept
+        : pkt_(other.pkt_)
+    {
+        other.pkt_ = nullptr;
+    }
+    LegacyPacket& operator=(LegacyPacket&& other) noexcept
+    {
+        if (this != &other) {
+            av_packet_free(&pkt_);
+            pkt_ = other.pkt_;
+            other.pkt_ = nullptr;
+        }
+        return *this;
+    }
+
+    static LegacyPacket createSentinel()
+    {
+        LegacyPacket pkt;
+        av_packet_free(&pkt.pkt_);
+        return pkt;
+    }
+
+    AVPacket* get() const { return pkt_; }
+
+private:
+    AVPacket* pkt_ = nullptr;
+};
+
+// make_packet(payload) 造一个数据包，make_sentinel() 造一个哨兵包，解码线程用哨兵包当接收的外壳
+template <typename P, typename MakePacket, typename MakeSentinel>
+double run(MakePacket make_packet, MakeSentinel make_sentinel)
+{
+    SemQueue<P> video_queue(kQueueSize);
+    SemQueue<P> audio_queue(kQueueSize);
+
+    auto decode = [&make_sentinel](SemQueue<P>* queue) {
+        P holder = make_sentinel();
+        while (queue->wait_and_pop(holder)) { }
+    };
+    std::thread video_decoder(decode, &video_queue);
+    std::thread audio_decoder(decode, &audio_queue);
+
+    const auto start = Clock::now();
+    const long video_total = long(kVideoPacketsPerMinute) * kMinutes;
+    const long audio_total = long(kAudioPacketsPerMinute) * kMinutes;
+    const long seek_every = (video_total + audio_total) / (long(kSeeksPerMinute) * kMinutes);
+    long video_sent = 0;
+    long audio_sent = 0;
+    long sent = 0;
+    while (video_sent < video_total || audio_sent < audio_total) {
+        // 按时间戳交错：视频包和音频包的比例和码流一致
+        const bool video_turn = audio_sent >= audio_total
+            || (video_sent < video_total && video_sent * audio_total <= audio_sent * video_total);
+        if (video_turn) {
+            video_queue.push(make_packet(kVideoPayload));
+            ++video_sent;
+        } else {
+            audio_queue.push(make_packet(kAudioPayload));
+            ++audio_sent;
+        }
+        if (++sent % seek_every == 0) {
+            video_queue.push(make_sentinel());
+            audio_queue.push(make_sentinel());
+        }
+    }
+    video_queue.shutdown();
+    audio_queue.shutdown();
+    video_decoder.join();
+    audio_decoder.join();
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / sent;
+}
+
+} // namespace
+
+int main()
+{
+    const double legacy_us = run<LegacyPacket>(
+        [](int size) {
+            LegacyPacket pkt;
+            av_new_packet(pkt.get(), size);
+            return pkt;
+        },
+        [] { return LegacyPacket::createSentinel(); });
+    const long legacy = g_legacy_allocations.load();
+
+    const auto before = PacketPool::global().stats();
+    const double pooled_us = run<Packet>(
+        [](int size) {
+            Packet pkt;
+            av_new_packet(pkt.get(), size);
+            return pkt;
+        },
+        [] { return Packet::createFlushPacket(); });
+    const auto after = PacketPool::global().stats();
+    const auto pooled = static_cast<long>(after.allocations - before.allocations);
+
+    std::printf("%d minutes, %d video + %d audio packets per minute\n",
+        kMinutes, kVideoPacketsPerMinute, kAudioPacketsPerMinute);
+    std::printf("legacy: %8.1f AVPacket allocations / minute  %6.2f us/packet\n", double(legacy) / kMinutes, legacy_us);
+    std::printf("pooled: %8.1f AVPacket allocations / minute  %6.2f us/packet  (pool acquires %llu, idle %zu)\n",
+        double(pooled) / kMinutes, pooled_us,
+        static_cast<unsigned long long>(after.acquires - before.acquires), after.idle);
+    return 0;
+}
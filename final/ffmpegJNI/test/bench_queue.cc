@@ -0,0 +1,111 @@
+// bench_queue.cc
+// SemQueue vs SpscQueue：吞吐（ops/sec）与单次交接延迟（p50/p99）
+// 容量取 MediaPipeline / Mp4Parser 实际使用的 30、60、300、600
+#include "SemQueue.hpp"
+#include "SpscQueue.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using player_utils::SemQueue;
+using player_utils::SpscQueue;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// 管线里流动的都是 shared_ptr<Frame> / Packet 这种“指针大小 + 移动语义”的元素
+struct Item {
+    int64_t enqueue_ns = 0;
+};
+using Element = std::shared_ptr<Item>;
+
+constexpr size_t kThroughputOps = 2'000'000;
+constexpr size_t kLatencyOps = 20'000;
+constexpr auto kLatencyPacing = std::chrono::microseconds(50);
+
+int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+template <typename Queue>
+double run_throughput(size_t capacity)
+{
+    Queue queue(capacity);
+    // 预先分配好元素，避免测到 make_shared 的开销
+    std::vector<Element> items(kThroughputOps);
+    for (auto& item : items)
+        item = std::make_shared<Item>();
+
+    auto start = Clock::now();
+    std::thread producer([&] {
+        for (auto& item : items)
+            queue.push(std::move(item));
+    });
+
+    Element out;
+    for (size_t i = 0; i < kThroughputOps; ++i)
+        queue.wait_and_pop(out);
+    producer.join();
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return static_cast<double>(kThroughputOps) / seconds;
+}
+
+// 生产者按固定节拍推送，测量元素从 push 到被 pop 出来的时间，
+// 这样测到的是交接本身（含唤醒）的延迟，而不是满队列时的排队时间
+template <typename Queue>
+std::pair<double, double> run_latency(size_t capacity)
+{
+    Queue queue(capacity);
+    std::vector<int64_t> samples;
+    samples.reserve(kLatencyOps);
+
+    std::thread producer([&] {
+        for (size_t i = 0; i < kLatencyOps; ++i) {
+            auto item = std::make_shared<Item>();
+            auto until = Clock::now() + kLatencyPacing;
+            while (Clock::now() < until) {
+            }
+            item->enqueue_ns = now_ns();
+            queue.push(std::move(item));
+        }
+    });
+
+    Element out;
+    for (size_t i = 0; i < kLatencyOps; ++i) {
+        queue.wait_and_pop(out);
+        samples.push_back(now_ns() - out->enqueue_ns);
+    }
+    producer.join();
+
+    std::sort(samples.begin(), samples.end());
+    double p50 = static_cast<double>(samples[samples.size() / 2]) / 1000.0;
+    double p99 = static_cast<double>(samples[samples.size() * 99 / 100]) / 1000.0;
+    return { p50, p99 };
+}
+
+template <typename Queue>
+void report(const char* name, size_t capacity)
+{
+    double ops = run_throughput<Queue>(capacity);
+    auto [p50, p99] = run_latency<Queue>(capacity);
+    std::printf("%-10s cap=%-4zu %12.0f ops/s   p50=%7.2f us   p99=%7.2f us\n",
+        name, capacity, ops, p50, p99);
+}
+
+} // namespace
+
+int main()
+{
+    const size_t capacities[] = { 30, 60, 300, 600 };
+    for (size_t capacity : capacities) {
+        report<SemQueue<Element>>("SemQueue", capacity);
+        report<SpscQueue<Element>>("SpscQueue", capacity);
+    }
+    return 0;
+}
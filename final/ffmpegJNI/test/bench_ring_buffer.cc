@@ -0,0 +1,112 @@
+// bench_ring_buffer.cc
+// SemQueue<T, std::queue<T>> vs SemQueue<T, RingBuffer<T, N>>
+// 元素是 shared_ptr（和视频帧队列一样），对比吞吐以及入队出队过程中的堆分配次数。
+// 单线程：填满再取空，只看容器本身；双线程：生产者 / 消费者交替阻塞。
+#include "RingBuffer.hpp"
+#include "SemQueue.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+using player_utils::SemQueue;
+
+namespace {
+std::atomic<long> g_allocations { 0 };
+} // namespace
+
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+void* operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+constexpr long kOps = 2'000'000;
+using Element = std::shared_ptr<int>;
+
+struct Result {
+    double mops;
+    double allocs_per_op;
+};
+
+template <typename Queue>
+Result run_single_thread(size_t capacity)
+{
+    Queue queue(capacity);
+    Element element = std::make_shared<int>(42);
+    Element out;
+
+    long before = g_allocations.load();
+    auto start = Clock::now();
+    for (long done = 0; done < kOps;) {
+        for (size_t i = 0; i < capacity; ++i)
+            queue.push(element);
+        for (size_t i = 0; i < capacity; ++i)
+            queue.try_pop(out);
+        done += static_cast<long>(capacity);
+    }
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+    return { kOps / secs / 1e6, double(g_allocations.load() - before) / kOps };
+}
+
+template <typename Queue>
+Result run_two_threads(size_t capacity)
+{
+    Queue queue(capacity);
+    Element element = std::make_shared<int>(42);
+
+    long before = g_allocations.load();
+    auto start = Clock::now();
+    std::thread producer([&] {
+        for (long i = 0; i < kOps; ++i)
+            queue.push(element);
+    });
+    Element out;
+    for (long i = 0; i < kOps; ++i)
+        queue.wait_and_pop(out);
+    producer.join();
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+    return { kOps / secs / 1e6, double(g_allocations.load() - before) / kOps };
+}
+
+template <size_t N>
+void compare()
+{
+    using DequeQueue = SemQueue<Element>;
+    using RingQueue = SemQueue<Element, RingBuffer<Element, N>>;
+
+    Result a = run_single_thread<DequeQueue>(N);
+    Result b = run_single_thread<RingQueue>(N);
+    std::printf("%-6zu %-12s %-14s %10.2f %14.4f\n", N, "1 thread", "std::queue", a.mops, a.allocs_per_op);
+    std::printf("%-6zu %-12s %-14s %10.2f %14.4f\n", N, "1 thread", "RingBuffer", b.mops, b.allocs_per_op);
+
+    Result c = run_two_threads<DequeQueue>(N);
+    Result d = run_two_threads<RingQueue>(N);
+    std::printf("%-6zu %-12s %-14s %10.2f %14.4f\n", N, "2 threads", "std::queue", c.mops, c.allocs_per_op);
+    std::printf("%-6zu %-12s %-14s %10.2f %14.4f\n", N, "2 threads", "RingBuffer", d.mops, d.allocs_per_op);
+}
+
+} // namespace
+
+int main()
+{
+    std::printf("%-6s %-12s %-14s %10s %14s\n", "cap", "mode", "container", "Mops/s", "allocs/op");
+    compare<5>();
+    compare<16>();
+    compare<30>();
+    compare<300>();
+    return 0;
+}
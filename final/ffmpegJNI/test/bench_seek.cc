@@ -0,0 +1,165 @@
+// bench_seek.cc
+// seek 到第一帧的延迟：从发起 seek 到解码线程输出 seek 之后的第一帧。
+//   rebuild: 原来的做法，销毁 Decoder / DecoderContext / 包队列再重建（avcodec_open2 + 新线程）
+//   reuse  : Decoder::FlushAndWait，线程和 codec context 都保留，只 avcodec_flush_buffers
+// 只走视频流。用法：bench_seek [file]，默认读当前目录下的 test.mp4（和 test_demuxer 一样）
+#include "Decoder.hpp"
+#include "DecoderContext.hpp"
+#include "Demuxer.hpp"
+#include "MediaSource.hpp"
+#include "Packet.hpp"
+#include "SemQueue.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+using ffmpeg_utils::Packet;
+using player_utils::SemQueue;
+
+namespace {
+
+constexpr int kSeeks = 30;
+constexpr size_t kPacketQueueSize = 300;
+
+// 解码线程输出的帧计数，等待 "seek 之后的第一帧"
+struct FrameCounter {
+    std::mutex mutex;
+    std::condition_variable cv;
+    uint64_t frames = 0;
+
+    bool on_frame(const AVFrame*)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++frames;
+        }
+        cv.notify_all();
+        return true;
+    }
+
+    uint64_t current()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return frames;
+    }
+
+    bool wait_beyond(uint64_t seen)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(5), [&] { return frames > seen; });
+    }
+};
+
+struct Pipeline {
+    std::shared_ptr<MediaSource> source;
+    std::unique_ptr<Demuxer> demuxer;
+    std::unique_ptr<SemQueue<Packet>> queue;
+    std::unique_ptr<Decoder> decoder;
+    FrameCounter counter;
+
+    void start_decoder()
+    {
+        queue = std::make_unique<SemQueue<Packet>>(kPacketQueueSize);
+        // 队列腾出空位时叫醒解复用线程，不用等它的空闲超时
+        queue->set_on_writable([this] { demuxer->Wake(); });
+        auto ctx = std::make_shared<DecoderContext>(source->get_video_codecpar());
+        decoder = std::make_unique<Decoder>(ctx, *queue);
+        decoder->Start([this](const AVFrame* frame) { return counter.on_frame(frame); });
+    }
+
+    void start_demuxer()
+    {
+        const int video_index = source->get_video_stream_index();
+        demuxer->Start([this, video_index](Packet& packet) {
+            if (!packet.isEof() && packet.streamIndex() != video_index) {
+                return Demuxer::SinkResult::kAccepted;
+            }
+            if (queue->try_push(packet)) {
+                return Demuxer::SinkResult::kAccepted;
+            }
+            return queue->is_shutdown() ? Demuxer::SinkResult::kClosed : Demuxer::SinkResult::kFull;
+        });
+    }
+
+    void stop_demuxer()
+    {
+        demuxer->RequestStop();
+        queue->clear();
+        demuxer->Stop();
+    }
+};
+
+template <typename Seek>
+std::vector<double> run(const char* path, Seek seek)
+{
+    Pipeline p;
+    p.source = std::make_shared<MediaSource>();
+    if (!p.source->open(path) || !p.source->has_video_stream()) {
+        std::fprintf(stderr, "cannot open video in %s\n", path);
+        return {};
+    }
+    p.demuxer = std::make_unique<Demuxer>(p.source);
+    p.start_decoder();
+    p.start_demuxer();
+    p.counter.wait_beyond(0);
+
+    const double duration = p.demuxer->GetDuration();
+    std::vector<double> latencies_ms;
+    for (int i = 0; i < kSeeks; ++i) {
+        // 在片长的 10%..90% 之间来回跳
+        const double target = duration * (0.1 + 0.8 * ((i * 7) % kSeeks) / kSeeks);
+        const auto start = Clock::now();
+        p.stop_demuxer();
+        seek(p);
+        const uint64_t seen = p.counter.current();
+        p.demuxer->SeekTo(target);
+        p.start_demuxer();
+        if (!p.counter.wait_beyond(seen)) {
+            std::fprintf(stderr, "no frame after seek to %.3f\n", target);
+            continue;
+        }
+        latencies_ms.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    p.stop_demuxer();
+    p.decoder->Stop();
+    return latencies_ms;
+}
+
+void report(const char* name, std::vector<double> ms)
+{
+    if (ms.empty()) {
+        std::printf("%-8s no samples\n", name);
+        return;
+    }
+    std::sort(ms.begin(), ms.end());
+    double sum = 0;
+    for (double v : ms) {
+        sum += v;
+    }
+    std::printf("%-8s mean %7.2f ms  p50 %7.2f ms  p90 %7.2f ms  max %7.2f ms  (%zu seeks)\n",
+        name, sum / ms.size(), ms[ms.size() / 2], ms[ms.size() * 9 / 10], ms.back(), ms.size());
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* path = argc > 1 ? argv[1] : "test.mp4";
+
+    report("rebuild", run(path, [](Pipeline& p) {
+        p.queue->shutdown();
+        p.decoder.reset();
+        p.start_decoder();
+    }));
+
+    report("reuse", run(path, [](Pipeline& p) {
+        p.decoder->FlushAndWait(std::chrono::milliseconds(500));
+    }));
+    return 0;
+}
@@ -0,0 +1,163 @@
+// bench_semaphore.cc
+// futex Semaphore vs 原先的 mutex + condvar 实现
+// 场景：1:1 乒乓（测唤醒延迟），1:N / N:1 有界生产消费（测吞吐）
+// 通过 getrusage 统计上下文切换次数，作为进内核次数的近似
+#include "Semaphore.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <sys/resource.h>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+// 基线：重构前的 player_utils::Semaphore
+class CondvarSemaphore {
+public:
+    explicit CondvarSemaphore(int64_t count = 0)
+        : count_(count)
+    {
+    }
+
+    void release()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        count_++;
+        cv_.notify_one();
+    }
+
+    void acquire()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this]() { return count_ > 0 || shutdown_; });
+        if (shutdown_) {
+            return;
+        }
+        count_--;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    int64_t count_;
+    bool shutdown_ = false;
+};
+
+struct Result {
+    double seconds;
+    long context_switches;
+};
+
+long context_switches()
+{
+    rusage usage {};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+template <typename F>
+Result measure(F&& body)
+{
+    long cs_before = context_switches();
+    auto start = Clock::now();
+    body();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return { seconds, context_switches() - cs_before };
+}
+
+// 两个线程通过两个信号量来回传递令牌，每一轮都必然阻塞 + 唤醒一次
+template <typename Sem>
+void ping_pong(const char* name, int rounds)
+{
+    Sem ping(0);
+    Sem pong(0);
+    auto result = measure([&] {
+        std::thread peer([&] {
+            for (int i = 0; i < rounds; ++i) {
+                ping.acquire();
+                pong.release();
+            }
+        });
+        for (int i = 0; i < rounds; ++i) {
+            ping.release();
+            pong.acquire();
+        }
+        peer.join();
+    });
+    std::printf("%-8s 1:1  round-trip %8.2f us   ctx-switch/op %.2f\n",
+        name, result.seconds * 1e6 / rounds,
+        static_cast<double>(result.context_switches) / rounds);
+}
+
+// SemQueue 的用法：生产者 acquire 空位 / release 数据，消费者反之
+template <typename Sem>
+void bounded(const char* name, int producers, int consumers, int64_t total_ops)
+{
+    Sem empty_slots(64);
+    Sem filled_slots(0);
+    auto result = measure([&] {
+        std::vector<std::thread> threads;
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&] {
+                for (int64_t i = 0; i < total_ops / producers; ++i) {
+                    empty_slots.acquire();
+                    filled_slots.release();
+                }
+            });
+        }
+        for (int c = 0; c < consumers; ++c) {
+            threads.emplace_back([&] {
+                for (int64_t i = 0; i < total_ops / consumers; ++i) {
+                    filled_slots.acquire();
+                    empty_slots.release();
+                }
+            });
+        }
+        for (auto& t : threads)
+            t.join();
+    });
+    std::printf("%-8s %d:%d  %12.0f ops/s   ctx-switch/op %.4f\n",
+        name, producers, consumers,
+        static_cast<double>(total_ops) / result.seconds,
+        static_cast<double>(result.context_switches) / static_cast<double>(total_ops));
+}
+
+template <typename Sem>
+void uncontended(const char* name, int64_t ops)
+{
+    Sem sem(0);
+    auto result = measure([&] {
+        for (int64_t i = 0; i < ops; ++i) {
+            sem.release();
+            sem.acquire();
+        }
+    });
+    std::printf("%-8s uncontended release+acquire %6.1f ns\n", name, result.seconds * 1e9 / static_cast<double>(ops));
+}
+
+} // namespace
+
+int main()
+{
+    constexpr int64_t kOps = 1'200'000;
+
+    uncontended<CondvarSemaphore>("condvar", kOps * 10);
+    uncontended<player_utils::Semaphore>("futex", kOps * 10);
+
+    ping_pong<CondvarSemaphore>("condvar", 100'000);
+    ping_pong<player_utils::Semaphore>("futex", 100'000);
+
+    const int fan[] = { 2, 4 };
+    for (int n : fan) {
+        bounded<CondvarSemaphore>("condvar", 1, n, kOps);
+        bounded<player_utils::Semaphore>("futex", 1, n, kOps);
+        bounded<CondvarSemaphore>("condvar", n, 1, kOps);
+        bounded<player_utils::Semaphore>("futex", n, 1, kOps);
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+// bench_thumbnail.cc
+// 进度条预览图的吞吐：
+//   box filter: 1080p YUV420 -> 160x90，SIMD 行累加 vs 逐像素标量累加（不需要视频文件）
+//   cold      : ThumbnailExtractor::extract 在全片均匀取 kThumbnails 张，缓存全部未命中
+//   warm      : 同样的位置再取一遍，全部命中 LRU 缓存
+//   scrub     : 模拟拖进度条，每 kScrubIntervalMs 发一次 request()，统计真正回调的张数和被取消的请求
+// 默认读当前目录下的 long.mp4，一段 2 小时的素材可以这样生成：
+//   ffmpeg -f lavfi -i testsrc2=size=1920x1080:rate=30 -t 7200 -c:v libx264 -preset ultrafast -g 60 long.mp4
+// 用法：bench_thumbnail [file]
+#include "BoxFilter.hpp"
+#include "Mp4Parser/ThumbnailExtractor.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+using mp4parser::ThumbnailExtractor;
+using player_utils::BoxFilter;
+
+namespace {
+
+constexpr int kSrcWidth = 1920;
+constexpr int kSrcHeight = 1080;
+constexpr int kThumbWidth = 160;
+constexpr int kThumbHeight = 90;
+constexpr int kFilterRounds = 500;
+
+constexpr int kThumbnails = 240; // 2 小时里每 30 秒一张
+constexpr int kScrubRequests = 400;
+constexpr int kScrubIntervalMs = 5;
+
+double seconds_since(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// 没有 SIMD 的行累加，和 BoxFilter::scale 的其余部分一样
+void scalar_scale(const uint8_t* src, int sw, int sh, int stride, uint8_t* dst, int dw, int dh, std::vector<uint32_t>& acc)
+{
+    acc.assign(static_cast<size_t>(sw), 0U);
+    for (int y = 0; y < dh; ++y) {
+        const int y0 = y * sh / dh;
+        const int y1 = (y + 1) * sh / dh;
+        std::fill(acc.begin(), acc.end(), 0U);
+        for (int sy = y0; sy < y1; ++sy) {
+            const uint8_t* row = src + static_cast<ptrdiff_t>(sy) * stride;
+            for (int i = 0; i < sw; ++i) {
+                acc[i] += row[i];
+            }
+        }
+        for (int x = 0; x < dw; ++x) {
+            const int x0 = x * sw / dw;
+            const int x1 = (x + 1) * sw / dw;
+            uint32_t sum = 0;
+            for (int sx = x0; sx < x1; ++sx) {
+                sum += acc[sx];
+            }
+            const uint32_t area = static_cast<uint32_t>((y1 - y0) * (x1 - x0));
+            dst[static_cast<ptrdiff_t>(y) * dw + x] = static_cast<uint8_t>((sum + area / 2) / area);
+        }
+    }
+}
+
+void bench_box_filter()
+{
+    std::vector<uint8_t> src(static_cast<size_t>(kSrcWidth) * kSrcHeight);
+    for (size_t i = 0; i < src.size(); ++i) {
+        src[i] = static_cast<uint8_t>(i * 31);
+    }
+    std::vector<uint8_t> dst(static_cast<size_t>(kThumbWidth) * kThumbHeight);
+
+    // 亮度平面 + 两个 1/4 大小的色度平面
+    BoxFilter filter;
+    auto start = Clock::now();
+    for (int n = 0; n < kFilterRounds; ++n) {
+        filter.scale(src.data(), kSrcWidth, kSrcHeight, kSrcWidth, dst.data(), kThumbWidth, kThumbHeight, kThumbWidth);
+        for (int c = 0; c < 2; ++c) {
+            filter.scale(src.data(), kSrcWidth / 2, kSrcHeight / 2, kSrcWidth, dst.data(), kThumbWidth / 2, kThumbHeight / 2, kThumbWidth);
+        }
+    }
+    const double simd = seconds_since(start);
+
+    std::vector<uint32_t> acc;
+    start = Clock::now();
+    for (int n = 0; n < kFilterRounds; ++n) {
+        scalar_scale(src.data(), kSrcWidth, kSrcHeight, kSrcWidth, dst.data(), kThumbWidth, kThumbHeight, acc);
+        for (int c = 0; c < 2; ++c) {
+            scalar_scale(src.data(), kSrcWidth / 2, kSrcHeight / 2, kSrcWidth, dst.data(), kThumbWidth / 2, kThumbHeight / 2, acc);
+        }
+    }
+    const double scalar = seconds_since(start);
+
+    std::printf("box filter %dx%d -> %dx%d: simd %.3f ms/frame, scalar %.3f ms/frame\n",
+        kSrcWidth, kSrcHeight, kThumbWidth, kThumbHeight, simd * 1e3 / kFilterRounds, scalar * 1e3 / kFilterRounds);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    bench_box_filter();
+
+    const char* path = argc > 1 ? argv[1] : "long.mp4";
+    ThumbnailExtractor::Options options;
+    options.width = kThumbWidth;
+    options.cache_capacity = kThumbnails;
+    auto extractor = ThumbnailExtractor::create(path, options);
+    if (!extractor) {
+        std::fprintf(stderr, "cannot open %s\n", path);
+        return 1;
+    }
+
+    const double duration = extractor->duration();
+    std::printf("%s: %.0f s\n", path, duration);
+    std::vector<double> positions;
+    for (int i = 0; i < kThumbnails; ++i) {
+        positions.push_back(duration * (i + 0.5) / kThumbnails);
+    }
+
+    for (const char* pass : { "cold", "warm" }) {
+        int produced = 0;
+        const auto start = Clock::now();
+        for (double t : positions) {
+            produced += extractor->extract(t) ? 1 : 0;
+        }
+        const double elapsed = seconds_since(start);
+        std::printf("%-5s %d/%d thumbnails  %.1f thumbnails/s\n", pass, produced, kThumbnails, produced / elapsed);
+    }
+
+    // 拖进度条：位置从头扫到尾，比解码快得多，大部分请求会被后面的覆盖
+    auto scrubber = ThumbnailExtractor::create(path, options);
+    std::atomic<int> delivered { 0 };
+    const auto start = Clock::now();
+    for (int i = 0; i < kScrubRequests; ++i) {
+        scrubber->request(duration * i / kScrubRequests, [&delivered](double, ThumbnailExtractor::Thumbnail thumbnail) {
+            if (thumbnail) {
+                delivered.fetch_add(1);
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(kScrubIntervalMs));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    const auto stats = scrubber->stats();
+    std::printf("scrub %d requests in %.2f s: %d delivered, %llu cancelled, %llu decoded\n",
+        kScrubRequests, seconds_since(start), delivered.load(),
+        static_cast<unsigned long long>(stats.cancelled), static_cast<unsigned long long>(stats.decoded));
+    return 0;
+}
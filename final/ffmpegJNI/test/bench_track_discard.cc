@@ -0,0 +1,119 @@
+// bench_track_discard.cc
+// 多音轨 / 多字幕文件上，没选中的流设成 AVDISCARD_ALL 和原来"全读出来再丢掉"的对比，从头读到尾：
+//   bytes read      : AVIOContext 实际从文件读的字节数
+//   packets         : av_read_frame 交出来的包数
+//   cpu ms / media s: 每秒媒体时长花掉的进程 CPU 时间
+// 每项跑 kRuns 次取最好的一次。用法：bench_track_discard [file...]，默认读当前目录下的 multi_audio.mp4
+#include "MediaSource.hpp"
+#include <time.h>
+
+#include <cstdio>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace {
+
+constexpr int kRuns = 3;
+
+double cpu_ms()
+{
+    timespec ts {};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) * 1000.0 + static_cast<double>(ts.tv_nsec) / 1e6;
+}
+
+struct Result {
+    int64_t bytes = 0;
+    size_t packets = 0;
+    double cpu_ms = 0.0;
+};
+
+// discard 为 false 时和原来一样：所有流都读出来，不是选中的音视频流的包在 sink 里丢掉
+bool demux(const char* path, bool discard, Result& result)
+{
+    MediaSource source;
+    if (!source.open(path)) {
+        return false;
+    }
+    AVFormatContext* fmt = source.get_format_context();
+    if (!discard) {
+        for (unsigned i = 0; i < fmt->nb_streams; ++i) {
+            fmt->streams[i]->discard = AVDISCARD_DEFAULT;
+        }
+    }
+
+    AVPacket* pkt = av_packet_alloc();
+    result = {};
+    const int64_t bytes_start = fmt->pb->bytes_read;
+    const double cpu_start = cpu_ms();
+    while (av_read_frame(fmt, pkt) >= 0) {
+        ++result.packets;
+        av_packet_unref(pkt);
+    }
+    result.cpu_ms = cpu_ms() - cpu_start;
+    result.bytes = fmt->pb->bytes_read - bytes_start;
+    av_packet_free(&pkt);
+    return true;
+}
+
+bool best_of(const char* path, bool discard, Result& best)
+{
+    for (int i = 0; i < kRuns; ++i) {
+        Result r;
+        if (!demux(path, discard, r)) {
+            return false;
+        }
+        if (i == 0 || r.cpu_ms < best.cpu_ms) {
+            best = r;
+        }
+    }
+    return true;
+}
+
+void print(const char* name, const Result& r, double media_s)
+{
+    std::printf("  %-12s %10.1f MB read  %8zu packets  %7.3f cpu ms / media s\n", name, r.bytes / 1048576.0, r.packets,
+        r.cpu_ms / media_s);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::vector<const char*> files(argv + 1, argv + argc);
+    if (files.empty()) {
+        files.push_back("multi_audio.mp4");
+    }
+    for (const char* path : files) {
+        double media_s = 0.0;
+        size_t tracks = 0;
+        {
+            MediaSource source;
+            if (!source.open(path) || source.get_format_context()->duration <= 0) {
+                std::fprintf(stderr, "cannot open %s\n", path);
+                continue;
+            }
+            media_s = static_cast<double>(source.get_format_context()->duration) / AV_TIME_BASE;
+            tracks = source.tracks().size();
+        }
+        Result warmup;
+        demux(path, false, warmup);
+
+        Result all;
+        Result selected;
+        if (!best_of(path, false, all) || !best_of(path, true, selected)) {
+            continue;
+        }
+        std::printf("%s (%.1f s, %zu tracks):\n", path, media_s, tracks);
+        print("read all", all, media_s);
+        print("discard", selected, media_s);
+        if (all.bytes > 0 && all.cpu_ms > 0.0) {
+            std::printf("  %.0f%% of the bytes, %.0f%% of the cpu time\n", 100.0 * selected.bytes / all.bytes,
+                100.0 * selected.cpu_ms / all.cpu_ms);
+        }
+    }
+    return 0;
+}
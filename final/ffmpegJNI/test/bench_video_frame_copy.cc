@@ -0,0 +1,139 @@
+// bench_video_frame_copy.cc
+// 4K YUV420 解码输出 -> VideoFrame 的两种方式：
+//   copy: 逐平面 memcpy 到 VideoFramePool 里的帧（convert_video_frame）
+//   ref : VideoFrame 只持有解码器缓冲区的引用（ref_video_frame）
+// 解码器输出用一组预先分配好的、带行对齐填充的缓冲区模拟，轮流使用以免全部命中 cache。
+// 每帧之后模拟渲染线程把三个平面各读一遍（glTexImage2D 的读取），统计每帧耗时和拷贝带来的内存流量。
+#include "Entitys.hpp"
+#include "VideoFramePool.hpp"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+using player_utils::VideoFrame;
+using player_utils::VideoFramePool;
+
+namespace {
+
+constexpr int kWidth = 3840;
+constexpr int kHeight = 2160;
+constexpr int kFrames = 600;
+constexpr int kDecoderBuffers = 8; // 解码器 buffer pool 里同时存在的帧数
+constexpr int kAlign = 64;
+
+struct DecodedPicture {
+    std::vector<uint8_t> storage;
+    uint8_t* data[3];
+    int linesize[3];
+    size_t bytes;
+};
+
+int plane_height(int i) { return i == 0 ? kHeight : (kHeight + 1) / 2; }
+
+std::vector<std::shared_ptr<DecodedPicture>> make_decoder_pool()
+{
+    std::vector<std::shared_ptr<DecodedPicture>> pool;
+    for (int n = 0; n < kDecoderBuffers; ++n) {
+        auto pic = std::make_shared<DecodedPicture>();
+        const int widths[3] = { kWidth, kWidth / 2, kWidth / 2 };
+        size_t total = 0;
+        for (int i = 0; i < 3; ++i) {
+            pic->linesize[i] = (widths[i] + kAlign - 1) / kAlign * kAlign + kAlign;
+            total += static_cast<size_t>(pic->linesize[i]) * plane_height(i);
+        }
+        pic->storage.assign(total, static_cast<uint8_t>(n));
+        size_t offset = 0;
+        for (int i = 0; i < 3; ++i) {
+            pic->data[i] = pic->storage.data() + offset;
+            offset += static_cast<size_t>(pic->linesize[i]) * plane_height(i);
+        }
+        pic->bytes = total;
+        pool.push_back(std::move(pic));
+    }
+    return pool;
+}
+
+std::shared_ptr<VideoFrame> copy_frame(const DecodedPicture& pic, VideoFramePool& pool)
+{
+    auto out = pool.acquire(kWidth, kHeight, 0, pic.bytes);
+    uint8_t* dst = out->data.data();
+    for (int i = 0; i < 3; ++i) {
+        const size_t bytes = static_cast<size_t>(pic.linesize[i]) * plane_height(i);
+        std::memcpy(dst, pic.data[i], bytes);
+        out->linesize[i] = pic.linesize[i];
+        dst += bytes;
+    }
+    return out;
+}
+
+std::shared_ptr<VideoFrame> ref_frame(const std::shared_ptr<DecodedPicture>& pic)
+{
+    auto out = std::make_shared<VideoFrame>();
+    out->width = kWidth;
+    out->height = kHeight;
+    for (int i = 0; i < 3; ++i) {
+        out->planes[i] = pic->data[i];
+        out->linesize[i] = pic->linesize[i];
+    }
+    out->ref_bytes = pic->bytes;
+    out->buffer_ref = pic;
+    return out;
+}
+
+// 渲染端按行读取可见区域
+uint64_t consume(const VideoFrame& frame)
+{
+    uint64_t sum = 0;
+    for (int i = 0; i < 3; ++i) {
+        const int width = i == 0 ? frame.width : (frame.width + 1) / 2;
+        const uint8_t* row = frame.plane(i);
+        for (int y = 0; y < frame.plane_height(i); ++y, row += frame.linesize[i]) {
+            for (int x = 0; x < width; x += 64) {
+                sum += row[x];
+            }
+        }
+    }
+    return sum;
+}
+
+template <typename MakeFrame>
+void run(const char* name, MakeFrame make_frame, size_t bytes_per_frame, size_t copied_per_frame)
+{
+    uint64_t checksum = 0;
+    double worst_us = 0;
+    const auto start = Clock::now();
+    for (int n = 0; n < kFrames; ++n) {
+        const auto t0 = Clock::now();
+        auto frame = make_frame(n);
+        checksum += consume(*frame);
+        const double us = std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+        if (us > worst_us) {
+            worst_us = us;
+        }
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    // 拷贝 = 读 + 写，各算一次
+    const double copy_gbps = 2.0 * static_cast<double>(copied_per_frame) * kFrames / seconds / 1e9;
+    std::printf("%-5s  %7.1f us/frame (worst %7.1f)  %5.1f fps  copy traffic %5.2f GB/s  frame %zu bytes  [%llu]\n",
+        name, seconds * 1e6 / kFrames, worst_us, kFrames / seconds, copy_gbps, bytes_per_frame,
+        static_cast<unsigned long long>(checksum & 0xff));
+}
+
+} // namespace
+
+int main()
+{
+    auto decoder_pool = make_decoder_pool();
+    const size_t bytes = decoder_pool[0]->bytes;
+    VideoFramePool frame_pool;
+    frame_pool.prewarm(kWidth, kHeight, 0, bytes, 2);
+
+    std::printf("%dx%d YUV420, %d frames\n", kWidth, kHeight, kFrames);
+    run("copy", [&](int n) { return copy_frame(*decoder_pool[n % kDecoderBuffers], frame_pool); }, bytes, bytes);
+    run("ref", [&](int n) { return ref_frame(decoder_pool[n % kDecoderBuffers]); }, bytes, 0);
+    return 0;
+}
@@ -0,0 +1,110 @@
+// test_box_filter.cc
+#include "BoxFilter.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <utility>
+#include <vector>
+
+using player_utils::BoxFilter;
+
+namespace {
+// 逐像素求平均的参考实现，区间划分和 BoxFilter 一致
+std::vector<uint8_t> reference_scale(const std::vector<uint8_t>& src, int sw, int sh, int stride, int dw, int dh)
+{
+    std::vector<uint8_t> out(static_cast<size_t>(dw) * dh);
+    for (int y = 0; y < dh; ++y) {
+        const int y0 = y * sh / dh;
+        const int y1 = std::max((y + 1) * sh / dh, y0 + 1);
+        for (int x = 0; x < dw; ++x) {
+            const int x0 = x * sw / dw;
+            const int x1 = std::max((x + 1) * sw / dw, x0 + 1);
+            uint32_t sum = 0;
+            for (int sy = y0; sy < y1; ++sy) {
+                for (int sx = x0; sx < x1; ++sx) {
+                    sum += src[static_cast<size_t>(sy) * stride + sx];
+                }
+            }
+            const uint32_t area = static_cast<uint32_t>((y1 - y0) * (x1 - x0));
+            out[static_cast<size_t>(y) * dw + x] = static_cast<uint8_t>((sum + area / 2) / area);
+        }
+    }
+    return out;
+}
+
+std::vector<uint8_t> make_plane(int stride, int height)
+{
+    std::vector<uint8_t> plane(static_cast<size_t>(stride) * height);
+    uint32_t seed = 12345;
+    for (auto& px : plane) {
+        seed = seed * 1664525U + 1013904223U;
+        px = static_cast<uint8_t>(seed >> 24);
+    }
+    return plane;
+}
+} // namespace
+
+TEST(BoxFilterTest, AccumulateRowMatchesScalarIncludingTail)
+{
+    // 37 = 两个 16 字节的 SIMD 块 + 5 个尾部像素
+    const std::vector<uint8_t> row = make_plane(37, 1);
+    std::vector<uint16_t> acc(37, 1000);
+    BoxFilter::accumulate_row(row.data(), acc.data(), 37);
+    BoxFilter::accumulate_row(row.data(), acc.data(), 37);
+    for (int i = 0; i < 37; ++i) {
+        EXPECT_EQ(acc[i], 1000 + 2 * row[i]) << "at " << i;
+    }
+}
+
+TEST(BoxFilterTest, MatchesReferenceOnOddSizesWithPadding)
+{
+    const int sw = 1917;
+    const int sh = 1079;
+    const int stride = 1984; // 行对齐填充
+    const std::vector<uint8_t> src = make_plane(stride, sh);
+
+    for (auto [dw, dh] : { std::pair { 160, 90 }, std::pair { 81, 45 }, std::pair { 320, 181 } }) {
+        std::vector<uint8_t> out(static_cast<size_t>(dw) * dh);
+        BoxFilter filter;
+        filter.scale(src.data(), sw, sh, stride, out.data(), dw, dh, dw);
+        EXPECT_EQ(out, reference_scale(src, sw, sh, stride, dw, dh)) << dw << "x" << dh;
+    }
+}
+
+TEST(BoxFilterTest, TallSpansDoNotOverflowTheSixteenBitAccumulator)
+{
+    // 一个输出像素覆盖 600 行全白：超过 uint16 一次能累加的 257 行
+    const int sw = 20;
+    const int sh = 600;
+    const std::vector<uint8_t> src(static_cast<size_t>(sw) * sh, 255);
+    uint8_t out[2] = {};
+    BoxFilter filter;
+    filter.scale(src.data(), sw, sh, sw, out, 2, 1, 2);
+    EXPECT_EQ(out[0], 255);
+    EXPECT_EQ(out[1], 255);
+}
+
+TEST(BoxFilterTest, HalvingAveragesEachTwoByTwoBlock)
+{
+    const std::vector<uint8_t> src = {
+        0, 4, 100, 200,
+        8, 12, 100, 201,
+    };
+    uint8_t out[2] = {};
+    BoxFilter filter;
+    filter.scale(src.data(), 4, 2, 4, out, 2, 1, 2);
+    EXPECT_EQ(out[0], 6); // (0 + 4 + 8 + 12) / 4
+    EXPECT_EQ(out[1], 150); // (100 + 200 + 100 + 201) / 4 = 150.25
+}
+
+TEST(BoxFilterTest, UpscalingRepeatsPixels)
+{
+    const uint8_t src[] = { 10, 20 };
+    uint8_t out[4] = {};
+    BoxFilter filter;
+    filter.scale(src, 2, 1, 2, out, 4, 1, 4);
+    EXPECT_EQ(out[0], 10);
+    EXPECT_EQ(out[1], 10);
+    EXPECT_EQ(out[2], 20);
+    EXPECT_EQ(out[3], 20);
+}
@@ -0,0 +1,63 @@
+// test_decode_threading.cc
+#include "DecodeThreading.hpp"
+#include <gtest/gtest.h>
+
+using player_utils::DecodeThreading;
+using player_utils::DecoderThreadCaps;
+using player_utils::resolve_decode_threading;
+using Mode = DecodeThreading::Mode;
+
+namespace {
+constexpr DecoderThreadCaps kBoth { true, true };
+constexpr DecoderThreadCaps kSliceOnly { false, true };
+constexpr DecoderThreadCaps kNone { false, false };
+} // namespace
+
+TEST(DecodeThreadingTest, AudioIsSingleThreaded)
+{
+    const auto r = resolve_decode_threading({}, kBoth, 0, 0, 8);
+    EXPECT_EQ(r.mode, Mode::Single);
+    EXPECT_EQ(r.thread_count, 1);
+}
+
+TEST(DecodeThreadingTest, AutoScalesWithResolution)
+{
+    EXPECT_EQ(resolve_decode_threading({}, kBoth, 3840, 2160, 8).thread_count, 7); // 留一个核
+    EXPECT_EQ(resolve_decode_threading({}, kBoth, 1920, 1080, 8).thread_count, 6);
+    EXPECT_EQ(resolve_decode_threading({}, kBoth, 1280, 720, 8).thread_count, 4);
+    EXPECT_EQ(resolve_decode_threading({}, kBoth, 854, 480, 8).thread_count, 2);
+    EXPECT_EQ(resolve_decode_threading({}, kBoth, 3840, 2160, 8).mode, Mode::Frame);
+}
+
+TEST(DecodeThreadingTest, SingleCoreFallsBackToOneThread)
+{
+    const auto r = resolve_decode_threading({}, kBoth, 3840, 2160, 1);
+    EXPECT_EQ(r.mode, Mode::Single);
+    EXPECT_EQ(r.thread_count, 1);
+}
+
+TEST(DecodeThreadingTest, LowDelayNeverUsesFrameThreads)
+{
+    DecodeThreading policy;
+    policy.mode = Mode::Frame;
+    policy.low_delay = true;
+    const auto r = resolve_decode_threading(policy, kBoth, 1920, 1080, 8);
+    EXPECT_EQ(r.mode, Mode::Slice);
+    EXPECT_TRUE(r.low_delay);
+}
+
+TEST(DecodeThreadingTest, FallsBackToWhatTheDecoderSupports)
+{
+    EXPECT_EQ(resolve_decode_threading({}, kSliceOnly, 1920, 1080, 8).mode, Mode::Slice);
+    EXPECT_EQ(resolve_decode_threading({}, kNone, 1920, 1080, 8).mode, Mode::Single);
+}
+
+TEST(DecodeThreadingTest, ExplicitCountIsKeptAndClamped)
+{
+    DecodeThreading policy;
+    policy.mode = Mode::Slice;
+    policy.thread_count = 3;
+    EXPECT_EQ(resolve_decode_threading(policy, kBoth, 640, 360, 8).thread_count, 3);
+    policy.thread_count = 64;
+    EXPECT_EQ(resolve_decode_threading(policy, kBoth, 640, 360, 8).thread_count, 16);
+}
@@ -3,7 +3,9 @@
 #include "DecoderContext.hpp"
 #include "Packet.hpp"
 #include "SemQueue.hpp"
+#include "TaskExecutor.hpp"
 #include <atomic>
+#include <chrono>
 #include <gtest/gtest.h>
 #include <thread>
 
@@ -57,8 +59,9 @@ protected:
         // frame_sink increments frame_count_ for each call
         frame_sink_ = [&](const AVFrame* frame) {
             ++frame_count_;
+            return true;
         };
-        decoder_ = std::make_unique<Decoder>(ctx_, *queue_, frame_sink_);
+        decoder_ = std::make_unique<Decoder>(ctx_, *queue_);
     }
 
     void TearDown() override
@@ -131,3 +134,72 @@ TEST_F(DecoderTest, ReuseAfterFlush)
     EXPECT_GE(first_count, 0);
     EXPECT_GE(second_count, 0);
 }
+
+// 跑在 executor 上、下游一直是满的时候 seek：
+// 帧队列只 shutdown 不取空（视频），或者根本不变（PCM 环形缓冲区），flush 哨兵包都要马上被处理，
+// 不能等到 FlushAndWait 超时
+TEST(DecoderExecutorTest, SeekWithFullOutputFlushesPromptly)
+{
+    TaskExecutor executor(1);
+    SemQueue<Packet> packets(20);
+    SemQueue<int> frames(1);
+    frames.push(0); // 下游已经满了
+
+    Decoder decoder(std::make_shared<MockDecoderContext>(), packets);
+    decoder.Start([&](const AVFrame*) { return frames.push(1); }, executor,
+        [&] { return !frames.full(); });
+    for (int i = 0; i < 5; ++i) {
+        packets.push(make_dummy_packet());
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto timeout = std::chrono::milliseconds(500);
+
+    // 下游满、没有 shutdown
+    auto start = Clock::now();
+    EXPECT_TRUE(decoder.FlushAndWait(timeout));
+    EXPECT_LT(Clock::now() - start, timeout / 2);
+
+    // seek 时帧队列被 shutdown，里面的帧还在
+    packets.push(make_dummy_packet());
+    frames.shutdown();
+    start = Clock::now();
+    EXPECT_TRUE(decoder.FlushAndWait(timeout));
+    EXPECT_LT(Clock::now() - start, timeout / 2);
+
+    decoder.Stop();
+}
+
+TEST(DecoderExecutorTest, FullOutputParksTaskUntilOutputWakerFires)
+{
+    TaskExecutor executor(1);
+    SemQueue<Packet> packets(20);
+    SemQueue<int> frames(1);
+    frames.push(0); // 下游已经满了
+
+    Decoder decoder(std::make_shared<MockDecoderContext>(), packets);
+    decoder.Start([&](const AVFrame*) {
+        int frame = 1;
+        return frames.try_push(frame) || !frames.is_shutdown();
+    },
+        executor, [&] { return !frames.full(); }, true);
+    frames.set_on_writable(decoder.OutputWaker());
+    packets.push(make_dummy_packet());
+
+    // 下游满：任务挂起等唤醒，既不取包、也不按退避时间轮询，更不会占着工作线程阻塞在 sink 里
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(packets.size(), 1U);
+    EXPECT_EQ(executor.stats().sleeps, 0U);
+
+    // 帧队列腾出空位，on_writable 叫醒任务，包被取走
+    int out = 0;
+    ASSERT_TRUE(frames.try_pop(out));
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+    while (!packets.empty() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(packets.empty());
+
+    frames.shutdown();
+    decoder.Stop();
+}
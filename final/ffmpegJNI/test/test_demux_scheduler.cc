@@ -0,0 +1,422 @@
+// test_demux_scheduler.cc
+#include "DemuxScheduler.hpp"
+#include "SemQueue.hpp"
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using player_utils::BufferWatermarks;
+using player_utils::SemQueue;
+using player_utils::SinkResult;
+using player_utils::StreamBufferLevels;
+
+namespace {
+
+struct TestPacket {
+    int stream = -1;
+    int64_t dts_us = 0;
+    int64_t duration_us = 0;
+    size_t bytes = 0;
+};
+
+using Scheduler = player_utils::DemuxScheduler<TestPacket>;
+using Decision = Scheduler::Decision;
+
+TestPacket packet_of(int stream, size_t bytes = 100)
+{
+    return { stream, 0, 10000, bytes };
+}
+
+} // namespace
+
+TEST(StreamBufferLevelsTest, RefillsOnlyAfterDrainingBelowLowWatermark)
+{
+    StreamBufferLevels levels(2);
+    levels.track(0, BufferWatermarks { 100, 300 });
+    int refills = 0;
+    levels.set_on_refill([&refills] { ++refills; });
+
+    for (int i = 0; i < 3; ++i) {
+        levels.on_push(0, 100);
+    }
+    EXPECT_EQ(levels.level(0).buffered_us, 300);
+    EXPECT_FALSE(levels.level(0).filling);
+
+    // 在两个水位之间不要数据，也不叫醒解复用器
+    levels.on_pop(0, 100);
+    EXPECT_FALSE(levels.level(0).filling);
+    EXPECT_EQ(refills, 0);
+
+    levels.on_pop(0, 150);
+    EXPECT_TRUE(levels.level(0).filling);
+    EXPECT_EQ(refills, 1);
+    levels.on_pop(0, 100);
+    EXPECT_EQ(levels.level(0).buffered_us, 0);
+    EXPECT_EQ(refills, 1);
+
+    // 没有 track 的流不记
+    levels.on_push(1, 1000);
+    EXPECT_FALSE(levels.level(1).tracked);
+    EXPECT_EQ(levels.level(1).buffered_us, 0);
+
+    levels.on_push(0, 500);
+    levels.reset();
+    EXPECT_EQ(levels.level(0).buffered_us, 0);
+    EXPECT_TRUE(levels.level(0).filling);
+}
+
+TEST(StreamBufferLevelsTest, RetargetMovesTheLevelToTheNewTrack)
+{
+    StreamBufferLevels levels(3);
+    levels.track(1, BufferWatermarks { 100, 300 });
+    levels.on_push(1, 250);
+
+    // 换音轨：旧音轨还在队列里的包按新音轨出队
+    levels.retarget(1, 2);
+    EXPECT_FALSE(levels.level(1).tracked);
+    EXPECT_TRUE(levels.level(2).tracked);
+    EXPECT_EQ(levels.level(2).buffered_us, 250);
+    levels.on_pop(2, 200);
+    EXPECT_EQ(levels.level(2).buffered_us, 50);
+    EXPECT_TRUE(levels.level(2).filling);
+}
+
+TEST(DemuxSchedulerTest, WithoutLevelsWaitsWhileAPacketIsParked)
+{
+    Scheduler scheduler;
+    scheduler.reset(nullptr, false);
+    bool full = true;
+    int accepted = 0;
+    Scheduler::Sink sink = [&](TestPacket&) {
+        if (full) {
+            return SinkResult::kFull;
+        }
+        ++accepted;
+        return SinkResult::kAccepted;
+    };
+
+    EXPECT_EQ(scheduler.next(sink).kind, Decision::kRead);
+    TestPacket packet = packet_of(0);
+    EXPECT_TRUE(scheduler.deliver(packet, 0, packet.bytes, sink));
+    EXPECT_EQ(scheduler.parked_packets(), 1U);
+    EXPECT_EQ(scheduler.next(sink).kind, Decision::kWait);
+
+    full = false;
+    EXPECT_EQ(scheduler.next(sink).kind, Decision::kRead);
+    EXPECT_EQ(accepted, 1);
+    EXPECT_EQ(scheduler.parked_packets(), 0U);
+
+    scheduler.input_ended();
+    EXPECT_EQ(scheduler.next(sink).kind, Decision::kEnd);
+}
+
+TEST(DemuxSchedulerTest, PerStreamReadsPickTheEmptiestFillingStream)
+{
+    auto levels = std::make_shared<StreamBufferLevels>(3);
+    levels->track(0, BufferWatermarks { 100, 300 });
+    levels->track(1, BufferWatermarks { 100, 300 });
+    Scheduler scheduler;
+    scheduler.reset(levels, true);
+    Scheduler::Sink sink = [](TestPacket&) { return SinkResult::kAccepted; };
+
+    levels->on_push(0, 50);
+    Decision d = scheduler.next(sink);
+    EXPECT_EQ(d.kind, Decision::kRead);
+    EXPECT_EQ(d.stream, 1);
+
+    levels->on_push(1, 300);
+    d = scheduler.next(sink);
+    EXPECT_EQ(d.kind, Decision::kRead);
+    EXPECT_EQ(d.stream, 0);
+
+    levels->on_push(0, 300);
+    EXPECT_EQ(scheduler.next(sink).kind, Decision::kWait);
+
+    scheduler.stream_ended(0);
+    scheduler.stream_ended(1);
+    EXPECT_EQ(scheduler.next(sink).kind, Decision::kEnd);
+}
+
+TEST(DemuxSchedulerTest, FullStreamIsParkedWhileOtherStreamsKeepReading)
+{
+    auto levels = std::make_shared<StreamBufferLevels>(2);
+    levels->track(0, BufferWatermarks { 100, 300 });
+    levels->track(1, BufferWatermarks { 100, 300 });
+    Scheduler scheduler;
+    scheduler.reset(levels, true);
+    std::vector<int> accepted;
+    Scheduler::Sink sink = [&accepted](TestPacket& packet) {
+        if (packet.stream == 0) {
+            return SinkResult::kFull;
+        }
+        accepted.push_back(packet.stream);
+        return SinkResult::kAccepted;
+    };
+
+    TestPacket video = packet_of(0);
+    ASSERT_TRUE(scheduler.deliver(video, 0, video.bytes, sink));
+    EXPECT_EQ(scheduler.parked_packets(), 1U);
+    // 流 0 还有包暂存着，不再为它读，只读流 1
+    for (int i = 0; i < 3; ++i) {
+        const Decision d = scheduler.next(sink);
+        ASSERT_EQ(d.kind, Decision::kRead);
+        EXPECT_EQ(d.stream, 1);
+        TestPacket audio = packet_of(1);
+        ASSERT_TRUE(scheduler.deliver(audio, 1, audio.bytes, sink));
+    }
+    EXPECT_EQ(accepted.size(), 3U);
+}
+
+TEST(DemuxSchedulerTest, InterleavedReadsStopAtTheParkingLimit)
+{
+    auto levels = std::make_shared<StreamBufferLevels>(2);
+    levels->track(0, BufferWatermarks { 100, 300 });
+    levels->track(1, BufferWatermarks { 100, 300 });
+    Scheduler scheduler;
+    scheduler.reset(levels, false);
+    bool video_full = true;
+    Scheduler::Sink sink = [&video_full](TestPacket& packet) {
+        return packet.stream == 0 && video_full ? SinkResult::kFull : SinkResult::kAccepted;
+    };
+
+    size_t reads = 0;
+    while (scheduler.next(sink).kind == Decision::kRead) {
+        TestPacket video = packet_of(0);
+        ASSERT_TRUE(scheduler.deliver(video, 0, video.bytes, sink));
+        ASSERT_LT(++reads, 10000U);
+    }
+    EXPECT_EQ(scheduler.parked_packets(), Scheduler::kMaxParkedPackets);
+
+    // 队列腾出空位之后暂存的包按顺序放进去，接着读
+    video_full = false;
+    EXPECT_EQ(scheduler.next(sink).kind, Decision::kRead);
+    EXPECT_EQ(scheduler.parked_packets(), 0U);
+
+    // 都补到高水位之后等
+    levels->on_push(0, 300);
+    levels->on_push(1, 300);
+    EXPECT_EQ(scheduler.next(sink).kind, Decision::kWait);
+}
+
+TEST(DemuxSchedulerTest, ClosedSinkStopsDelivery)
+{
+    Scheduler scheduler;
+    scheduler.reset(nullptr, false);
+    Scheduler::Sink sink = [](TestPacket&) { return SinkResult::kClosed; };
+    TestPacket packet = packet_of(0);
+    EXPECT_FALSE(scheduler.deliver(packet, 0, packet.bytes, sink));
+}
+
+// 合成的音视频交错文件 + 真实的包队列 + 解码慢一倍的视频消费者 + 实时消费的音频，时间加速 kSpeedup 倍。
+// 音频在开始播放之后一次都不能断
+namespace {
+
+constexpr int kVideo = 0;
+constexpr int kAudio = 1;
+constexpr int kSpeedup = 10;
+constexpr int64_t kMediaUs = 8000000;
+constexpr int64_t kVideoFrameUs = 33333;
+constexpr int64_t kAudioFrameUs = 21333; // 1024 samples @ 48 kHz
+constexpr size_t kVideoQueuePackets = 60; // 2 秒
+constexpr size_t kAudioQueuePackets = 600;
+
+enum class Mode {
+    kBlockingPush, // 原来的解复用：按文件顺序读，队列满了就阻塞在 push 上
+    kInterleaved, // av_read_frame：只有一个读位置，满了的流暂存
+    kPerStream, // Mp4SampleReader：每个流有自己的读位置
+};
+
+std::chrono::microseconds wall(int64_t media_us)
+{
+    return std::chrono::microseconds(media_us / kSpeedup);
+}
+
+class SyntheticSource {
+public:
+    SyntheticSource()
+    {
+        for (int64_t t = 0; t < kMediaUs; t += kVideoFrameUs) {
+            streams_[kVideo].push_back({ kVideo, t, kVideoFrameUs, 20000 });
+        }
+        for (int64_t t = 0; t < kMediaUs; t += kAudioFrameUs) {
+            streams_[kAudio].push_back({ kAudio, t, kAudioFrameUs, 400 });
+        }
+    }
+
+    size_t count(int stream) const { return streams_[stream].size(); }
+
+    // 按 dts 交错，同 av_read_frame
+    bool read(TestPacket& packet)
+    {
+        int best = -1;
+        for (int s : { kVideo, kAudio }) {
+            if (next_[s] < streams_[s].size()
+                && (best < 0 || streams_[s][next_[s]].dts_us < streams_[best][next_[best]].dts_us)) {
+                best = s;
+            }
+        }
+        return best >= 0 && read(best, packet);
+    }
+
+    bool read(int stream, TestPacket& packet)
+    {
+        if (next_[stream] >= streams_[stream].size()) {
+            return false;
+        }
+        packet = streams_[stream][next_[stream]++];
+        return true;
+    }
+
+private:
+    std::vector<TestPacket> streams_[2];
+    size_t next_[2] = { 0, 0 };
+};
+
+struct PlaybackResult {
+    int audio_underruns = 0;
+    size_t max_parked = 0;
+};
+
+PlaybackResult play(Mode mode)
+{
+    SyntheticSource source;
+    SemQueue<TestPacket> video_queue(kVideoQueuePackets);
+    SemQueue<TestPacket> audio_queue(kAudioQueuePackets);
+    SemQueue<TestPacket>* queues[2] = { &video_queue, &audio_queue };
+
+    auto levels = std::make_shared<StreamBufferLevels>(2);
+    levels->track(kVideo, BufferWatermarks { 1000000, 4000000 });
+    levels->track(kAudio, BufferWatermarks { 500000, 1500000 });
+
+    // 和 Demuxer::Wake() / run_scheduled() 一样的唤醒方式
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool wake_requested = false;
+    std::atomic<bool> stop { false };
+    auto wake = [&] {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            wake_requested = true;
+        }
+        cv.notify_one();
+    };
+    levels->set_on_refill(wake);
+    const size_t capacities[2] = { kVideoQueuePackets, kAudioQueuePackets };
+    for (int s : { kVideo, kAudio }) {
+        queues[s]->set_on_writable(wake, capacities[s] / 2);
+        queues[s]->set_on_pop([&levels](const TestPacket& p) { levels->on_pop(p.stream, p.duration_us); });
+    }
+
+    PlaybackResult result;
+    std::thread demux([&] {
+        if (mode == Mode::kBlockingPush) {
+            TestPacket packet;
+            while (!stop.load() && source.read(packet)) {
+                const TestPacket copy = packet;
+                if (!queues[packet.stream]->push(std::move(packet))) {
+                    return;
+                }
+                levels->on_push(copy.stream, copy.duration_us);
+            }
+            return;
+        }
+        Scheduler scheduler;
+        scheduler.reset(levels, mode == Mode::kPerStream);
+        Scheduler::Sink sink = [&](TestPacket& packet) {
+            const TestPacket copy = packet;
+            SemQueue<TestPacket>* queue = queues[packet.stream];
+            if (queue->try_push(packet)) {
+                levels->on_push(copy.stream, copy.duration_us);
+                return SinkResult::kAccepted;
+            }
+            return queue->is_shutdown() ? SinkResult::kClosed : SinkResult::kFull;
+        };
+        while (!stop.load()) {
+            const Decision d = scheduler.next(sink);
+            result.max_parked = std::max(result.max_parked, scheduler.parked_packets());
+            if (d.kind == Decision::kClosed || d.kind == Decision::kEnd) {
+                return;
+            }
+            if (d.kind == Decision::kWait) {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait_for(lock, std::chrono::milliseconds(50), [&] { return wake_requested || stop.load(); });
+                wake_requested = false;
+                continue;
+            }
+            TestPacket packet;
+            if (!(d.stream >= 0 ? source.read(d.stream, packet) : source.read(packet))) {
+                d.stream >= 0 ? scheduler.stream_ended(d.stream) : scheduler.input_ended();
+                continue;
+            }
+            const int stream = packet.stream;
+            const size_t bytes = packet.bytes;
+            if (!scheduler.deliver(packet, stream, bytes, sink)) {
+                return;
+            }
+        }
+    });
+
+    // 视频解码跟不上：每帧花两倍帧时长
+    std::thread video([&] {
+        TestPacket packet;
+        while (video_queue.wait_and_pop(packet)) {
+            std::this_thread::sleep_for(wall(2 * kVideoFrameUs));
+        }
+    });
+
+    // 音频按播放速度取包，先缓冲到低水位再开始播
+    const size_t audio_packets = source.count(kAudio);
+    while (levels->level(kAudio).buffered_us < 500000) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto deadline = std::chrono::steady_clock::now();
+    for (size_t played = 0; played < audio_packets; ++played) {
+        TestPacket packet;
+        if (!audio_queue.try_pop(packet)) {
+            ++result.audio_underruns;
+            if (!audio_queue.wait_and_pop(packet)) {
+                break;
+            }
+            deadline = std::chrono::steady_clock::now();
+        }
+        deadline += wall(packet.duration_us);
+        std::this_thread::sleep_until(deadline);
+    }
+
+    stop.store(true);
+    video_queue.shutdown();
+    audio_queue.shutdown();
+    wake();
+    demux.join();
+    video.join();
+    return result;
+}
+
+} // namespace
+
+TEST(DemuxSchedulerStressTest, BlockingPushStarvesAudioBehindSlowVideo)
+{
+    // 对照组：说明下面两个测试确实压到了队头阻塞
+    EXPECT_GT(play(Mode::kBlockingPush).audio_underruns, 0);
+}
+
+TEST(DemuxSchedulerStressTest, InterleavedReadsKeepAudioFed)
+{
+    const PlaybackResult result = play(Mode::kInterleaved);
+    EXPECT_EQ(result.audio_underruns, 0);
+    EXPECT_LE(result.max_parked, Scheduler::kMaxParkedPackets);
+}
+
+TEST(DemuxSchedulerStressTest, PerStreamReadsKeepAudioFed)
+{
+    const PlaybackResult result = play(Mode::kPerStream);
+    EXPECT_EQ(result.audio_underruns, 0);
+    EXPECT_EQ(result.max_parked, 1U);
+}
@@ -0,0 +1,83 @@
+// test_frame_skip_policy.cc
+#include "FrameSkipPolicy.hpp"
+#include <gtest/gtest.h>
+
+using player_utils::FrameSkipPolicy;
+using player_utils::VideoLateness;
+
+TEST(VideoLatenessTest, ClampsEarlyFramesToZero)
+{
+    VideoLateness lateness;
+    lateness.publish(0.12);
+    EXPECT_DOUBLE_EQ(lateness.get(), 0.12);
+    lateness.publish(-0.03); // 视频比音频早
+    EXPECT_DOUBLE_EQ(lateness.get(), 0.0);
+}
+
+TEST(FrameSkipPolicyTest, EscalatesStraightToTheMatchingLevel)
+{
+    FrameSkipPolicy policy;
+    EXPECT_EQ(policy.update(0.02, false), FrameSkipPolicy::kNone);
+    EXPECT_EQ(policy.update(0.08, false), FrameSkipPolicy::kNonRef);
+    EXPECT_EQ(policy.update(0.40, false), FrameSkipPolicy::kNonKey);
+    EXPECT_EQ(policy.escalations(), 2U);
+}
+
+TEST(FrameSkipPolicyTest, DeescalatesOneLevelAfterStayingCalm)
+{
+    FrameSkipPolicy policy(3);
+    policy.update(0.20, false);
+    ASSERT_EQ(policy.level(), FrameSkipPolicy::kBidir);
+
+    // 0.1 低于 kBidir 的阈值但没低于一半：保持
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(policy.update(0.10, false), FrameSkipPolicy::kBidir);
+    }
+    // 连续 3 个包低于一半才降一档，从 kBidir 往下降还要等到关键帧
+    EXPECT_EQ(policy.update(0.05, false), FrameSkipPolicy::kBidir);
+    EXPECT_EQ(policy.update(0.05, false), FrameSkipPolicy::kBidir);
+    EXPECT_EQ(policy.update(0.05, true), FrameSkipPolicy::kNonRef);
+    // 中间有一个包又落后了，重新计数
+    EXPECT_EQ(policy.update(0.0, false), FrameSkipPolicy::kNonRef);
+    EXPECT_EQ(policy.update(0.05, false), FrameSkipPolicy::kNonRef);
+    EXPECT_EQ(policy.update(0.0, false), FrameSkipPolicy::kNonRef);
+    EXPECT_EQ(policy.update(0.0, false), FrameSkipPolicy::kNonRef);
+    EXPECT_EQ(policy.update(0.0, false), FrameSkipPolicy::kNone);
+}
+
+TEST(FrameSkipPolicyTest, LeavesKeyframeOnlyModeOnAKeyframe)
+{
+    FrameSkipPolicy policy(2);
+    policy.update(0.5, false);
+    ASSERT_EQ(policy.level(), FrameSkipPolicy::kNonKey);
+
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_EQ(policy.update(0.0, false), FrameSkipPolicy::kNonKey);
+    }
+    EXPECT_EQ(policy.update(0.0, true), FrameSkipPolicy::kBidir);
+}
+
+TEST(FrameSkipPolicyTest, LeavesBidirModeOnAKeyframe)
+{
+    // kBidir 跳过了参考 B 帧，GOP 中途降到 kNonRef 的话后面的帧会引用没解过的帧
+    FrameSkipPolicy policy(2);
+    policy.update(0.20, false);
+    ASSERT_EQ(policy.level(), FrameSkipPolicy::kBidir);
+
+    for (int i = 0; i < 20; ++i) {
+        EXPECT_EQ(policy.update(0.0, false), FrameSkipPolicy::kBidir);
+    }
+    EXPECT_EQ(policy.update(0.0, true), FrameSkipPolicy::kNonRef);
+    // kNonRef 跳过的帧没有被引用，降到 kNone 不用等关键帧
+    EXPECT_EQ(policy.update(0.0, false), FrameSkipPolicy::kNonRef);
+    EXPECT_EQ(policy.update(0.0, false), FrameSkipPolicy::kNone);
+}
+
+TEST(FrameSkipPolicyTest, ResetDropsBackToNone)
+{
+    FrameSkipPolicy policy;
+    policy.update(0.5, false);
+    policy.reset();
+    EXPECT_EQ(policy.level(), FrameSkipPolicy::kNone);
+    EXPECT_EQ(policy.update(0.0, false), FrameSkipPolicy::kNone);
+}
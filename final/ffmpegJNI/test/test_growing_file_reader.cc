@@ -0,0 +1,189 @@
+// test_growing_file_reader.cc
+#include "GrowingFileReader.hpp"
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using player_utils::GrowingFileReader;
+using player_utils::LiveOptions;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+class GrowingFileReaderTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        char path[] = "/tmp/growing_file_reader_XXXXXX";
+        const int fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        close(fd);
+        path_ = path;
+    }
+
+    void TearDown() override { std::remove(path_.c_str()); }
+
+    // 像录制进程一样每次打开、追加、关闭
+    void append(const std::string& data) const
+    {
+        const int fd = ::open(path_.c_str(), O_WRONLY | O_APPEND);
+        ASSERT_GE(fd, 0);
+        ASSERT_EQ(write(fd, data.data(), data.size()), static_cast<ssize_t>(data.size()));
+        close(fd);
+    }
+
+    std::unique_ptr<GrowingFileReader> open_reader(int idle_timeout_ms) const
+    {
+        LiveOptions options;
+        options.enabled = true;
+        options.poll_interval_ms = 20;
+        options.idle_timeout_ms = idle_timeout_ms;
+        return GrowingFileReader::open(path_, options);
+    }
+
+    static std::string read_some(GrowingFileReader& reader, size_t len = 64)
+    {
+        std::string out(len, '\0');
+        const int64_t n = reader.read(reinterpret_cast<uint8_t*>(&out[0]), len);
+        out.resize(n > 0 ? static_cast<size_t>(n) : 0);
+        return out;
+    }
+
+    std::string path_;
+};
+
+} // namespace
+
+TEST_F(GrowingFileReaderTest, WaitsForAppendedData)
+{
+    append("abc");
+    auto reader = open_reader(5000);
+    ASSERT_NE(reader, nullptr);
+    EXPECT_EQ(read_some(*reader), "abc");
+    EXPECT_TRUE(reader->at_write_head());
+
+    std::thread writer([this] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        append("defg");
+    });
+    const auto start = Clock::now();
+    EXPECT_EQ(read_some(*reader), "defg");
+    EXPECT_GE(Clock::now() - start, std::chrono::milliseconds(40));
+    writer.join();
+    EXPECT_EQ(reader->size(), 7);
+    EXPECT_EQ(reader->stats().waits, 1U);
+    EXPECT_EQ(reader->stats().bytes_read, 7U);
+}
+
+TEST_F(GrowingFileReaderTest, EndsAfterIdleTimeout)
+{
+    append("abc");
+    auto reader = open_reader(100);
+    ASSERT_NE(reader, nullptr);
+    EXPECT_EQ(read_some(*reader), "abc");
+    const auto start = Clock::now();
+    uint8_t byte = 0;
+    EXPECT_EQ(reader->read(&byte, 1), 0);
+    EXPECT_GE(Clock::now() - start, std::chrono::milliseconds(50));
+    EXPECT_TRUE(reader->finished());
+}
+
+TEST_F(GrowingFileReaderTest, InterruptUnblocksRead)
+{
+    append("abc");
+    auto reader = open_reader(0);
+    ASSERT_NE(reader, nullptr);
+    EXPECT_EQ(read_some(*reader), "abc");
+
+    std::thread stopper([&reader] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        reader->interrupt(true);
+    });
+    uint8_t byte = 0;
+    EXPECT_EQ(reader->read(&byte, 1), -EINTR);
+    stopper.join();
+
+    // 恢复之后接着等
+    reader->interrupt(false);
+    append("d");
+    EXPECT_EQ(read_some(*reader), "d");
+}
+
+TEST_F(GrowingFileReaderTest, SeeksPastWriteHead)
+{
+    append("0123");
+    auto reader = open_reader(5000);
+    ASSERT_NE(reader, nullptr);
+    ASSERT_EQ(reader->seek(6), 6);
+    EXPECT_TRUE(reader->at_write_head());
+    std::thread writer([this] {
+        append("45");
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        append("6789");
+    });
+    EXPECT_EQ(read_some(*reader), "6789");
+    writer.join();
+    ASSERT_EQ(reader->seek(0), 0);
+    EXPECT_FALSE(reader->at_write_head());
+    EXPECT_EQ(read_some(*reader), "0123456789");
+}
+
+// 另一个进程按分片追加，读的一方从头读到录制结束，内容和写进去的一样
+TEST_F(GrowingFileReaderTest, FollowsWriterProcess)
+{
+    constexpr int kFragments = 20;
+    auto fragment = [](int i) { return std::string(static_cast<size_t>(1000 + 37 * i), static_cast<char>('a' + i)); };
+    std::string expected;
+    for (int i = 0; i < kFragments; ++i) {
+        expected += fragment(i);
+    }
+
+    auto reader = open_reader(300);
+    ASSERT_NE(reader, nullptr);
+    const pid_t child = fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        for (int i = 0; i < kFragments; ++i) {
+            const std::string data = fragment(i);
+            const int fd = ::open(path_.c_str(), O_WRONLY | O_APPEND);
+            // 一个分片分两次写，读的一方会碰到写了一半的分片
+            const size_t half = data.size() / 2;
+            if (fd < 0 || write(fd, data.data(), half) != static_cast<ssize_t>(half)) {
+                _exit(1);
+            }
+            usleep(2000);
+            if (write(fd, data.data() + half, data.size() - half) != static_cast<ssize_t>(data.size() - half)) {
+                _exit(1);
+            }
+            close(fd);
+            usleep(10000);
+        }
+        _exit(0);
+    }
+
+    std::string got;
+    std::vector<uint8_t> buffer(700);
+    while (true) {
+        const int64_t n = reader->read(buffer.data(), buffer.size());
+        ASSERT_GE(n, 0);
+        if (n == 0) {
+            break;
+        }
+        got.append(reinterpret_cast<const char*>(buffer.data()), static_cast<size_t>(n));
+    }
+    int status = 0;
+    ASSERT_EQ(waitpid(child, &status, 0), child);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    EXPECT_EQ(got, expected);
+    EXPECT_GT(reader->stats().waits, 0U);
+}
@@ -0,0 +1,144 @@
+// test_keyframe_index.cc
+#include "KeyframeIndex.hpp"
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using player_utils::KeyframeIndex;
+
+namespace {
+constexpr int64_t kMtime = 1700000000123456789LL;
+
+// 25fps，time_base 1/12800（每帧 512），GOP 50 帧 = 2 秒，故意乱序传入
+KeyframeIndex make_index()
+{
+    std::vector<KeyframeIndex::Entry> entries = {
+        { 2 * 25600, 3000, 50 },
+        { 0, 48, 50 },
+        { 25600, 1500, 50 },
+        { 3 * 25600, 4500, 20 },
+    };
+    return KeyframeIndex(std::move(entries), 1, 12800);
+}
+} // namespace
+
+TEST(KeyframeIndexTest, SortsEntriesAndFindsNeighbours)
+{
+    const KeyframeIndex index = make_index();
+    ASSERT_EQ(index.size(), 4U);
+    EXPECT_EQ(index.entries().front().pts, 0);
+    EXPECT_EQ(index.entries().back().pts, 3 * 25600);
+
+    ASSERT_NE(index.at_or_before(30000), nullptr);
+    EXPECT_EQ(index.at_or_before(30000)->pts, 25600);
+    EXPECT_EQ(index.at_or_before(25600)->pts, 25600);
+    EXPECT_EQ(index.at_or_before(-1), nullptr);
+
+    ASSERT_NE(index.at_or_after(30000), nullptr);
+    EXPECT_EQ(index.at_or_after(30000)->pts, 2 * 25600);
+    EXPECT_EQ(index.at_or_after(25600)->pts, 25600);
+    EXPECT_EQ(index.at_or_after(4 * 25600), nullptr);
+}
+
+TEST(KeyframeIndexTest, SnapsToNearestKeyframe)
+{
+    const KeyframeIndex index = make_index();
+    EXPECT_DOUBLE_EQ(index.snap(2.9), 2.0);
+    EXPECT_DOUBLE_EQ(index.snap(3.1), 4.0);
+    EXPECT_DOUBLE_EQ(index.snap(100.0), 6.0);
+    EXPECT_DOUBLE_EQ(KeyframeIndex().snap(1.5), 1.5);
+}
+
+TEST(KeyframeIndexTest, EstimatesCatchUpFrames)
+{
+    const KeyframeIndex index = make_index();
+    EXPECT_EQ(index.catch_up_frames(25600), 0);
+    // GOP 中间：50 帧的一半
+    EXPECT_EQ(index.catch_up_frames(25600 + 12800), 25);
+    // 最后一个 GOP 之后没有下一个关键帧，按整个 GOP 算
+    EXPECT_EQ(index.catch_up_frames(3 * 25600 + 512), 19);
+    EXPECT_EQ(index.catch_up_frames(-1), -1);
+
+    KeyframeIndex unknown({ { 0, -1, 0 } }, 1, 1000);
+    EXPECT_EQ(unknown.catch_up_frames(500), -1);
+}
+
+TEST(KeyframeIndexTest, BuilderCountsGopFrames)
+{
+    KeyframeIndex::Builder builder(false);
+    builder.add(-512, 10, false); // 第一个关键帧之前的样本不属于任何 GOP
+    for (int i = 0; i < 10; ++i) {
+        builder.add(i * 512, 100 + i, i % 4 == 0);
+    }
+    const KeyframeIndex index = builder.build(1, 12800);
+    ASSERT_EQ(index.size(), 3U);
+    EXPECT_EQ(index.entries()[0].frames, 4);
+    EXPECT_EQ(index.entries()[1].frames, 4);
+    EXPECT_EQ(index.entries()[2].frames, 2);
+    EXPECT_EQ(index.catch_up_frames(2 * 512), 2);
+}
+
+// 只有关键帧的索引：GOP 帧数未知，不能当成全 I 帧（那样 catch_up_frames 为 0，精确 seek 被跳过）
+TEST(KeyframeIndexTest, KeyframeOnlyIndexLeavesGopSizeUnknown)
+{
+    KeyframeIndex::Builder from_index(false);
+    for (int i = 0; i < 4; ++i) {
+        from_index.add(i * 25600, 1000 * i, true);
+    }
+    const KeyframeIndex index = from_index.build(1, 12800);
+    ASSERT_EQ(index.size(), 4U);
+    for (const auto& e : index.entries()) {
+        EXPECT_EQ(e.frames, 0);
+    }
+    EXPECT_EQ(index.catch_up_frames(25600 + 12800), -1);
+
+    // 扫包得到的是每一个样本，全是关键帧就真的是全 I 帧，不用追帧
+    KeyframeIndex::Builder from_scan(true);
+    for (int i = 0; i < 4; ++i) {
+        from_scan.add(i * 512, 1000 * i, true);
+    }
+    const KeyframeIndex intra = from_scan.build(1, 12800);
+    EXPECT_EQ(intra.entries()[1].frames, 1);
+    EXPECT_EQ(intra.catch_up_frames(512 + 100), 0);
+}
+
+TEST(KeyframeIndexTest, SidecarRoundTrip)
+{
+    const KeyframeIndex index = make_index();
+    std::stringstream buffer;
+    ASSERT_TRUE(index.save(buffer, 123456, kMtime));
+
+    KeyframeIndex loaded;
+    ASSERT_TRUE(KeyframeIndex::load(buffer, 123456, kMtime, loaded));
+    ASSERT_EQ(loaded.size(), index.size());
+    for (size_t i = 0; i < index.size(); ++i) {
+        EXPECT_EQ(loaded.entries()[i].pts, index.entries()[i].pts);
+        EXPECT_EQ(loaded.entries()[i].pos, index.entries()[i].pos);
+        EXPECT_EQ(loaded.entries()[i].frames, index.entries()[i].frames);
+    }
+    EXPECT_DOUBLE_EQ(loaded.to_seconds(25600), 2.0);
+}
+
+TEST(KeyframeIndexTest, RejectsStaleOrCorruptSidecar)
+{
+    const KeyframeIndex index = make_index();
+    std::stringstream buffer;
+    ASSERT_TRUE(index.save(buffer, 123456, kMtime));
+    const std::string bytes = buffer.str();
+
+    KeyframeIndex loaded;
+    // 源文件大小变了
+    std::stringstream stale(bytes);
+    EXPECT_FALSE(KeyframeIndex::load(stale, 654321, kMtime, loaded));
+    // 大小没变，但是被改写过
+    std::stringstream rewritten(bytes);
+    EXPECT_FALSE(KeyframeIndex::load(rewritten, 123456, kMtime + 1, loaded));
+    // 文件被截断
+    std::stringstream truncated(bytes.substr(0, bytes.size() - 3));
+    EXPECT_FALSE(KeyframeIndex::load(truncated, 123456, kMtime, loaded));
+    // 不是关键帧表
+    std::stringstream garbage(std::string(64, 'x'));
+    EXPECT_FALSE(KeyframeIndex::load(garbage, 123456, kMtime, loaded));
+    EXPECT_TRUE(loaded.empty());
+}
@@ -0,0 +1,97 @@
+// test_live_latency.cc
+#include "LiveLatency.hpp"
+#include <gtest/gtest.h>
+
+using player_utils::LiveLatency;
+using player_utils::LiveOptions;
+
+namespace {
+
+LiveOptions live_options()
+{
+    LiveOptions options;
+    options.enabled = true;
+    options.target_latency_ms = 2000;
+    options.max_latency_ms = 6000;
+    return options;
+}
+
+} // namespace
+
+TEST(LiveLatencyTest, NoControlWithoutWriteHead)
+{
+    LiveLatency latency(live_options(), true);
+    latency.update(-1.0, 0.0);
+    EXPECT_FALSE(latency.should_drop(true, true, 0.0));
+    EXPECT_FALSE(latency.should_drop(false, false, 0.0));
+
+    LiveOptions off = live_options();
+    off.enabled = false;
+    LiveLatency disabled(off, true);
+    disabled.update(100.0, 0.0);
+    EXPECT_FALSE(disabled.should_drop(true, true, 0.0));
+    EXPECT_EQ(disabled.catch_ups(), 0U);
+}
+
+TEST(LiveLatencyTest, CatchesUpToKeyframeNearTarget)
+{
+    LiveLatency latency(live_options(), true);
+    // 写到了 20 秒，队列里缓冲了 1 秒：读到 0 秒时落后 21 秒
+    latency.update(20.0, 1.0);
+    EXPECT_TRUE(latency.should_drop(true, true, 0.0));
+    EXPECT_NEAR(latency.latency_sec(), 21.0, 1e-9);
+    EXPECT_TRUE(latency.catching_up());
+    EXPECT_EQ(latency.catch_ups(), 1U);
+
+    EXPECT_TRUE(latency.should_drop(true, false, 10.0));
+    EXPECT_TRUE(latency.should_drop(false, false, 17.0));
+    // 关键帧，但还没到 写入位置 - 2 秒
+    EXPECT_TRUE(latency.should_drop(true, true, 17.5));
+    EXPECT_TRUE(latency.should_drop(true, false, 18.1));
+    EXPECT_FALSE(latency.should_drop(true, true, 18.5));
+    EXPECT_FALSE(latency.catching_up());
+    // 关键帧之后读到的、时刻在它之前的音频包也丢掉，之后照常
+    EXPECT_TRUE(latency.should_drop(false, false, 18.2));
+    EXPECT_FALSE(latency.should_drop(false, false, 18.6));
+    EXPECT_FALSE(latency.should_drop(true, false, 18.54));
+    EXPECT_FALSE(latency.should_drop(false, false, 18.3));
+    EXPECT_NEAR(latency.latency_sec(), 20.0 - 18.3 + 1.0, 1e-9);
+    EXPECT_EQ(latency.catch_ups(), 1U);
+}
+
+TEST(LiveLatencyTest, AudioOnlyResumesAtFirstReachablePacket)
+{
+    LiveLatency latency(live_options(), false);
+    latency.update(30.0, 0.0);
+    EXPECT_TRUE(latency.should_drop(false, false, 1.0));
+    EXPECT_TRUE(latency.should_drop(false, false, 27.9));
+    EXPECT_FALSE(latency.should_drop(false, false, 28.0));
+    EXPECT_FALSE(latency.should_drop(false, false, 28.02));
+}
+
+TEST(LiveLatencyTest, StaysWithinBoundWhileKeepingUp)
+{
+    LiveLatency latency(live_options(), true);
+    // 写入位置每次往前 0.5 秒，解复用紧跟在后面 3 秒
+    for (int i = 0; i < 100; ++i) {
+        const double edge = 10.0 + 0.5 * i;
+        latency.update(edge, 1.0);
+        EXPECT_FALSE(latency.should_drop(true, i % 4 == 0, edge - 3.0));
+    }
+    EXPECT_EQ(latency.catch_ups(), 0U);
+}
+
+TEST(LiveLatencyTest, SeekBackSuspendsUntilCaughtUp)
+{
+    LiveLatency latency(live_options(), true);
+    latency.update(100.0, 0.0);
+    latency.on_seek();
+    // 时移回 10 秒：落后 90 秒也不追
+    EXPECT_FALSE(latency.should_drop(true, true, 10.0));
+    EXPECT_FALSE(latency.should_drop(true, false, 60.0));
+    // 赶到目标延迟以内之后恢复控制
+    EXPECT_FALSE(latency.should_drop(true, false, 98.5));
+    latency.update(110.0, 0.0);
+    EXPECT_TRUE(latency.should_drop(true, false, 99.0));
+    EXPECT_EQ(latency.catch_ups(), 1U);
+}
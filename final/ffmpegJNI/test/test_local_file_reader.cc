@@ -0,0 +1,154 @@
+// test_local_file_reader.cc
+#include "LocalFileReader.hpp"
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using player_utils::FileIoOptions;
+using player_utils::LocalFileReader;
+
+namespace {
+
+class LocalFileReaderTest : public ::testing::TestWithParam<FileIoOptions::Mode> {
+protected:
+    void SetUp() override
+    {
+        char path[] = "/tmp/local_file_reader_XXXXXX";
+        const int fd = mkstemp(path);
+        ASSERT_GE(fd, 0);
+        path_ = path;
+        // 故意不是块大小的整数倍
+        content_.resize(5 * kChunk + 123);
+        std::mt19937 rng(42);
+        for (auto& b : content_) {
+            b = static_cast<uint8_t>(rng());
+        }
+        ASSERT_EQ(write(fd, content_.data(), content_.size()), static_cast<ssize_t>(content_.size()));
+        close(fd);
+    }
+
+    void TearDown() override { std::remove(path_.c_str()); }
+
+    std::unique_ptr<LocalFileReader> open_reader(size_t chunks = 3)
+    {
+        FileIoOptions options;
+        options.mode = GetParam();
+        options.chunk_size = kChunk;
+        options.chunks = chunks;
+        return LocalFileReader::open(path_, options);
+    }
+
+    // 从当前位置读 len 字节（可能分好几次），和文件内容比较
+    void expect_read(LocalFileReader& reader, size_t len)
+    {
+        const int64_t start = reader.position();
+        std::vector<uint8_t> buffer(len);
+        size_t got = 0;
+        while (got < len) {
+            const int64_t n = reader.read(buffer.data() + got, len - got);
+            ASSERT_GT(n, 0) << "at " << start + static_cast<int64_t>(got);
+            got += static_cast<size_t>(n);
+        }
+        ASSERT_TRUE(std::equal(buffer.begin(), buffer.end(), content_.begin() + start)) << "at " << start;
+    }
+
+    static constexpr size_t kChunk = 4096;
+    std::string path_;
+    std::vector<uint8_t> content_;
+};
+
+} // namespace
+
+TEST_P(LocalFileReaderTest, ReadsWholeFileSequentially)
+{
+    auto reader = open_reader();
+    ASSERT_NE(reader, nullptr);
+    EXPECT_EQ(reader->size(), static_cast<int64_t>(content_.size()));
+
+    // 和 AVIOContext 一样按小块读，跨块边界
+    std::vector<uint8_t> out;
+    uint8_t buffer[1000];
+    while (true) {
+        const int64_t n = reader->read(buffer, sizeof(buffer));
+        ASSERT_GE(n, 0);
+        if (n == 0) {
+            break;
+        }
+        out.insert(out.end(), buffer, buffer + n);
+    }
+    EXPECT_EQ(out, content_);
+    EXPECT_EQ(reader->read(buffer, sizeof(buffer)), 0);
+    EXPECT_EQ(reader->stats().bytes_read, content_.size());
+}
+
+TEST_P(LocalFileReaderTest, SeeksInsideAndOutsideTheWindow)
+{
+    auto reader = open_reader(2);
+    ASSERT_NE(reader, nullptr);
+    expect_read(*reader, 100);
+
+    // 窗口里往前跳
+    ASSERT_EQ(reader->seek(kChunk + 7), static_cast<int64_t>(kChunk + 7));
+    expect_read(*reader, 2 * kChunk);
+    // 往回 seek 到已经被覆盖的块
+    ASSERT_EQ(reader->seek(10), 10);
+    expect_read(*reader, 500);
+    // 跳到窗口之外，一直读到文件末尾
+    ASSERT_EQ(reader->seek(4 * kChunk + 1), static_cast<int64_t>(4 * kChunk + 1));
+    expect_read(*reader, content_.size() - (4 * kChunk + 1));
+    uint8_t byte = 0;
+    EXPECT_EQ(reader->read(&byte, 1), 0);
+    EXPECT_GT(reader->stats().refills, 0U);
+
+    // 文件末尾之后读不到东西，再 seek 回来还能读
+    ASSERT_EQ(reader->seek(content_.size() + 10), static_cast<int64_t>(content_.size() + 10));
+    EXPECT_EQ(reader->read(&byte, 1), 0);
+    ASSERT_EQ(reader->seek(3), 3);
+    expect_read(*reader, 10);
+    EXPECT_EQ(reader->seek(-1), -EINVAL);
+}
+
+TEST_P(LocalFileReaderTest, RandomSeeksReturnFileContents)
+{
+    auto reader = open_reader();
+    ASSERT_NE(reader, nullptr);
+    std::mt19937 rng(7);
+    for (int i = 0; i < 300; ++i) {
+        const size_t pos = rng() % content_.size();
+        const size_t len = std::min<size_t>(1 + rng() % (2 * kChunk), content_.size() - pos);
+        ASSERT_EQ(reader->seek(static_cast<int64_t>(pos)), static_cast<int64_t>(pos));
+        expect_read(*reader, len);
+    }
+}
+
+TEST_P(LocalFileReaderTest, DestroyWhileReadAheadIsRunning)
+{
+    for (int i = 0; i < 20; ++i) {
+        auto reader = open_reader();
+        ASSERT_NE(reader, nullptr);
+        reader->seek(static_cast<int64_t>(i * 997 % content_.size()));
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Modes, LocalFileReaderTest,
+    ::testing::Values(FileIoOptions::Mode::Mmap, FileIoOptions::Mode::ReadAhead),
+    [](const ::testing::TestParamInfo<FileIoOptions::Mode>& info) {
+        return info.param == FileIoOptions::Mode::Mmap ? std::string("Mmap") : std::string("ReadAhead");
+    });
+
+TEST(LocalFileReaderOpenTest, DefaultModeAndMissingFileFallBack)
+{
+    FileIoOptions options;
+    EXPECT_EQ(LocalFileReader::open("/proc/self/status", options), nullptr);
+    options.mode = FileIoOptions::Mode::ReadAhead;
+    EXPECT_EQ(LocalFileReader::open("/nonexistent/file.mp4", options), nullptr);
+    // 不是普通文件（管道、设备）也交给 FFmpeg
+    EXPECT_EQ(LocalFileReader::open("/dev/null", options), nullptr);
+}
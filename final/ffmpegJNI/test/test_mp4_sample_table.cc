@@ -0,0 +1,470 @@
+// test_mp4_sample_table.cc
+#include "Mp4SampleTable.hpp"
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+using ffmpeg_utils::Mp4FragmentScanner;
+using ffmpeg_utils::Mp4SampleTable;
+
+namespace {
+
+using Bytes = std::vector<uint8_t>;
+
+void put(Bytes& out, uint64_t value, int bytes)
+{
+    for (int i = bytes - 1; i >= 0; --i) {
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+Bytes u32s(std::initializer_list<uint32_t> values)
+{
+    Bytes out;
+    for (uint32_t v : values) {
+        put(out, v, 4);
+    }
+    return out;
+}
+
+Bytes cat(std::initializer_list<Bytes> parts)
+{
+    Bytes out;
+    for (const Bytes& p : parts) {
+        out.insert(out.end(), p.begin(), p.end());
+    }
+    return out;
+}
+
+Bytes box(const char (&type)[5], const Bytes& payload)
+{
+    Bytes out;
+    put(out, payload.size() + 8, 4);
+    put(out, Mp4SampleTable::fourcc(type), 4);
+    out.insert(out.end(), payload.begin(), payload.end());
+    return out;
+}
+
+// version / flags 各占 1 / 3 字节的 full box
+Bytes full_box(const char (&type)[5], uint8_t version, const Bytes& payload)
+{
+    Bytes body = { version, 0, 0, 0 };
+    body.insert(body.end(), payload.begin(), payload.end());
+    return box(type, body);
+}
+
+Bytes mvhd(uint32_t timescale) { return full_box("mvhd", 0, u32s({ 0, 0, timescale, 0 })); }
+
+Bytes trak(uint32_t id, const char (&handler)[5], uint32_t timescale, const Bytes& stbl, const Bytes& edts = {})
+{
+    const Bytes tkhd = full_box("tkhd", 0, u32s({ 0, 0, id, 0, 0 }));
+    const Bytes mdhd = full_box("mdhd", 0, u32s({ 0, 0, timescale, 0, 0 }));
+    const Bytes hdlr = full_box("hdlr", 0, u32s({ 0, Mp4SampleTable::fourcc(handler), 0, 0, 0 }));
+    return box("trak", cat({ tkhd, edts, box("mdia", cat({ mdhd, hdlr, box("minf", box("stbl", stbl)) })) }));
+}
+
+// 视频：timescale 12800，6 帧每帧 512，IBBPBB 的 ctts（第一帧偏移 -512，制造负 ctts），关键帧 1、4，
+// stsc 两段：第 1 块 4 帧，之后每块 2 帧；stsz 逐帧给出；co64 给出块偏移
+Bytes video_stbl()
+{
+    return cat({
+        full_box("stts", 0, u32s({ 1, 6, 512 })),
+        full_box("ctts", 1, u32s({ 6, 1, static_cast<uint32_t>(-512), 1, 1024, 1, 0, 1, 1024, 1, 0, 1, 0 })),
+        full_box("stss", 0, u32s({ 2, 1, 4 })),
+        full_box("stsz", 0, u32s({ 0, 6, 100, 10, 20, 30, 40, 50 })),
+        full_box("stsc", 0, u32s({ 2, 1, 4, 1, 2, 2, 1 })),
+        full_box("co64", 0, cat({ u32s({ 2 }), u32s({ 0, 1000, 1, 0 }) })),
+    });
+}
+
+// 音频：timescale 48000，5 帧每帧 1024，没有 stss（全是关键帧），stz2 4 位宽，stco 每块一帧
+Bytes audio_stbl()
+{
+    Bytes stz2 = { 0, 0, 0, 4 };
+    put(stz2, 5, 4);
+    stz2.insert(stz2.end(), { 0x12, 0x34, 0x50 });
+    return cat({
+        full_box("stts", 0, u32s({ 1, 5, 1024 })),
+        full_box("stz2", 0, stz2),
+        full_box("stsc", 0, u32s({ 1, 1, 1, 1 })),
+        full_box("stco", 0, u32s({ 5, 2000, 2100, 2200, 2300, 2400 })),
+    });
+}
+
+Bytes moov(std::initializer_list<Bytes> traks)
+{
+    Bytes payload = mvhd(1000);
+    for (const Bytes& t : traks) {
+        payload.insert(payload.end(), t.begin(), t.end());
+    }
+    return payload;
+}
+
+bool parse(Mp4SampleTable& table, const Bytes& moov_payload, std::string* error = nullptr)
+{
+    return table.parse_moov(moov_payload.data(), moov_payload.size(), error);
+}
+
+} // namespace
+
+TEST(Mp4SampleTableTest, ExpandsVideoTables)
+{
+    Mp4SampleTable table;
+    std::string error;
+    ASSERT_TRUE(parse(table, moov({ trak(1, "vide", 12800, video_stbl()) }), &error)) << error;
+    const Mp4SampleTable::Track* track = table.find_track(1);
+    ASSERT_NE(track, nullptr);
+    EXPECT_TRUE(track->is_video());
+    EXPECT_EQ(track->timescale, 12800U);
+    EXPECT_EQ(track->max_sample_size, 100U);
+    ASSERT_EQ(track->samples.size(), 6U);
+
+    const std::vector<int64_t> offsets = { 1000, 1100, 1110, 1130, 1ULL << 32, (1ULL << 32) + 40 };
+    const std::vector<uint32_t> keys = { 1, 0, 0, 1, 0, 0 };
+    for (size_t i = 0; i < 6; ++i) {
+        const auto& s = track->samples[i];
+        EXPECT_EQ(s.offset, offsets[i]) << i;
+        EXPECT_EQ(s.flags & Mp4SampleTable::kKeyframe, keys[i]) << i;
+        EXPECT_EQ(s.duration, 512U);
+        // 负 ctts：dts 整体前移 512，pts 不变
+        EXPECT_EQ(s.dts, static_cast<int64_t>(i) * 512 - 512) << i;
+        EXPECT_GE(s.pts_offset, 0);
+    }
+    EXPECT_EQ(track->samples[0].dts + track->samples[0].pts_offset, -512);
+    EXPECT_EQ(track->samples[1].dts + track->samples[1].pts_offset, 1536);
+    EXPECT_EQ(track->samples[5].dts + track->samples[5].pts_offset, 2560);
+}
+
+TEST(Mp4SampleTableTest, ExpandsAudioTablesWithoutStss)
+{
+    Mp4SampleTable table;
+    std::string error;
+    ASSERT_TRUE(parse(table, moov({ trak(1, "vide", 12800, video_stbl()), trak(2, "soun", 48000, audio_stbl()) }), &error))
+        << error;
+    ASSERT_EQ(table.tracks().size(), 2U);
+    const Mp4SampleTable::Track* track = table.find_track(2);
+    ASSERT_NE(track, nullptr);
+    EXPECT_TRUE(track->is_audio());
+    ASSERT_EQ(track->samples.size(), 5U);
+    const std::vector<uint32_t> sizes = { 1, 2, 3, 4, 5 };
+    for (size_t i = 0; i < 5; ++i) {
+        EXPECT_EQ(track->samples[i].size, sizes[i]) << i;
+        EXPECT_EQ(track->samples[i].offset, 2000 + 100 * static_cast<int64_t>(i));
+        EXPECT_EQ(track->samples[i].dts, 1024 * static_cast<int64_t>(i));
+        EXPECT_EQ(track->samples[i].flags, static_cast<uint32_t>(Mp4SampleTable::kKeyframe));
+    }
+    EXPECT_EQ(table.find_track(3), nullptr);
+}
+
+TEST(Mp4SampleTableTest, AppliesEditList)
+{
+    // 空编辑 0.5 秒（movie timescale 1000）+ 从媒体时间 2048 开始播放：
+    // dts 平移 24000 - 2048，前两帧落在编辑之前，标记丢弃
+    Bytes elst = full_box("elst", 0, u32s({ 2, 500, static_cast<uint32_t>(-1), 0x00010000, 1000, 2048, 0x00010000 }));
+    Mp4SampleTable table;
+    std::string error;
+    ASSERT_TRUE(parse(table, moov({ trak(2, "soun", 48000, audio_stbl(), box("edts", elst)) }), &error)) << error;
+    const auto& samples = table.find_track(2)->samples;
+    EXPECT_EQ(samples[0].dts, 24000 - 2048);
+    EXPECT_EQ(samples[2].dts, 24000);
+    EXPECT_NE(samples[0].flags & Mp4SampleTable::kDiscard, 0U);
+    EXPECT_NE(samples[1].flags & Mp4SampleTable::kDiscard, 0U);
+    EXPECT_EQ(samples[2].flags & Mp4SampleTable::kDiscard, 0U);
+
+    // 多段编辑不支持
+    Bytes two_edits = full_box("elst", 0, u32s({ 2, 500, 0, 0x00010000, 500, 4096, 0x00010000 }));
+    EXPECT_FALSE(parse(table, moov({ trak(2, "soun", 48000, audio_stbl(), box("edts", two_edits)) }), &error));
+    EXPECT_NE(error.find("edit"), std::string::npos);
+}
+
+TEST(Mp4SampleTableTest, FindsSamplesAndKeyframes)
+{
+    Mp4SampleTable table;
+    ASSERT_TRUE(parse(table, moov({ trak(1, "vide", 12800, video_stbl()) })));
+    const Mp4SampleTable::Track& track = *table.find_track(1);
+    // dts: -512 0 512 1024 1536 2048
+    EXPECT_EQ(Mp4SampleTable::sample_at_or_before(track, -10000), 0U);
+    EXPECT_EQ(Mp4SampleTable::sample_at_or_before(track, 0), 1U);
+    EXPECT_EQ(Mp4SampleTable::sample_at_or_before(track, 1000), 2U);
+    EXPECT_EQ(Mp4SampleTable::sample_at_or_before(track, 1 << 20), 5U);
+    EXPECT_EQ(Mp4SampleTable::keyframe_at_or_before(track, 1000), 0U);
+    EXPECT_EQ(Mp4SampleTable::keyframe_at_or_before(track, 1024), 3U);
+    EXPECT_EQ(Mp4SampleTable::keyframe_at_or_before(track, 1 << 20), 3U);
+}
+
+TEST(Mp4SampleTableTest, RejectsUnsupportedOrBrokenMoov)
+{
+    Mp4SampleTable table;
+    std::string error;
+    // 分片 mp4：moov 里有 mvex，样本表是空的
+    const Bytes empty_stbl = cat({
+        full_box("stts", 0, u32s({ 0 })),
+        full_box("stsz", 0, u32s({ 0, 0 })),
+        full_box("stsc", 0, u32s({ 0 })),
+        full_box("stco", 0, u32s({ 0 })),
+    });
+    EXPECT_FALSE(parse(table, cat({ moov({ trak(1, "vide", 12800, empty_stbl) }), box("mvex", {}) }), &error));
+    EXPECT_FALSE(parse(table, moov({ trak(1, "vide", 12800, empty_stbl) }), &error));
+    EXPECT_FALSE(parse(table, mvhd(1000), &error));
+
+    // 每个截断位置都不能越界，也不能成功
+    const Bytes good = moov({ trak(1, "vide", 12800, video_stbl()) });
+    for (size_t cut = 0; cut < good.size(); cut += 3) {
+        const Bytes truncated(good.begin(), good.begin() + static_cast<std::ptrdiff_t>(cut));
+        EXPECT_FALSE(parse(table, truncated)) << "cut at " << cut;
+    }
+    // 失败不影响上一次成功解析的结果
+    ASSERT_TRUE(parse(table, good));
+    EXPECT_FALSE(parse(table, mvhd(1000)));
+    EXPECT_EQ(table.tracks().size(), 1U);
+}
+
+TEST(Mp4SampleTableTest, RejectsSampleCountTheTablesCannotBack)
+{
+    Mp4SampleTable table;
+    std::string error;
+    // stsz 只有 12 字节，却声称每个样本 100 字节、一共 2^24 个：stts / stsc 覆盖不到，不能按它申请样本数组
+    const uint32_t huge = 1U << 24;
+    const Bytes huge_stsz = full_box("stsz", 0, u32s({ 100, huge }));
+    const Bytes one_chunk = cat({ full_box("stsc", 0, u32s({ 1, 1, 5, 1 })), full_box("stco", 0, u32s({ 1, 1000 })) });
+    EXPECT_FALSE(parse(table, moov({ trak(1, "vide", 12800, cat({ full_box("stts", 0, u32s({ 1, 5, 512 })), huge_stsz, one_chunk })) }), &error));
+    EXPECT_EQ(error, "stts covers fewer samples than stsz");
+    EXPECT_FALSE(parse(table, moov({ trak(1, "vide", 12800, cat({ full_box("stts", 0, u32s({ 1, huge, 512 })), huge_stsz, one_chunk })) }), &error));
+    EXPECT_EQ(error, "stsc / stco cover fewer samples than stsz");
+
+    // 表都对得上，但样本加起来比文件还大
+    const Bytes huge_chunk = cat({ full_box("stsc", 0, u32s({ 1, 1, huge, 1 })), full_box("stco", 0, u32s({ 1, 1000 })) });
+    const Bytes huge_moov = moov({ trak(1, "vide", 12800, cat({ full_box("stts", 0, u32s({ 1, huge, 512 })), huge_stsz, huge_chunk })) });
+    EXPECT_FALSE(table.parse_moov(huge_moov.data(), huge_moov.size(), &error, 4096));
+    EXPECT_EQ(error, "stsz claims more data than the file holds");
+
+    // 逐帧给出大小时按总和算：video_stbl 一共 250 字节
+    const Bytes good = moov({ trak(1, "vide", 12800, video_stbl()) });
+    EXPECT_FALSE(table.parse_moov(good.data(), good.size(), &error, 249));
+    EXPECT_TRUE(table.parse_moov(good.data(), good.size(), &error, 250)) << error;
+}
+
+TEST(Mp4SampleTableTest, RejectsEditListThatOverflows)
+{
+    Mp4SampleTable table;
+    std::string error;
+    // version 1 的 elst 用 64 位时长 / 媒体时间：空编辑时长乘 timescale 溢出
+    Bytes empty_edit = u32s({ 2 });
+    put(empty_edit, INT64_MAX / 2, 8);
+    put(empty_edit, static_cast<uint64_t>(-1), 8);
+    put(empty_edit, 0x00010000, 4);
+    put(empty_edit, 1000, 8);
+    put(empty_edit, 0, 8);
+    put(empty_edit, 0x00010000, 4);
+    EXPECT_FALSE(parse(table, moov({ trak(2, "soun", 48000, audio_stbl(), box("edts", full_box("elst", 1, empty_edit))) }), &error));
+    EXPECT_EQ(error, "edit list out of range");
+
+    // 空编辑之后接一个接近 INT64_MIN 的媒体时间：平移量（轨道开始 - 媒体时间）溢出
+    Bytes media_edit = u32s({ 2 });
+    put(media_edit, 1000, 8);
+    put(media_edit, static_cast<uint64_t>(-1), 8);
+    put(media_edit, 0x00010000, 4);
+    put(media_edit, 1000, 8);
+    put(media_edit, static_cast<uint64_t>(INT64_MIN + 1), 8);
+    put(media_edit, 0x00010000, 4);
+    EXPECT_FALSE(parse(table, moov({ trak(2, "soun", 48000, audio_stbl(), box("edts", full_box("elst", 1, media_edit))) }), &error));
+    EXPECT_EQ(error, "edit list out of range");
+
+    // 平移量本身放得下（接近 INT64_MAX），平移之后的 dts 溢出
+    Bytes late_edit = u32s({ 1 });
+    put(late_edit, 1000, 8);
+    put(late_edit, static_cast<uint64_t>(INT64_MIN + 2), 8);
+    put(late_edit, 0x00010000, 4);
+    EXPECT_FALSE(parse(table, moov({ trak(2, "soun", 48000, audio_stbl(), box("edts", full_box("elst", 1, late_edit))) }), &error));
+    EXPECT_EQ(error, "edit list out of range");
+}
+
+TEST(Mp4SampleTableTest, ParsesFileWithLargeBoxes)
+{
+    char path[] = "/tmp/mp4_sample_table_XXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    // ftyp + 64 位长度的 mdat + moov
+    Bytes file = box("ftyp", u32s({ Mp4SampleTable::fourcc("isom"), 0 }));
+    put(file, 1, 4);
+    put(file, Mp4SampleTable::fourcc("mdat"), 4);
+    put(file, 16 + 32, 8);
+    file.resize(file.size() + 32, 0xAB);
+    const Bytes moov_box = box("moov", moov({ trak(2, "soun", 48000, audio_stbl()) }));
+    file.insert(file.end(), moov_box.begin(), moov_box.end());
+    ASSERT_EQ(write(fd, file.data(), file.size()), static_cast<ssize_t>(file.size()));
+
+    Mp4SampleTable table;
+    std::string error;
+    EXPECT_TRUE(table.parse_file(fd, &error)) << error;
+    EXPECT_EQ(table.tracks().size(), 1U);
+
+    ASSERT_EQ(ftruncate(fd, static_cast<off_t>(file.size() - moov_box.size())), 0);
+    Mp4SampleTable missing;
+    EXPECT_FALSE(missing.parse_file(fd, &error));
+    EXPECT_EQ(error, "no moov box");
+    close(fd);
+    unlink(path);
+}
+
+namespace {
+
+// flags 也要填的 full box：tfhd / trun 的可选字段由 flags 决定
+Bytes flagged_box(const char (&type)[5], uint8_t version, uint32_t flags, const Bytes& payload)
+{
+    Bytes body = { version };
+    put(body, flags, 3);
+    body.insert(body.end(), payload.begin(), payload.end());
+    return box(type, body);
+}
+
+Bytes u64(uint64_t value)
+{
+    Bytes out;
+    put(out, value, 8);
+    return out;
+}
+
+// 分片 mp4 的 moov：视频轨道 1（timescale 12800，trex 默认每帧 512），音频轨道 2（48000，默认 1024）
+Bytes fragmented_moov_payload()
+{
+    const Bytes trex = cat({
+        full_box("trex", 0, u32s({ 1, 1, 512, 0, 0 })),
+        full_box("trex", 0, u32s({ 2, 1, 1024, 0, 0 })),
+    });
+    return cat({ moov({ trak(1, "vide", 12800, {}), trak(2, "soun", 48000, {}) }), box("mvex", trex) });
+}
+
+// 一个 moof：视频 frames 帧按 trex 的默认时长（trun 只给大小），音频每个样本单独给时长
+Bytes moof(uint64_t video_dts, uint32_t frames, uint32_t audio_dts, std::initializer_list<uint32_t> audio_durations)
+{
+    Bytes video_trun = u32s({ frames, 0 });
+    for (uint32_t i = 0; i < frames; ++i) {
+        put(video_trun, 100, 4);
+    }
+    Bytes audio_trun = u32s({ static_cast<uint32_t>(audio_durations.size()) });
+    for (uint32_t duration : audio_durations) {
+        put(audio_trun, duration, 4);
+        put(audio_trun, 10, 4);
+    }
+    const Bytes video_traf = box("traf", cat({
+        flagged_box("tfhd", 0, 0, u32s({ 1 })),
+        full_box("tfdt", 1, u64(video_dts)),
+        flagged_box("trun", 0, 0x201, video_trun),
+    }));
+    // tfhd 的默认时长会被 trun 里逐个给出的时长盖掉
+    const Bytes audio_traf = box("traf", cat({
+        flagged_box("tfhd", 0, 0x8, u32s({ 2, 999 })),
+        full_box("tfdt", 0, u32s({ audio_dts })),
+        flagged_box("trun", 0, 0x300, audio_trun),
+    }));
+    return box("moof", cat({ full_box("mfhd", 0, u32s({ 1 })), video_traf, audio_traf }));
+}
+
+void append(int fd, const Bytes& bytes)
+{
+    ASSERT_EQ(write(fd, bytes.data(), bytes.size()), static_cast<ssize_t>(bytes.size()));
+}
+
+} // namespace
+
+TEST(Mp4FragmentScannerTest, FollowsWriteHeadAsFragmentsComplete)
+{
+    char path[] = "/tmp/mp4_fragment_scanner_XXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    Mp4FragmentScanner scanner;
+    int64_t size = 0;
+    auto write_and_scan = [&](const Bytes& bytes) {
+        append(fd, bytes);
+        size += static_cast<int64_t>(bytes.size());
+        return scanner.scan(fd, size);
+    };
+
+    ASSERT_TRUE(write_and_scan(cat({ box("ftyp", u32s({ Mp4SampleTable::fourcc("iso6"), 0 })), box("moov", fragmented_moov_payload()) })));
+    EXPECT_TRUE(scanner.has_moov());
+    EXPECT_LT(scanner.end_seconds(1), 0.0);
+
+    // moof 写完了但 mdat 只写了一半：这个分片还不算
+    const Bytes mdat = box("mdat", Bytes(64, 0xAB));
+    const int64_t before_fragment = size;
+    ASSERT_TRUE(write_and_scan(moof(0, 3, 0, { 1000, 1024, 1048 })));
+    ASSERT_TRUE(write_and_scan(Bytes(mdat.begin(), mdat.begin() + 20)));
+    EXPECT_LT(scanner.end_seconds(1), 0.0);
+    EXPECT_GT(scanner.scanned_bytes(), before_fragment);
+
+    ASSERT_TRUE(write_and_scan(Bytes(mdat.begin() + 20, mdat.end())));
+    EXPECT_DOUBLE_EQ(scanner.end_seconds(1), 3 * 512 / 12800.0);
+    EXPECT_DOUBLE_EQ(scanner.end_seconds(2), (1000 + 1024 + 1048) / 48000.0);
+    EXPECT_EQ(scanner.scanned_bytes(), size);
+
+    // 写了一半的 moof 留到下次
+    const Bytes second = moof(1536, 3, 3072, { 1024 });
+    ASSERT_TRUE(write_and_scan(Bytes(second.begin(), second.begin() + 30)));
+    EXPECT_DOUBLE_EQ(scanner.end_seconds(1), 3 * 512 / 12800.0);
+    ASSERT_TRUE(write_and_scan(cat({ Bytes(second.begin() + 30, second.end()), mdat })));
+    EXPECT_DOUBLE_EQ(scanner.end_seconds(1), 6 * 512 / 12800.0);
+    EXPECT_DOUBLE_EQ(scanner.end_seconds(2), 4096 / 48000.0);
+    EXPECT_LT(scanner.end_seconds(7), 0.0);
+
+    close(fd);
+    unlink(path);
+}
+
+TEST(Mp4FragmentScannerTest, ContinuesWithoutTfdt)
+{
+    Mp4FragmentScanner scanner;
+    const Bytes moov_payload = fragmented_moov_payload();
+    ASSERT_TRUE(scanner.parse_moov(moov_payload.data(), moov_payload.size()));
+
+    // 没有 tfdt，tfhd 给了默认时长 256：从上一个分片的结束时刻接着算
+    const Bytes traf = box("traf", cat({
+        flagged_box("tfhd", 0, 0x8, u32s({ 1, 256 })),
+        flagged_box("trun", 0, 0, u32s({ 4 })),
+    }));
+    const Bytes payload = cat({ full_box("mfhd", 0, u32s({ 1 })), traf });
+    for (int fragment = 1; fragment <= 2; ++fragment) {
+        ASSERT_TRUE(scanner.parse_moof(payload.data(), payload.size()));
+        scanner.commit_fragment();
+        EXPECT_DOUBLE_EQ(scanner.end_seconds(1), fragment * 1024 / 12800.0);
+    }
+    // 这一轨在分片里没出现，不变
+    EXPECT_LT(scanner.end_seconds(2), 0.0);
+}
+
+TEST(Mp4FragmentScannerTest, RejectsNonFragmentedOrBrokenBoxes)
+{
+    Mp4FragmentScanner scanner;
+    const Bytes plain = moov({ trak(2, "soun", 48000, audio_stbl()) });
+    EXPECT_FALSE(scanner.parse_moov(plain.data(), plain.size()));
+
+    const Bytes moov_payload = fragmented_moov_payload();
+    ASSERT_TRUE(scanner.parse_moov(moov_payload.data(), moov_payload.size()));
+    // trun 声称的样本数比 box 里装得下的多
+    const Bytes lying = cat({ box("traf", cat({
+        flagged_box("tfhd", 0, 0, u32s({ 1 })),
+        flagged_box("trun", 0, 0x100, u32s({ 1000, 512 })),
+    })) });
+    EXPECT_FALSE(scanner.parse_moof(lying.data(), lying.size()));
+    // 每个截断位置都不能越界
+    const Bytes good = moof(0, 3, 0, { 1024, 1024 });
+    for (size_t cut = 8; cut < good.size(); cut += 3) {
+        scanner.parse_moof(good.data() + 8, cut - 8);
+    }
+
+    char path[] = "/tmp/mp4_fragment_scanner_XXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    const Bytes file = box("moov", plain);
+    append(fd, file);
+    Mp4FragmentScanner plain_scanner;
+    EXPECT_FALSE(plain_scanner.scan(fd, static_cast<int64_t>(file.size())));
+    close(fd);
+    unlink(path);
+}
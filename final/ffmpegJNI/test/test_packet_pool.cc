@@ -0,0 +1,91 @@
+// test_packet_pool.cc
+#include "Packet.hpp"
+#include "PacketPool.hpp"
+#include "SemQueue.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+
+using ffmpeg_utils::Packet;
+using ffmpeg_utils::PacketPool;
+using player_utils::SemQueue;
+
+TEST(PacketPoolTest, ReleasedPacketsAreReusedAndUnreferenced)
+{
+    PacketPool pool(4);
+    AVPacket* first = pool.acquire();
+    ASSERT_NE(first, nullptr);
+    ASSERT_EQ(av_new_packet(first, 128), 0);
+    first->stream_index = 3;
+    pool.release(first);
+
+    AVPacket* again = pool.acquire();
+    EXPECT_EQ(again, first);
+    EXPECT_EQ(again->data, nullptr);
+    EXPECT_EQ(again->size, 0);
+    EXPECT_EQ(again->stream_index, 0);
+    pool.release(again);
+
+    auto stats = pool.stats();
+    EXPECT_EQ(stats.acquires, 2U);
+    EXPECT_EQ(stats.allocations, 1U);
+    EXPECT_EQ(stats.idle, 1U);
+}
+
+TEST(PacketPoolTest, SentinelsNeverTouchThePool)
+{
+    const auto before = PacketPool::global().stats();
+    {
+        Packet flush = Packet::createFlushPacket();
+        Packet eof = Packet::createEofPacket();
+        EXPECT_EQ(flush.get(), nullptr);
+        EXPECT_EQ(eof.get(), nullptr);
+    }
+    const auto after = PacketPool::global().stats();
+    EXPECT_EQ(after.acquires, before.acquires);
+    EXPECT_EQ(after.idle, before.idle);
+}
+
+// 哨兵包经过队列（移动构造 / 移动赋值）之后仍然是哨兵
+TEST(PacketPoolTest, SentinelFlagsSurviveTheQueue)
+{
+    SemQueue<Packet> queue(4);
+    queue.push(Packet::createFlushPacket());
+    queue.push(Packet::createEofPacket());
+    queue.push(Packet());
+
+    Packet packet(nullptr);
+    ASSERT_TRUE(queue.try_pop(packet));
+    EXPECT_TRUE(packet.isFlush());
+    ASSERT_TRUE(queue.try_pop(packet));
+    EXPECT_TRUE(packet.isEof());
+    EXPECT_FALSE(packet.isFlush());
+    ASSERT_TRUE(queue.try_pop(packet));
+    EXPECT_TRUE(packet.isData());
+}
+
+TEST(PacketPoolTest, SteadyStateMakesNoNewAllocations)
+{
+    SemQueue<Packet> queue(32);
+    auto cycle = [&queue](int count) {
+        std::thread consumer([&queue, count] {
+            Packet packet(nullptr);
+            for (int i = 0; i < count; ++i) {
+                queue.wait_and_pop(packet);
+            }
+        });
+        for (int i = 0; i < count; ++i) {
+            Packet packet;
+            av_new_packet(packet.get(), 64);
+            queue.push(std::move(packet));
+        }
+        consumer.join();
+    };
+
+    cycle(1000);
+    const auto warm = PacketPool::global().stats();
+    cycle(10000);
+    const auto after = PacketPool::global().stats();
+    EXPECT_EQ(after.acquires - warm.acquires, 10000U);
+    // 队列最多 32 个包在途，预热阶段已经分配够了
+    EXPECT_EQ(after.allocations, warm.allocations);
+}
@@ -0,0 +1,195 @@
+// test_pcm_ring_buffer.cc
+#include "PcmRingBuffer.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <gtest/gtest.h>
+#include <linux/seccomp.h>
+#include <new>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using player_utils::PcmRingBuffer;
+
+// --- 统计 "模拟回调线程" 上的内存分配 ---
+// new/delete 和 malloc/free 是成对替换的，GCC 的 -Wmismatched-new-delete 在这里是误报
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+namespace {
+thread_local bool g_in_callback = false;
+std::atomic<long> g_callback_allocations { 0 };
+} // namespace
+
+void* operator new(size_t size)
+{
+    if (g_in_callback) {
+        g_callback_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    if (g_in_callback) {
+        g_callback_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+namespace {
+constexpr int kChannels = 2;
+constexpr int kSampleRate = 48000;
+
+// 第 n 个采样帧的两个声道分别是 n 和 -n（截断到 int16）
+void fill_frames(std::vector<int16_t>& buf, uint64_t first, size_t frames)
+{
+    buf.resize(frames * kChannels);
+    for (size_t i = 0; i < frames; ++i) {
+        auto v = static_cast<int16_t>(first + i);
+        buf[i * kChannels] = v;
+        buf[i * kChannels + 1] = static_cast<int16_t>(-v);
+    }
+}
+} // namespace
+
+TEST(PcmRingBufferTest, WrapsAroundAndReportsPts)
+{
+    PcmRingBuffer ring(100, kChannels, kSampleRate); // 向上取整到 128
+    EXPECT_EQ(ring.capacity_frames(), 128U);
+
+    std::vector<int16_t> in;
+    std::vector<int16_t> out(128 * kChannels);
+    uint64_t produced = 0;
+    uint64_t consumed = 0;
+    for (int round = 0; round < 10; ++round) {
+        fill_frames(in, produced, 90);
+        ASSERT_TRUE(ring.write(in.data(), 90, produced / double(kSampleRate)));
+        produced += 90;
+
+        auto r = ring.read(out.data(), 90);
+        ASSERT_EQ(r.frames, 90U);
+        EXPECT_DOUBLE_EQ(r.pts, consumed / double(kSampleRate));
+        for (size_t i = 0; i < r.frames; ++i) {
+            ASSERT_EQ(out[i * kChannels], static_cast<int16_t>(consumed + i));
+        }
+        consumed += r.frames;
+    }
+
+    // 读到一半的时候 PTS 按采样率外推
+    fill_frames(in, produced, 96);
+    ASSERT_TRUE(ring.write(in.data(), 96, 10.0));
+    ASSERT_EQ(ring.read(out.data(), 48).pts, 10.0);
+    EXPECT_DOUBLE_EQ(ring.read(out.data(), 48).pts, 10.0 + 48.0 / kSampleRate);
+
+    EXPECT_EQ(ring.read(out.data(), 16).frames, 0U);
+    EXPECT_EQ(ring.underruns(), 1U);
+}
+
+TEST(PcmRingBufferTest, ShutdownReleasesBlockedWriterAndResetEmpties)
+{
+    PcmRingBuffer ring(64, kChannels, kSampleRate);
+    std::vector<int16_t> in;
+    fill_frames(in, 0, 64);
+    ASSERT_TRUE(ring.write(in.data(), 64, 0.0));
+
+    std::thread writer([&] { EXPECT_FALSE(ring.write(in.data(), 64, 1.0)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ring.shutdown();
+    writer.join();
+
+    ring.reset();
+    EXPECT_EQ(ring.available_frames(), 0U);
+    ASSERT_TRUE(ring.write(in.data(), 32, 5.0));
+    std::vector<int16_t> out(32 * kChannels);
+    EXPECT_EQ(ring.read(out.data(), 32).pts, 5.0);
+}
+
+// 压力测试：解码线程写随机大小的块，"回调线程" 按 AAudio 的节奏读。
+// 回调线程进入 SECCOMP_MODE_STRICT 之后，除了 read/write/exit/sigreturn 之外的任何系统调用
+// （futex、mmap、clock_gettime 的 fallback……）都会让内核发 SIGKILL 杀掉整个测试进程，
+// 不会有断言失败的报告，表现为测试程序异常退出；
+// 同时统计这个线程上的 operator new/delete 调用次数。
+TEST(PcmRingBufferTest, CallbackPathMakesNoAllocationsOrSyscalls)
+{
+    constexpr uint64_t kTotalFrames = 2'000'000;
+    constexpr size_t kCallbackFrames = 192;
+    PcmRingBuffer ring(kSampleRate / 10, kChannels, kSampleRate);
+
+    // 写端没写完就停了的时候让读线程退出，普通的原子读不是系统调用
+    std::atomic<bool> stop_reader { false };
+    uint64_t read_frames = 0;
+    uint64_t mismatches = 0;
+    uint64_t pts_errors = 0;
+
+    std::thread reader([&] {
+        int16_t out[kCallbackFrames * kChannels];
+        g_in_callback = true;
+        if (prctl(PR_SET_SECCOMP, SECCOMP_MODE_STRICT) != 0) {
+            g_in_callback = false;
+            return;
+        }
+
+        while (read_frames < kTotalFrames && !stop_reader.load(std::memory_order_relaxed)) {
+            auto r = ring.read(out, kCallbackFrames);
+            if (r.frames > 0) {
+                const double expected_pts = read_frames / double(kSampleRate);
+                if (r.pts < expected_pts - 1e-6 || r.pts > expected_pts + 1e-6)
+                    ++pts_errors;
+            }
+            for (size_t i = 0; i < r.frames; ++i) {
+                if (out[i * kChannels] != static_cast<int16_t>(read_frames + i)
+                    || out[i * kChannels + 1] != static_cast<int16_t>(-static_cast<int16_t>(read_frames + i)))
+                    ++mismatches;
+            }
+            read_frames += r.frames;
+        }
+
+        // strict 模式下不能走 pthread 的退出流程（futex / munmap），直接用 exit 系统调用结束这个线程。
+        // 内核照样清掉 tid 并唤醒 join 的一方，栈由 join 释放
+        syscall(SYS_exit, 0);
+    });
+
+    // 回调线程一旦被杀，写端会一直等空间；由看门狗关掉缓冲区，让测试失败而不是卡死
+    std::atomic<bool> writer_done { false };
+    std::thread watchdog([&] {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!writer_done.load() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        ring.shutdown();
+    });
+
+    std::vector<int16_t> in;
+    uint64_t written = 0;
+    unsigned seed = 12345;
+    while (written < kTotalFrames) {
+        seed = seed * 1103515245 + 12345;
+        size_t frames = std::min<uint64_t>(64 + (seed >> 16) % 2048, kTotalFrames - written);
+        fill_frames(in, written, frames);
+        if (!ring.write(in.data(), frames, written / double(kSampleRate)))
+            break;
+        written += frames;
+    }
+    writer_done = true;
+    watchdog.join();
+    if (written != kTotalFrames) {
+        stop_reader = true;
+    }
+    reader.join();
+    ASSERT_EQ(written, kTotalFrames) << "reader thread stalled";
+    ASSERT_EQ(read_frames, kTotalFrames) << "seccomp unavailable, reader did not run";
+    EXPECT_EQ(mismatches, 0U);
+    EXPECT_EQ(pts_errors, 0U);
+    EXPECT_EQ(g_callback_allocations.load(), 0);
+}
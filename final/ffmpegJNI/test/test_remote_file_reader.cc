@@ -0,0 +1,470 @@
+// test_remote_file_reader.cc
+// 起一个 lab06 的 fileServer，从回环地址上读它目录里的文件：内容对不对，起播 / seek 延迟和吞吐打印出来。
+// 服务器路径默认是 CMake 里编出来的那个，也可以用环境变量 LAB06_FILE_SERVER 指定
+#include "RemoteFileReader.hpp"
+#include <gtest/gtest.h>
+
+#include <signal.h>
+#include <sys/wait.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef LAB06_FILE_SERVER
+#define LAB06_FILE_SERVER "fileServer"
+#endif
+
+using player_utils::Lab06Connection;
+using player_utils::RemoteFileReader;
+using player_utils::RemoteOptions;
+using player_utils::RemoteUrl;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ms_since(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// 和 MediaSource 里 AVIOContext 的缓冲区一样大
+constexpr size_t kReadSize = 64 * 1024;
+constexpr size_t kFileSize = 48 * 1024 * 1024 + 12345;
+
+class RemoteFileReaderTest : public ::testing::Test {
+protected:
+    static void SetUpTestSuite()
+    {
+        char dir[] = "/tmp/remote_file_reader_XXXXXX";
+        ASSERT_NE(mkdtemp(dir), nullptr);
+        dir_ = dir;
+        data_.resize(kFileSize);
+        std::mt19937 rng(42);
+        for (auto& byte : data_) {
+            byte = static_cast<uint8_t>(rng());
+        }
+        std::ofstream out(dir_ + "/media.bin", std::ios::binary);
+        out.write(reinterpret_cast<const char*>(data_.data()), static_cast<std::streamsize>(data_.size()));
+    }
+
+    static void TearDownTestSuite()
+    {
+        std::remove((dir_ + "/media.bin").c_str());
+        rmdir(dir_.c_str());
+    }
+
+    void SetUp() override
+    {
+        const char* env = std::getenv("LAB06_FILE_SERVER");
+        const std::string server = env != nullptr ? env : LAB06_FILE_SERVER;
+        if (access(server.c_str(), X_OK) != 0) {
+            GTEST_SKIP() << "lab06 fileServer not found at " << server;
+        }
+        port_ = free_port();
+        ASSERT_GT(port_, 0);
+        server_ = fork();
+        ASSERT_GE(server_, 0);
+        if (server_ == 0) {
+            // 服务器按相对路径打开文件，工作目录设成放测试文件的目录；每个连接打一行日志，丢掉
+            if (chdir(dir_.c_str()) != 0 || freopen("/dev/null", "w", stdout) == nullptr) {
+                _exit(127);
+            }
+            const std::string port = std::to_string(port_);
+            execl(server.c_str(), server.c_str(), port.c_str(), static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        ASSERT_TRUE(wait_for_server());
+    }
+
+    void TearDown() override
+    {
+        if (server_ > 0) {
+            kill(server_, SIGTERM);
+            waitpid(server_, nullptr, 0);
+        }
+    }
+
+    [[nodiscard]] std::string url(const std::string& name = "media.bin") const
+    {
+        return "lab06://127.0.0.1:" + std::to_string(port_) + "/" + name;
+    }
+
+    // 从 pos 起读 len 字节（读到文件末尾为止）
+    static std::vector<uint8_t> read_at(RemoteFileReader& reader, int64_t pos, size_t len)
+    {
+        EXPECT_EQ(reader.seek(pos), pos);
+        std::vector<uint8_t> out(len);
+        size_t got = 0;
+        while (got < len) {
+            const int64_t n = reader.read(out.data() + got, len - got);
+            EXPECT_GE(n, 0);
+            if (n <= 0) {
+                break;
+            }
+            got += static_cast<size_t>(n);
+        }
+        out.resize(got);
+        return out;
+    }
+
+    static bool matches(const std::vector<uint8_t>& got, int64_t pos)
+    {
+        return static_cast<size_t>(pos) + got.size() <= data_.size()
+            && std::equal(got.begin(), got.end(), data_.begin() + pos);
+    }
+
+    static std::string dir_;
+    static std::vector<uint8_t> data_;
+    int port_ = 0;
+    pid_t server_ = -1;
+
+private:
+    static int free_port()
+    {
+        const int fd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        int port = -1;
+        if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0
+            && getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0) {
+            port = ntohs(addr.sin_port);
+        }
+        close(fd);
+        return port;
+    }
+
+    [[nodiscard]] bool wait_for_server() const
+    {
+        for (int i = 0; i < 200; ++i) {
+            const int fd = socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr {};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(static_cast<uint16_t>(port_));
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            const bool ok = connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0;
+            close(fd);
+            if (ok) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    }
+};
+
+std::string RemoteFileReaderTest::dir_;
+std::vector<uint8_t> RemoteFileReaderTest::data_;
+
+// 进程内的简易 lab06 服务器，只认区间请求。请求 fail_offset 开头的区间时，前 failures 次直接断开连接
+class FlakyServer {
+public:
+    FlakyServer(std::vector<uint8_t> data, int64_t fail_offset, int failures)
+        : data_(std::move(data))
+        , fail_offset_(fail_offset)
+        , failures_left_(failures)
+    {
+        listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0 && listen(listen_fd_, 16) == 0
+            && getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) == 0) {
+            port_ = ntohs(addr.sin_port);
+        }
+        acceptor_ = std::thread([this] { accept_loop(); });
+    }
+
+    ~FlakyServer()
+    {
+        stop_ = true;
+        shutdown(listen_fd_, SHUT_RDWR);
+        acceptor_.join();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const int fd : client_fds_) {
+                shutdown(fd, SHUT_RDWR);
+            }
+        }
+        for (std::thread& t : clients_) {
+            t.join();
+        }
+        close(listen_fd_);
+    }
+
+    [[nodiscard]] std::string url() const { return "lab06://127.0.0.1:" + std::to_string(port_) + "/media.bin"; }
+    [[nodiscard]] int dropped() const { return dropped_.load(); }
+
+private:
+    void accept_loop()
+    {
+        while (!stop_) {
+            const int fd = accept(listen_fd_, nullptr, nullptr);
+            if (fd < 0) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mutex_);
+            client_fds_.push_back(fd);
+            clients_.emplace_back([this, fd] { serve(fd); });
+        }
+    }
+
+    void serve(int fd)
+    {
+        std::string pending;
+        char buffer[4096];
+        while (true) {
+            const size_t newline = pending.find('\n');
+            if (newline == std::string::npos) {
+                const ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+                if (n <= 0) {
+                    break;
+                }
+                pending.append(buffer, static_cast<size_t>(n));
+                continue;
+            }
+            const std::string line = pending.substr(0, newline);
+            pending.erase(0, newline + 1);
+            const int64_t offset = field(line, "offset");
+            const int64_t length = field(line, "length");
+            if (offset == fail_offset_ && failures_left_.fetch_sub(1) > 0) {
+                ++dropped_;
+                break;
+            }
+            const auto size = static_cast<int64_t>(data_.size());
+            const int64_t begin = std::min(offset, size);
+            const int64_t end = std::min(begin + length, size);
+            const std::string header = "{\"filesize\":" + std::to_string(size) + ",\"offset\":" + std::to_string(begin)
+                + ",\"length\":" + std::to_string(end - begin) + "}\n";
+            if (send(fd, header.data(), header.size(), MSG_NOSIGNAL) < 0
+                || send(fd, data_.data() + begin, static_cast<size_t>(end - begin), MSG_NOSIGNAL) < 0) {
+                break;
+            }
+        }
+        // 断开但先不 close，fd 号留到析构时再还，免得被别的连接复用之后 shutdown 错了
+        shutdown(fd, SHUT_RDWR);
+    }
+
+    static int64_t field(const std::string& line, const char* key)
+    {
+        const size_t pos = line.find(std::string("\"") + key + "\":");
+        return pos == std::string::npos ? -1 : std::strtoll(line.c_str() + pos + std::strlen(key) + 3, nullptr, 10);
+    }
+
+    std::vector<uint8_t> data_;
+    int64_t fail_offset_;
+    std::atomic<int> failures_left_;
+    std::atomic<int> dropped_ { 0 };
+    int listen_fd_ = -1;
+    int port_ = 0;
+    std::atomic<bool> stop_ { false };
+    std::thread acceptor_;
+    std::mutex mutex_;
+    std::vector<int> client_fds_;
+    std::vector<std::thread> clients_;
+};
+
+} // namespace
+
+TEST(RemoteUrlTest, ParsesHostPortAndPath)
+{
+    RemoteUrl url;
+    ASSERT_TRUE(RemoteUrl::parse("lab06://192.168.1.5:9000/movies/a.mp4", url));
+    EXPECT_EQ(url.host, "192.168.1.5");
+    EXPECT_EQ(url.port, 9000);
+    EXPECT_EQ(url.path, "movies/a.mp4");
+    ASSERT_TRUE(RemoteUrl::parse("lab06://nas:80//srv/a.mp4", url));
+    EXPECT_EQ(url.path, "/srv/a.mp4");
+
+    EXPECT_FALSE(RemoteUrl::is_remote("/sdcard/a.mp4"));
+    EXPECT_FALSE(RemoteUrl::parse("http://nas:80/a.mp4", url));
+    EXPECT_FALSE(RemoteUrl::parse("lab06://nas/a.mp4", url));
+    EXPECT_FALSE(RemoteUrl::parse("lab06://nas:0/a.mp4", url));
+    EXPECT_FALSE(RemoteUrl::parse("lab06://nas:99999/a.mp4", url));
+    EXPECT_FALSE(RemoteUrl::parse("lab06://nas:80/", url));
+    EXPECT_FALSE(RemoteUrl::parse("lab06://:80/a.mp4", url));
+}
+
+TEST_F(RemoteFileReaderTest, RangeRequestsShareOneConnection)
+{
+    RemoteUrl parsed;
+    ASSERT_TRUE(RemoteUrl::parse(url(), parsed));
+    Lab06Connection connection(parsed, 2000);
+    std::vector<uint8_t> buffer(1000);
+    int64_t file_size = 0;
+    for (const int64_t offset : { int64_t { 0 }, int64_t { 777777 }, static_cast<int64_t>(kFileSize) - 10 }) {
+        const int64_t n = connection.fetch(offset, buffer.size(), buffer.data(), file_size);
+        EXPECT_EQ(file_size, static_cast<int64_t>(kFileSize));
+        ASSERT_EQ(n, std::min<int64_t>(1000, static_cast<int64_t>(kFileSize) - offset));
+        EXPECT_TRUE(std::equal(buffer.begin(), buffer.begin() + n, data_.begin() + offset));
+    }
+    // 文件末尾之后取到 0 字节
+    EXPECT_EQ(connection.fetch(static_cast<int64_t>(kFileSize) + 5, buffer.size(), buffer.data(), file_size), 0);
+
+    RemoteUrl missing = parsed;
+    missing.path = "missing.bin";
+    Lab06Connection other(missing, 2000);
+    EXPECT_EQ(other.fetch(0, buffer.size(), buffer.data(), file_size), -ENOENT);
+}
+
+TEST_F(RemoteFileReaderTest, FailsToOpenMissingFileOrServer)
+{
+    EXPECT_EQ(RemoteFileReader::open(url("missing.bin"), {}), nullptr);
+    EXPECT_EQ(RemoteFileReader::open("lab06://127.0.0.1/media.bin", {}), nullptr);
+    kill(server_, SIGTERM);
+    waitpid(server_, nullptr, 0);
+    server_ = -1;
+    EXPECT_EQ(RemoteFileReader::open(url(), {}), nullptr);
+}
+
+// 起播：打开（连接 + 第一块）到拿到头 64 KB
+TEST_F(RemoteFileReaderTest, StartupLatency)
+{
+    const auto start = Clock::now();
+    auto reader = RemoteFileReader::open(url(), {});
+    ASSERT_NE(reader, nullptr);
+    const double open_ms = ms_since(start);
+    const auto head = read_at(*reader, 0, kReadSize);
+    const double first_read_ms = ms_since(start);
+    EXPECT_EQ(reader->size(), static_cast<int64_t>(kFileSize));
+    EXPECT_TRUE(matches(head, 0));
+    EXPECT_EQ(reader->stats().waits, 0U);
+    std::printf("startup: open %.2f ms, first %zu KB %.2f ms\n", open_ms, kReadSize / 1024, first_read_ms);
+    EXPECT_LT(first_read_ms, 1000.0);
+}
+
+// 整个文件按 AVIOContext 的粒度顺序读完，不同连接数的吞吐
+TEST_F(RemoteFileReaderTest, SequentialThroughput)
+{
+    for (const size_t connections : { size_t { 1 }, size_t { 4 } }) {
+        RemoteOptions options;
+        options.connections = connections;
+        const auto start = Clock::now();
+        auto reader = RemoteFileReader::open(url(), options);
+        ASSERT_NE(reader, nullptr);
+        const auto all = read_at(*reader, 0, kFileSize + 100);
+        const double ms = ms_since(start);
+        ASSERT_EQ(all.size(), kFileSize);
+        EXPECT_TRUE(matches(all, 0));
+
+        uint8_t byte = 0;
+        EXPECT_EQ(reader->read(&byte, 1), 0);
+        const auto transfer = reader->transfer();
+        // 顺序读每块只取一次，也没有取了又作废的块
+        EXPECT_EQ(transfer.discarded, 0U);
+        EXPECT_EQ(transfer.bytes, kFileSize);
+        std::printf("sequential, %zu connection(s): %.1f MB/s, %llu chunks, %llu waits\n", connections,
+            static_cast<double>(kFileSize) / (1024.0 * 1024.0) / (ms / 1000.0),
+            static_cast<unsigned long long>(transfer.chunks), static_cast<unsigned long long>(reader->stats().waits));
+    }
+}
+
+// 随机 seek 之后读一个 AVIOContext 缓冲区的延迟，内容要和 seek 目标对得上
+TEST_F(RemoteFileReaderTest, SeekLatency)
+{
+    auto reader = RemoteFileReader::open(url(), {});
+    ASSERT_NE(reader, nullptr);
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int64_t> pick(0, static_cast<int64_t>(kFileSize) - 1);
+    std::vector<double> latencies;
+    for (int i = 0; i < 30; ++i) {
+        const int64_t pos = pick(rng);
+        const auto start = Clock::now();
+        const auto got = read_at(*reader, pos, kReadSize);
+        latencies.push_back(ms_since(start));
+        ASSERT_EQ(got.size(), std::min<size_t>(kReadSize, kFileSize - static_cast<size_t>(pos)));
+        ASSERT_TRUE(matches(got, pos)) << "at " << pos;
+        // 紧接着往后读一点，seek 之后的预读要接得上
+        const auto next = read_at(*reader, pos + static_cast<int64_t>(got.size()), kReadSize);
+        ASSERT_TRUE(matches(next, pos + static_cast<int64_t>(got.size())));
+    }
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("seek + %zu KB: median %.2f ms, max %.2f ms, %llu refills\n", kReadSize / 1024,
+        latencies[latencies.size() / 2], latencies.back(), static_cast<unsigned long long>(reader->stats().refills));
+    EXPECT_GE(reader->stats().refills, 20U);
+    EXPECT_LT(latencies[latencies.size() / 2], 500.0);
+
+    // 往回一点点（读过、还留着的块）不用重新取
+    const uint64_t refills = reader->stats().refills;
+    constexpr int64_t kPos = 10 * 1024 * 1024;
+    ASSERT_TRUE(matches(read_at(*reader, kPos, 3 * kReadSize), kPos));
+    ASSERT_TRUE(matches(read_at(*reader, kPos + 1000, kReadSize), kPos + 1000));
+    EXPECT_EQ(reader->stats().refills, refills + 1);
+
+    // 文件末尾之后读到结束
+    EXPECT_EQ(reader->seek(static_cast<int64_t>(kFileSize) + 10), static_cast<int64_t>(kFileSize) + 10);
+    uint8_t byte = 0;
+    EXPECT_EQ(reader->read(&byte, 1), 0);
+}
+
+// 正在取块时关掉（播放器停止 / 换片源）：不会卡住，服务器也不会因为客户端断开而退出
+TEST_F(RemoteFileReaderTest, CloseWhileFetchingKeepsServerAlive)
+{
+    for (int i = 0; i < 5; ++i) {
+        RemoteOptions options;
+        options.chunk_size = 4 * 1024 * 1024;
+        auto reader = RemoteFileReader::open(url(), options);
+        ASSERT_NE(reader, nullptr);
+        reader->seek(static_cast<int64_t>(kFileSize) / 2);
+        const auto start = Clock::now();
+        reader.reset();
+        EXPECT_LT(ms_since(start), 1000.0);
+    }
+    EXPECT_EQ(waitpid(server_, nullptr, WNOHANG), 0);
+    auto reader = RemoteFileReader::open(url(), {});
+    ASSERT_NE(reader, nullptr);
+    EXPECT_TRUE(matches(read_at(*reader, 12345, kReadSize), 12345));
+}
+
+// 预读的块取失败了要重新排队，不能一直挂在 Failed 上让 read 报错（那样播放就结束了）
+TEST(RemoteFileReaderRetryTest, FailedReadAheadChunkIsRetried)
+{
+    constexpr size_t kChunk = 64 * 1024;
+    std::vector<uint8_t> data(16 * kChunk + 100);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 131 + 7);
+    }
+    RemoteOptions options;
+    options.chunk_size = kChunk;
+    options.connections = 2;
+    options.timeout_ms = 2000;
+
+    // Lab06Connection::fetch 自己会重连一次，断 4 次 = 块级别失败两次，第三次取到
+    {
+        FlakyServer server(data, 3 * kChunk, 4);
+        auto reader = RemoteFileReader::open(server.url(), options);
+        ASSERT_NE(reader, nullptr);
+        std::vector<uint8_t> out(data.size());
+        size_t got = 0;
+        while (got < out.size()) {
+            const int64_t n = reader->read(out.data() + got, std::min(out.size() - got, size_t { 10000 }));
+            ASSERT_GT(n, 0) << "at " << got;
+            got += static_cast<size_t>(n);
+        }
+        EXPECT_EQ(out, data);
+        EXPECT_EQ(server.dropped(), 4);
+        EXPECT_EQ(reader->transfer().retries, 2U);
+    }
+
+    // 一直失败：重试次数用完之后 read 报错，而不是一直等下去
+    {
+        FlakyServer server(data, 2 * kChunk, 1000);
+        auto reader = RemoteFileReader::open(server.url(), options);
+        ASSERT_NE(reader, nullptr);
+        ASSERT_EQ(reader->seek(2 * kChunk), static_cast<int64_t>(2 * kChunk));
+        uint8_t buffer[1024];
+        EXPECT_LT(reader->read(buffer, sizeof(buffer)), 0);
+        EXPECT_EQ(reader->transfer().retries, 2U);
+    }
+}
@@ -0,0 +1,129 @@
+// test_ring_buffer.cc
+#include "RingBuffer.hpp"
+#include "SemQueue.hpp"
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+
+using player_utils::SemQueue;
+
+namespace {
+// 没有默认构造函数，并统计存活的实例数
+struct Tracked {
+    static inline int alive = 0;
+    explicit Tracked(int v)
+        : value(v)
+    {
+        ++alive;
+    }
+    Tracked(const Tracked& other)
+        : value(other.value)
+    {
+        ++alive;
+    }
+    Tracked(Tracked&& other) noexcept
+        : value(other.value)
+    {
+        ++alive;
+    }
+    Tracked& operator=(const Tracked&) = default;
+    Tracked& operator=(Tracked&&) = default;
+    ~Tracked() { --alive; }
+    int value;
+};
+} // namespace
+
+TEST(RingBufferTest, WrapsAroundWithNonPowerOfTwoCapacity)
+{
+    RingBuffer<int, 5> ring;
+    static_assert(RingBuffer<int, 5>::kStorageSize == 8);
+    EXPECT_EQ(ring.capacity(), 5U);
+
+    int next_in = 0;
+    int next_out = 0;
+    for (int round = 0; round < 20; ++round) {
+        while (ring.try_push(next_in))
+            ++next_in;
+        EXPECT_TRUE(ring.full());
+        EXPECT_EQ(ring.size(), 5U);
+        EXPECT_EQ(ring.back(), next_in - 1);
+        for (int i = 0; i < 3; ++i) {
+            int out = -1;
+            ASSERT_TRUE(ring.try_pop(out));
+            EXPECT_EQ(out, next_out++);
+        }
+    }
+    int out;
+    while (ring.try_pop(out))
+        EXPECT_EQ(out, next_out++);
+    EXPECT_FALSE(ring.try_pop(out));
+    EXPECT_EQ(next_in, next_out);
+}
+
+TEST(RingBufferTest, ConstructsAndDestroysElementsInPlace)
+{
+    {
+        RingBuffer<Tracked, 4> ring;
+        EXPECT_EQ(Tracked::alive, 0);
+        ring.emplace(1);
+        ring.emplace(2);
+        ring.push(Tracked(3));
+        EXPECT_EQ(Tracked::alive, 3);
+        ring.pop();
+        EXPECT_EQ(Tracked::alive, 2);
+
+        RingBuffer<Tracked, 4> other;
+        other.emplace(9);
+        ring.swap(other);
+        EXPECT_EQ(ring.size(), 1U);
+        EXPECT_EQ(ring.front().value, 9);
+        EXPECT_EQ(other.front().value, 2);
+        EXPECT_EQ(other.back().value, 3);
+        EXPECT_EQ(Tracked::alive, 3);
+
+        other.clear();
+        EXPECT_EQ(Tracked::alive, 1);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(RingBufferTest, SpansCoverElementsAcrossTheWrap)
+{
+    RingBuffer<int, 8> ring;
+    for (int i = 0; i < 6; ++i)
+        ring.push(i);
+    ring.pop_n(5);
+    for (int i = 6; i < 12; ++i)
+        ring.push(i);
+
+    auto [first, second] = ring.spans();
+    EXPECT_EQ(first.size + second.size, ring.size());
+    int expected = 5;
+    for (size_t i = 0; i < first.size; ++i)
+        EXPECT_EQ(first.data[i], expected++);
+    for (size_t i = 0; i < second.size; ++i)
+        EXPECT_EQ(second.data[i], expected++);
+    EXPECT_EQ(expected, 12);
+    EXPECT_GT(second.size, 0U);
+}
+
+TEST(RingBufferTest, WorksAsSemQueueContainer)
+{
+    SemQueue<std::shared_ptr<std::string>, RingBuffer<std::shared_ptr<std::string>, 5>> queue(5);
+    for (int i = 0; i < 5; ++i)
+        ASSERT_TRUE(queue.push(std::make_shared<std::string>(std::to_string(i))));
+    EXPECT_EQ(queue.size(), 5U);
+
+    std::shared_ptr<std::string> out;
+    ASSERT_TRUE(queue.try_pop(out));
+    EXPECT_EQ(*out, "0");
+
+    queue.clear();
+    EXPECT_TRUE(queue.empty());
+    queue.shutdown();
+    queue.reset();
+    ASSERT_TRUE(queue.push(std::make_shared<std::string>("after reset")));
+    ASSERT_TRUE(queue.wait_and_pop(out, std::chrono::milliseconds(10)));
+    EXPECT_EQ(*out, "after reset");
+}
@@ -0,0 +1,362 @@
+// test_sem_queue.cc
+#include "SemQueue.hpp"
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using player_utils::SemQueue;
+
+namespace {
+struct FakeFrame {
+    std::vector<uint8_t> data;
+};
+using FramePtr = std::shared_ptr<FakeFrame>;
+
+FramePtr make_frame(size_t bytes)
+{
+    auto frame = std::make_shared<FakeFrame>();
+    frame->data.resize(bytes);
+    return frame;
+}
+
+size_t frame_bytes(const FramePtr& frame)
+{
+    return frame ? frame->data.size() : 0;
+}
+} // namespace
+
+TEST(SemQueueBudgetTest, PushBlocksWhenCostBudgetIsExhausted)
+{
+    // 个数上限很宽，真正起作用的是 1000 字节的预算
+    SemQueue<FramePtr> queue(30, frame_bytes, 1000);
+    ASSERT_TRUE(queue.push(make_frame(400)));
+    ASSERT_TRUE(queue.push(make_frame(400)));
+    EXPECT_EQ(queue.cost(), 800U);
+
+    std::atomic<bool> pushed { false };
+    std::thread producer([&] {
+        EXPECT_TRUE(queue.push(make_frame(400)));
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_FALSE(pushed.load());
+
+    FramePtr out;
+    ASSERT_TRUE(queue.try_pop(out));
+    producer.join();
+    EXPECT_TRUE(pushed.load());
+    EXPECT_EQ(queue.size(), 2U);
+    EXPECT_EQ(queue.cost(), 800U);
+}
+
+TEST(SemQueueBudgetTest, OversizedElementIsAdmittedIntoEmptyQueue)
+{
+    SemQueue<FramePtr> queue(30, frame_bytes, 1000);
+    ASSERT_TRUE(queue.push(make_frame(5000)));
+    EXPECT_EQ(queue.cost(), 5000U);
+
+    FramePtr out;
+    ASSERT_TRUE(queue.wait_and_pop(out, std::chrono::milliseconds(10)));
+    EXPECT_EQ(queue.cost(), 0U);
+}
+
+TEST(SemQueueBudgetTest, ShutdownReleasesProducerBlockedOnBudget)
+{
+    SemQueue<FramePtr> queue(30, frame_bytes, 100);
+    ASSERT_TRUE(queue.push(make_frame(100)));
+
+    std::thread producer([&] { EXPECT_FALSE(queue.push(make_frame(100))); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.shutdown();
+    producer.join();
+
+    queue.reset();
+    EXPECT_EQ(queue.cost(), 0U);
+    EXPECT_TRUE(queue.push(make_frame(100)));
+}
+
+TEST(SemQueueBulkTest, PopBulkPreservesOrderAndRespectsMax)
+{
+    SemQueue<int> queue(16);
+    std::vector<int> input { 1, 2, 3, 4, 5 };
+    EXPECT_EQ(queue.push_bulk(input), input.size());
+    EXPECT_EQ(queue.size(), 5U);
+
+    int out[3] = {};
+    ASSERT_EQ(queue.try_pop_bulk(out, 3), 3U);
+    EXPECT_EQ(out[0], 1);
+    EXPECT_EQ(out[1], 2);
+    EXPECT_EQ(out[2], 3);
+
+    ASSERT_EQ(queue.pop_bulk(out, 3, std::chrono::milliseconds(10)), 2U);
+    EXPECT_EQ(out[0], 4);
+    EXPECT_EQ(out[1], 5);
+
+    EXPECT_EQ(queue.try_pop_bulk(out, 3), 0U);
+    EXPECT_EQ(queue.pop_bulk(out, 3, std::chrono::milliseconds(10)), 0U);
+
+    // 空位都已经还回去了，可以再次填满
+    std::vector<int> refill(16, 7);
+    EXPECT_EQ(queue.push_bulk(refill), 16U);
+}
+
+TEST(SemQueueBulkTest, PushBulkLargerThanCapacityWaitsForConsumer)
+{
+    constexpr int kCount = 1000;
+    SemQueue<int> queue(8);
+    std::vector<int> input(kCount);
+    for (int i = 0; i < kCount; ++i)
+        input[i] = i;
+
+    std::thread producer([&] { EXPECT_EQ(queue.push_bulk(input), static_cast<size_t>(kCount)); });
+
+    std::vector<int> received;
+    int out[5];
+    while (received.size() < static_cast<size_t>(kCount)) {
+        size_t n = queue.pop_bulk(out, 5, std::chrono::seconds(2));
+        ASSERT_GT(n, 0U);
+        received.insert(received.end(), out, out + n);
+    }
+    producer.join();
+    EXPECT_EQ(received, input);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(SemQueueBulkTest, BulkPopReleasesCostBudget)
+{
+    SemQueue<FramePtr> queue(30, frame_bytes, 1000);
+    std::vector<FramePtr> frames { make_frame(400), make_frame(400) };
+    ASSERT_EQ(queue.push_bulk(frames), 2U);
+    EXPECT_EQ(queue.cost(), 800U);
+
+    std::atomic<bool> pushed { false };
+    std::thread producer([&] {
+        EXPECT_TRUE(queue.push(make_frame(900)));
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(pushed.load());
+
+    FramePtr out[2];
+    ASSERT_EQ(queue.try_pop_bulk(out, 2), 2U);
+    producer.join();
+    EXPECT_TRUE(pushed.load());
+    EXPECT_EQ(queue.cost(), 900U);
+}
+
+TEST(SemQueueBulkTest, ShutdownStopsBlockedBulkPush)
+{
+    SemQueue<int> queue(4);
+    std::vector<int> input(10, 1);
+    std::thread producer([&] { EXPECT_EQ(queue.push_bulk(input), 4U); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.shutdown();
+    producer.join();
+}
+
+TEST(SemQueueTelemetryTest, RecordsWaitsHighWaterAndUnderruns)
+{
+    SemQueue<int> queue(2);
+    auto telemetry = std::make_shared<player_utils::QueueTelemetry>();
+    queue.set_telemetry(telemetry);
+
+    int out = 0;
+    EXPECT_FALSE(queue.try_pop(out));
+    EXPECT_FALSE(queue.wait_and_pop(out, std::chrono::milliseconds(5)));
+
+    ASSERT_TRUE(queue.push(1));
+    ASSERT_TRUE(queue.push(2));
+    std::thread producer([&] { EXPECT_TRUE(queue.push(3)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ASSERT_TRUE(queue.try_pop(out));
+    producer.join();
+
+    auto stats = queue.stats();
+    EXPECT_EQ(stats.pushes, 3U);
+    EXPECT_EQ(stats.pops, 1U);
+    EXPECT_EQ(stats.size, 2U);
+    EXPECT_EQ(stats.high_water, 2U);
+    EXPECT_EQ(stats.underruns, 2U);
+    EXPECT_EQ(stats.producer_waits, 1U);
+    EXPECT_GE(stats.producer_wait_ns, 10'000'000U);
+    EXPECT_EQ(stats.consumer_waits, 1U); // 超时的那次
+
+    uint64_t in_hist = 0;
+    for (auto n : stats.producer_wait_hist)
+        in_hist += n;
+    EXPECT_EQ(in_hist, 1U);
+    // 20ms 左右的等待落在 2^14 ~ 2^15 微秒附近
+    EXPECT_EQ(player_utils::QueueTelemetry::bucket_for(std::chrono::milliseconds(20)), 14U);
+}
+
+TEST(SemQueueTelemetryTest, TelemetrySurvivesQueueRebuild)
+{
+    auto telemetry = std::make_shared<player_utils::QueueTelemetry>();
+    {
+        SemQueue<int> queue(4);
+        queue.set_telemetry(telemetry);
+        queue.push(1);
+        queue.push(2);
+        queue.clear();
+    }
+    SemQueue<int> rebuilt(4);
+    rebuilt.set_telemetry(telemetry);
+    rebuilt.push(3);
+
+    auto stats = rebuilt.stats();
+    EXPECT_EQ(stats.pushes, 3U);
+    EXPECT_EQ(stats.cleared, 2U);
+    EXPECT_EQ(stats.size, 1U);
+}
+
+TEST(SemQueueTryPushTest, FailsWithoutMovingWhenFullOrOverBudget)
+{
+    SemQueue<int> queue(2);
+    int a = 1;
+    int b = 2;
+    int c = 3;
+    EXPECT_TRUE(queue.try_push(a));
+    EXPECT_TRUE(queue.try_push(b));
+    EXPECT_TRUE(queue.full());
+    EXPECT_FALSE(queue.try_push(c));
+    EXPECT_EQ(c, 3);
+
+    SemQueue<FramePtr> budgeted(8, frame_bytes, 100);
+    auto big = make_frame(80);
+    auto more = make_frame(30);
+    EXPECT_TRUE(budgeted.try_push(big));
+    EXPECT_FALSE(budgeted.try_push(more));
+    EXPECT_NE(more, nullptr);
+    FramePtr out;
+    ASSERT_TRUE(budgeted.try_pop(out));
+    EXPECT_TRUE(budgeted.try_push(more));
+    EXPECT_EQ(budgeted.cost(), 30U);
+
+    queue.shutdown();
+    EXPECT_TRUE(queue.is_shutdown());
+    EXPECT_FALSE(queue.full()); // push 不会再阻塞
+    int d = 4;
+    EXPECT_FALSE(queue.try_push(d));
+}
+
+TEST(SemQueueTryPushTest, FullIsFalseWhileTheNextPushWouldBlockOnBudget)
+{
+    // 预算还剩 10 字节：没有满，但下一帧 40 字节放不下，push 会等，只有 try_push 不等
+    SemQueue<FramePtr> queue(8, frame_bytes, 100);
+    ASSERT_TRUE(queue.push(make_frame(90)));
+    EXPECT_FALSE(queue.full());
+
+    auto next = make_frame(40);
+    EXPECT_FALSE(queue.try_push(next));
+    EXPECT_NE(next, nullptr);
+
+    std::atomic<bool> pushed { false };
+    std::thread producer([&] {
+        EXPECT_TRUE(queue.push(make_frame(40)));
+        pushed = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_FALSE(pushed.load());
+    EXPECT_FALSE(queue.full());
+
+    FramePtr out;
+    ASSERT_TRUE(queue.try_pop(out));
+    producer.join();
+    EXPECT_TRUE(pushed.load());
+    EXPECT_EQ(queue.cost(), 40U);
+}
+
+TEST(SemQueueTryPushTest, WakeupsFireOnPushPopClearAndShutdown)
+{
+    SemQueue<int> queue(4);
+    int readable = 0;
+    int writable = 0;
+    queue.set_on_readable([&] { ++readable; });
+    queue.set_on_writable([&] { ++writable; });
+
+    queue.push(1);
+    int two = 2;
+    queue.try_push(two);
+    EXPECT_EQ(readable, 2);
+
+    int out = 0;
+    queue.try_pop(out);
+    EXPECT_EQ(writable, 1);
+    queue.clear();
+    EXPECT_EQ(writable, 2);
+    queue.clear(); // 空队列不再唤醒
+    EXPECT_EQ(writable, 2);
+
+    queue.shutdown();
+    EXPECT_EQ(readable, 3);
+    EXPECT_EQ(writable, 3);
+}
+
+// 消费者拿到 filled 计数、还没加锁时被 clear 抢先清空：不能对空队列取元素，
+// 也不能让空位比容量多（clear 只返还它拿到计数的那些空位）
+TEST(SemQueueClearTest, ConcurrentClearKeepsPopsSafeAndQueueBounded)
+{
+    constexpr size_t kCapacity = 4;
+    SemQueue<std::unique_ptr<int>> queue(kCapacity);
+    std::atomic<bool> stop { false };
+
+    std::thread producer([&] {
+        int n = 0;
+        while (!stop.load()) {
+            auto element = std::make_unique<int>(n);
+            if (queue.try_push(element)) {
+                ++n;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    std::thread popper([&] {
+        std::unique_ptr<int> out;
+        while (!stop.load()) {
+            if (queue.wait_and_pop(out, std::chrono::milliseconds(1))) {
+                EXPECT_NE(out, nullptr);
+            }
+        }
+    });
+    std::thread bulk_popper([&] {
+        std::unique_ptr<int> out[3];
+        while (!stop.load()) {
+            const size_t n = queue.try_pop_bulk(out, 3);
+            for (size_t i = 0; i < n; ++i) {
+                EXPECT_NE(out[i], nullptr);
+            }
+        }
+    });
+    std::thread clearer([&] {
+        while (!stop.load()) {
+            queue.clear();
+            std::this_thread::yield();
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    stop = true;
+    producer.join();
+    popper.join();
+    bulk_popper.join();
+    clearer.join();
+
+    // 计数没有乱：清空之后正好能放 kCapacity 个，也正好能取出 kCapacity 个
+    queue.clear();
+    for (size_t i = 0; i < kCapacity; ++i) {
+        auto element = std::make_unique<int>(static_cast<int>(i));
+        EXPECT_TRUE(queue.try_push(element)) << i;
+    }
+    auto extra = std::make_unique<int>(-1);
+    EXPECT_FALSE(queue.try_push(extra));
+    std::unique_ptr<int> out;
+    for (size_t i = 0; i < kCapacity; ++i) {
+        ASSERT_TRUE(queue.try_pop(out)) << i;
+        EXPECT_EQ(*out, static_cast<int>(i));
+    }
+    EXPECT_FALSE(queue.try_pop(out));
+}
@@ -0,0 +1,125 @@
+// test_semaphore.cc
+#include "SemQueue.hpp"
+#include "Semaphore.hpp"
+#include <atomic>
+#include <chrono>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using player_utils::SemQueue;
+using player_utils::Semaphore;
+
+TEST(SemaphoreTest, CountsAreConservedUnderContention)
+{
+    constexpr int kThreads = 4;
+    constexpr int kOps = 50000;
+    Semaphore empty_slots(8);
+    Semaphore filled_slots(0);
+    std::atomic<int> consumed { 0 };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&] {
+            for (int n = 0; n < kOps; ++n) {
+                empty_slots.acquire();
+                filled_slots.release();
+            }
+        });
+        threads.emplace_back([&] {
+            for (int n = 0; n < kOps; ++n) {
+                filled_slots.acquire();
+                consumed.fetch_add(1);
+                empty_slots.release();
+            }
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_EQ(consumed.load(), kThreads * kOps);
+    EXPECT_FALSE(filled_slots.try_acquire());
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_TRUE(empty_slots.try_acquire());
+    }
+    EXPECT_FALSE(empty_slots.try_acquire());
+}
+
+TEST(SemaphoreTest, TimedAcquireTimesOutAndLeavesCountIntact)
+{
+    Semaphore sem(0);
+    EXPECT_FALSE(sem.try_acquire_for(std::chrono::milliseconds(10)));
+
+    // 超时撤销之后，新的 release 不能被 "幽灵等待者" 吃掉
+    sem.release();
+    EXPECT_TRUE(sem.try_acquire());
+
+    std::thread releaser([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        sem.release();
+    });
+    EXPECT_TRUE(sem.try_acquire_for(std::chrono::seconds(2)));
+    releaser.join();
+}
+
+TEST(SemaphoreTest, ReleaseAllWakesEveryWaiter)
+{
+    Semaphore sem(0);
+    std::atomic<int> woken { 0 };
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < 3; ++i) {
+        waiters.emplace_back([&] {
+            sem.acquire();
+            woken.fetch_add(1);
+        });
+    }
+    waiters.emplace_back([&] {
+        EXPECT_FALSE(sem.try_acquire_for(std::chrono::seconds(5)));
+        woken.fetch_add(1);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    sem.release_all();
+    for (auto& t : waiters)
+        t.join();
+    EXPECT_EQ(woken.load(), 4);
+}
+
+TEST(SemaphoreTest, SemQueueIsBoundedAgainAfterReset)
+{
+    SemQueue<int> queue(2);
+    queue.shutdown();
+    queue.reset();
+
+    EXPECT_TRUE(queue.push(1));
+    EXPECT_TRUE(queue.push(2));
+
+    int value = 0;
+    EXPECT_TRUE(queue.wait_and_pop(value, std::chrono::milliseconds(10)));
+    EXPECT_EQ(value, 1);
+    EXPECT_TRUE(queue.wait_and_pop(value, std::chrono::milliseconds(10)));
+    EXPECT_EQ(value, 2);
+    EXPECT_FALSE(queue.wait_and_pop(value, std::chrono::milliseconds(10)));
+}
+
+TEST(SemaphoreTest, BulkReleaseWakesOnlyAsManyWaitersAsNeeded)
+{
+    Semaphore sem(0);
+    std::atomic<int> woken { 0 };
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < 3; ++i) {
+        waiters.emplace_back([&] {
+            sem.acquire();
+            woken.fetch_add(1);
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    // 3 个等待者拿走 3 个，剩下 2 个留在计数里
+    sem.release(5);
+    for (auto& t : waiters)
+        t.join();
+    EXPECT_EQ(woken.load(), 3);
+    EXPECT_EQ(sem.try_acquire_up_to(10), 2);
+    EXPECT_EQ(sem.try_acquire_up_to(10), 0);
+}
@@ -0,0 +1,74 @@
+// test_spsc_queue.cc
+#include "SpscQueue.hpp"
+#include <chrono>
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+
+using player_utils::SpscQueue;
+
+TEST(SpscQueueTest, PreservesFifoOrderAcrossThreads)
+{
+    constexpr int kCount = 100000;
+    SpscQueue<int> queue(30);
+
+    std::thread producer([&] {
+        for (int i = 0; i < kCount; ++i) {
+            ASSERT_TRUE(queue.push(i));
+        }
+    });
+
+    int value = -1;
+    for (int i = 0; i < kCount; ++i) {
+        ASSERT_TRUE(queue.wait_and_pop(value));
+        ASSERT_EQ(value, i);
+    }
+    producer.join();
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(SpscQueueTest, RespectsCapacityAndTimeout)
+{
+    SpscQueue<int> queue(3);
+    EXPECT_TRUE(queue.push(1));
+    EXPECT_TRUE(queue.push(2));
+    EXPECT_TRUE(queue.push(3));
+    EXPECT_EQ(queue.size(), 3U);
+
+    // 队列满时 push 会阻塞，直到消费者腾出空位
+    std::thread producer([&] { EXPECT_TRUE(queue.push(4)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(queue.size(), 3U);
+
+    int value = 0;
+    ASSERT_TRUE(queue.try_pop(value));
+    EXPECT_EQ(value, 1);
+    producer.join();
+    EXPECT_EQ(queue.size(), 3U);
+
+    queue.clear();
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.wait_and_pop(value, std::chrono::milliseconds(10)));
+}
+
+TEST(SpscQueueTest, ShutdownWakesBlockedConsumerAndDrainsRemaining)
+{
+    SpscQueue<std::unique_ptr<int>> queue(4);
+    std::unique_ptr<int> out;
+
+    std::thread consumer([&] { EXPECT_FALSE(queue.wait_and_pop(out)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    queue.shutdown();
+    consumer.join();
+
+    // shutdown 后拒绝 push；reset 之后恢复正常
+    EXPECT_FALSE(queue.push(std::make_unique<int>(1)));
+    queue.reset();
+    EXPECT_TRUE(queue.push(std::make_unique<int>(2)));
+
+    // 已经在队列里的元素在 shutdown 后仍可以取出
+    queue.shutdown();
+    ASSERT_TRUE(queue.wait_and_pop(out));
+    EXPECT_EQ(*out, 2);
+    EXPECT_FALSE(queue.wait_and_pop(out));
+}
@@ -0,0 +1,155 @@
+// test_stream_info_cache.cc
+#include "StreamInfoCache.hpp"
+#include <gtest/gtest.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using player_utils::CachedStreamInfo;
+using player_utils::FileIdentity;
+using player_utils::StreamInfoCache;
+
+namespace {
+
+FileIdentity make_identity()
+{
+    FileIdentity id;
+    id.path = "/sdcard/Movies/demo.mp4";
+    id.size = 123456789;
+    id.mtime_ns = 1700000000123456789LL;
+    return id;
+}
+
+StreamInfoCache::Entry make_entry()
+{
+    StreamInfoCache::Entry entry;
+    entry.duration = 61234567;
+    CachedStreamInfo video;
+    video.codec_type = 0;
+    video.codec_id = 173;
+    video.format = 0;
+    video.profile = 1;
+    video.level = 153;
+    video.width = 3840;
+    video.height = 2160;
+    video.sar_num = 1;
+    video.video_delay = 2;
+    video.extradata = { 0x01, 0x02, 0x03, 0x04, 0x05 };
+    CachedStreamInfo audio;
+    audio.codec_type = 1;
+    audio.codec_id = 86018;
+    audio.sample_rate = 48000;
+    audio.channels = 2;
+    audio.channel_mask = 0x3;
+    audio.frame_size = 1024;
+    audio.extradata = { 0x11, 0x90 };
+    entry.streams = { video, audio };
+    return entry;
+}
+
+} // namespace
+
+TEST(StreamInfoCacheTest, RoundTripsEntry)
+{
+    std::stringstream buffer;
+    ASSERT_TRUE(StreamInfoCache::write(buffer, make_identity(), make_entry()));
+
+    StreamInfoCache::Entry loaded;
+    ASSERT_TRUE(StreamInfoCache::read(buffer, make_identity(), loaded));
+    EXPECT_EQ(loaded.duration, 61234567);
+    ASSERT_EQ(loaded.streams.size(), 2U);
+    EXPECT_EQ(loaded.streams[0].width, 3840);
+    EXPECT_EQ(loaded.streams[0].level, 153);
+    EXPECT_EQ(loaded.streams[0].video_delay, 2);
+    EXPECT_EQ(loaded.streams[0].extradata, make_entry().streams[0].extradata);
+    EXPECT_EQ(loaded.streams[1].sample_rate, 48000);
+    EXPECT_EQ(loaded.streams[1].channel_mask, 0x3U);
+    EXPECT_EQ(loaded.streams[1].extradata, make_entry().streams[1].extradata);
+}
+
+TEST(StreamInfoCacheTest, RejectsChangedFile)
+{
+    std::stringstream buffer;
+    ASSERT_TRUE(StreamInfoCache::write(buffer, make_identity(), make_entry()));
+    const std::string bytes = buffer.str();
+
+    auto read_as = [&bytes](const FileIdentity& id) {
+        std::istringstream in(bytes);
+        StreamInfoCache::Entry loaded;
+        return StreamInfoCache::read(in, id, loaded);
+    };
+    FileIdentity id = make_identity();
+    id.size += 1;
+    EXPECT_FALSE(read_as(id));
+    id = make_identity();
+    id.mtime_ns += 1;
+    EXPECT_FALSE(read_as(id));
+    id = make_identity();
+    id.path += ".bak";
+    EXPECT_FALSE(read_as(id));
+    EXPECT_TRUE(read_as(make_identity()));
+}
+
+TEST(StreamInfoCacheTest, RejectsTruncatedOrCorruptData)
+{
+    std::stringstream buffer;
+    ASSERT_TRUE(StreamInfoCache::write(buffer, make_identity(), make_entry()));
+    const std::string bytes = buffer.str();
+
+    for (size_t cut = 0; cut < bytes.size(); cut += 7) {
+        std::istringstream in(bytes.substr(0, cut));
+        StreamInfoCache::Entry loaded;
+        loaded.duration = -1;
+        EXPECT_FALSE(StreamInfoCache::read(in, make_identity(), loaded)) << "cut at " << cut;
+        EXPECT_EQ(loaded.duration, -1); // 失败时不改输出
+    }
+    std::string bad_magic = bytes;
+    bad_magic[0] = 'X';
+    std::istringstream in(bad_magic);
+    StreamInfoCache::Entry loaded;
+    EXPECT_FALSE(StreamInfoCache::read(in, make_identity(), loaded));
+}
+
+TEST(StreamInfoCacheTest, SavesAndLoadsFromDirectory)
+{
+    char dir[] = "/tmp/stream_info_cache_XXXXXX";
+    ASSERT_NE(mkdtemp(dir), nullptr);
+    const std::string media = std::string(dir) + "/clip.mp4";
+    {
+        std::ofstream out(media, std::ios::binary);
+        out << "not really an mp4";
+    }
+
+    FileIdentity id;
+    ASSERT_TRUE(FileIdentity::of(media, id));
+    EXPECT_EQ(id.size, 17);
+    FileIdentity missing;
+    EXPECT_FALSE(FileIdentity::of(std::string(dir) + "/missing.mp4", missing));
+    EXPECT_FALSE(FileIdentity::of(dir, missing)); // 目录不是普通文件
+
+    StreamInfoCache cache(dir);
+    StreamInfoCache::Entry loaded;
+    EXPECT_FALSE(cache.load(id, loaded));
+    ASSERT_TRUE(cache.save(id, make_entry()));
+    ASSERT_TRUE(cache.load(id, loaded));
+    EXPECT_EQ(loaded.streams.size(), 2U);
+
+    // 文件被改写之后大小变了，旧的项作废
+    {
+        std::ofstream out(media, std::ios::binary | std::ios::app);
+        out << "!";
+    }
+    FileIdentity changed;
+    ASSERT_TRUE(FileIdentity::of(media, changed));
+    EXPECT_EQ(cache.entry_path(changed), cache.entry_path(id));
+    EXPECT_FALSE(cache.load(changed, loaded));
+
+    std::remove(cache.entry_path(id).c_str());
+    std::remove(media.c_str());
+    rmdir(dir);
+}
@@ -0,0 +1,156 @@
+// test_task_executor.cc
+#include "SemQueue.hpp"
+#include "TaskExecutor.hpp"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using player_utils::SemQueue;
+using player_utils::TaskExecutor;
+using Step = TaskExecutor::Step;
+
+TEST(TaskExecutorTest, RunsYieldingTasksToCompletion)
+{
+    TaskExecutor executor(4);
+    std::vector<std::shared_ptr<TaskExecutor::Task>> tasks;
+    std::vector<int> counts(32, 0);
+    for (size_t i = 0; i < counts.size(); ++i) {
+        tasks.push_back(executor.spawn([&counts, i] {
+            return ++counts[i] < 100 ? Step::kYield : Step::kDone;
+        }));
+    }
+    for (auto& task : tasks) {
+        task->wake();
+    }
+    for (auto& task : tasks) {
+        task->wait_done();
+        EXPECT_TRUE(task->done());
+    }
+    for (int count : counts) {
+        EXPECT_EQ(count, 100);
+    }
+    EXPECT_EQ(executor.stats().steps, 3200U);
+}
+
+TEST(TaskExecutorTest, WaitingTaskRunsAgainOnlyAfterWake)
+{
+    TaskExecutor executor(2);
+    std::atomic<int> steps { 0 };
+    auto task = executor.spawn([&steps] { return ++steps < 3 ? Step::kWait : Step::kDone; });
+    task->wake();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(steps.load(), 1);
+    task->wake();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(steps.load(), 2);
+    task->wake();
+    task->wait_done();
+    EXPECT_EQ(steps.load(), 3);
+}
+
+TEST(TaskExecutorTest, SleepingTaskWakesUpAfterBackoff)
+{
+    TaskExecutor executor(1);
+    std::atomic<int> steps { 0 };
+    auto task = executor.spawn([&steps] { return ++steps < 5 ? Step::kSleep : Step::kDone; },
+        std::chrono::milliseconds(1));
+    const auto start = std::chrono::steady_clock::now();
+    task->wake();
+    task->wait_done();
+    EXPECT_EQ(steps.load(), 5);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(4));
+    EXPECT_EQ(executor.stats().sleeps, 4U);
+}
+
+// 生产者 / 消费者都是任务，只靠 SemQueue 的唤醒回调推进：唤醒丢一次就会卡住
+TEST(TaskExecutorTest, QueueWakeupsDriveProducerAndConsumer)
+{
+    constexpr int kItems = 200000;
+    TaskExecutor executor(3);
+    SemQueue<int> queue(4);
+    int next = 0;
+    int pending = -1;
+    long long sum = 0;
+
+    auto producer = executor.spawn([&] {
+        for (int i = 0; i < 64; ++i) {
+            if (pending < 0) {
+                if (next == kItems) {
+                    queue.shutdown();
+                    return Step::kDone;
+                }
+                pending = next++;
+            }
+            if (!queue.try_push(pending)) {
+                return Step::kWait;
+            }
+            pending = -1;
+        }
+        return Step::kYield;
+    });
+    auto consumer = executor.spawn([&] {
+        int value = 0;
+        for (int i = 0; i < 64; ++i) {
+            if (!queue.try_pop(value)) {
+                return queue.is_shutdown() && queue.empty() ? Step::kDone : Step::kWait;
+            }
+            sum += value;
+        }
+        return Step::kYield;
+    });
+    std::weak_ptr<TaskExecutor::Task> weak_producer = producer;
+    std::weak_ptr<TaskExecutor::Task> weak_consumer = consumer;
+    queue.set_on_readable([weak_consumer] {
+        if (auto task = weak_consumer.lock()) {
+            task->wake();
+        }
+    });
+    queue.set_on_writable([weak_producer] {
+        if (auto task = weak_producer.lock()) {
+            task->wake();
+        }
+    });
+
+    producer->wake();
+    consumer->wake();
+    producer->wait_done();
+    consumer->wait_done();
+    EXPECT_EQ(sum, static_cast<long long>(kItems) * (kItems - 1) / 2);
+}
+
+TEST(TaskExecutorTest, IdleWorkersStealQueuedTasks)
+{
+    TaskExecutor executor(4);
+    std::atomic<int> running { 0 };
+    std::atomic<int> max_running { 0 };
+    // 一个任务在工作线程里唤醒其余任务，它们都进这个工作线程的队列，其他线程只能偷
+    std::vector<std::shared_ptr<TaskExecutor::Task>> children;
+    for (int i = 0; i < 8; ++i) {
+        children.push_back(executor.spawn([&] {
+            const int now = ++running;
+            int seen = max_running.load();
+            while (now > seen && !max_running.compare_exchange_weak(seen, now)) {
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            --running;
+            return Step::kDone;
+        }));
+    }
+    auto parent = executor.spawn([&] {
+        for (auto& child : children) {
+            child->wake();
+        }
+        return Step::kDone;
+    });
+    parent->wake();
+    for (auto& child : children) {
+        child->wait_done();
+    }
+    EXPECT_GT(max_running.load(), 1);
+    EXPECT_GT(executor.stats().steals, 0U);
+}
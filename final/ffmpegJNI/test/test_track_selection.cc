@@ -0,0 +1,54 @@
+// test_track_selection.cc
+#include "TrackSelection.hpp"
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using player_utils::find_track_by_stream;
+using player_utils::resolve_track;
+using player_utils::TrackInfo;
+using player_utils::TrackType;
+
+namespace {
+
+// 一个视频、两条音轨（中 / 英）、一条字幕，id 和流下标故意不一样
+std::vector<TrackInfo> tracks()
+{
+    return {
+        { 1, 0, TrackType::Video, "h264", "", true },
+        { 2, 1, TrackType::Audio, "aac", "chi", true },
+        { 3, 2, TrackType::Audio, "aac", "eng", false },
+        { 5, 3, TrackType::Subtitle, "mov_text", "eng", false },
+    };
+}
+
+} // namespace
+
+TEST(TrackSelectionTest, ResolvesIdsToStreamIndices)
+{
+    const auto all = tracks();
+    EXPECT_EQ(resolve_track(all, TrackType::Audio, 3, 1), 2);
+    EXPECT_EQ(resolve_track(all, TrackType::Subtitle, 5, -1), 3);
+    EXPECT_EQ(resolve_track(all, TrackType::Video, 1, -1), 0);
+}
+
+TEST(TrackSelectionTest, FallsBackOnAutoUnknownOrWrongType)
+{
+    const auto all = tracks();
+    // < 0：音视频用 av_find_best_stream 的结果，字幕不要
+    EXPECT_EQ(resolve_track(all, TrackType::Audio, -1, 1), 1);
+    EXPECT_EQ(resolve_track(all, TrackType::Subtitle, -1, -1), -1);
+    EXPECT_EQ(resolve_track(all, TrackType::Audio, 42, 1), 1);
+    // id 存在但不是音轨
+    EXPECT_EQ(resolve_track(all, TrackType::Audio, 5, 1), 1);
+}
+
+TEST(TrackSelectionTest, FindsTrackByStreamIndex)
+{
+    const auto all = tracks();
+    const TrackInfo* track = find_track_by_stream(all, 2);
+    ASSERT_NE(track, nullptr);
+    EXPECT_EQ(track->id, 3);
+    EXPECT_EQ(track->language, "eng");
+    EXPECT_EQ(find_track_by_stream(all, 7), nullptr);
+}
@@ -0,0 +1,167 @@
+// test_video_frame_pool.cc
+#include "RingBuffer.hpp"
+#include "SemQueue.hpp"
+#include "VideoFramePool.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <new>
+#include <thread>
+#include <vector>
+
+using player_utils::SemQueue;
+using player_utils::VideoFrame;
+using player_utils::VideoFramePool;
+
+// --- 统计整个进程的堆分配次数 ---
+// new/delete 和 malloc/free 是成对替换的，GCC 的 -Wmismatched-new-delete 在这里是误报
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+namespace {
+std::atomic<long> g_allocations { 0 };
+} // namespace
+
+void* operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+constexpr int kWidth = 1920;
+constexpr int kHeight = 1080;
+constexpr int kFormat = 0; // AV_PIX_FMT_YUV420P
+constexpr size_t kFrameBytes = kWidth * kHeight * 3 / 2;
+} // namespace
+
+// 复制出来的帧和引用解码器缓冲区的零拷贝帧，plane() / byte_size() 给出同样的结果
+TEST(VideoFrameTest, CopiedAndReferencedFramesExposeTheSamePlanes)
+{
+    const int linesize[3] = { kWidth + 64, kWidth / 2 + 32, kWidth / 2 + 32 };
+    const size_t plane_bytes[3] = {
+        size_t(linesize[0]) * kHeight, size_t(linesize[1]) * (kHeight / 2), size_t(linesize[2]) * (kHeight / 2)
+    };
+    const size_t total = plane_bytes[0] + plane_bytes[1] + plane_bytes[2];
+
+    // 模拟解码器的输出：三个独立分配的平面
+    auto decoder_buffer = std::make_shared<std::vector<std::vector<uint8_t>>>();
+    for (int i = 0; i < 3; ++i) {
+        decoder_buffer->emplace_back(plane_bytes[i], static_cast<uint8_t>(i + 1));
+    }
+
+    VideoFramePool pool(2);
+    auto copied = pool.acquire(kWidth, kHeight, kFormat, total);
+    uint8_t* dst = copied->data.data();
+    for (int i = 0; i < 3; ++i) {
+        std::memcpy(dst, (*decoder_buffer)[i].data(), plane_bytes[i]);
+        copied->linesize[i] = linesize[i];
+        dst += plane_bytes[i];
+    }
+
+    auto referenced = std::make_shared<VideoFrame>();
+    referenced->width = kWidth;
+    referenced->height = kHeight;
+    for (int i = 0; i < 3; ++i) {
+        referenced->planes[i] = (*decoder_buffer)[i].data();
+        referenced->linesize[i] = linesize[i];
+        referenced->ref_bytes += plane_bytes[i];
+    }
+    referenced->buffer_ref = decoder_buffer;
+
+    EXPECT_TRUE(referenced->data.empty());
+    EXPECT_EQ(copied->byte_size(), total);
+    EXPECT_EQ(referenced->byte_size(), total);
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(referenced->plane(i), (*decoder_buffer)[i].data());
+        EXPECT_EQ(std::memcmp(copied->plane(i), referenced->plane(i), plane_bytes[i]), 0) << "plane " << i;
+    }
+
+    // 零拷贝帧让解码器缓冲区一直活到最后一个引用释放
+    std::weak_ptr<void> watch = decoder_buffer;
+    decoder_buffer.reset();
+    EXPECT_FALSE(watch.expired());
+    referenced.reset();
+    EXPECT_TRUE(watch.expired());
+}
+
+TEST(VideoFramePoolTest, ReusesFramesOfTheSameShape)
+{
+    VideoFramePool pool(4);
+    VideoFrame* first_raw = nullptr;
+    {
+        auto frame = pool.acquire(kWidth, kHeight, kFormat, kFrameBytes);
+        first_raw = frame.get();
+        EXPECT_EQ(frame->data.size(), kFrameBytes);
+        frame->pts = 1.0;
+    }
+    auto again = pool.acquire(kWidth, kHeight, kFormat, kFrameBytes);
+    EXPECT_EQ(again.get(), first_raw);
+    EXPECT_EQ(again->pts, 0.0);
+
+    // 不同尺寸不会拿到上面那一帧
+    auto other = pool.acquire(1280, 720, kFormat, 1280 * 720 * 3 / 2);
+    EXPECT_NE(other.get(), first_raw);
+
+    auto stats = pool.stats();
+    EXPECT_EQ(stats.acquires, 3U);
+    EXPECT_EQ(stats.hits, 1U);
+    EXPECT_NEAR(stats.hit_rate(), 1.0 / 3, 1e-9);
+}
+
+TEST(VideoFramePoolTest, FramesOutliveThePool)
+{
+    std::shared_ptr<VideoFrame> survivor;
+    {
+        VideoFramePool pool;
+        survivor = pool.acquire(16, 16, kFormat, 384);
+    }
+    survivor->data[0] = 42;
+    survivor.reset(); // 共享状态在这里才释放，ASan 下不应报错
+}
+
+// 模拟 解码线程 -> 帧队列 -> 渲染线程：池预热之后整条路径不应再有任何堆分配
+TEST(VideoFramePoolTest, DecodeToRenderPathIsAllocationFreeInSteadyState)
+{
+    constexpr int kWarmupFrames = 200;
+    constexpr int kFrames = 2000;
+    constexpr size_t kQueueSize = 5;
+    using FramePtr = std::shared_ptr<VideoFrame>;
+
+    // 同时在路上的帧最多是：队列里的 + 解码线程手上的 + 渲染线程的当前帧和上一帧
+    constexpr size_t kInFlight = kQueueSize + 3;
+    VideoFramePool pool(kInFlight);
+    pool.prewarm(kWidth, kHeight, kFormat, kFrameBytes, kInFlight);
+    SemQueue<FramePtr, RingBuffer<FramePtr, kQueueSize>> queue(kQueueSize);
+    std::atomic<long> allocations_at_steady_state { -1 };
+
+    std::thread render([&] {
+        FramePtr frame;
+        FramePtr last_rendered;
+        for (int i = 0; i < kWarmupFrames + kFrames; ++i) {
+            if (!queue.wait_and_pop(frame))
+                break;
+            last_rendered = std::move(frame); // 渲染线程会一直拿着上一帧
+        }
+    });
+
+    for (int i = 0; i < kWarmupFrames + kFrames; ++i) {
+        if (i == kWarmupFrames) {
+            allocations_at_steady_state = g_allocations.load();
+        }
+        auto frame = pool.acquire(kWidth, kHeight, kFormat, kFrameBytes);
+        std::memset(frame->data.data(), i & 0xff, 64);
+        frame->pts = i / 60.0;
+        ASSERT_TRUE(queue.push(std::move(frame)));
+    }
+    long allocations_after = g_allocations.load();
+    render.join();
+
+    EXPECT_EQ(allocations_after - allocations_at_steady_state.load(), 0);
+    EXPECT_EQ(pool.stats().hit_rate(), 1.0);
+}
@@ -158,25 +158,20 @@ void GLESRender::paint(const std::shared_ptr<VideoFrame>& frame_to_draw)
 
 void GLESRender::upload_yuv_to_texture(const VideoFrame& frame)
 {
-
-    // Y plane
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, y_tex_);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, frame.width, frame.height,
-        0, GL_LUMINANCE, GL_UNSIGNED_BYTE,
-        frame.data.data());
-    // U plane
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, u_tex_);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, frame.width / 2, frame.height / 2,
-        0, GL_LUMINANCE, GL_UNSIGNED_BYTE,
-        frame.data.data() + frame.linesize[0] * frame.height);
-    // V plane
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, v_tex_);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, frame.width / 2, frame.height / 2,
-        0, GL_LUMINANCE, GL_UNSIGNED_BYTE,
-        frame.data.data() + frame.linesize[0] * frame.height + frame.linesize[1] * (frame.height / 2));
+    // 按解码器的 linesize 直接上传，行尾的对齐填充由 GL_UNPACK_ROW_LENGTH 跳过，
+    // 零拷贝帧（平面指向解码器缓冲区）和复制出来的帧走同一条路径
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    const GLuint textures[3] = { y_tex_, u_tex_, v_tex_ };
+    for (int i = 0; i < 3; ++i) {
+        const int width = i == 0 ? frame.width : (frame.width + 1) / 2;
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, textures[i]);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, frame.linesize[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, width, frame.plane_height(i),
+            0, GL_LUMINANCE, GL_UNSIGNED_BYTE,
+            frame.plane(i));
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 }
 
 void GLESRender::draw_frame()
@@ -2,6 +2,7 @@
 #include "EGLCore.hpp"
 #include "Entitys.hpp"
 #include "GLESRender.hpp"
+#include "RingBuffer.hpp"
 #include <android/log.h>
 #include <android/native_window.h>
 #include <memory>
@@ -35,7 +36,10 @@ struct GLRenderHost::Impl {
 
     std::unique_ptr<EGLCore> egl_;
     std::unique_ptr<GLESRender> renderer_;
-    SemQueue<std::shared_ptr<player_utils::VideoFrame>> frame_queue_ { 5 };
+    // 只缓存几帧，容量固定，用 RingBuffer 代替 std::deque，入队出队不再分配内存
+    static constexpr size_t kFrameQueueSize = 5;
+    using FramePtr = std::shared_ptr<player_utils::VideoFrame>;
+    SemQueue<FramePtr, RingBuffer<FramePtr, kFrameQueueSize>> frame_queue_ { kFrameQueueSize };
 
     std::shared_ptr<player_utils::VideoFrame> last_frame_rendered_;
 
@@ -1,4 +1,3 @@
-
 #pragma once
 #include "Poller.hpp"
 #include <cerrno>
@@ -19,19 +18,41 @@ public:
     {
     }
 
+    Connection(Connection&& other) noexcept;
+    Connection& operator=(Connection&&) = delete;
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+    ~Connection();
+
     [[nodiscard]] int fd() const { return fd_; }
 
-    void handle(Poller& poller);
+    // 处理一次 EPOLLIN / EPOLLOUT，返回 false 表示连接已经关闭
+    bool handle(Poller& poller);
 
 private:
     int fd_;
     std::string recv_buf_;
 
-    void sendFileResponse(const std::string& filename);
+    // 正在发的响应：先发 send_buf_（JSON 头），再从 file_fd_ 的 [file_offset_, file_end_) sendfile
+    std::string send_buf_;
+    int file_fd_ = -1;
+    off_t file_offset_ = 0;
+    off_t file_end_ = 0;
+    // 整个文件的请求发完就关连接（和原来一样），区间请求发完接着等下一个请求
+    bool close_after_send_ = false;
+
+    bool readRequests();
+    void startResponse(const std::string& line);
+    // 发到 socket 写满为止，返回 false 表示出错
+    bool flush();
+
+    void sendFileResponse(const std::string& filename, long long offset, long long length);
 
     void sendError(const std::string& msg);
 
+    void closeFile();
+
     void closeSelf(Poller& poller) const;
 };
 
-}
\ No newline at end of file
+}
@@ -1,40 +1,139 @@
-
 #include "Connection.hpp"
+#include <algorithm>
 
 namespace tcp {
 using json = nlohmann::json;
 
-void Connection::handle(Poller& poller)
+namespace {
+    // 一直没有换行的请求当作非法的
+    constexpr size_t MAX_REQUEST_SIZE = 64 * 1024;
+} // namespace
+
+Connection::Connection(Connection&& other) noexcept
+    : fd_(other.fd_)
+    , recv_buf_(std::move(other.recv_buf_))
+    , send_buf_(std::move(other.send_buf_))
+    , file_fd_(other.file_fd_)
+    , file_offset_(other.file_offset_)
+    , file_end_(other.file_end_)
+    , close_after_send_(other.close_after_send_)
 {
-    char buf[BUF_SIZE];
-    ssize_t n;
-    while ((n = read(fd_, buf, sizeof(buf))) > 0) {
-        recv_buf_.append(buf, n);
-        if (recv_buf_.find('\n') != std::string::npos)
-            break;
-    }
+    other.file_fd_ = -1;
+}
 
-    if (n == 0 || (n < 0 && errno != EAGAIN)) {
+Connection::~Connection()
+{
+    closeFile();
+}
+
+bool Connection::handle(Poller& poller)
+{
+    if (!readRequests()) {
         closeSelf(poller);
-        return;
+        return false;
     }
 
-    auto pos = recv_buf_.find('\n');
-    if (pos != std::string::npos) {
+    while (true) {
+        if (!flush()) {
+            closeSelf(poller);
+            return false;
+        }
+        if (!send_buf_.empty() || file_fd_ >= 0) {
+            return true; // socket 写满了，等 EPOLLOUT 接着发
+        }
+        if (close_after_send_) {
+            closeSelf(poller);
+            return false;
+        }
+
+        auto pos = recv_buf_.find('\n');
+        if (pos == std::string::npos) {
+            return true;
+        }
         std::string line = recv_buf_.substr(0, pos);
-        try {
-            json j = json::parse(line);
-            std::string filename = j.at("filename");
-            sendFileResponse(filename);
-        } catch (...) {
-            sendError("invalid request");
+        recv_buf_.erase(0, pos + 1);
+        startResponse(line);
+    }
+}
+
+// 边缘触发，一直读到 EAGAIN；对方关闭或者出错时返回 false
+bool Connection::readRequests()
+{
+    char buf[BUF_SIZE];
+    while (true) {
+        ssize_t n = read(fd_, buf, sizeof(buf));
+        if (n > 0) {
+            recv_buf_.append(buf, n);
+            if (recv_buf_.size() > MAX_REQUEST_SIZE && recv_buf_.find('\n') == std::string::npos) {
+                return false;
+            }
+            continue;
+        }
+        if (n == 0) {
+            return false;
+        }
+        if (errno == EINTR) {
+            continue;
         }
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
 
-        closeSelf(poller);
+void Connection::startResponse(const std::string& line)
+{
+    try {
+        json j = json::parse(line);
+        std::string filename = j.at("filename");
+        // 带 offset 的是区间请求，不带 length 表示读到文件末尾
+        if (j.contains("offset")) {
+            close_after_send_ = false;
+            long long offset = j.at("offset");
+            long long length = j.contains("length") ? j.at("length").get<long long>() : -1;
+            if (offset < 0 || (j.contains("length") && length < 0)) {
+                sendError("invalid range");
+                return;
+            }
+            sendFileResponse(filename, offset, length);
+        } else {
+            close_after_send_ = true;
+            sendFileResponse(filename, -1, -1);
+        }
+    } catch (...) {
+        sendError("invalid request");
     }
 }
 
-void Connection::sendFileResponse(const std::string& filename)
+bool Connection::flush()
+{
+    while (!send_buf_.empty()) {
+        ssize_t n = write(fd_, send_buf_.data(), send_buf_.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        send_buf_.erase(0, n);
+    }
+
+    while (file_fd_ >= 0 && file_offset_ < file_end_) {
+        ssize_t sent = ::sendfile(fd_, file_fd_, &file_offset_, file_end_ - file_offset_);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        if (sent == 0) {
+            return false; // 文件在发送途中被截短了，发不够响应头里说的长度
+        }
+    }
+    closeFile();
+    return true;
+}
+
+// offset < 0 时发整个文件，否则发 [offset, offset + length)，超出文件的部分截掉
+void Connection::sendFileResponse(const std::string& filename, long long offset, long long length)
 {
     int file_fd = ::open(filename.c_str(), O_RDONLY);
     if (file_fd < 0) {
@@ -42,28 +141,38 @@ void Connection::sendFileResponse(const std::string& filename)
         return;
     }
 
-    off_t offset = 0;
     off_t fsize = ::lseek(file_fd, 0, SEEK_END);
-    ::lseek(file_fd, 0, SEEK_SET);
-
     json resp = { { "filesize", static_cast<size_t>(fsize) } };
-    std::string hdr = resp.dump() + "\n";
-    write(fd_, hdr.data(), hdr.size());
-
-    while (offset < fsize) {
-        ssize_t sent = ::sendfile(fd_, file_fd, &offset, fsize - offset);
-        if (sent <= 0)
-            break; // error or done
+    off_t begin = 0;
+    off_t end = fsize;
+    if (offset >= 0) {
+        begin = std::min<off_t>(offset, fsize);
+        if (length >= 0) {
+            end = std::min<off_t>(begin + length, fsize);
+        }
+        resp["offset"] = static_cast<long long>(begin);
+        resp["length"] = static_cast<long long>(end - begin);
     }
 
-    ::close(file_fd);
+    send_buf_ = resp.dump() + "\n";
+    file_fd_ = file_fd;
+    file_offset_ = begin;
+    file_end_ = end;
 }
 
 void Connection::sendError(const std::string& msg)
 {
     json err = { { "error", msg } };
-    std::string s = err.dump() + "\n";
-    write(fd_, s.data(), s.size());
+    send_buf_ = err.dump() + "\n";
+    close_after_send_ = true;
+}
+
+void Connection::closeFile()
+{
+    if (file_fd_ >= 0) {
+        ::close(file_fd_);
+        file_fd_ = -1;
+    }
 }
 
 void Connection::closeSelf(Poller& poller) const
@@ -1,6 +1,7 @@
 #include "Connection.hpp"
 #include "Poller.hpp"
 #include "Socket.hpp"
+#include <csignal>
 #include <iostream>
 
 static void handle_new_connection(tcp::Socket& socket, Poller& poller, std::unordered_map<int, tcp::Connection>& conns);
@@ -12,6 +13,9 @@ int main(int argc, char* argv[])
         return 1;
     }
 
+    // 客户端中途断开（比如播放器 seek 之后丢掉正在收的块）时 write 返回 EPIPE，而不是杀掉服务器
+    signal(SIGPIPE, SIG_IGN);
+
     int32_t port = std::stoi(argv[1]);
     tcp::Socket socket(port);
     Poller poller;
@@ -25,10 +29,9 @@ int main(int argc, char* argv[])
             int fd = ev.data.fd;
             if (fd == server_fd) {
                 handle_new_connection(socket, poller, connections);
-            } else if ((ev.events & EPOLLIN) != 0U) {
+            } else if ((ev.events & (EPOLLIN | EPOLLOUT | EPOLLERR | EPOLLHUP)) != 0U) {
                 auto it = connections.find(fd);
-                if (it != connections.end()) {
-                    it->second.handle(poller);
+                if (it != connections.end() && !it->second.handle(poller)) {
                     connections.erase(it);
                 }
             }
@@ -46,7 +49,8 @@ static void handle_new_connection(tcp::Socket& socket, Poller& poller,
         if (client_fd < 0) {
             break;
         }
-        poller.add_fd(client_fd, EPOLLIN | EPOLLET);
+        // 大文件一次发不完，socket 可写时（EPOLLOUT）接着发
+        poller.add_fd(client_fd, EPOLLIN | EPOLLOUT | EPOLLET);
         conns.emplace(client_fd, tcp::Connection(client_fd));
     }
 }